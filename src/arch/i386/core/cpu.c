@@ -52,21 +52,21 @@ void get_cpuinfo ( struct cpuinfo_x86 *cpu ) {
 	}
 
 	/* Get features, if present */
-	cpuid ( 0x00000000, &cpuid_level, &discard_1,
+	cpuid ( 0x00000000, 0, &cpuid_level, &discard_1,
 		&discard_2, &discard_3 );
 	if ( cpuid_level >= 0x00000001 ) {
-		cpuid ( 0x00000001, &discard_1, &discard_2,
+		cpuid ( 0x00000001, 0, &discard_1, &discard_2,
 			&discard_3, &cpu->features );
 	} else {
 		DBG ( "CPUID cannot return capabilities\n" );
 	}
 
 	/* Get 64-bit features, if present */
-	cpuid ( 0x80000000, &cpuid_extlevel, &discard_1,
+	cpuid ( 0x80000000, 0, &cpuid_extlevel, &discard_1,
 		&discard_2, &discard_3 );
 	if ( ( cpuid_extlevel & 0xffff0000 ) == 0x80000000 ) {
 		if ( cpuid_extlevel >= 0x80000001 ) {
-			cpuid ( 0x80000001, &discard_1, &discard_2,
+			cpuid ( 0x80000001, 0, &discard_1, &discard_2,
 				&discard_3, &cpu->amd_features );
 		}
 	}
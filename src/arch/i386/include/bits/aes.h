@@ -0,0 +1,55 @@
+#ifndef _BITS_AES_H
+#define _BITS_AES_H
+
+/** @file
+ *
+ * i386-specific AES implementation
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Encrypt blocks
+ *
+ * @v keys		Encryption key schedule
+ * @v rounds		Number of rounds
+ * @v src		Data to encrypt
+ * @v dst		Buffer for encrypted data
+ * @v count		Number of blocks
+ * @ret count		Number of blocks processed
+ *
+ * There is no architecture-specific implementation, so no blocks are
+ * processed.
+ */
+static inline __attribute__ (( always_inline )) size_t
+aes_arch_encrypt ( const uint32_t *keys __unused, unsigned int rounds __unused,
+		   const void *src __unused, void *dst __unused,
+		   size_t count __unused ) {
+	return 0;
+}
+
+/**
+ * Decrypt blocks
+ *
+ * @v keys		Decryption key schedule
+ * @v rounds		Number of rounds
+ * @v src		Data to decrypt
+ * @v dst		Buffer for decrypted data
+ * @v count		Number of blocks
+ * @ret count		Number of blocks processed
+ *
+ * There is no architecture-specific implementation, so no blocks are
+ * processed.
+ */
+static inline __attribute__ (( always_inline )) size_t
+aes_arch_decrypt ( const uint32_t *keys __unused, unsigned int rounds __unused,
+		   const void *src __unused, void *dst __unused,
+		   size_t count __unused ) {
+	return 0;
+}
+
+#endif /* _BITS_AES_H */
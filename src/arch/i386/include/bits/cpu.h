@@ -1,6 +1,8 @@
 #ifndef I386_BITS_CPU_H
 #define I386_BITS_CPU_H
 
+#include <ipxe/cpuid.h>
+
 /* Intel-defined CPU features, CPUID level 0x00000001, word 0 */
 #define X86_FEATURE_FPU		0 /* Onboard FPU */
 #define X86_FEATURE_VME		1 /* Virtual Mode Extensions */
@@ -70,17 +72,6 @@ struct cpuinfo_x86 {
 #define X86_EFLAGS_VIP	0x00100000 /* Virtual Interrupt Pending */
 #define X86_EFLAGS_ID	0x00200000 /* CPUID detection flag */
 
-/*
- * Generic CPUID function
- */
-static inline __attribute__ (( always_inline )) void
-cpuid ( int op, unsigned int *eax, unsigned int *ebx,
-	unsigned int *ecx, unsigned int *edx ) {
-	__asm__ ( "cpuid" :
-		  "=a" ( *eax ), "=b" ( *ebx ), "=c" ( *ecx ), "=d" ( *edx )
-		: "0" ( op ) );
-}
-
 extern void get_cpuinfo ( struct cpuinfo_x86 *cpu );
 
 #endif /* I386_BITS_CPU_H */
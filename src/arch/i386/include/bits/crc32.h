@@ -0,0 +1,32 @@
+#ifndef _BITS_CRC32_H
+#define _BITS_CRC32_H
+
+/** @file
+ *
+ * i386-specific CRC32 implementation
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Calculate 32-bit little-endian CRC checksum
+ *
+ * @v crc		CRC to update
+ * @v data		Data to checksum
+ * @v len		Length of data
+ * @ret len		Length of data processed
+ *
+ * There is no architecture-specific implementation, so no data is
+ * processed.
+ */
+static inline __attribute__ (( always_inline )) size_t
+crc32_arch_le ( uint32_t *crc __unused, const void *data __unused,
+		size_t len __unused ) {
+	return 0;
+}
+
+#endif /* _BITS_CRC32_H */
@@ -0,0 +1,32 @@
+#ifndef _BITS_SHA1_H
+#define _BITS_SHA1_H
+
+/** @file
+ *
+ * i386-specific SHA-1 implementation
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Calculate SHA-1 digest of complete blocks
+ *
+ * @v hash		Digest state
+ * @v data		Data
+ * @v count		Number of blocks
+ * @ret count		Number of blocks processed
+ *
+ * There is no architecture-specific implementation, so no blocks are
+ * processed.
+ */
+static inline __attribute__ (( always_inline )) size_t
+sha1_arch_blocks ( uint32_t *hash __unused, const void *data __unused,
+		   size_t count __unused ) {
+	return 0;
+}
+
+#endif /* _BITS_SHA1_H */
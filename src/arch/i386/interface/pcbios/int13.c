@@ -26,6 +26,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <assert.h>
 #include <ipxe/list.h>
 #include <ipxe/blockdev.h>
+#include <ipxe/blockcache.h>
 #include <ipxe/io.h>
 #include <ipxe/open.h>
 #include <ipxe/uri.h>
@@ -63,6 +64,36 @@ FILE_LICENCE ( GPL2_OR_LATER );
  */
 #define INT13_COMMAND_TIMEOUT ( 15 * TICKS_PER_SEC )
 
+/**
+ * Maximum number of concurrently outstanding INT 13 commands
+ *
+ * A single INT 13 read or write is split into fragments of at most
+ * the underlying device's maximum transfer size.  Fragments are
+ * issued for as long as the underlying device's window remains open,
+ * up to this limit.
+ */
+#define INT13_MAX_COMMANDS 8
+
+/**
+ * Interval between reports of INT 13 drive statistics
+ *
+ * A successfully SAN-booted drive is never unhooked, so statistics
+ * are also reported periodically while the drive is in use.
+ */
+#define INT13_STATS_INTERVAL ( 10 * TICKS_PER_SEC )
+
+/** INT 13 emulated drive I/O statistics */
+struct int13_statistics {
+	/** Number of read/write commands issued */
+	unsigned long commands;
+	/** Maximum number of read/write commands outstanding at once */
+	unsigned int max_outstanding;
+	/** Total latency of completed read/write commands (in ticks) */
+	unsigned long total_latency;
+	/** Maximum latency of a completed read/write command (in ticks) */
+	unsigned long max_latency;
+};
+
 /** An INT 13 emulated drive */
 struct int13_drive {
 	/** Reference count */
@@ -121,6 +152,12 @@ struct int13_drive {
 	int block_rc;
 	/** Status of last operation */
 	int last_status;
+	/** I/O statistics */
+	struct int13_statistics stats;
+	/** Block cache */
+	struct block_cache cache;
+	/** Time at which statistics were last reported */
+	unsigned long stats_reported;
 };
 
 /** Vector for chaining to other INT 13 handlers */
@@ -152,6 +189,8 @@ struct int13_command {
 	struct interface block;
 	/** Command timeout timer */
 	struct retry_timer timer;
+	/** Time at which command was issued */
+	unsigned long started;
 };
 
 /**
@@ -292,12 +331,34 @@ static void int13_command_stop ( struct int13_command *command ) {
 	command->int13 = NULL;
 }
 
-/** The single active INT 13 command */
-static struct int13_command int13_command = {
-	.block = INTF_INIT ( int13_command_desc ),
-	.timer = TIMER_INIT ( int13_command_expired ),
+/** The INT 13 commands */
+static struct int13_command int13_commands[INT13_MAX_COMMANDS] = {
+	[ 0 ... ( INT13_MAX_COMMANDS - 1 ) ] = {
+		.block = INTF_INIT ( int13_command_desc ),
+		.timer = TIMER_INIT ( int13_command_expired ),
+	},
 };
 
+/**
+ * Abort all outstanding INT 13 commands for a drive
+ *
+ * @v int13		Emulated drive
+ * @v rc		Reason for abort
+ */
+static void int13_command_abort ( struct int13_drive *int13, int rc ) {
+	struct int13_command *command;
+	unsigned int i;
+
+	for ( i = 0 ; i < INT13_MAX_COMMANDS ; i++ ) {
+		command = &int13_commands[i];
+		if ( command->int13 != int13 )
+			continue;
+		if ( command->rc == -EINPROGRESS )
+			int13_command_close ( command, rc );
+		int13_command_stop ( command );
+	}
+}
+
 /**
  * Read from or write to INT 13 drive
  *
@@ -314,37 +375,100 @@ static int int13_rw ( struct int13_drive *int13, uint64_t lba,
 					   struct interface *data,
 					   uint64_t lba, unsigned int count,
 					   userptr_t buffer, size_t len ) ) {
-	struct int13_command *command = &int13_command;
+	struct int13_statistics *stats = &int13->stats;
+	struct int13_command *command;
+	unsigned int outstanding = 0;
 	unsigned int frag_count;
+	unsigned long latency;
+	unsigned long idle;
+	unsigned int i;
 	size_t frag_len;
 	int rc;
 
-	while ( count ) {
+	/* Reopen block device if necessary */
+	if ( ( int13->block_rc != 0 ) &&
+	     ( ( rc = int13_reopen_block ( int13 ) ) != 0 ) )
+		return rc;
 
-		/* Determine fragment length */
-		frag_count = count;
-		if ( frag_count > int13->capacity.max_count )
-			frag_count = int13->capacity.max_count;
-		frag_len = ( int13->capacity.blksize * frag_count );
+	idle = currticks();
+	while ( count || outstanding ) {
+
+		/* Issue as many fragments as the block device will accept */
+		for ( i = 0 ; count && ( i < INT13_MAX_COMMANDS ) ; i++ ) {
+			command = &int13_commands[i];
+			if ( command->int13 )
+				continue;
+			if ( xfer_window ( &int13->block ) == 0 )
+				break;
+
+			/* Determine fragment length */
+			frag_count = count;
+			if ( frag_count > int13->capacity.max_count )
+				frag_count = int13->capacity.max_count;
+			frag_len = ( int13->capacity.blksize * frag_count );
+
+			/* Issue command */
+			command->rc = -EINPROGRESS;
+			command->int13 = int13;
+			command->started = currticks();
+			start_timer_fixed ( &command->timer,
+					    INT13_COMMAND_TIMEOUT );
+			if ( ( rc = block_rw ( &int13->block, &command->block,
+					       lba, frag_count, buffer,
+					       frag_len ) ) != 0 ) {
+				int13_command_stop ( command );
+				goto err;
+			}
+			stats->commands++;
+			if ( ++outstanding > stats->max_outstanding )
+				stats->max_outstanding = outstanding;
+
+			/* Move to next fragment */
+			lba += frag_count;
+			count -= frag_count;
+			buffer = userptr_add ( buffer, frag_len );
+		}
 
-		/* Issue command */
-		if ( ( ( rc = int13_command_start ( command, int13 ) ) != 0 ) ||
-		     ( ( rc = block_rw ( &int13->block, &command->block, lba,
-					 frag_count, buffer,
-					 frag_len ) ) != 0 ) ||
-		     ( ( rc = int13_command_wait ( command ) ) != 0 ) ) {
-			int13_command_stop ( command );
-			return rc;
+		/* If nothing is in flight, then the block device is
+		 * refusing to accept commands.  Fail immediately if it
+		 * has been closed, and eventually if it remains stuck.
+		 */
+		if ( ! outstanding ) {
+			if ( ( rc = int13->block_rc ) != 0 )
+				goto err;
+			if ( ( currticks() - idle ) >= INT13_COMMAND_TIMEOUT ) {
+				rc = -ETIMEDOUT;
+				goto err;
+			}
 		}
-		int13_command_stop ( command );
 
-		/* Move to next fragment */
-		lba += frag_count;
-		count -= frag_count;
-		buffer = userptr_add ( buffer, frag_len );
+		/* Allow commands to progress */
+		step();
+
+		/* Collect completed fragments */
+		for ( i = 0 ; i < INT13_MAX_COMMANDS ; i++ ) {
+			command = &int13_commands[i];
+			if ( ( command->int13 != int13 ) ||
+			     ( command->rc == -EINPROGRESS ) )
+				continue;
+			idle = currticks();
+			latency = ( idle - command->started );
+			stats->total_latency += latency;
+			if ( latency > stats->max_latency )
+				stats->max_latency = latency;
+			rc = command->rc;
+			int13_command_stop ( command );
+			outstanding--;
+			if ( rc != 0 )
+				goto err;
+		}
 	}
 
 	return 0;
+
+ err:
+	int13_command_abort ( int13, -ECANCELED );
+	return rc;
 }
 
 /**
@@ -354,7 +478,7 @@ static int int13_rw ( struct int13_drive *int13, uint64_t lba,
  * @ret rc		Return status code
  */
 static int int13_read_capacity ( struct int13_drive *int13 ) {
-	struct int13_command *command = &int13_command;
+	struct int13_command *command = &int13_commands[0];
 	int rc;
 
 	/* Issue command */
@@ -367,6 +491,91 @@ static int int13_read_capacity ( struct int13_drive *int13 ) {
 	}
 
 	int13_command_stop ( command );
+
+	/* Resize block cache to match device */
+	block_cache_reset ( &int13->cache, &int13->capacity );
+
+	return 0;
+}
+
+/**
+ * Read from INT 13 drive on behalf of block cache
+ *
+ * @v cache		Block cache
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @ret rc		Return status code
+ */
+static int int13_cache_read ( struct block_cache *cache, uint64_t lba,
+			      unsigned int count, userptr_t buffer ) {
+	struct int13_drive *int13 =
+		container_of ( cache, struct int13_drive, cache );
+
+	return int13_rw ( int13, lba, count, buffer, block_read );
+}
+
+/**
+ * Report INT 13 drive statistics
+ *
+ * @v int13		Emulated drive
+ */
+static void int13_report_stats ( struct int13_drive *int13 ) {
+
+	DBGC ( int13, "INT13 drive %02x issued %ld commands (max %d "
+	       "outstanding), latency total %ld max %ld ticks\n",
+	       int13->drive, int13->stats.commands,
+	       int13->stats.max_outstanding, int13->stats.total_latency,
+	       int13->stats.max_latency );
+	DBGC ( int13, "INT13 drive %02x cache hits %ld misses %ld read-ahead "
+	       "%ld direct %ld copied %ld blocks\n", int13->drive,
+	       int13->cache.stats.hits, int13->cache.stats.misses,
+	       int13->cache.stats.readahead, int13->cache.stats.direct,
+	       int13->cache.stats.copied );
+	int13->stats_reported = currticks();
+}
+
+/**
+ * Read from or write to INT 13 drive via block cache
+ *
+ * @v int13		Emulated drive
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @v block_rw		Block read/write method
+ * @ret rc		Return status code
+ *
+ * Writes are passed straight through to the block device, and then
+ * update any cached copy of the data.
+ */
+static int int13_cached_rw ( struct int13_drive *int13, uint64_t lba,
+			     unsigned int count, userptr_t buffer,
+			     int ( * block_rw ) ( struct interface *control,
+						  struct interface *data,
+						  uint64_t lba,
+						  unsigned int count,
+						  userptr_t buffer,
+						  size_t len ) ) {
+	int rc;
+
+	/* Report statistics periodically, if debugging is enabled */
+	if ( DBG_LOG && ( ( currticks() - int13->stats_reported ) >=
+			  INT13_STATS_INTERVAL ) )
+		int13_report_stats ( int13 );
+
+	/* Satisfy reads from the cache where possible */
+	if ( block_rw == block_read )
+		return block_cache_read ( &int13->cache, lba, count, buffer );
+
+	/* Write through to block device */
+	if ( ( rc = int13_rw ( int13, lba, count, buffer,
+			       block_rw ) ) != 0 ) {
+		/* Device contents are now unknown */
+		block_cache_invalidate ( &int13->cache );
+		return rc;
+	}
+	block_cache_write ( &int13->cache, lba, count, buffer );
+
 	return 0;
 }
 
@@ -559,7 +768,8 @@ static int int13_rw_sectors ( struct int13_drive *int13,
 		count );
 
 	/* Read from / write to block device */
-	if ( ( rc = int13_rw ( int13, lba, count, buffer, block_rw ) ) != 0 ) {
+	if ( ( rc = int13_cached_rw ( int13, lba, count, buffer,
+				      block_rw ) ) != 0 ) {
 		DBGC ( int13, "INT13 drive %02x I/O failed: %s\n",
 		       int13->drive, strerror ( rc ) );
 		return -INT13_STATUS_READ_ERROR;
@@ -734,7 +944,8 @@ static int int13_extended_rw ( struct int13_drive *int13,
 	DBGC2 ( int13, " (count %ld)\n", count );
 
 	/* Read from / write to block device */
-	if ( ( rc = int13_rw ( int13, lba, count, buffer, block_rw ) ) != 0 ) {
+	if ( ( rc = int13_cached_rw ( int13, lba, count, buffer,
+				      block_rw ) ) != 0 ) {
 		DBGC ( int13, "INT13 drive %02x extended I/O failed: %s\n",
 		       int13->drive, strerror ( rc ) );
 		/* Record that no blocks were transferred successfully */
@@ -1156,6 +1367,7 @@ static void int13_free ( struct refcnt *refcnt ) {
 	struct int13_drive *int13 =
 		container_of ( refcnt, struct int13_drive, refcnt );
 
+	block_cache_fini ( &int13->cache );
 	uri_put ( int13->uri );
 	free ( int13 );
 }
@@ -1199,6 +1411,7 @@ static int int13_hook ( struct uri *uri, unsigned int drive ) {
 	}
 	ref_init ( &int13->refcnt, int13_free );
 	intf_init ( &int13->block, &int13_block_desc, &int13->refcnt );
+	block_cache_init ( &int13->cache, int13_cache_read );
 	int13->uri = uri_get ( uri );
 	int13->drive = drive;
 	int13->natural_drive = natural_drive;
@@ -1288,6 +1501,7 @@ static void int13_unhook ( unsigned int drive ) {
 	 */
 
 	DBGC ( int13, "INT13 drive %02x unregistered\n", int13->drive );
+	int13_report_stats ( int13 );
 
 	/* Unhook INT 13 vector if no more drives */
 	if ( list_empty ( &int13s ) ) {
@@ -1424,6 +1638,7 @@ static int int13_describe ( unsigned int drive ) {
 	       "table:\n", int13->drive );
 	DBGC_HDA ( int13, xbft_address, &xbftab,
 		   le32_to_cpu ( xbftab.acpi.length ) );
+	int13_report_stats ( int13 );
 
 	return 0;
 }
@@ -0,0 +1,74 @@
+#ifndef _IPXE_CPUID_H
+#define _IPXE_CPUID_H
+
+/** @file
+ *
+ * x86 CPU feature detection
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+
+/** Get vendor ID and largest standard function */
+#define CPUID_VENDOR_ID 0x00000000UL
+
+/** Get standard features */
+#define CPUID_FEATURES 0x00000001UL
+
+/** Carry-less multiplication instruction is supported */
+#define CPUID_FEATURES_INTEL_ECX_PCLMUL 0x00000002UL
+
+/** SSSE3 instructions are supported */
+#define CPUID_FEATURES_INTEL_ECX_SSSE3 0x00000200UL
+
+/** AES instructions are supported */
+#define CPUID_FEATURES_INTEL_ECX_AES 0x02000000UL
+
+/** Get structured extended features */
+#define CPUID_EXTENDED_FEATURES 0x00000007UL
+
+/** SHA instructions are supported */
+#define CPUID_EXTENDED_FEATURES_EBX_SHA 0x20000000UL
+
+/**
+ * Issue CPUID instruction
+ *
+ * @v function		CPUID function
+ * @v subfunction	CPUID subfunction
+ * @ret eax		Output value of %eax
+ * @ret ebx		Output value of %ebx
+ * @ret ecx		Output value of %ecx
+ * @ret edx		Output value of %edx
+ */
+static inline __attribute__ (( always_inline )) void
+cpuid ( uint32_t function, uint32_t subfunction, uint32_t *eax,
+	uint32_t *ebx, uint32_t *ecx, uint32_t *edx ) {
+
+	__asm__ ( "cpuid"
+		  : "=a" ( *eax ), "=b" ( *ebx ), "=c" ( *ecx ), "=d" ( *edx )
+		  : "0" ( function ), "2" ( subfunction ) );
+}
+
+/**
+ * Check whether a CPUID function is supported
+ *
+ * @v function		CPUID function
+ * @ret supported	Function is supported
+ *
+ * This must be called only on a CPU known to support CPUID (i.e. on
+ * anything capable of running 64-bit code).
+ */
+static inline int cpuid_supported ( uint32_t function ) {
+	uint32_t max_function;
+	uint32_t discard_b;
+	uint32_t discard_c;
+	uint32_t discard_d;
+
+	cpuid ( CPUID_VENDOR_ID, 0, &max_function, &discard_b, &discard_c,
+		&discard_d );
+	return ( function <= max_function );
+}
+
+#endif /* _IPXE_CPUID_H */
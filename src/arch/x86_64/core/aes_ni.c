@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2011 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+/** @file
+ *
+ * AES using the x86 AES instructions
+ *
+ * Round keys are loaded with unaligned moves on every round, since
+ * the cipher context carries no alignment guarantee.  Four blocks are
+ * processed in parallel where possible, to hide the latency of each
+ * AES round instruction.
+ */
+
+#include <stdint.h>
+#include <ipxe/cpuid.h>
+#include <ipxe/aes.h>
+#include <bits/aes.h>
+
+/**
+ * Check for AES instructions
+ *
+ * @ret supported	AES instructions are supported
+ */
+static int aes_ni_supported ( void ) {
+	static int supported = -1;
+	uint32_t eax;
+	uint32_t ebx;
+	uint32_t ecx;
+	uint32_t edx;
+
+	if ( supported < 0 ) {
+		cpuid ( CPUID_FEATURES, 0, &eax, &ebx, &ecx, &edx );
+		supported = ( ( ecx & CPUID_FEATURES_INTEL_ECX_AES ) ? 1 : 0 );
+	}
+	return supported;
+}
+
+/**
+ * Construct AES block processing function
+ *
+ * @v _name		Function name
+ * @v _round		Instruction for main rounds
+ * @v _last		Instruction for final round
+ */
+#define AES_NI_CRYPT( _name, _round, _last )				\
+static void _name ( const uint32_t *keys, unsigned int rounds,		\
+		    const void *src, void *dst, size_t count ) {	\
+	const uint32_t *key;						\
+	unsigned long remaining;					\
+									\
+	/* Process four blocks at a time */				\
+	for ( ; count >= 4 ; count -= 4 ) {				\
+		key = keys;						\
+		remaining = ( rounds - 1 );				\
+		__asm__ __volatile__ ( "movdqu (%0), %%xmm4\n\t"	\
+				       "movdqu 0(%2), %%xmm0\n\t"	\
+				       "movdqu 16(%2), %%xmm1\n\t"	\
+				       "movdqu 32(%2), %%xmm2\n\t"	\
+				       "movdqu 48(%2), %%xmm3\n\t"	\
+				       "pxor %%xmm4, %%xmm0\n\t"	\
+				       "pxor %%xmm4, %%xmm1\n\t"	\
+				       "pxor %%xmm4, %%xmm2\n\t"	\
+				       "pxor %%xmm4, %%xmm3\n\t"	\
+				       "\n1:\n\t"			\
+				       "add $16, %0\n\t"		\
+				       "movdqu (%0), %%xmm4\n\t"	\
+				       _round " %%xmm4, %%xmm0\n\t"	\
+				       _round " %%xmm4, %%xmm1\n\t"	\
+				       _round " %%xmm4, %%xmm2\n\t"	\
+				       _round " %%xmm4, %%xmm3\n\t"	\
+				       "dec %1\n\t"			\
+				       "jnz 1b\n\t"			\
+				       "movdqu 16(%0), %%xmm4\n\t"	\
+				       _last " %%xmm4, %%xmm0\n\t"	\
+				       _last " %%xmm4, %%xmm1\n\t"	\
+				       _last " %%xmm4, %%xmm2\n\t"	\
+				       _last " %%xmm4, %%xmm3\n\t"	\
+				       "movdqu %%xmm0, 0(%3)\n\t"	\
+				       "movdqu %%xmm1, 16(%3)\n\t"	\
+				       "movdqu %%xmm2, 32(%3)\n\t"	\
+				       "movdqu %%xmm3, 48(%3)\n\t"	\
+				       : "+r" ( key ), "+r" ( remaining ) \
+				       : "r" ( src ), "r" ( dst )	\
+				       : "xmm0", "xmm1", "xmm2",	\
+					 "xmm3", "xmm4", "memory" );	\
+		src += ( 4 * AES_BLOCKSIZE );				\
+		dst += ( 4 * AES_BLOCKSIZE );				\
+	}								\
+									\
+	/* Process any remaining blocks individually */			\
+	for ( ; count ; count-- ) {					\
+		key = keys;						\
+		remaining = ( rounds - 1 );				\
+		__asm__ __volatile__ ( "movdqu (%0), %%xmm4\n\t"	\
+				       "movdqu (%2), %%xmm0\n\t"	\
+				       "pxor %%xmm4, %%xmm0\n\t"	\
+				       "\n1:\n\t"			\
+				       "add $16, %0\n\t"		\
+				       "movdqu (%0), %%xmm4\n\t"	\
+				       _round " %%xmm4, %%xmm0\n\t"	\
+				       "dec %1\n\t"			\
+				       "jnz 1b\n\t"			\
+				       "movdqu 16(%0), %%xmm4\n\t"	\
+				       _last " %%xmm4, %%xmm0\n\t"	\
+				       "movdqu %%xmm0, (%3)\n\t"	\
+				       : "+r" ( key ), "+r" ( remaining ) \
+				       : "r" ( src ), "r" ( dst )	\
+				       : "xmm0", "xmm4", "memory" );	\
+		src += AES_BLOCKSIZE;					\
+		dst += AES_BLOCKSIZE;					\
+	}								\
+}
+
+/** Encrypt blocks using the AES instructions */
+AES_NI_CRYPT ( aes_ni_encrypt, "aesenc", "aesenclast" );
+
+/** Decrypt blocks using the AES instructions */
+AES_NI_CRYPT ( aes_ni_decrypt, "aesdec", "aesdeclast" );
+
+/**
+ * Encrypt blocks
+ *
+ * @v keys		Encryption key schedule
+ * @v rounds		Number of rounds
+ * @v src		Data to encrypt
+ * @v dst		Buffer for encrypted data
+ * @v count		Number of blocks
+ * @ret count		Number of blocks processed
+ *
+ * Returns zero (having processed nothing) if the CPU does not support
+ * the AES instructions.
+ */
+size_t aes_arch_encrypt ( const uint32_t *keys, unsigned int rounds,
+			  const void *src, void *dst, size_t count ) {
+
+	if ( ! ( count && aes_ni_supported() ) )
+		return 0;
+	aes_ni_encrypt ( keys, rounds, src, dst, count );
+	return count;
+}
+
+/**
+ * Decrypt blocks
+ *
+ * @v keys		Decryption key schedule (for the equivalent
+ *			inverse cipher)
+ * @v rounds		Number of rounds
+ * @v src		Data to decrypt
+ * @v dst		Buffer for decrypted data
+ * @v count		Number of blocks
+ * @ret count		Number of blocks processed
+ *
+ * Returns zero (having processed nothing) if the CPU does not support
+ * the AES instructions.
+ */
+size_t aes_arch_decrypt ( const uint32_t *keys, unsigned int rounds,
+			  const void *src, void *dst, size_t count ) {
+
+	if ( ! ( count && aes_ni_supported() ) )
+		return 0;
+	aes_ni_decrypt ( keys, rounds, src, dst, count );
+	return count;
+}
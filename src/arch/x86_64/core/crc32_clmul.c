@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2011 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+/** @file
+ *
+ * CRC32 using the x86 carry-less multiplication instruction
+ *
+ * Data is folded 64 bytes at a time into four 128-bit accumulators,
+ * which are then folded into a single accumulator and reduced to a
+ * 32-bit CRC using Barrett reduction.  This is the technique
+ * described in Intel's "Fast CRC Computation for Generic Polynomials
+ * Using PCLMULQDQ Instruction" white paper, using the folding
+ * constants for the bit-reflected polynomial 0xedb88320.
+ */
+
+#include <stdint.h>
+#include <ipxe/cpuid.h>
+#include <bits/crc32.h>
+
+/** Minimum length of data worth processing with PCLMULQDQ */
+#define CRC32_CLMUL_MIN_LEN 64
+
+/** Length of data processed by each PCLMULQDQ fold */
+#define CRC32_CLMUL_FOLD_LEN 16
+
+/**
+ * Folding and reduction constants
+ *
+ * Each constant occupies one 128-bit slot, low quadword first:
+ *
+ *   - x^(4*128+32) and x^(4*128-32) mod P, for 64-byte folding
+ *   - x^(128+32) and x^(128-32) mod P, for 16-byte folding
+ *   - x^64 mod P, for the 64-to-32-bit fold
+ *   - a 32-bit mask
+ *   - P and floor(x^64/P), for Barrett reduction
+ */
+static const uint64_t crc32_clmul_constants[10]
+	__attribute__ (( aligned ( 16 ) )) = {
+	0x0000000154442bd4ULL, 0x00000001c6e41596ULL,
+	0x00000001751997d0ULL, 0x00000000ccaa009eULL,
+	0x0000000163cd6124ULL, 0x0000000000000000ULL,
+	0x00000000ffffffffULL, 0x0000000000000000ULL,
+	0x00000001db710641ULL, 0x00000001f7011641ULL,
+};
+
+/**
+ * Check for carry-less multiplication instruction
+ *
+ * @ret supported	PCLMULQDQ is supported
+ */
+static int crc32_clmul_supported ( void ) {
+	static int supported = -1;
+	uint32_t eax;
+	uint32_t ebx;
+	uint32_t ecx;
+	uint32_t edx;
+
+	if ( supported < 0 ) {
+		cpuid ( CPUID_FEATURES, 0, &eax, &ebx, &ecx, &edx );
+		supported = ( ( ecx & CPUID_FEATURES_INTEL_ECX_PCLMUL ) ?
+			      1 : 0 );
+	}
+	return supported;
+}
+
+/**
+ * Calculate 32-bit little-endian CRC checksum using PCLMULQDQ
+ *
+ * @v crc		Initial value
+ * @v data		Data to checksum
+ * @v len		Length of data (a multiple of 16, at least 64)
+ * @ret crc		Updated CRC
+ */
+static uint32_t crc32_clmul ( uint32_t crc, const void *data, size_t len ) {
+
+	__asm__ __volatile__ ( /* Load first 64 bytes and merge in CRC */
+			       "movdqu 0x00(%1), %%xmm1\n\t"
+			       "movdqu 0x10(%1), %%xmm2\n\t"
+			       "movdqu 0x20(%1), %%xmm3\n\t"
+			       "movdqu 0x30(%1), %%xmm4\n\t"
+			       "movd %k0, %%xmm0\n\t"
+			       "pxor %%xmm0, %%xmm1\n\t"
+			       "sub $0x40, %2\n\t"
+			       "add $0x40, %1\n\t"
+			       "movdqa 0x00(%3), %%xmm0\n\t"
+			       "cmp $0x40, %2\n\t"
+			       "jb 2f\n\t"
+			       /* Fold 64 bytes at a time */
+			       "\n1:\n\t"
+			       "movdqa %%xmm1, %%xmm5\n\t"
+			       "movdqa %%xmm2, %%xmm6\n\t"
+			       "movdqa %%xmm3, %%xmm7\n\t"
+			       "movdqa %%xmm4, %%xmm8\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm2\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm3\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm4\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm6\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm7\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm8\n\t"
+			       "pxor %%xmm5, %%xmm1\n\t"
+			       "pxor %%xmm6, %%xmm2\n\t"
+			       "pxor %%xmm7, %%xmm3\n\t"
+			       "pxor %%xmm8, %%xmm4\n\t"
+			       "movdqu 0x00(%1), %%xmm5\n\t"
+			       "movdqu 0x10(%1), %%xmm6\n\t"
+			       "movdqu 0x20(%1), %%xmm7\n\t"
+			       "movdqu 0x30(%1), %%xmm8\n\t"
+			       "pxor %%xmm5, %%xmm1\n\t"
+			       "pxor %%xmm6, %%xmm2\n\t"
+			       "pxor %%xmm7, %%xmm3\n\t"
+			       "pxor %%xmm8, %%xmm4\n\t"
+			       "sub $0x40, %2\n\t"
+			       "add $0x40, %1\n\t"
+			       "cmp $0x40, %2\n\t"
+			       "jae 1b\n\t"
+			       /* Fold four accumulators into one */
+			       "\n2:\n\t"
+			       "movdqa 0x10(%3), %%xmm0\n\t"
+			       "movdqa %%xmm1, %%xmm5\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm1\n\t"
+			       "pxor %%xmm2, %%xmm1\n\t"
+			       "movdqa %%xmm1, %%xmm5\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm1\n\t"
+			       "pxor %%xmm3, %%xmm1\n\t"
+			       "movdqa %%xmm1, %%xmm5\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm1\n\t"
+			       "pxor %%xmm4, %%xmm1\n\t"
+			       "cmp $0x10, %2\n\t"
+			       "jb 4f\n\t"
+			       /* Fold remaining data 16 bytes at a time */
+			       "\n3:\n\t"
+			       "movdqa %%xmm1, %%xmm5\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm1\n\t"
+			       "movdqu (%1), %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm1\n\t"
+			       "sub $0x10, %2\n\t"
+			       "add $0x10, %1\n\t"
+			       "cmp $0x10, %2\n\t"
+			       "jae 3b\n\t"
+			       /* Fold 128 bits to 64 bits */
+			       "\n4:\n\t"
+			       "pclmulqdq $0x01, %%xmm1, %%xmm0\n\t"
+			       "psrldq $0x08, %%xmm1\n\t"
+			       "pxor %%xmm0, %%xmm1\n\t"
+			       /* Fold 64 bits to 32 bits */
+			       "movdqa %%xmm1, %%xmm2\n\t"
+			       "movdqa 0x20(%3), %%xmm0\n\t"
+			       "movdqa 0x30(%3), %%xmm3\n\t"
+			       "psrldq $0x04, %%xmm2\n\t"
+			       "pand %%xmm3, %%xmm1\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+			       "pxor %%xmm2, %%xmm1\n\t"
+			       /* Barrett reduction */
+			       "movdqa 0x40(%3), %%xmm0\n\t"
+			       "movdqa %%xmm1, %%xmm2\n\t"
+			       "pand %%xmm3, %%xmm1\n\t"
+			       "pclmulqdq $0x10, %%xmm0, %%xmm1\n\t"
+			       "pand %%xmm3, %%xmm1\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+			       "pxor %%xmm2, %%xmm1\n\t"
+			       "psrldq $0x04, %%xmm1\n\t"
+			       "movd %%xmm1, %k0\n\t"
+			       : "+r" ( crc ), "+r" ( data ), "+r" ( len )
+			       : "r" ( crc32_clmul_constants )
+			       : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4",
+				 "xmm5", "xmm6", "xmm7", "xmm8", "memory" );
+	return crc;
+}
+
+/**
+ * Calculate 32-bit little-endian CRC checksum
+ *
+ * @v crc		CRC to update
+ * @v data		Data to checksum
+ * @v len		Length of data
+ * @ret len		Length of data processed
+ *
+ * Processes the longest multiple of 16 bytes from the start of the
+ * data.  Returns zero (having processed nothing) if the data is too
+ * short or if the CPU does not support the PCLMULQDQ instruction.
+ */
+size_t crc32_arch_le ( uint32_t *crc, const void *data, size_t len ) {
+
+	if ( ( len < CRC32_CLMUL_MIN_LEN ) || ! crc32_clmul_supported() )
+		return 0;
+	len &= ~( CRC32_CLMUL_FOLD_LEN - 1 );
+	*crc = crc32_clmul ( *crc, data, len );
+	return len;
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2011 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+/** @file
+ *
+ * SHA-1 using the x86 SHA extensions
+ *
+ */
+
+#include <stdint.h>
+#include <ipxe/cpuid.h>
+#include <ipxe/sha1.h>
+#include <bits/sha1.h>
+
+/** Byte-reversal mask for PSHUFB */
+static const uint8_t sha1_ni_bswap[16] = {
+	15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0
+};
+
+/**
+ * Check for SHA extensions
+ *
+ * @ret supported	SHA extensions are supported
+ */
+static int sha1_ni_supported ( void ) {
+	static int supported = -1;
+	uint32_t eax;
+	uint32_t ebx;
+	uint32_t ecx;
+	uint32_t edx;
+
+	if ( supported < 0 ) {
+		supported = 0;
+		if ( cpuid_supported ( CPUID_EXTENDED_FEATURES ) ) {
+			cpuid ( CPUID_FEATURES, 0, &eax, &ebx, &ecx, &edx );
+			if ( ecx & CPUID_FEATURES_INTEL_ECX_SSSE3 ) {
+				cpuid ( CPUID_EXTENDED_FEATURES, 0,
+					&eax, &ebx, &ecx, &edx );
+				if ( ebx & CPUID_EXTENDED_FEATURES_EBX_SHA )
+					supported = 1;
+			}
+		}
+	}
+	return supported;
+}
+
+/**
+ * Calculate SHA-1 digest of complete blocks using the SHA extensions
+ *
+ * @v hash		Digest state
+ * @v data		Data
+ * @v count		Number of blocks
+ * @ret count		Number of blocks processed
+ *
+ * Returns zero (having processed nothing) if the CPU does not support
+ * the SHA extensions.
+ */
+size_t sha1_arch_blocks ( uint32_t *hash, const void *data, size_t count ) {
+	size_t remaining = count;
+
+	if ( ! ( count && sha1_ni_supported() ) )
+		return 0;
+
+	__asm__ __volatile__ ( /* Load state as ABCD and E */
+		       "movdqu (%0), %%xmm0\n\t"
+		       "pshufd $0x1b, %%xmm0, %%xmm0\n\t"
+		       "movd 16(%0), %%xmm1\n\t"
+		       "pslldq $12, %%xmm1\n\t"
+		       "movdqu %3, %%xmm7\n\t"
+		       "\n1:\n\t"
+		       /* Save state */
+		       "movdqa %%xmm0, %%xmm8\n\t"
+		       "movdqa %%xmm1, %%xmm9\n\t"
+		       /* Rounds 0-3 */
+		       "movdqu 0(%1), %%xmm3\n\t"
+		       "pshufb %%xmm7, %%xmm3\n\t"
+		       "paddd %%xmm3, %%xmm1\n\t"
+		       "movdqa %%xmm0, %%xmm2\n\t"
+		       "sha1rnds4 $0, %%xmm1, %%xmm0\n\t"
+		       /* Rounds 4-7 */
+		       "movdqu 16(%1), %%xmm4\n\t"
+		       "pshufb %%xmm7, %%xmm4\n\t"
+		       "sha1nexte %%xmm4, %%xmm2\n\t"
+		       "movdqa %%xmm0, %%xmm1\n\t"
+		       "sha1rnds4 $0, %%xmm2, %%xmm0\n\t"
+		       "sha1msg1 %%xmm4, %%xmm3\n\t"
+		       /* Rounds 8-11 */
+		       "movdqu 32(%1), %%xmm5\n\t"
+		       "pshufb %%xmm7, %%xmm5\n\t"
+		       "sha1nexte %%xmm5, %%xmm1\n\t"
+		       "movdqa %%xmm0, %%xmm2\n\t"
+		       "sha1rnds4 $0, %%xmm1, %%xmm0\n\t"
+		       "sha1msg1 %%xmm5, %%xmm4\n\t"
+		       "pxor %%xmm5, %%xmm3\n\t"
+		       /* Rounds 12-15 */
+		       "movdqu 48(%1), %%xmm6\n\t"
+		       "pshufb %%xmm7, %%xmm6\n\t"
+		       "sha1nexte %%xmm6, %%xmm2\n\t"
+		       "movdqa %%xmm0, %%xmm1\n\t"
+		       "sha1msg2 %%xmm6, %%xmm3\n\t"
+		       "sha1rnds4 $0, %%xmm2, %%xmm0\n\t"
+		       "sha1msg1 %%xmm6, %%xmm5\n\t"
+		       "pxor %%xmm6, %%xmm4\n\t"
+		       /* Rounds 16-19 */
+		       "sha1nexte %%xmm3, %%xmm1\n\t"
+		       "movdqa %%xmm0, %%xmm2\n\t"
+		       "sha1msg2 %%xmm3, %%xmm4\n\t"
+		       "sha1rnds4 $0, %%xmm1, %%xmm0\n\t"
+		       "sha1msg1 %%xmm3, %%xmm6\n\t"
+		       "pxor %%xmm3, %%xmm5\n\t"
+		       /* Rounds 20-23 */
+		       "sha1nexte %%xmm4, %%xmm2\n\t"
+		       "movdqa %%xmm0, %%xmm1\n\t"
+		       "sha1msg2 %%xmm4, %%xmm5\n\t"
+		       "sha1rnds4 $1, %%xmm2, %%xmm0\n\t"
+		       "sha1msg1 %%xmm4, %%xmm3\n\t"
+		       "pxor %%xmm4, %%xmm6\n\t"
+		       /* Rounds 24-27 */
+		       "sha1nexte %%xmm5, %%xmm1\n\t"
+		       "movdqa %%xmm0, %%xmm2\n\t"
+		       "sha1msg2 %%xmm5, %%xmm6\n\t"
+		       "sha1rnds4 $1, %%xmm1, %%xmm0\n\t"
+		       "sha1msg1 %%xmm5, %%xmm4\n\t"
+		       "pxor %%xmm5, %%xmm3\n\t"
+		       /* Rounds 28-31 */
+		       "sha1nexte %%xmm6, %%xmm2\n\t"
+		       "movdqa %%xmm0, %%xmm1\n\t"
+		       "sha1msg2 %%xmm6, %%xmm3\n\t"
+		       "sha1rnds4 $1, %%xmm2, %%xmm0\n\t"
+		       "sha1msg1 %%xmm6, %%xmm5\n\t"
+		       "pxor %%xmm6, %%xmm4\n\t"
+		       /* Rounds 32-35 */
+		       "sha1nexte %%xmm3, %%xmm1\n\t"
+		       "movdqa %%xmm0, %%xmm2\n\t"
+		       "sha1msg2 %%xmm3, %%xmm4\n\t"
+		       "sha1rnds4 $1, %%xmm1, %%xmm0\n\t"
+		       "sha1msg1 %%xmm3, %%xmm6\n\t"
+		       "pxor %%xmm3, %%xmm5\n\t"
+		       /* Rounds 36-39 */
+		       "sha1nexte %%xmm4, %%xmm2\n\t"
+		       "movdqa %%xmm0, %%xmm1\n\t"
+		       "sha1msg2 %%xmm4, %%xmm5\n\t"
+		       "sha1rnds4 $1, %%xmm2, %%xmm0\n\t"
+		       "sha1msg1 %%xmm4, %%xmm3\n\t"
+		       "pxor %%xmm4, %%xmm6\n\t"
+		       /* Rounds 40-43 */
+		       "sha1nexte %%xmm5, %%xmm1\n\t"
+		       "movdqa %%xmm0, %%xmm2\n\t"
+		       "sha1msg2 %%xmm5, %%xmm6\n\t"
+		       "sha1rnds4 $2, %%xmm1, %%xmm0\n\t"
+		       "sha1msg1 %%xmm5, %%xmm4\n\t"
+		       "pxor %%xmm5, %%xmm3\n\t"
+		       /* Rounds 44-47 */
+		       "sha1nexte %%xmm6, %%xmm2\n\t"
+		       "movdqa %%xmm0, %%xmm1\n\t"
+		       "sha1msg2 %%xmm6, %%xmm3\n\t"
+		       "sha1rnds4 $2, %%xmm2, %%xmm0\n\t"
+		       "sha1msg1 %%xmm6, %%xmm5\n\t"
+		       "pxor %%xmm6, %%xmm4\n\t"
+		       /* Rounds 48-51 */
+		       "sha1nexte %%xmm3, %%xmm1\n\t"
+		       "movdqa %%xmm0, %%xmm2\n\t"
+		       "sha1msg2 %%xmm3, %%xmm4\n\t"
+		       "sha1rnds4 $2, %%xmm1, %%xmm0\n\t"
+		       "sha1msg1 %%xmm3, %%xmm6\n\t"
+		       "pxor %%xmm3, %%xmm5\n\t"
+		       /* Rounds 52-55 */
+		       "sha1nexte %%xmm4, %%xmm2\n\t"
+		       "movdqa %%xmm0, %%xmm1\n\t"
+		       "sha1msg2 %%xmm4, %%xmm5\n\t"
+		       "sha1rnds4 $2, %%xmm2, %%xmm0\n\t"
+		       "sha1msg1 %%xmm4, %%xmm3\n\t"
+		       "pxor %%xmm4, %%xmm6\n\t"
+		       /* Rounds 56-59 */
+		       "sha1nexte %%xmm5, %%xmm1\n\t"
+		       "movdqa %%xmm0, %%xmm2\n\t"
+		       "sha1msg2 %%xmm5, %%xmm6\n\t"
+		       "sha1rnds4 $2, %%xmm1, %%xmm0\n\t"
+		       "sha1msg1 %%xmm5, %%xmm4\n\t"
+		       "pxor %%xmm5, %%xmm3\n\t"
+		       /* Rounds 60-63 */
+		       "sha1nexte %%xmm6, %%xmm2\n\t"
+		       "movdqa %%xmm0, %%xmm1\n\t"
+		       "sha1msg2 %%xmm6, %%xmm3\n\t"
+		       "sha1rnds4 $3, %%xmm2, %%xmm0\n\t"
+		       "sha1msg1 %%xmm6, %%xmm5\n\t"
+		       "pxor %%xmm6, %%xmm4\n\t"
+		       /* Rounds 64-67 */
+		       "sha1nexte %%xmm3, %%xmm1\n\t"
+		       "movdqa %%xmm0, %%xmm2\n\t"
+		       "sha1msg2 %%xmm3, %%xmm4\n\t"
+		       "sha1rnds4 $3, %%xmm1, %%xmm0\n\t"
+		       "sha1msg1 %%xmm3, %%xmm6\n\t"
+		       "pxor %%xmm3, %%xmm5\n\t"
+		       /* Rounds 68-71 */
+		       "sha1nexte %%xmm4, %%xmm2\n\t"
+		       "movdqa %%xmm0, %%xmm1\n\t"
+		       "sha1msg2 %%xmm4, %%xmm5\n\t"
+		       "sha1rnds4 $3, %%xmm2, %%xmm0\n\t"
+		       "pxor %%xmm4, %%xmm6\n\t"
+		       /* Rounds 72-75 */
+		       "sha1nexte %%xmm5, %%xmm1\n\t"
+		       "movdqa %%xmm0, %%xmm2\n\t"
+		       "sha1msg2 %%xmm5, %%xmm6\n\t"
+		       "sha1rnds4 $3, %%xmm1, %%xmm0\n\t"
+		       /* Rounds 76-79 */
+		       "sha1nexte %%xmm6, %%xmm2\n\t"
+		       "movdqa %%xmm0, %%xmm1\n\t"
+		       "sha1rnds4 $3, %%xmm2, %%xmm0\n\t"
+		       /* Accumulate state */
+		       "sha1nexte %%xmm9, %%xmm1\n\t"
+		       "paddd %%xmm8, %%xmm0\n\t"
+		       /* Move to next block */
+		       "addq $64, %1\n\t"
+		       "decq %2\n\t"
+		       "jnz 1b\n\t"
+		       /* Store state */
+		       "pshufd $0x1b, %%xmm0, %%xmm0\n\t"
+		       "movdqu %%xmm0, (%0)\n\t"
+		       "psrldq $12, %%xmm1\n\t"
+		       "movd %%xmm1, 16(%0)\n\t"
+		       : "+r" ( hash ), "+r" ( data ), "+r" ( remaining )
+		       : "m" ( sha1_ni_bswap )
+		       : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5",
+			 "xmm6", "xmm7", "xmm8", "xmm9", "memory" );
+
+	return count;
+}
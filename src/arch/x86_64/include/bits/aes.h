@@ -0,0 +1,20 @@
+#ifndef _BITS_AES_H
+#define _BITS_AES_H
+
+/** @file
+ *
+ * x86_64-specific AES implementation
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stddef.h>
+
+extern size_t aes_arch_encrypt ( const uint32_t *keys, unsigned int rounds,
+				 const void *src, void *dst, size_t count );
+extern size_t aes_arch_decrypt ( const uint32_t *keys, unsigned int rounds,
+				 const void *src, void *dst, size_t count );
+
+#endif /* _BITS_AES_H */
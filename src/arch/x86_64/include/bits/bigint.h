@@ -0,0 +1,20 @@
+#ifndef _BITS_BIGINT_H
+#define _BITS_BIGINT_H
+
+/** @file
+ *
+ * Big integer support
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+
+/** Element of a big integer */
+typedef uint64_t bigint_element_t;
+
+/** Double-width element, large enough to hold the product of two elements */
+typedef unsigned __int128 bigint_wide_t;
+
+#endif /* _BITS_BIGINT_H */
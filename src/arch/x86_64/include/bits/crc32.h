@@ -0,0 +1,17 @@
+#ifndef _BITS_CRC32_H
+#define _BITS_CRC32_H
+
+/** @file
+ *
+ * x86_64-specific CRC32 implementation
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stddef.h>
+
+extern size_t crc32_arch_le ( uint32_t *crc, const void *data, size_t len );
+
+#endif /* _BITS_CRC32_H */
@@ -0,0 +1,18 @@
+#ifndef _BITS_SHA1_H
+#define _BITS_SHA1_H
+
+/** @file
+ *
+ * x86_64-specific SHA-1 implementation
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stddef.h>
+
+extern size_t sha1_arch_blocks ( uint32_t *hash, const void *data,
+				 size_t count );
+
+#endif /* _BITS_SHA1_H */
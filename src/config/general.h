@@ -121,7 +121,8 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #define SANBOOT_CMD		/* SAN boot commands */
 #define LOGIN_CMD		/* Login command */
 #undef	TIME_CMD		/* Time commands */
-#undef	DIGEST_CMD		/* Image crypto digest commands */
+#undef	DIGEST_CMD		/* Image crypto digest commands (also
+				 * enables "imgfetch --digest") */
 #undef	LOTEST_CMD		/* Loopback testing commands */
 #undef	VLAN_CMD		/* VLAN commands */
 #undef	PXE_CMD			/* PXE commands */
@@ -141,6 +142,31 @@ FILE_LICENCE ( GPL2_OR_LATER );
  */
 
 #define	NETDEV_DISCARD_RATE 0	/* Drop every N packets (0=>no drop) */
+#define	NETDEV_RX_BATCH 16	/* Max. packets processed per network
+				 * device per poll (may be overridden
+				 * via the "rx-batch" setting) */
+#define	HTTP_PIPELINE 1		/* Max. HTTP requests outstanding per
+				 * connection (1=>no pipelining) */
+#define	HTTP_SEGMENTS 4		/* Max. parallel HTTP range requests
+				 * per download (1=>no segmentation) */
+#define	NEIGHBOUR_CACHE_SIZE 16	/* Max. ARP/NDP neighbour cache entries */
+#define	DNS_CACHE_SIZE 16	/* Max. DNS cache entries (0=>no cache) */
+#define	DNS_CACHE_TTL 300	/* Max. lifetime of cached DNS results, in
+				 * seconds (may be overridden via the
+				 * "dns-cache-ttl" setting) */
+#define	E1000_NUM_TX_DESC 16	/* e1000/e1000e/igb TX ring size (power
+				 * of two, min. 8) */
+#define	E1000_NUM_RX_DESC 32	/* e1000/e1000e/igb max. RX ring size
+				 * (power of two, min. 8; limited at
+				 * open time to half of the free heap) */
+#define	BLOCK_CACHE_SIZE 256	/* SAN block cache size, in kB (0=>no
+				 * cache) */
+#define	BLOCK_CACHE_READAHEAD 64 /* Max. SAN block read-ahead, in kB */
+#define	ISCSI_MAX_TASKS 8	/* Max. iSCSI commands outstanding per
+				 * session */
+#define	ISCSI_MAX_PDU_LEN 262144 /* Max. iSCSI PDU data segment length
+				 * (limited at login time to a quarter
+				 * of the free heap) */
 #undef	BUILD_SERIAL		/* Include an automatic build serial
 				 * number.  Add "bs" to the list of
 				 * make targets.  For example:
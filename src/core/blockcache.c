@@ -0,0 +1,502 @@
+/*
+ * Copyright (C) 2012 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <config/general.h>
+#include <ipxe/list.h>
+#include <ipxe/malloc.h>
+#include <ipxe/umalloc.h>
+#include <ipxe/blockcache.h>
+
+/** @file
+ *
+ * Block device cache
+ *
+ * The block cache sits between a consumer of a block device (such as
+ * an INT 13 emulated drive) and the underlying SAN transport, and
+ * holds recently read blocks in fixed-size cache lines.  Cache line
+ * data lives in external memory; only the line descriptors are
+ * allocated from the heap.
+ *
+ * Reads that continue where the previous read finished are treated
+ * as sequential, and trigger read-ahead of the following cache lines.
+ * The read-ahead window doubles with each consecutive sequential read
+ * (up to the size of the fill buffer) and collapses on any random
+ * access.  Any run of missing cache lines lying wholly within a read
+ * is placed directly into the caller's buffer rather than into the
+ * cache, so that large reads are not copied a second time via a cache
+ * line.  Writes are passed through to the underlying device by the
+ * consumer, and are then copied into any cache lines that they
+ * overlap.
+ *
+ * The cache storage may be discarded at any time while the cache is
+ * not in use, in which case it is reallocated on the next read.
+ */
+
+/** Preferred length of a cache line */
+#define BLOCK_CACHE_LINE_LEN 4096
+
+/** List of all block caches */
+static LIST_HEAD ( block_caches );
+
+/**
+ * Free block cache storage
+ *
+ * @v cache		Block cache
+ */
+static void block_cache_free ( struct block_cache *cache ) {
+
+	ufree ( cache->data );
+	cache->data = UNULL;
+	free ( cache->lines );
+	cache->lines = NULL;
+	INIT_LIST_HEAD ( &cache->lru );
+}
+
+/**
+ * Allocate block cache storage
+ *
+ * @v cache		Block cache
+ * @ret ok		Cache storage is available
+ */
+static int block_cache_alloc ( struct block_cache *cache ) {
+	unsigned int i;
+
+	/* Do nothing if already allocated */
+	if ( cache->lines )
+		return 1;
+
+	/* Fail if caching is disabled for this device */
+	if ( ! cache->num_lines )
+		return 0;
+
+	/* Allocate storage */
+	cache->lines = zalloc ( cache->num_lines *
+				sizeof ( cache->lines[0] ) );
+	if ( ! cache->lines )
+		goto err;
+	cache->data = umalloc ( ( cache->num_lines + cache->fill_lines ) *
+				cache->line_len );
+	if ( ! cache->data )
+		goto err;
+	for ( i = 0 ; i < cache->num_lines ; i++ )
+		list_add_tail ( &cache->lines[i].list, &cache->lru );
+
+	return 1;
+
+ err:
+	DBGC ( cache, "BLKCACHE %p could not allocate %d lines\n",
+	       cache, cache->num_lines );
+	block_cache_free ( cache );
+	return 0;
+}
+
+/**
+ * Get cache line data
+ *
+ * @v cache		Block cache
+ * @v line		Cache line
+ * @ret offset		Offset of line data within cache data
+ */
+static inline size_t block_cache_offset ( struct block_cache *cache,
+					  struct block_cache_line *line ) {
+	return ( ( line - cache->lines ) * cache->line_len );
+}
+
+/**
+ * Find cache line
+ *
+ * @v cache		Block cache
+ * @v lba		Starting logical block address of line
+ * @ret line		Cache line, or NULL if not cached
+ */
+static struct block_cache_line * block_cache_find ( struct block_cache *cache,
+						    uint64_t lba ) {
+	struct block_cache_line *line;
+
+	list_for_each_entry ( line, &cache->lru, list ) {
+		/* Invalid lines are always at the tail of the list */
+		if ( ! ( line->flags & BLOCK_CACHE_LINE_VALID ) )
+			break;
+		if ( line->lba == lba ) {
+			/* Mark as most recently used */
+			list_del ( &line->list );
+			list_add ( &line->list, &cache->lru );
+			return line;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Add cache line
+ *
+ * @v cache		Block cache
+ * @v lba		Starting logical block address of line
+ * @v src		Line data
+ * @v src_off		Offset of line data
+ * @ret line		Cache line
+ *
+ * The least recently used line is recycled.
+ */
+static struct block_cache_line * block_cache_add ( struct block_cache *cache,
+						   uint64_t lba, userptr_t src,
+						   off_t src_off ) {
+	struct block_cache_line *line;
+
+	line = list_entry ( cache->lru.prev, struct block_cache_line, list );
+	memcpy_user ( cache->data, block_cache_offset ( cache, line ),
+		      src, src_off, cache->line_len );
+	cache->stats.copied += cache->line_count;
+	line->lba = lba;
+	line->flags = BLOCK_CACHE_LINE_VALID;
+	list_del ( &line->list );
+	list_add ( &line->list, &cache->lru );
+	return line;
+}
+
+/**
+ * Copy overlapping part of a cache line into a read buffer
+ *
+ * @v cache		Block cache
+ * @v line_lba		Starting logical block address of line
+ * @v src		Line data
+ * @v src_off		Offset of line data
+ * @v lba		Starting logical block address of read
+ * @v count		Number of logical blocks in read
+ * @v buffer		Read buffer
+ * @ret copied		Number of blocks copied
+ */
+static unsigned int block_cache_copy ( struct block_cache *cache,
+				       uint64_t line_lba, userptr_t src,
+				       off_t src_off, uint64_t lba,
+				       unsigned int count, userptr_t buffer ) {
+	size_t blksize = cache->capacity.blksize;
+	uint64_t start = line_lba;
+	uint64_t end = ( line_lba + cache->line_count );
+
+	/* Clip to read */
+	if ( start < lba )
+		start = lba;
+	if ( end > ( lba + count ) )
+		end = ( lba + count );
+	if ( start >= end )
+		return 0;
+
+	memcpy_user ( buffer, ( ( start - lba ) * blksize ),
+		      src, ( src_off + ( ( start - line_lba ) * blksize ) ),
+		      ( ( end - start ) * blksize ) );
+	cache->stats.copied += ( end - start );
+	return ( end - start );
+}
+
+/**
+ * Initialise block cache
+ *
+ * @v cache		Block cache
+ * @v read		Underlying device read method
+ */
+void block_cache_init ( struct block_cache *cache,
+			int ( * read ) ( struct block_cache *cache,
+					 uint64_t lba, unsigned int count,
+					 userptr_t buffer ) ) {
+
+	memset ( cache, 0, sizeof ( *cache ) );
+	cache->read = read;
+	INIT_LIST_HEAD ( &cache->lru );
+	list_add ( &cache->list, &block_caches );
+}
+
+/**
+ * Reset block cache for a (possibly changed) underlying device
+ *
+ * @v cache		Block cache
+ * @v capacity		Underlying device capacity
+ *
+ * Any cached data is discarded.  Storage will be allocated on the
+ * next read.
+ */
+void block_cache_reset ( struct block_cache *cache,
+			 struct block_device_capacity *capacity ) {
+	size_t blksize = capacity->blksize;
+
+	/* Discard any existing storage */
+	block_cache_free ( cache );
+
+	/* Determine cache geometry */
+	memcpy ( &cache->capacity, capacity, sizeof ( cache->capacity ) );
+	cache->line_count = 1;
+	if ( blksize && ( blksize < BLOCK_CACHE_LINE_LEN ) )
+		cache->line_count = ( BLOCK_CACHE_LINE_LEN / blksize );
+	cache->line_len = ( cache->line_count * blksize );
+	cache->num_lines = ( blksize ?
+			     ( ( BLOCK_CACHE_SIZE * 1024 ) / cache->line_len ) :
+			     0 );
+	cache->fill_lines = ( ( BLOCK_CACHE_READAHEAD * 1024 ) /
+			      cache->line_len );
+	if ( ! cache->fill_lines )
+		cache->fill_lines = 1;
+	cache->next_lba = 0;
+	cache->readahead = 0;
+
+	DBGC ( cache, "BLKCACHE %p using %d lines of %d blocks (max %d "
+	       "read-ahead)\n", cache, cache->num_lines, cache->line_count,
+	       cache->fill_lines );
+}
+
+/**
+ * Invalidate block cache
+ *
+ * @v cache		Block cache
+ */
+void block_cache_invalidate ( struct block_cache *cache ) {
+	struct block_cache_line *line;
+
+	list_for_each_entry ( line, &cache->lru, list )
+		line->flags = 0;
+}
+
+/**
+ * Finalise block cache
+ *
+ * @v cache		Block cache
+ */
+void block_cache_fini ( struct block_cache *cache ) {
+
+	DBGC ( cache, "BLKCACHE %p hits %ld misses %ld read-ahead %ld "
+	       "discards %ld\n", cache, cache->stats.hits,
+	       cache->stats.misses, cache->stats.readahead,
+	       cache->stats.discards );
+	block_cache_free ( cache );
+	list_del ( &cache->list );
+}
+
+/**
+ * Read from block cache
+ *
+ * @v cache		Block cache
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @ret rc		Return status code
+ *
+ * Blocks not present in the cache are read from the underlying
+ * device a cache line at a time, together with any read-ahead.
+ * Whole missing lines within the read bypass the cache, and are read
+ * directly into the read buffer.
+ */
+int block_cache_read ( struct block_cache *cache, uint64_t lba,
+		       unsigned int count, userptr_t buffer ) {
+	struct block_cache_statistics *stats = &cache->stats;
+	unsigned int line_count = cache->line_count;
+	size_t blksize = cache->capacity.blksize;
+	struct block_cache_line *line;
+	uint64_t end = ( lba + count );
+	uint64_t line_lba;
+	uint64_t fill_end;
+	uint64_t direct_end;
+	uint64_t want_end;
+	uint64_t ahead;
+	unsigned int fill_count;
+	size_t fill_off;
+	size_t direct_off;
+	unsigned int i;
+	int rc;
+
+	/* Bypass cache for reads outside the device, or if no cache
+	 * storage is available.
+	 */
+	if ( ( end > cache->capacity.blocks ) || ( end < lba ) ||
+	     cache->busy || ( ! block_cache_alloc ( cache ) ) )
+		return cache->read ( cache, lba, count, buffer );
+	fill_off = ( cache->num_lines * cache->line_len );
+
+	/* Adapt read-ahead window to access pattern */
+	if ( lba == cache->next_lba ) {
+		cache->readahead = ( cache->readahead ?
+				     ( cache->readahead * 2 ) : 1 );
+		if ( cache->readahead > cache->fill_lines )
+			cache->readahead = cache->fill_lines;
+	} else {
+		cache->readahead = 0;
+	}
+	cache->next_lba = end;
+	want_end = ( end + ( cache->readahead * line_count ) );
+	if ( want_end > cache->capacity.blocks )
+		want_end = cache->capacity.blocks;
+
+	/* Prevent storage from being discarded while filling */
+	cache->busy = 1;
+
+	line_lba = ( lba - ( lba % line_count ) );
+	while ( line_lba < want_end ) {
+
+		/* Use cached line, if present */
+		if ( ( line = block_cache_find ( cache, line_lba ) ) ) {
+			stats->hits += block_cache_copy ( cache, line_lba,
+							  cache->data,
+							  block_cache_offset
+							  ( cache, line ),
+							  lba, count, buffer );
+			line_lba += line_count;
+			continue;
+		}
+
+		/* Determine run of missing lines */
+		fill_end = ( line_lba + line_count );
+		while ( ( fill_end < want_end ) &&
+			( ! block_cache_find ( cache, fill_end ) ) ) {
+			fill_end += line_count;
+		}
+		if ( fill_end > cache->capacity.blocks )
+			fill_end = cache->capacity.blocks;
+
+		/* Read any whole lines within the read directly into
+		 * the read buffer, bypassing the cache.
+		 */
+		direct_end = fill_end;
+		if ( direct_end > end )
+			direct_end = ( end - ( end % line_count ) );
+		if ( ( line_lba >= lba ) && ( direct_end > line_lba ) ) {
+			fill_count = ( direct_end - line_lba );
+			direct_off = ( ( line_lba - lba ) * blksize );
+			if ( ( rc = cache->read ( cache, line_lba, fill_count,
+						  userptr_add ( buffer,
+								direct_off ) ) )
+			     != 0 ) {
+				cache->busy = 0;
+				return rc;
+			}
+			stats->direct += fill_count;
+			line_lba = direct_end;
+			continue;
+		}
+
+		/* If the read starts part way into this line, fill only
+		 * this line, so that any following whole lines within
+		 * the read may then be read directly.
+		 */
+		if ( direct_end > ( line_lba + line_count ) )
+			fill_end = ( line_lba + line_count );
+
+		/* Limit remaining run to size of fill buffer */
+		if ( fill_end > ( line_lba + ( cache->fill_lines *
+					       line_count ) ) ) {
+			fill_end = ( line_lba + ( cache->fill_lines *
+						  line_count ) );
+		}
+		fill_count = ( fill_end - line_lba );
+
+		/* Read missing lines from underlying device */
+		if ( ( rc = cache->read ( cache, line_lba, fill_count,
+					  userptr_add ( cache->data,
+							fill_off ) ) )
+		     != 0 ) {
+			cache->busy = 0;
+			return rc;
+		}
+
+		/* Add lines to cache and copy out requested blocks */
+		for ( i = 0 ; line_lba < fill_end ; i++ ) {
+			line = block_cache_add ( cache, line_lba, cache->data,
+						 ( fill_off +
+						   ( i * cache->line_len ) ) );
+			stats->misses += block_cache_copy ( cache, line_lba,
+							    cache->data,
+							    block_cache_offset
+							    ( cache, line ),
+							    lba, count,
+							    buffer );
+			ahead = ( ( line_lba > end ) ? line_lba : end );
+			line_lba += line_count;
+			if ( line_lba > fill_end )
+				line_lba = fill_end;
+			if ( line_lba > ahead )
+				stats->readahead += ( line_lba - ahead );
+		}
+	}
+
+	cache->busy = 0;
+	return 0;
+}
+
+/**
+ * Update block cache following a write
+ *
+ * @v cache		Block cache
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ *
+ * The data must already have been written to the underlying device.
+ */
+void block_cache_write ( struct block_cache *cache, uint64_t lba,
+			 unsigned int count, userptr_t buffer ) {
+	size_t blksize = cache->capacity.blksize;
+	struct block_cache_line *line;
+	uint64_t end = ( lba + count );
+	uint64_t start;
+	uint64_t stop;
+
+	list_for_each_entry ( line, &cache->lru, list ) {
+		if ( ! ( line->flags & BLOCK_CACHE_LINE_VALID ) )
+			break;
+		start = line->lba;
+		stop = ( line->lba + cache->line_count );
+		if ( start < lba )
+			start = lba;
+		if ( stop > end )
+			stop = end;
+		if ( start >= stop )
+			continue;
+		memcpy_user ( cache->data, ( block_cache_offset ( cache, line )
+					     + ( ( start - line->lba ) *
+						 blksize ) ),
+			      buffer, ( ( start - lba ) * blksize ),
+			      ( ( stop - start ) * blksize ) );
+	}
+}
+
+/**
+ * Discard some cached data
+ *
+ * @ret discarded	Number of cached items discarded
+ */
+static unsigned int block_cache_discard ( void ) {
+	struct block_cache *cache;
+
+	/* Discard the storage of the first idle cache, if any */
+	list_for_each_entry ( cache, &block_caches, list ) {
+		if ( cache->busy || ( ! cache->lines ) )
+			continue;
+		DBGC ( cache, "BLKCACHE %p discarded\n", cache );
+		block_cache_free ( cache );
+		cache->stats.discards++;
+		return 1;
+	}
+	return 0;
+}
+
+/** Block cache discarder */
+struct cache_discarder block_cache_discarder __cache_discarder = {
+	.discard = block_cache_discard,
+};
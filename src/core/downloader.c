@@ -29,6 +29,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <ipxe/umalloc.h>
 #include <ipxe/image.h>
 #include <ipxe/downloader.h>
+#include <ipxe/imgdigest.h>
 
 /** @file
  *
@@ -36,6 +37,9 @@ FILE_LICENCE ( GPL2_OR_LATER );
  *
  */
 
+/** Minimum size of download buffer when growing without a size hint */
+#define DOWNLOADER_MIN_ALLOC 65536
+
 /** A downloader */
 struct downloader {
 	/** Reference count for this object */
@@ -50,6 +54,17 @@ struct downloader {
 	struct image *image;
 	/** Current position within image buffer */
 	size_t pos;
+	/** Allocated length of image buffer
+	 *
+	 * This may exceed the image length while the download is in
+	 * progress; the buffer is trimmed when the download finishes.
+	 */
+	size_t alloc;
+
+	/** Number of buffer reallocations */
+	unsigned int reallocs;
+	/** Number of bytes moved by buffer reallocations */
+	size_t copied;
 };
 
 /**
@@ -72,6 +87,20 @@ static void downloader_free ( struct refcnt *refcnt ) {
  * @v rc		Reason for termination
  */
 static void downloader_finished ( struct downloader *downloader, int rc ) {
+	struct image *image = downloader->image;
+	userptr_t new_buffer;
+
+	/* Trim any excess buffer space */
+	if ( downloader->alloc > image->len ) {
+		new_buffer = urealloc ( image->data, image->len );
+		if ( new_buffer || ( ! image->len ) ) {
+			image->data = new_buffer;
+			downloader->alloc = image->len;
+		}
+	}
+	DBGC ( downloader, "Downloader %p finished with %zd bytes after %d "
+	       "reallocations moving %zd bytes\n", downloader, image->len,
+	       downloader->reallocs, downloader->copied );
 
 	/* Shut down interfaces */
 	intf_shutdown ( &downloader->xfer, rc );
@@ -83,28 +112,61 @@ static void downloader_finished ( struct downloader *downloader, int rc ) {
  *
  * @v downloader	Downloader
  * @v len		Required minimum size
+ * @v exact		Size is a hint for the final length of the file
  * @ret rc		Return status code
+ *
+ * When extending the buffer to accommodate received data, the buffer
+ * is grown geometrically so that a download of unknown length does
+ * not require a reallocation (and potentially a copy of the whole
+ * image) for every received packet.  When the final length of the
+ * file is known (as indicated via a seek beyond the end of the
+ * buffer), the buffer is allocated to exactly that length.
  */
 static int downloader_ensure_size ( struct downloader *downloader,
-				    size_t len ) {
+				    size_t len, int exact ) {
+	struct image *image = downloader->image;
 	userptr_t new_buffer;
+	size_t alloc;
 
-	/* If buffer is already large enough, do nothing */
-	if ( len <= downloader->image->len )
+	/* If buffer is already large enough, just record new length */
+	if ( len <= downloader->alloc ) {
+		if ( len > image->len )
+			image->len = len;
 		return 0;
+	}
+
+	/* Calculate new buffer size */
+	alloc = len;
+	if ( ! exact ) {
+		if ( alloc < ( 2 * downloader->alloc ) )
+			alloc = ( 2 * downloader->alloc );
+		if ( alloc < DOWNLOADER_MIN_ALLOC )
+			alloc = DOWNLOADER_MIN_ALLOC;
+	}
 
-	DBGC ( downloader, "Downloader %p extending to %zd bytes\n",
-	       downloader, len );
+	DBGC ( downloader, "Downloader %p extending to %zd bytes (%zd "
+	       "allocated)\n", downloader, len, alloc );
 
-	/* Extend buffer */
-	new_buffer = urealloc ( downloader->image->data, len );
+	/* Extend buffer, falling back to the exact length required */
+	new_buffer = urealloc ( image->data, alloc );
+	if ( ( ! new_buffer ) && ( alloc > len ) ) {
+		alloc = len;
+		new_buffer = urealloc ( image->data, alloc );
+	}
 	if ( ! new_buffer ) {
 		DBGC ( downloader, "Downloader %p could not extend buffer to "
 		       "%zd bytes\n", downloader, len );
 		return -ENOBUFS;
 	}
-	downloader->image->data = new_buffer;
-	downloader->image->len = len;
+
+	/* Record statistics */
+	downloader->reallocs++;
+	if ( image->data && ( new_buffer != image->data ) )
+		downloader->copied += image->len;
+
+	image->data = new_buffer;
+	image->len = len;
+	downloader->alloc = alloc;
 
 	return 0;
 }
@@ -158,10 +220,14 @@ static int downloader_xfer_deliver ( struct downloader *downloader,
 		downloader->pos = 0;
 	downloader->pos += meta->offset;
 
-	/* Ensure that we have enough buffer space for this data */
+	/* Ensure that we have enough buffer space for this data.  A
+	 * zero-length buffer represents a seek, which is used by
+	 * protocols to indicate the total file size.
+	 */
 	len = iob_len ( iobuf );
 	max = ( downloader->pos + len );
-	if ( ( rc = downloader_ensure_size ( downloader, max ) ) != 0 )
+	if ( ( rc = downloader_ensure_size ( downloader, max,
+					     ( len == 0 ) ) ) != 0 )
 		goto done;
 
 	/* Copy data to buffer */
@@ -208,6 +274,24 @@ static struct interface_descriptor downloader_job_desc =
  *
  */
 
+/**
+ * Add image digest filter
+ *
+ * @v xfer		Data transfer interface
+ * @v image		Image being downloaded
+ * @ret next		Data transfer interface to open
+ * @ret rc		Return status code
+ *
+ * This is a stub that is overridden when image digest support is
+ * present.
+ */
+__weak int add_image_digest ( struct interface *xfer,
+			      struct image *image __unused,
+			      struct interface **next ) {
+	*next = xfer;
+	return 0;
+}
+
 /**
  * Instantiate a downloader
  *
@@ -223,6 +307,7 @@ static struct interface_descriptor downloader_job_desc =
 int create_downloader ( struct interface *job, struct image *image,
 			int type, ... ) {
 	struct downloader *downloader;
+	struct interface *xfer;
 	va_list args;
 	int rc;
 
@@ -236,10 +321,16 @@ int create_downloader ( struct interface *job, struct image *image,
 	intf_init ( &downloader->xfer, &downloader_xfer_desc,
 		    &downloader->refcnt );
 	downloader->image = image_get ( image );
+	downloader->alloc = image->len;
 	va_start ( args, type );
 
+	/* Calculate image digests as data arrives, if applicable */
+	if ( ( rc = add_image_digest ( &downloader->xfer, image,
+				       &xfer ) ) != 0 )
+		goto err;
+
 	/* Instantiate child objects and attach to our interfaces */
-	if ( ( rc = xfer_vopen ( &downloader->xfer, type, args ) ) != 0 )
+	if ( ( rc = xfer_vopen ( xfer, type, args ) ) != 0 )
 		goto err;
 
 	/* Attach parent interface, mortalise self, and return */
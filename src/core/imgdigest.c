@@ -0,0 +1,377 @@
+/*
+ * Copyright (C) 2011 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/xfer.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/image.h>
+#include <ipxe/crypto.h>
+#include <ipxe/base16.h>
+#include <ipxe/md5.h>
+#include <ipxe/sha1.h>
+#include <ipxe/imgdigest.h>
+
+/** @file
+ *
+ * Image digests
+ *
+ * When an expected digest has been supplied for an image, the digest
+ * is calculated incrementally by a filter placed in front of the
+ * downloader, so that it is available without a second pass over the
+ * image data.  If the data does not arrive strictly in order (as can
+ * happen with multicast or segmented transfers), or if no digest was
+ * requested, the digest is instead calculated on demand from the
+ * complete image.
+ */
+
+/** Image digest does not match expected value */
+#define EACCES_DIGEST __einfo_error ( EINFO_EACCES_DIGEST )
+#define EINFO_EACCES_DIGEST __einfo_uniqify \
+	( EINFO_EACCES, 0x01, "Image digest mismatch" )
+
+/** Expected digest is of an unrecognised length */
+#define EINVAL_DIGEST __einfo_error ( EINFO_EINVAL_DIGEST )
+#define EINFO_EINVAL_DIGEST __einfo_uniqify \
+	( EINFO_EINVAL, 0x01, "Invalid image digest" )
+
+/** Maximum length of image data passed to a single digest update */
+#define IMAGE_DIGEST_MAX_FRAG 0x10000000UL
+
+/** An image digest filter */
+struct image_digester {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** Data transfer interface (towards the downloader) */
+	struct interface xfer;
+	/** Raw data transfer interface (towards the data source) */
+	struct interface raw;
+
+	/** Image being downloaded */
+	struct image *image;
+	/** Digest algorithm */
+	struct digest_algorithm *digest;
+	/** Current position within image, as seen by the downloader */
+	size_t pos;
+	/** Length of data digested so far */
+	size_t len;
+	/** Data has arrived out of order */
+	int unordered;
+
+	/** Digest context */
+	uint8_t ctx[0];
+};
+
+/**
+ * Identify cached image digest
+ *
+ * @v image		Image
+ * @v digest		Digest algorithm
+ * @ret flag		Flag indicating that cached digest is valid, or 0
+ * @ret cached		Cached digest, or NULL
+ */
+static uint8_t * image_digest_cache ( struct image *image,
+				      struct digest_algorithm *digest,
+				      unsigned int *flag ) {
+
+	if ( digest == &md5_algorithm ) {
+		*flag = IMAGE_MD5;
+		return image->md5;
+	} else if ( digest == &sha1_algorithm ) {
+		*flag = IMAGE_SHA1;
+		return image->sha1;
+	} else {
+		*flag = 0;
+		return NULL;
+	}
+}
+
+/**
+ * Free image digest filter
+ *
+ * @v refcnt		Reference counter
+ */
+static void image_digester_free ( struct refcnt *refcnt ) {
+	struct image_digester *digester =
+		container_of ( refcnt, struct image_digester, refcnt );
+
+	image_put ( digester->image );
+	free ( digester );
+}
+
+/**
+ * Close image digest filter
+ *
+ * @v digester		Image digest filter
+ * @v rc		Reason for close
+ */
+static void image_digester_close ( struct image_digester *digester, int rc ) {
+	struct image *image = digester->image;
+	struct digest_algorithm *digest = digester->digest;
+	unsigned int flag;
+	uint8_t *cached;
+
+	/* Record digest if the whole image was digested in order */
+	cached = image_digest_cache ( image, digest, &flag );
+	if ( ( rc == 0 ) && ( ! digester->unordered ) &&
+	     ( digester->len == image->len ) && cached ) {
+		digest_final ( digest, digester->ctx, cached );
+		image->flags |= flag;
+		DBGC ( digester, "IMGDIGEST %p digested %zd bytes\n",
+		       digester, digester->len );
+	}
+
+	/* Shut down interfaces */
+	intf_shutdown ( &digester->raw, rc );
+	intf_shutdown ( &digester->xfer, rc );
+}
+
+/**
+ * Handle received data
+ *
+ * @v digester		Image digest filter
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int image_digester_deliver ( struct image_digester *digester,
+				    struct io_buffer *iobuf,
+				    struct xfer_metadata *meta ) {
+	size_t len = iob_len ( iobuf );
+
+	/* Track position in the same way as the downloader */
+	if ( meta->flags & XFER_FL_ABS_OFFSET )
+		digester->pos = 0;
+	digester->pos += meta->offset;
+
+	/* Digest data if it follows on from the data already digested.
+	 * Zero-length deliveries are seeks, and do not break ordering.
+	 */
+	if ( len && ( ! digester->unordered ) ) {
+		if ( digester->pos == digester->len ) {
+			digest_update ( digester->digest, digester->ctx,
+					iobuf->data, len );
+			digester->len += len;
+		} else {
+			DBGC ( digester, "IMGDIGEST %p received data at %zd "
+			       "(expected %zd)\n", digester, digester->pos,
+			       digester->len );
+			digester->unordered = 1;
+		}
+	}
+	digester->pos += len;
+
+	return xfer_deliver ( &digester->xfer, iobuf, meta );
+}
+
+/** Image digest filter data transfer interface operations */
+static struct interface_operation image_digester_xfer_op[] = {
+	INTF_OP ( intf_close, struct image_digester *, image_digester_close ),
+};
+
+/** Image digest filter data transfer interface descriptor */
+static struct interface_descriptor image_digester_xfer_desc =
+	INTF_DESC_PASSTHRU ( struct image_digester, xfer,
+			     image_digester_xfer_op, raw );
+
+/** Image digest filter raw data transfer interface operations */
+static struct interface_operation image_digester_raw_op[] = {
+	INTF_OP ( xfer_deliver, struct image_digester *,
+		  image_digester_deliver ),
+	INTF_OP ( intf_close, struct image_digester *, image_digester_close ),
+};
+
+/** Image digest filter raw data transfer interface descriptor */
+static struct interface_descriptor image_digester_raw_desc =
+	INTF_DESC_PASSTHRU ( struct image_digester, raw,
+			     image_digester_raw_op, xfer );
+
+/**
+ * Add image digest filter
+ *
+ * @v xfer		Data transfer interface (towards the downloader)
+ * @v image		Image being downloaded
+ * @ret next		Data transfer interface to open
+ * @ret rc		Return status code
+ *
+ * The filter is added only if a digest algorithm has been requested
+ * for the image via image_expect_digest().
+ */
+int add_image_digest ( struct interface *xfer, struct image *image,
+		       struct interface **next ) {
+	struct digest_algorithm *digest = image->digest;
+	struct image_digester *digester;
+
+	/* Do nothing unless a digest has been requested */
+	if ( ! digest ) {
+		*next = xfer;
+		return 0;
+	}
+
+	/* Allocate and initialise structure */
+	digester = zalloc ( sizeof ( *digester ) + digest->ctxsize );
+	if ( ! digester )
+		return -ENOMEM;
+	ref_init ( &digester->refcnt, image_digester_free );
+	intf_init ( &digester->xfer, &image_digester_xfer_desc,
+		    &digester->refcnt );
+	intf_init ( &digester->raw, &image_digester_raw_desc,
+		    &digester->refcnt );
+	digester->image = image_get ( image );
+	digester->digest = digest;
+	image->flags &= ~( IMAGE_MD5 | IMAGE_SHA1 );
+	digest_init ( digest, digester->ctx );
+
+	/* Attach to parent interface, mortalise self, and return */
+	intf_plug_plug ( &digester->xfer, xfer );
+	*next = &digester->raw;
+	ref_put ( &digester->refcnt );
+	return 0;
+}
+
+/**
+ * Get image digest
+ *
+ * @v image		Image
+ * @v digest		Digest algorithm
+ * @v out		Buffer for digest output
+ * @ret rc		Return status code
+ *
+ * Returns the digest recorded during download, if available, and
+ * otherwise calculates (and, for MD5 and SHA-1, records) the digest
+ * from the image data.
+ */
+int image_digest ( struct image *image, struct digest_algorithm *digest,
+		   void *out ) {
+	uint8_t ctx[digest->ctxsize];
+	uint8_t *cached;
+	unsigned int flag;
+	size_t offset;
+	size_t frag_len;
+
+	/* Use cached digest, if known */
+	cached = image_digest_cache ( image, digest, &flag );
+	if ( image->flags & flag ) {
+		memcpy ( out, cached, digest->digestsize );
+		return 0;
+	}
+
+	/* Calculate digest directly from the image data */
+	digest_init ( digest, ctx );
+	for ( offset = 0 ; offset < image->len ; offset += frag_len ) {
+		frag_len = ( image->len - offset );
+		if ( frag_len > IMAGE_DIGEST_MAX_FRAG )
+			frag_len = IMAGE_DIGEST_MAX_FRAG;
+		digest_update ( digest, ctx,
+				user_to_virt ( image->data, offset ),
+				frag_len );
+	}
+	digest_final ( digest, ctx, out );
+
+	/* Record digest, if applicable */
+	if ( cached ) {
+		memcpy ( cached, out, digest->digestsize );
+		image->flags |= flag;
+	}
+
+	return 0;
+}
+
+/**
+ * Decode expected image digest
+ *
+ * @v expected		Expected MD5 or SHA-1 digest, as a hex string
+ * @v raw		Buffer for decoded digest
+ * @ret digest		Digest algorithm
+ * @ret rc		Return status code
+ *
+ * The digest algorithm is selected by the length of the expected
+ * digest.
+ */
+static int image_digest_decode ( const char *expected, void *raw,
+				 struct digest_algorithm **digest ) {
+	int len;
+
+	/* Decode expected digest and identify algorithm */
+	len = base16_decode ( expected, raw );
+	if ( len < 0 )
+		return len;
+	if ( len == MD5_DIGEST_SIZE ) {
+		*digest = &md5_algorithm;
+	} else if ( len == SHA1_DIGEST_SIZE ) {
+		*digest = &sha1_algorithm;
+	} else {
+		return -EINVAL_DIGEST;
+	}
+
+	return 0;
+}
+
+/**
+ * Request image digest calculation during download
+ *
+ * @v image		Image
+ * @v expected		Expected MD5 or SHA-1 digest, as a hex string
+ * @ret rc		Return status code
+ *
+ * This must be called before the download is started.
+ */
+int image_expect_digest ( struct image *image, const char *expected ) {
+	uint8_t raw[ base16_decoded_max_len ( expected ) ];
+	struct digest_algorithm *digest;
+	int rc;
+
+	if ( ( rc = image_digest_decode ( expected, raw, &digest ) ) != 0 )
+		return rc;
+	image->digest = digest;
+
+	return 0;
+}
+
+/**
+ * Verify image digest
+ *
+ * @v image		Image
+ * @v expected		Expected MD5 or SHA-1 digest, as a hex string
+ * @ret rc		Return status code
+ */
+int image_verify_digest ( struct image *image, const char *expected ) {
+	uint8_t raw[ base16_decoded_max_len ( expected ) ];
+	uint8_t actual[ sizeof ( raw ) ];
+	struct digest_algorithm *digest;
+	int rc;
+
+	/* Decode expected digest */
+	if ( ( rc = image_digest_decode ( expected, raw, &digest ) ) != 0 )
+		return rc;
+
+	/* Compare against actual digest */
+	if ( ( rc = image_digest ( image, digest, actual ) ) != 0 )
+		return rc;
+	if ( memcmp ( actual, raw, digest->digestsize ) != 0 ) {
+		DBGC ( image, "IMAGE %s digest mismatch\n", image->name );
+		return -EACCES_DIGEST;
+	}
+
+	return 0;
+}
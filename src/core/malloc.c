@@ -22,6 +22,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <stdint.h>
 #include <string.h>
 #include <strings.h>
+#include <stdio.h>
 #include <ipxe/io.h>
 #include <ipxe/list.h>
 #include <ipxe/init.h>
@@ -97,6 +98,72 @@ size_t freemem;
 /** The heap itself */
 static char heap[HEAP_SIZE] __attribute__ (( aligned ( __alignof__(void *) )));
 
+/**
+ * A memory block size class
+ *
+ * Small allocations are rounded up to the size of a size class.
+ * Freed blocks are kept on a per-class free list and handed out again
+ * without searching (or splitting) the free block list, which makes
+ * the allocation of frequently-used objects such as I/O buffers
+ * cheap.  Blocks on these lists are returned to the free block list
+ * whenever an allocation from the free block list fails.
+ */
+struct memblock_class {
+	/** Size of blocks in this class */
+	size_t size;
+	/** List of free blocks in this class */
+	struct list_head free;
+	/** Number of free blocks in this class */
+	unsigned int count;
+	/** Number of allocations satisfied from this class */
+	unsigned int hits;
+	/** Number of allocations not satisfied from this class */
+	unsigned int misses;
+};
+
+/** Define a memory block size class */
+#define MEMBLOCK_CLASS( _index, _size ) {				\
+	.size = (_size),						\
+	.free = LIST_HEAD_INIT ( memblock_classes[_index].free ),	\
+	}
+
+/** Memory block size classes
+ *
+ * Using two classes per power of two limits the wastage from
+ * rounding up to at most one third of each block.  The sizes must
+ * follow the pattern assumed by memblock_class().  A class whose size
+ * is not a multiple of @c MIN_MEMBLOCK_SIZE (i.e. the 48-byte class
+ * on 64-bit builds) is simply never selected, since sizes are always
+ * rounded up to a multiple of @c MIN_MEMBLOCK_SIZE before lookup.
+ */
+static struct memblock_class memblock_classes[] = {
+	MEMBLOCK_CLASS ( 0, 32 ),
+	MEMBLOCK_CLASS ( 1, 48 ),
+	MEMBLOCK_CLASS ( 2, 64 ),
+	MEMBLOCK_CLASS ( 3, 96 ),
+	MEMBLOCK_CLASS ( 4, 128 ),
+	MEMBLOCK_CLASS ( 5, 192 ),
+	MEMBLOCK_CLASS ( 6, 256 ),
+	MEMBLOCK_CLASS ( 7, 384 ),
+	MEMBLOCK_CLASS ( 8, 512 ),
+	MEMBLOCK_CLASS ( 9, 768 ),
+	MEMBLOCK_CLASS ( 10, 1024 ),
+	MEMBLOCK_CLASS ( 11, 1536 ),
+	MEMBLOCK_CLASS ( 12, 2048 ),
+	MEMBLOCK_CLASS ( 13, 3072 ),
+	MEMBLOCK_CLASS ( 14, 4096 ),
+};
+
+/** Number of memory block size classes */
+#define NUM_MEMBLOCK_CLASSES \
+	( sizeof ( memblock_classes ) / sizeof ( memblock_classes[0] ) )
+
+/** Maximum total size of blocks held on size class free lists */
+#define MEMBLOCK_CLASS_MAX_CACHED ( HEAP_SIZE / 8 )
+
+/** Total size of blocks held on size class free lists */
+static size_t memblock_cached;
+
 /**
  * Discard some cached data
  *
@@ -112,6 +179,115 @@ static unsigned int discard_cache ( void ) {
 	return discarded;
 }
 
+/**
+ * Insert a memory block into the free block list
+ *
+ * @v ptr		Memory block
+ * @v size		Size of the memory block
+ *
+ * The block will be merged with any adjacent free blocks.  The total
+ * free memory counter is not updated.
+ */
+static void insert_memblock ( void *ptr, size_t size ) {
+	struct memory_block *freeing;
+	struct memory_block *block;
+	struct memory_block *tmp;
+	ssize_t gap_before;
+	ssize_t gap_after = -1;
+
+	freeing = ptr;
+	freeing->size = size;
+	DBG ( "Freeing [%p,%p)\n", freeing, ( ( ( void * ) freeing ) + size ));
+
+	/* Insert/merge into free list */
+	list_for_each_entry_safe ( block, tmp, &free_blocks, list ) {
+		/* Calculate gaps before and after the "freeing" block */
+		gap_before = ( ( ( void * ) freeing ) - 
+			       ( ( ( void * ) block ) + block->size ) );
+		gap_after = ( ( ( void * ) block ) - 
+			      ( ( ( void * ) freeing ) + freeing->size ) );
+		/* Merge with immediately preceding block, if possible */
+		if ( gap_before == 0 ) {
+			DBG ( "[%p,%p) + [%p,%p) -> [%p,%p)\n", block,
+			      ( ( ( void * ) block ) + block->size ), freeing,
+			      ( ( ( void * ) freeing ) + freeing->size ),block,
+			      ( ( ( void * ) freeing ) + freeing->size ) );
+			block->size += size;
+			list_del ( &block->list );
+			freeing = block;
+		}
+		/* Stop processing as soon as we reach a following block */
+		if ( gap_after >= 0 )
+			break;
+	}
+
+	/* Insert before the immediately following block.  If
+	 * possible, merge the following block into the "freeing"
+	 * block.
+	 */
+	DBG ( "[%p,%p)\n", freeing, ( ( ( void * ) freeing ) + freeing->size));
+	list_add_tail ( &freeing->list, &block->list );
+	if ( gap_after == 0 ) {
+		DBG ( "[%p,%p) + [%p,%p) -> [%p,%p)\n", freeing,
+		      ( ( ( void * ) freeing ) + freeing->size ), block,
+		      ( ( ( void * ) block ) + block->size ), freeing,
+		      ( ( ( void * ) block ) + block->size ) );
+		freeing->size += block->size;
+		list_del ( &block->list );
+	}
+}
+
+/**
+ * Identify size class for a memory block
+ *
+ * @v size		Size (rounded up to a multiple of MIN_MEMBLOCK_SIZE)
+ * @ret class		Size class, or NULL if block is too large
+ */
+static struct memblock_class * memblock_class ( size_t size ) {
+	unsigned int order;
+	unsigned int index;
+
+	/* Blocks larger than the largest class are not cached */
+	if ( size > memblock_classes[ NUM_MEMBLOCK_CLASSES - 1 ].size )
+		return NULL;
+
+	/* Classes run from 32 bytes upwards, with two classes (2^n
+	 * and 3*2^(n-1)) per power of two.
+	 */
+	if ( size <= memblock_classes[0].size )
+		return &memblock_classes[0];
+	order = fls ( size - 1 );
+	index = ( 2 * ( order - 5 ) );
+	if ( size <= memblock_classes[ index - 1 ].size )
+		index--;
+	return &memblock_classes[index];
+}
+
+/**
+ * Return all blocks held on size class free lists to the free block list
+ *
+ * @ret released	Number of blocks released
+ */
+static unsigned int memblock_class_release ( void ) {
+	struct memblock_class *class;
+	struct memory_block *block;
+	unsigned int released = 0;
+
+	for ( class = memblock_classes ;
+	      class < &memblock_classes[NUM_MEMBLOCK_CLASSES] ; class++ ) {
+		while ( ! list_empty ( &class->free ) ) {
+			block = list_first_entry ( &class->free,
+						   struct memory_block, list );
+			list_del ( &block->list );
+			class->count--;
+			memblock_cached -= class->size;
+			insert_memblock ( block, class->size );
+			released++;
+		}
+	}
+	return released;
+}
+
 /**
  * Allocate a memory block
  *
@@ -125,6 +301,7 @@ static unsigned int discard_cache ( void ) {
  * @c align must be a power of two.  @c size may not be zero.
  */
 void * alloc_memblock ( size_t size, size_t align ) {
+	struct memblock_class *class;
 	struct memory_block *block;
 	size_t align_mask;
 	size_t pre_size;
@@ -138,6 +315,27 @@ void * alloc_memblock ( size_t size, size_t align ) {
 	size = ( size + MIN_MEMBLOCK_SIZE - 1 ) & ~( MIN_MEMBLOCK_SIZE - 1 );
 	align_mask = ( align - 1 ) | ( MIN_MEMBLOCK_SIZE - 1 );
 
+	/* Use a suitably aligned block from the size class free list,
+	 * if one is available.
+	 */
+	class = memblock_class ( size );
+	if ( class ) {
+		size = class->size;
+		list_for_each_entry ( block, &class->free, list ) {
+			if ( virt_to_phys ( block ) & align_mask )
+				continue;
+			list_del ( &block->list );
+			class->count--;
+			class->hits++;
+			memblock_cached -= size;
+			freemem -= size;
+			DBG ( "Allocated [%p,%p) from class\n", block,
+			      ( ( ( void * ) block ) + size ) );
+			return block;
+		}
+		class->misses++;
+	}
+
 	DBG ( "Allocating %#zx (aligned %#zx)\n", size, align );
 	while ( 1 ) {
 		/* Search through blocks for the first one with enough space */
@@ -187,7 +385,12 @@ void * alloc_memblock ( size_t size, size_t align ) {
 			}
 		}
 
-		/* Try discarding some cached data to free up memory */
+		/* Try returning blocks held on size class free lists
+		 * to the free block list, or discarding some cached
+		 * data, to free up memory.
+		 */
+		if ( memblock_class_release() )
+			continue;
 		if ( ! discard_cache() ) {
 			/* Nothing available to discard */
 			DBG ( "Failed to allocate %#zx (aligned %#zx)\n",
@@ -206,11 +409,8 @@ void * alloc_memblock ( size_t size, size_t align ) {
  * If @c ptr is NULL, no action is taken.
  */
 void free_memblock ( void *ptr, size_t size ) {
+	struct memblock_class *class;
 	struct memory_block *freeing;
-	struct memory_block *block;
-	struct memory_block *tmp;
-	ssize_t gap_before;
-	ssize_t gap_after = -1;
 
 	/* Allow for ptr==NULL */
 	if ( ! ptr )
@@ -220,45 +420,24 @@ void free_memblock ( void *ptr, size_t size ) {
 	 * would have used.
 	 */
 	size = ( size + MIN_MEMBLOCK_SIZE - 1 ) & ~( MIN_MEMBLOCK_SIZE - 1 );
-	freeing = ptr;
-	freeing->size = size;
-	DBG ( "Freeing [%p,%p)\n", freeing, ( ( ( void * ) freeing ) + size ));
-
-	/* Insert/merge into free list */
-	list_for_each_entry_safe ( block, tmp, &free_blocks, list ) {
-		/* Calculate gaps before and after the "freeing" block */
-		gap_before = ( ( ( void * ) freeing ) - 
-			       ( ( ( void * ) block ) + block->size ) );
-		gap_after = ( ( ( void * ) block ) - 
-			      ( ( ( void * ) freeing ) + freeing->size ) );
-		/* Merge with immediately preceding block, if possible */
-		if ( gap_before == 0 ) {
-			DBG ( "[%p,%p) + [%p,%p) -> [%p,%p)\n", block,
-			      ( ( ( void * ) block ) + block->size ), freeing,
-			      ( ( ( void * ) freeing ) + freeing->size ),block,
-			      ( ( ( void * ) freeing ) + freeing->size ) );
-			block->size += size;
-			list_del ( &block->list );
-			freeing = block;
-		}
-		/* Stop processing as soon as we reach a following block */
-		if ( gap_after >= 0 )
-			break;
-	}
+	class = memblock_class ( size );
+	if ( class )
+		size = class->size;
 
-	/* Insert before the immediately following block.  If
-	 * possible, merge the following block into the "freeing"
-	 * block.
+	/* Hold block on size class free list if possible, otherwise
+	 * return it to the free block list.
 	 */
-	DBG ( "[%p,%p)\n", freeing, ( ( ( void * ) freeing ) + freeing->size));
-	list_add_tail ( &freeing->list, &block->list );
-	if ( gap_after == 0 ) {
-		DBG ( "[%p,%p) + [%p,%p) -> [%p,%p)\n", freeing,
-		      ( ( ( void * ) freeing ) + freeing->size ), block,
-		      ( ( ( void * ) block ) + block->size ), freeing,
-		      ( ( ( void * ) block ) + block->size ) );
-		freeing->size += block->size;
-		list_del ( &block->list );
+	if ( class &&
+	     ( ( memblock_cached + size ) <= MEMBLOCK_CLASS_MAX_CACHED ) ) {
+		freeing = ptr;
+		freeing->size = size;
+		list_add ( &freeing->list, &class->free );
+		class->count++;
+		memblock_cached += size;
+		DBG ( "Freeing [%p,%p) to class\n",
+		      freeing, ( ( ( void * ) freeing ) + size ) );
+	} else {
+		insert_memblock ( ptr, size );
 	}
 
 	/* Update free memory counter */
@@ -387,7 +566,9 @@ void mpopulate ( void *start, size_t len ) {
 	/* Prevent free_memblock() from rounding up len beyond the end
 	 * of what we were actually given...
 	 */
-	free_memblock ( start, ( len & ~( MIN_MEMBLOCK_SIZE - 1 ) ) );
+	len &= ~( MIN_MEMBLOCK_SIZE - 1 );
+	insert_memblock ( start, len );
+	freemem += len;
 }
 
 /**
@@ -403,19 +584,30 @@ struct init_fn heap_init_fn __init_fn ( INIT_EARLY ) = {
 	.initialise = init_heap,
 };
 
-#if 0
-#include <stdio.h>
 /**
- * Dump free block list
+ * Dump free block list and allocation statistics
  *
  */
 void mdumpfree ( void ) {
 	struct memory_block *block;
+	struct memblock_class *class;
+	unsigned int count = 0;
+	size_t largest = 0;
 
 	printf ( "Free block list:\n" );
 	list_for_each_entry ( block, &free_blocks, list ) {
 		printf ( "[%p,%p] (size %#zx)\n", block,
 			 ( ( ( void * ) block ) + block->size ), block->size );
+		if ( block->size > largest )
+			largest = block->size;
+		count++;
+	}
+	printf ( "Free: %#zx bytes (%#zx in size classes), %d blocks, "
+		 "largest %#zx\n", freemem, memblock_cached, count, largest );
+	printf ( "Size classes:\n" );
+	for ( class = memblock_classes ;
+	      class < &memblock_classes[NUM_MEMBLOCK_CLASSES] ; class++ ) {
+		printf ( "%#6zx: %d free, %d hits, %d misses\n", class->size,
+			 class->count, class->hits, class->misses );
 	}
 }
-#endif
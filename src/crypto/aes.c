@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 2011 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+/** @file
+ *
+ * AES algorithm
+ *
+ * The portable implementation uses a single 1kB lookup table for
+ * each direction, combining SubBytes and MixColumns (or their
+ * inverses), with the other three tables derived by rotation.  The
+ * tables are generated on first use rather than being stored in the
+ * binary.  Decryption uses the equivalent inverse cipher, so that
+ * both directions share the same round structure.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <byteswap.h>
+#include <ipxe/rotate.h>
+#include <ipxe/crypto.h>
+#include <ipxe/cbc.h>
+#include <ipxe/aes.h>
+#include <bits/aes.h>
+
+/** Number of 32-bit columns in an AES block */
+#define AES_COLUMNS ( AES_BLOCKSIZE / sizeof ( uint32_t ) )
+
+/** AES S-box */
+static uint8_t aes_sbox[256];
+
+/** AES inverse S-box */
+static uint8_t aes_inv_sbox[256];
+
+/** Combined SubBytes and MixColumns table */
+static uint32_t aes_mixcol[256];
+
+/** Combined InvSubBytes and InvMixColumns table */
+static uint32_t aes_inv_mixcol[256];
+
+/**
+ * Multiply by x in GF(2^8)
+ *
+ * @v byte		Byte
+ * @ret byte		Byte multiplied by x
+ */
+static inline uint8_t aes_xtime ( uint8_t byte ) {
+	return ( ( byte << 1 ) ^ ( ( byte & 0x80 ) ? 0x1b : 0 ) );
+}
+
+/**
+ * Generate lookup tables
+ *
+ */
+static void aes_generate ( void ) {
+	uint8_t p = 1;
+	uint8_t q = 1;
+	uint8_t s;
+	uint32_t s1;
+	uint32_t s2;
+	uint32_t s4;
+	uint32_t s8;
+	unsigned int i;
+
+	/* Do nothing if tables have already been generated */
+	if ( aes_sbox[0] )
+		return;
+
+	/* Generate S-boxes by stepping through the multiplicative
+	 * group using generator 3 and its inverse.
+	 */
+	do {
+		p ^= aes_xtime ( p );
+		q ^= ( q << 1 );
+		q ^= ( q << 2 );
+		q ^= ( q << 4 );
+		if ( q & 0x80 )
+			q ^= 0x09;
+		s = ( q ^ ( ( q << 1 ) | ( q >> 7 ) ) ^
+		      ( ( q << 2 ) | ( q >> 6 ) ) ^
+		      ( ( q << 3 ) | ( q >> 5 ) ) ^
+		      ( ( q << 4 ) | ( q >> 4 ) ) ^ 0x63 );
+		aes_sbox[p] = s;
+		aes_inv_sbox[s] = p;
+	} while ( p != 1 );
+	aes_sbox[0] = 0x63;
+	aes_inv_sbox[0x63] = 0;
+
+	/* Generate MixColumns tables */
+	for ( i = 0 ; i < 256 ; i++ ) {
+		s1 = aes_sbox[i];
+		s2 = aes_xtime ( s1 );
+		aes_mixcol[i] = ( ( ( s2 ^ s1 ) << 24 ) | ( s1 << 16 ) |
+				  ( s1 << 8 ) | s2 );
+		s1 = aes_inv_sbox[i];
+		s2 = aes_xtime ( s1 );
+		s4 = aes_xtime ( s2 );
+		s8 = aes_xtime ( s4 );
+		aes_inv_mixcol[i] = ( ( ( s8 ^ s2 ^ s1 ) << 24 ) |
+				      ( ( s8 ^ s4 ^ s1 ) << 16 ) |
+				      ( ( s8 ^ s1 ) << 8 ) |
+				      ( s8 ^ s4 ^ s2 ) );
+	}
+}
+
+/**
+ * Apply S-box to each byte of a column
+ *
+ * @v column		Column
+ * @ret column		Substituted column
+ */
+static uint32_t aes_subword ( uint32_t column ) {
+	return ( ( ( uint32_t ) aes_sbox[ column >> 24 ] << 24 ) |
+		 ( ( uint32_t ) aes_sbox[ ( column >> 16 ) & 0xff ] << 16 ) |
+		 ( ( uint32_t ) aes_sbox[ ( column >> 8 ) & 0xff ] << 8 ) |
+		 ( ( uint32_t ) aes_sbox[ column & 0xff ] ) );
+}
+
+/**
+ * Apply InvMixColumns to a column
+ *
+ * @v column		Column
+ * @ret column		Transformed column
+ */
+static uint32_t aes_inv_mixcolumn ( uint32_t column ) {
+	return ( aes_inv_mixcol[ aes_sbox[ column & 0xff ] ] ^
+		 rol32 ( aes_inv_mixcol[ aes_sbox[ ( column >> 8 ) & 0xff ] ],
+			 8 ) ^
+		 rol32 ( aes_inv_mixcol[ aes_sbox[ ( column >> 16 ) & 0xff ] ],
+			 16 ) ^
+		 rol32 ( aes_inv_mixcol[ aes_sbox[ column >> 24 ] ], 24 ) );
+}
+
+/**
+ * Perform AES on a single block
+ *
+ * @v keys		Key schedule
+ * @v rounds		Number of rounds
+ * @v mixcol		Combined SubBytes and MixColumns table
+ * @v sbox		S-box
+ * @v shift		Column offset between successive rows
+ * @v src		Input block
+ * @v dst		Output block
+ *
+ * Encryption and decryption (using the equivalent inverse cipher)
+ * differ only in the tables used and in the direction of the row
+ * shift.  A shift of one column per row gives ShiftRows, and a shift
+ * of three columns per row gives InvShiftRows.
+ */
+static void aes_block ( const uint32_t *keys, unsigned int rounds,
+			const uint32_t *mixcol, const uint8_t *sbox,
+			unsigned int shift, const void *src, void *dst ) {
+	uint32_t state[AES_COLUMNS];
+	uint32_t next[AES_COLUMNS];
+	unsigned int round;
+	unsigned int i;
+	uint8_t b0;
+	uint8_t b1;
+	uint8_t b2;
+	uint8_t b3;
+
+	/* Load state and add initial round key */
+	memcpy ( state, src, sizeof ( state ) );
+	for ( i = 0 ; i < AES_COLUMNS ; i++ )
+		state[i] = ( le32_to_cpu ( state[i] ) ^ *(keys++) );
+
+	/* Perform rounds */
+	for ( round = 1 ; round <= rounds ; round++ ) {
+		for ( i = 0 ; i < AES_COLUMNS ; i++ ) {
+			b0 = ( state[i] & 0xff );
+			b1 = ( ( state[ ( i + shift ) % 4 ] >> 8 ) & 0xff );
+			b2 = ( ( state[ ( i + 2 ) % 4 ] >> 16 ) & 0xff );
+			b3 = ( state[ ( i + 3 * shift ) % 4 ] >> 24 );
+			if ( round < rounds ) {
+				next[i] = ( mixcol[b0] ^
+					    rol32 ( mixcol[b1], 8 ) ^
+					    rol32 ( mixcol[b2], 16 ) ^
+					    rol32 ( mixcol[b3], 24 ) );
+			} else {
+				/* Final round omits MixColumns */
+				next[i] = ( ( ( uint32_t ) sbox[b3] << 24 ) |
+					    ( ( uint32_t ) sbox[b2] << 16 ) |
+					    ( ( uint32_t ) sbox[b1] << 8 ) |
+					    ( ( uint32_t ) sbox[b0] ) );
+			}
+			next[i] ^= *(keys++);
+		}
+		memcpy ( state, next, sizeof ( state ) );
+	}
+
+	/* Store state */
+	for ( i = 0 ; i < AES_COLUMNS ; i++ )
+		state[i] = cpu_to_le32 ( state[i] );
+	memcpy ( dst, state, sizeof ( state ) );
+}
+
+/**
+ * Set key
+ *
+ * @v ctx		Context
+ * @v key		Key
+ * @v keylen		Key length
+ * @ret rc		Return status code
+ */
+static int aes_setkey ( void *ctx, const void *key, size_t keylen ) {
+	struct aes_context *aes_ctx = ctx;
+	unsigned int key_words = ( keylen / sizeof ( uint32_t ) );
+	unsigned int total_words;
+	unsigned int round;
+	unsigned int i;
+	uint32_t *enc;
+	uint32_t *dec;
+	uint32_t temp;
+	uint8_t rcon = 0x01;
+
+	/* Check key length */
+	switch ( keylen ) {
+	case ( 128 / 8 ) :
+	case ( 192 / 8 ) :
+	case ( 256 / 8 ) :
+		break;
+	default:
+		return -EINVAL;
+	}
+	aes_ctx->rounds = ( key_words + 6 );
+	total_words = ( ( aes_ctx->rounds + 1 ) * AES_COLUMNS );
+
+	/* Generate lookup tables, if not already done */
+	aes_generate();
+
+	/* Expand encryption key schedule */
+	enc = aes_ctx->encrypt;
+	memcpy ( enc, key, keylen );
+	for ( i = 0 ; i < key_words ; i++ )
+		enc[i] = le32_to_cpu ( enc[i] );
+	for ( ; i < total_words ; i++ ) {
+		temp = enc[ i - 1 ];
+		if ( ( i % key_words ) == 0 ) {
+			temp = ( aes_subword ( ror32 ( temp, 8 ) ) ^ rcon );
+			rcon = aes_xtime ( rcon );
+		} else if ( ( key_words > 6 ) && ( ( i % key_words ) == 4 ) ) {
+			temp = aes_subword ( temp );
+		}
+		enc[i] = ( enc[ i - key_words ] ^ temp );
+	}
+
+	/* Construct decryption key schedule, in reverse round order
+	 * and with InvMixColumns applied to all but the first and
+	 * last round keys.
+	 */
+	dec = aes_ctx->decrypt;
+	for ( round = 0 ; round <= aes_ctx->rounds ; round++ ) {
+		enc = &aes_ctx->encrypt[ ( aes_ctx->rounds - round ) *
+					 AES_COLUMNS ];
+		for ( i = 0 ; i < AES_COLUMNS ; i++ ) {
+			temp = *(enc++);
+			if ( round && ( round < aes_ctx->rounds ) )
+				temp = aes_inv_mixcolumn ( temp );
+			*(dec++) = temp;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Set initialisation vector
+ *
+ * @v ctx		Context
+ * @v iv		Initialisation vector
+ */
+static void aes_setiv ( void *ctx __unused, const void *iv __unused ) {
+	/* Nothing to do */
+}
+
+/**
+ * Encrypt data
+ *
+ * @v ctx		Context
+ * @v src		Data to encrypt
+ * @v dst		Buffer for encrypted data
+ * @v len		Length of data
+ *
+ * Multiple blocks are encrypted independently of each other.
+ */
+static void aes_encrypt ( void *ctx, const void *src, void *dst,
+			  size_t len ) {
+	struct aes_context *aes_ctx = ctx;
+	size_t count = ( len / AES_BLOCKSIZE );
+
+	assert ( ( len % AES_BLOCKSIZE ) == 0 );
+
+	/* Use architecture-specific implementation, if available */
+	if ( aes_arch_encrypt ( aes_ctx->encrypt, aes_ctx->rounds,
+				src, dst, count ) )
+		return;
+
+	for ( ; count ; count-- ) {
+		aes_block ( aes_ctx->encrypt, aes_ctx->rounds, aes_mixcol,
+			    aes_sbox, 1, src, dst );
+		src += AES_BLOCKSIZE;
+		dst += AES_BLOCKSIZE;
+	}
+}
+
+/**
+ * Decrypt data
+ *
+ * @v ctx		Context
+ * @v src		Data to decrypt
+ * @v dst		Buffer for decrypted data
+ * @v len		Length of data
+ *
+ * Multiple blocks are decrypted independently of each other.
+ */
+static void aes_decrypt ( void *ctx, const void *src, void *dst,
+			  size_t len ) {
+	struct aes_context *aes_ctx = ctx;
+	size_t count = ( len / AES_BLOCKSIZE );
+
+	assert ( ( len % AES_BLOCKSIZE ) == 0 );
+
+	/* Use architecture-specific implementation, if available */
+	if ( aes_arch_decrypt ( aes_ctx->decrypt, aes_ctx->rounds,
+				src, dst, count ) )
+		return;
+
+	for ( ; count ; count-- ) {
+		aes_block ( aes_ctx->decrypt, aes_ctx->rounds, aes_inv_mixcol,
+			    aes_inv_sbox, 3, src, dst );
+		src += AES_BLOCKSIZE;
+		dst += AES_BLOCKSIZE;
+	}
+}
+
+/** Basic AES algorithm */
+struct cipher_algorithm aes_algorithm = {
+	.name = "aes",
+	.ctxsize = sizeof ( struct aes_context ),
+	.blocksize = AES_BLOCKSIZE,
+	.setkey = aes_setkey,
+	.setiv = aes_setiv,
+	.encrypt = aes_encrypt,
+	.decrypt = aes_decrypt,
+};
+
+/* AES with cipher-block chaining */
+CBC_CIPHER ( aes_cbc, aes_cbc_algorithm,
+	     aes_algorithm, struct aes_context, AES_BLOCKSIZE );
@@ -0,0 +1,401 @@
+/*
+ * Copyright (C) 2012 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <ipxe/bigint.h>
+
+/** @file
+ *
+ * Big integer support
+ *
+ * Modular exponentiation is performed using Montgomery
+ * multiplication, which replaces each division by the modulus with a
+ * multiplication and a shift by whole elements.  For an n-element
+ * modulus N, the Montgomery form of a value x is ( x * R mod N ),
+ * where R = 2^(n*BIGINT_ELEMENT_BITS).
+ */
+
+/**
+ * Initialise big integer
+ *
+ * @v value0		Element 0 of big integer to initialise
+ * @v size		Number of elements
+ * @v data		Raw data (in big-endian order)
+ * @v len		Length of raw data
+ */
+void bigint_init_raw ( bigint_element_t *value0, unsigned int size,
+		       const void *data, size_t len ) {
+	const uint8_t *byte = ( data + len );
+	unsigned int i;
+	unsigned int j;
+
+	/* Sanity check */
+	assert ( len <= ( size * sizeof ( value0[0] ) ) );
+
+	/* Construct each element from the least significant bytes */
+	for ( i = 0 ; i < size ; i++ ) {
+		value0[i] = 0;
+		for ( j = 0 ; ( j < sizeof ( value0[0] ) ) && len ; j++ ) {
+			value0[i] |= ( ( ( bigint_element_t ) *(--byte) ) <<
+				       ( 8 * j ) );
+			len--;
+		}
+	}
+}
+
+/**
+ * Finalise big integer
+ *
+ * @v value0		Element 0 of big integer to finalise
+ * @v size		Number of elements
+ * @v out		Output buffer (in big-endian order)
+ * @v len		Length of output buffer
+ */
+void bigint_done_raw ( const bigint_element_t *value0, unsigned int size,
+		       void *out, size_t len ) {
+	uint8_t *byte = ( out + len );
+	unsigned int i;
+
+	/* Extract bytes, least significant first, zero-padding as needed */
+	for ( i = 0 ; i < len ; i++ ) {
+		*(--byte) = ( ( ( i / sizeof ( value0[0] ) ) < size ) ?
+			      ( value0[ i / sizeof ( value0[0] ) ] >>
+				( 8 * ( i % sizeof ( value0[0] ) ) ) ) : 0 );
+	}
+}
+
+/**
+ * Compare big integers
+ *
+ * @v value0		Element 0 of big integer
+ * @v reference0	Element 0 of reference big integer
+ * @v size		Number of elements
+ * @ret geq		Big integer is greater than or equal to the reference
+ */
+int bigint_is_geq_raw ( const bigint_element_t *value0,
+			const bigint_element_t *reference0,
+			unsigned int size ) {
+	unsigned int i = size;
+
+	while ( i-- ) {
+		if ( value0[i] != reference0[i] )
+			return ( value0[i] > reference0[i] );
+	}
+	return 1;
+}
+
+/**
+ * Find highest bit set in big integer
+ *
+ * @v value0		Element 0 of big integer
+ * @v size		Number of elements
+ * @ret max_bit		Highest bit set + 1 (or 0 if no bits set)
+ */
+unsigned int bigint_max_set_bit_raw ( const bigint_element_t *value0,
+				      unsigned int size ) {
+	bigint_element_t element;
+	unsigned int max_bit;
+
+	while ( size-- ) {
+		element = value0[size];
+		if ( ! element )
+			continue;
+		max_bit = ( size * BIGINT_ELEMENT_BITS );
+		for ( ; element ; element >>= 1 )
+			max_bit++;
+		return max_bit;
+	}
+	return 0;
+}
+
+/**
+ * Test bit in big integer
+ *
+ * @v value0		Element 0 of big integer
+ * @v bit		Bit to test
+ * @ret is_set		Bit is set
+ */
+static inline int bigint_bit_is_set_raw ( const bigint_element_t *value0,
+					  unsigned int bit ) {
+	return ( ( value0[ bit / BIGINT_ELEMENT_BITS ] >>
+		   ( bit % BIGINT_ELEMENT_BITS ) ) & 1 );
+}
+
+/**
+ * Subtract big integers
+ *
+ * @v subtrahend0	Element 0 of big integer to subtract
+ * @v value0		Element 0 of big integer to be subtracted from
+ * @v size		Number of elements
+ */
+static void bigint_subtract_raw ( const bigint_element_t *subtrahend0,
+				  bigint_element_t *value0,
+				  unsigned int size ) {
+	bigint_element_t borrow = 0;
+	bigint_element_t subtrahend;
+	bigint_element_t value;
+	unsigned int i;
+
+	for ( i = 0 ; i < size ; i++ ) {
+		subtrahend = subtrahend0[i];
+		value = value0[i];
+		value0[i] = ( value - subtrahend - borrow );
+		borrow = ( ( value < subtrahend ) ||
+			   ( ( value == subtrahend ) && borrow ) );
+	}
+}
+
+/**
+ * Double big integer modulo N
+ *
+ * @v value0		Element 0 of big integer (must be less than N)
+ * @v modulus0		Element 0 of modulus N
+ * @v size		Number of elements
+ */
+static void bigint_double_mod_raw ( bigint_element_t *value0,
+				    const bigint_element_t *modulus0,
+				    unsigned int size ) {
+	bigint_element_t carry = 0;
+	bigint_element_t element;
+	unsigned int i;
+
+	/* Shift left by one bit */
+	for ( i = 0 ; i < size ; i++ ) {
+		element = value0[i];
+		value0[i] = ( ( element << 1 ) | carry );
+		carry = ( element >> ( BIGINT_ELEMENT_BITS - 1 ) );
+	}
+
+	/* Result is less than 2N, so at most one subtraction is needed */
+	if ( carry || bigint_is_geq_raw ( value0, modulus0, size ) )
+		bigint_subtract_raw ( modulus0, value0, size );
+}
+
+/**
+ * Calculate Montgomery inverse of modulus
+ *
+ * @v modulus0		Element 0 of modulus N (must be odd)
+ * @ret inverse		-N^-1 mod 2^BIGINT_ELEMENT_BITS
+ */
+static bigint_element_t bigint_montgomery_inverse ( const bigint_element_t
+						    *modulus0 ) {
+	bigint_element_t modulus = modulus0[0];
+	bigint_element_t inverse = modulus;
+	unsigned int bits;
+
+	/* Any odd N is its own inverse modulo 8.  Each Newton-Raphson
+	 * iteration then doubles the number of correct bits.
+	 */
+	for ( bits = 3 ; bits < BIGINT_ELEMENT_BITS ; bits *= 2 )
+		inverse *= ( 2 - ( modulus * inverse ) );
+
+	return -inverse;
+}
+
+/**
+ * Perform Montgomery multiplication of big integers
+ *
+ * @v multiplicand0	Element 0 of big integer to be multiplied
+ * @v multiplier0	Element 0 of big integer to be multiplied
+ * @v modulus0		Element 0 of modulus N
+ * @v inverse		Montgomery inverse of modulus
+ * @v result0		Element 0 of big integer to hold result
+ * @v size		Number of elements
+ * @v tmp0		Element 0 of ( size + 1 ) elements of working space
+ *
+ * Calculates ( multiplicand * multiplier / R mod N ), interleaving
+ * the multiplication with the reduction so that the intermediate
+ * value never exceeds ( size + 1 ) elements.  Both inputs must be
+ * less than N.  The result may overlap either input.
+ */
+static void bigint_montgomery_raw ( const bigint_element_t *multiplicand0,
+				    const bigint_element_t *multiplier0,
+				    const bigint_element_t *modulus0,
+				    bigint_element_t inverse,
+				    bigint_element_t *result0,
+				    unsigned int size,
+				    bigint_element_t *tmp0 ) {
+	bigint_element_t multiplier;
+	bigint_element_t factor;
+	bigint_element_t product;
+	bigint_wide_t wide;
+	bigint_element_t carry;
+	bigint_element_t reduce_carry;
+	unsigned int i;
+	unsigned int j;
+
+	memset ( tmp0, 0, ( ( size + 1 ) * sizeof ( tmp0[0] ) ) );
+	for ( i = 0 ; i < size ; i++ ) {
+
+		/* Calculate the multiple of N that will clear the lowest
+		 * element of ( tmp + multiplicand * multiplier[i] ).
+		 */
+		multiplier = multiplier0[i];
+		wide = ( ( ( bigint_wide_t ) multiplicand0[0] ) * multiplier );
+		wide += tmp0[0];
+		carry = ( wide >> BIGINT_ELEMENT_BITS );
+		product = wide;
+		factor = ( product * inverse );
+		wide = ( ( ( bigint_wide_t ) modulus0[0] ) * factor );
+		wide += product;
+		reduce_carry = ( wide >> BIGINT_ELEMENT_BITS );
+
+		/* Add both products in a single pass, shifting down by
+		 * one element.
+		 */
+		for ( j = 1 ; j < size ; j++ ) {
+			wide = ( ( ( bigint_wide_t ) multiplicand0[j] ) *
+				 multiplier );
+			wide += tmp0[j];
+			wide += carry;
+			carry = ( wide >> BIGINT_ELEMENT_BITS );
+			product = wide;
+			wide = ( ( ( bigint_wide_t ) modulus0[j] ) * factor );
+			wide += product;
+			wide += reduce_carry;
+			reduce_carry = ( wide >> BIGINT_ELEMENT_BITS );
+			tmp0[ j - 1 ] = wide;
+		}
+		wide = ( ( ( bigint_wide_t ) tmp0[size] ) + carry );
+		wide += reduce_carry;
+		tmp0[ size - 1 ] = wide;
+		tmp0[size] = ( wide >> BIGINT_ELEMENT_BITS );
+	}
+
+	/* Result is less than 2N, so at most one subtraction is needed */
+	if ( tmp0[size] || bigint_is_geq_raw ( tmp0, modulus0, size ) )
+		bigint_subtract_raw ( modulus0, tmp0, size );
+	memcpy ( result0, tmp0, ( size * sizeof ( result0[0] ) ) );
+}
+
+/**
+ * Perform Montgomery exponentiation of big integers
+ *
+ * @v base0		Element 0 of base, in Montgomery form
+ * @v modulus0		Element 0 of modulus N
+ * @v inverse		Montgomery inverse of modulus
+ * @v exponent0		Element 0 of exponent (must be non-zero)
+ * @v result0		Element 0 of big integer to hold result
+ * @v size		Number of elements
+ * @v exponent_size	Number of elements in exponent
+ * @v tmp0		Element 0 of ( size + 1 ) elements of working space
+ *
+ * The result is left in Montgomery form.
+ */
+static void bigint_montgomery_exp_raw ( const bigint_element_t *base0,
+					const bigint_element_t *modulus0,
+					bigint_element_t inverse,
+					const bigint_element_t *exponent0,
+					bigint_element_t *result0,
+					unsigned int size,
+					unsigned int exponent_size,
+					bigint_element_t *tmp0 ) {
+	unsigned int bit;
+
+	/* Scan exponent from the most significant set bit downwards */
+	bit = bigint_max_set_bit_raw ( exponent0, exponent_size );
+	assert ( bit != 0 );
+	memcpy ( result0, base0, ( size * sizeof ( result0[0] ) ) );
+	while ( --bit ) {
+		bigint_montgomery_raw ( result0, result0, modulus0, inverse,
+					result0, size, tmp0 );
+		if ( bigint_bit_is_set_raw ( exponent0, ( bit - 1 ) ) ) {
+			bigint_montgomery_raw ( result0, base0, modulus0,
+						inverse, result0, size, tmp0 );
+		}
+	}
+}
+
+/**
+ * Perform modular exponentiation of big integers
+ *
+ * @v base0		Element 0 of big integer base (must be less than N)
+ * @v modulus0		Element 0 of big integer modulus N (must be odd)
+ * @v exponent0		Element 0 of big integer exponent
+ * @v result0		Element 0 of big integer to hold result
+ * @v size		Number of elements in base, modulus, and result
+ * @v exponent_size	Number of elements in exponent
+ * @v tmp		Temporary working space
+ */
+void bigint_mod_exp_raw ( const bigint_element_t *base0,
+			  const bigint_element_t *modulus0,
+			  const bigint_element_t *exponent0,
+			  bigint_element_t *result0,
+			  unsigned int size, unsigned int exponent_size,
+			  void *tmp ) {
+	bigint_element_t *product0 = tmp;
+	bigint_element_t *scratch0 = ( product0 + size + 1 );
+	bigint_element_t *square0 = ( scratch0 + size );
+	unsigned int r_bits = ( size * BIGINT_ELEMENT_BITS );
+	bigint_element_t elements = size;
+	bigint_element_t inverse;
+	unsigned int max_bit;
+	unsigned int i;
+
+	/* Sanity checks */
+	assert ( modulus0[0] & 1 );
+	assert ( ! bigint_is_geq_raw ( base0, modulus0, size ) );
+
+	/* Anything to the power zero is one */
+	if ( ! bigint_max_set_bit_raw ( exponent0, exponent_size ) ) {
+		memset ( result0, 0, ( size * sizeof ( result0[0] ) ) );
+		result0[0] = 1;
+		return;
+	}
+
+	/* Calculate Montgomery inverse of modulus */
+	inverse = bigint_montgomery_inverse ( modulus0 );
+
+	/* Calculate the Montgomery form of 2^BIGINT_ELEMENT_BITS by
+	 * repeated doubling, starting from the largest power of two
+	 * that is less than N.
+	 */
+	max_bit = bigint_max_set_bit_raw ( modulus0, size );
+	memset ( scratch0, 0, ( size * sizeof ( scratch0[0] ) ) );
+	scratch0[ ( max_bit - 1 ) / BIGINT_ELEMENT_BITS ] =
+		( ( ( bigint_element_t ) 1 ) <<
+		  ( ( max_bit - 1 ) % BIGINT_ELEMENT_BITS ) );
+	for ( i = max_bit ; i <= ( r_bits + BIGINT_ELEMENT_BITS ) ; i++ )
+		bigint_double_mod_raw ( scratch0, modulus0, size );
+
+	/* Raise this to the power of the number of elements, giving
+	 * the Montgomery form of R (i.e. R^2 mod N).  This takes only
+	 * a handful of Montgomery multiplications, rather than one
+	 * modular doubling per bit of R.
+	 */
+	bigint_montgomery_exp_raw ( scratch0, modulus0, inverse, &elements,
+				    square0, size, 1, product0 );
+
+	/* Convert base to Montgomery form */
+	bigint_montgomery_raw ( base0, square0, modulus0, inverse, scratch0,
+				size, product0 );
+
+	/* Perform exponentiation */
+	bigint_montgomery_exp_raw ( scratch0, modulus0, inverse, exponent0,
+				    square0, size, exponent_size, product0 );
+
+	/* Convert result out of Montgomery form */
+	memset ( scratch0, 0, ( size * sizeof ( scratch0[0] ) ) );
+	scratch0[0] = 1;
+	bigint_montgomery_raw ( square0, scratch0, modulus0, inverse, result0,
+				size, product0 );
+}
@@ -29,6 +29,9 @@ FILE_LICENCE ( GPL2_OR_LATER );
  *
  */
 
+/** Maximum length of data decrypted in a single call to the raw cipher */
+#define CBC_DECRYPT_MAX_LEN 256
+
 /**
  * XOR data blocks
  *
@@ -37,11 +40,13 @@ FILE_LICENCE ( GPL2_OR_LATER );
  * @v len		Length of data
  */
 static void cbc_xor ( const void *src, void *dst, size_t len ) {
-	const uint32_t *srcl = src;
-	uint32_t *dstl = dst;
+	const unsigned long *srcl = src;
+	unsigned long *dstl = dst;
 	unsigned int i;
 
-	/* Assume that block sizes will always be dword-aligned, for speed */
+	/* Assume that block sizes will always be multiples of the
+	 * native word size, for speed.
+	 */
 	assert ( ( len % sizeof ( *srcl ) ) == 0 );
 
 	for ( i = 0 ; i < ( len / sizeof ( *srcl ) ) ; i++ )
@@ -83,19 +88,42 @@ void cbc_encrypt ( void *ctx, const void *src, void *dst, size_t len,
  * @v len		Length of data
  * @v raw_cipher	Underlying cipher algorithm
  * @v cbc_ctx		CBC context
+ *
+ * Unlike encryption, decryption of each block does not depend upon
+ * the result of decrypting the previous block.  Several blocks are
+ * therefore passed to the raw cipher at once, allowing it to process
+ * them in parallel, and the chaining is applied afterwards.
  */
 void cbc_decrypt ( void *ctx, const void *src, void *dst, size_t len,
 		   struct cipher_algorithm *raw_cipher, void *cbc_ctx ) {
 	size_t blocksize = raw_cipher->blocksize;
+	size_t max_len = ( CBC_DECRYPT_MAX_LEN -
+			   ( CBC_DECRYPT_MAX_LEN % blocksize ) );
+	unsigned long ciphertext[ CBC_DECRYPT_MAX_LEN /
+				  sizeof ( unsigned long ) ];
+	size_t frag_len;
 
 	assert ( ( len % blocksize ) == 0 );
+	assert ( blocksize <= CBC_DECRYPT_MAX_LEN );
 
 	while ( len ) {
-		cipher_decrypt ( raw_cipher, ctx, src, dst, blocksize );
+		frag_len = len;
+		if ( frag_len > max_len )
+			frag_len = max_len;
+
+		/* Preserve ciphertext, since decryption may be in place */
+		memcpy ( ciphertext, src, frag_len );
+
+		/* Decrypt all blocks, then undo the chaining */
+		cipher_decrypt ( raw_cipher, ctx, src, dst, frag_len );
 		cbc_xor ( cbc_ctx, dst, blocksize );
-		memcpy ( cbc_ctx, src, blocksize );
-		dst += blocksize;
-		src += blocksize;
-		len -= blocksize;
+		cbc_xor ( ciphertext, ( dst + blocksize ),
+			  ( frag_len - blocksize ) );
+		memcpy ( cbc_ctx, ( ( ( void * ) ciphertext ) + frag_len -
+				    blocksize ), blocksize );
+
+		dst += frag_len;
+		src += frag_len;
+		len -= frag_len;
 	}
 }
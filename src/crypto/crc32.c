@@ -20,10 +20,55 @@
 
 FILE_LICENCE ( GPL2_OR_LATER );
 
+#include <stdint.h>
+#include <byteswap.h>
 #include <ipxe/crc32.h>
+#include <bits/crc32.h>
 
 #define CRCPOLY		0xedb88320
 
+/** Number of bytes processed per iteration of the sliced loop */
+#define CRC32_SLICES	8
+
+/**
+ * CRC32 lookup tables
+ *
+ * Table 0 holds the CRC of each possible byte value; table @c n
+ * holds the CRC of each possible byte value followed by @c n zero
+ * bytes.  The tables are generated on first use rather than being
+ * stored in the binary, since they occupy 8kB.
+ */
+static u32 crc32_table[CRC32_SLICES][256] __attribute__ (( aligned ( 64 ) ));
+
+/** CRC32 lookup tables have been generated */
+static int crc32_table_ready;
+
+/**
+ * Generate CRC32 lookup tables
+ *
+ */
+static void crc32_init_table ( void ) {
+	unsigned int slice;
+	unsigned int byte;
+	unsigned int i;
+	u32 crc;
+
+	for ( byte = 0 ; byte < 256 ; byte++ ) {
+		crc = byte;
+		for ( i = 0 ; i < 8 ; i++ )
+			crc = ( ( crc >> 1 ) ^ ( ( crc & 1 ) ? CRCPOLY : 0 ) );
+		crc32_table[0][byte] = crc;
+	}
+	for ( slice = 1 ; slice < CRC32_SLICES ; slice++ ) {
+		for ( byte = 0 ; byte < 256 ; byte++ ) {
+			crc = crc32_table[ slice - 1 ][byte];
+			crc32_table[slice][byte] =
+				( ( crc >> 8 ) ^ crc32_table[0][ crc & 0xff ] );
+		}
+	}
+	crc32_table_ready = 1;
+}
+
 /**
  * Calculate 32-bit little-endian CRC checksum
  *
@@ -34,21 +79,56 @@ FILE_LICENCE ( GPL2_OR_LATER );
  * Usually @a seed is initially zero or all one bits, depending on the
  * protocol. To continue a CRC checksum over multiple calls, pass the
  * return value from one call as the @a seed parameter to the next.
+ *
+ * Bulk data is passed to the architecture-specific implementation,
+ * if any.  Anything that it does not process is handled eight bytes
+ * at a time using the "slice-by-8" table lookup technique, with any
+ * unaligned head and tail processed a byte at a time.
  */
 u32 crc32_le ( u32 seed, const void *data, size_t len )
 {
 	u32 crc = seed;
 	const u8 *src = data;
-	u32 mult;
-	int i;
-
-	while ( len-- ) {
-		crc ^= *src++;
-		for ( i = 0; i < 8; i++ ) {
-			mult = ( crc & 1 ) ? CRCPOLY : 0;
-			crc = ( crc >> 1 ) ^ mult;
-		}
+	const u32 *src32;
+	size_t done;
+	u32 lo;
+	u32 hi;
+
+	/* Use architecture-specific implementation, if available */
+	done = crc32_arch_le ( &crc, src, len );
+	src += done;
+	len -= done;
+
+	/* Generate tables if necessary */
+	if ( ! crc32_table_ready )
+		crc32_init_table();
+
+	/* Process leading bytes up to a 32-bit boundary */
+	while ( len && ( ( ( intptr_t ) src ) & ( sizeof ( *src32 ) - 1 ) ) ) {
+		crc = ( ( crc >> 8 ) ^ crc32_table[0][ ( crc ^ *(src++) ) & 0xff ] );
+		len--;
 	}
 
+	/* Process eight bytes at a time */
+	src32 = ( ( const void * ) src );
+	while ( len >= CRC32_SLICES ) {
+		lo = ( crc ^ le32_to_cpu ( *(src32++) ) );
+		hi = le32_to_cpu ( *(src32++) );
+		crc = ( crc32_table[7][ lo & 0xff ] ^
+			crc32_table[6][ ( lo >> 8 ) & 0xff ] ^
+			crc32_table[5][ ( lo >> 16 ) & 0xff ] ^
+			crc32_table[4][ lo >> 24 ] ^
+			crc32_table[3][ hi & 0xff ] ^
+			crc32_table[2][ ( hi >> 8 ) & 0xff ] ^
+			crc32_table[1][ ( hi >> 16 ) & 0xff ] ^
+			crc32_table[0][ hi >> 24 ] );
+		len -= CRC32_SLICES;
+	}
+	src = ( ( const void * ) src32 );
+
+	/* Process trailing bytes */
+	while ( len-- )
+		crc = ( ( crc >> 8 ) ^ crc32_table[0][ ( crc ^ *(src++) ) & 0xff ] );
+
 	return crc;
 }
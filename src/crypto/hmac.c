@@ -47,6 +47,33 @@ static void hmac_reduce_key ( struct digest_algorithm *digest,
 	*key_len = digest->digestsize;
 }
 
+/**
+ * Start digest with padded key
+ *
+ * @v digest		Digest algorithm to use
+ * @v digest_ctx	Digest context
+ * @v key		Key
+ * @v key_len		Length of key (must not exceed the block size)
+ * @v xor		Padding byte
+ */
+static void hmac_start_pad ( struct digest_algorithm *digest,
+			     void *digest_ctx, const void *key, size_t key_len,
+			     uint8_t xor ) {
+	uint8_t k_pad[digest->blocksize];
+	unsigned int i;
+
+	/* Construct pad */
+	memset ( k_pad, 0, sizeof ( k_pad ) );
+	memcpy ( k_pad, key, key_len );
+	for ( i = 0 ; i < sizeof ( k_pad ) ; i++ ) {
+		k_pad[i] ^= xor;
+	}
+
+	/* Start hash */
+	digest_init ( digest, digest_ctx );
+	digest_update ( digest, digest_ctx, k_pad, sizeof ( k_pad ) );
+}
+
 /**
  * Initialise HMAC
  *
@@ -62,23 +89,13 @@ static void hmac_reduce_key ( struct digest_algorithm *digest,
  */
 void hmac_init ( struct digest_algorithm *digest, void *digest_ctx,
 		 void *key, size_t *key_len ) {
-	unsigned char k_ipad[digest->blocksize];
-	unsigned int i;
 
 	/* Reduce key if necessary */
-	if ( *key_len > sizeof ( k_ipad ) )
+	if ( *key_len > digest->blocksize )
 		hmac_reduce_key ( digest, key, key_len );
 
-	/* Construct input pad */
-	memset ( k_ipad, 0, sizeof ( k_ipad ) );
-	memcpy ( k_ipad, key, *key_len );
-	for ( i = 0 ; i < sizeof ( k_ipad ) ; i++ ) {
-		k_ipad[i] ^= 0x36;
-	}
-	
 	/* Start inner hash */
-	digest_init ( digest, digest_ctx );
-	digest_update ( digest, digest_ctx, k_ipad, sizeof ( k_ipad ) );
+	hmac_start_pad ( digest, digest_ctx, key, *key_len, 0x36 );
 }
 
 /**
@@ -97,26 +114,71 @@ void hmac_init ( struct digest_algorithm *digest, void *digest_ctx,
  */
 void hmac_final ( struct digest_algorithm *digest, void *digest_ctx,
 		  void *key, size_t *key_len, void *hmac ) {
-	unsigned char k_opad[digest->blocksize];
-	unsigned int i;
 
 	/* Reduce key if necessary */
-	if ( *key_len > sizeof ( k_opad ) )
+	if ( *key_len > digest->blocksize )
 		hmac_reduce_key ( digest, key, key_len );
 
-	/* Construct output pad */
-	memset ( k_opad, 0, sizeof ( k_opad ) );
-	memcpy ( k_opad, key, *key_len );
-	for ( i = 0 ; i < sizeof ( k_opad ) ; i++ ) {
-		k_opad[i] ^= 0x5c;
+	/* Finish inner hash */
+	digest_final ( digest, digest_ctx, hmac );
+
+	/* Perform outer hash */
+	hmac_start_pad ( digest, digest_ctx, key, *key_len, 0x5c );
+	digest_update ( digest, digest_ctx, hmac, digest->digestsize );
+	digest_final ( digest, digest_ctx, hmac );
+}
+
+/**
+ * Precompute HMAC key context
+ *
+ * @v digest		Digest algorithm to use
+ * @v key_ctx		HMAC key context to fill in
+ * @v key		Key
+ * @v key_len		Length of key
+ *
+ * The HMAC key context (of size hmac_key_ctxsize()) holds the inner
+ * and outer digest states after absorbing the padded key.  Each
+ * subsequent HMAC calculated using hmac_key_start() and
+ * hmac_key_final() then saves the two compression function
+ * invocations (and any key reduction) performed by hmac_init() and
+ * hmac_final().
+ */
+void hmac_key_init ( struct digest_algorithm *digest, void *key_ctx,
+		     const void *key, size_t key_len ) {
+	uint8_t digest_ctx[digest->ctxsize];
+	uint8_t reduced[digest->digestsize];
+
+	/* Reduce key if necessary */
+	if ( key_len > digest->blocksize ) {
+		digest_init ( digest, digest_ctx );
+		digest_update ( digest, digest_ctx, key, key_len );
+		digest_final ( digest, digest_ctx, reduced );
+		key = reduced;
+		key_len = sizeof ( reduced );
 	}
-	
+
+	/* Calculate inner and outer digest states */
+	hmac_start_pad ( digest, key_ctx, key, key_len, 0x36 );
+	hmac_start_pad ( digest, ( key_ctx + digest->ctxsize ), key, key_len,
+			 0x5c );
+}
+
+/**
+ * Finalise HMAC using precomputed key context
+ *
+ * @v digest		Digest algorithm to use
+ * @v key_ctx		HMAC key context
+ * @v digest_ctx	Digest context
+ * @v hmac		HMAC digest to fill in
+ */
+void hmac_key_final ( struct digest_algorithm *digest, const void *key_ctx,
+		      void *digest_ctx, void *hmac ) {
+
 	/* Finish inner hash */
 	digest_final ( digest, digest_ctx, hmac );
 
 	/* Perform outer hash */
-	digest_init ( digest, digest_ctx );
-	digest_update ( digest, digest_ctx, k_opad, sizeof ( k_opad ) );
+	memcpy ( digest_ctx, ( key_ctx + digest->ctxsize ), digest->ctxsize );
 	digest_update ( digest, digest_ctx, hmac, digest->digestsize );
 	digest_final ( digest, digest_ctx, hmac );
 }
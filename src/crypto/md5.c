@@ -25,64 +25,41 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <stdint.h>
 #include <string.h>
 #include <byteswap.h>
+#include <endian.h>
+#include <ipxe/rotate.h>
 #include <ipxe/crypto.h>
 #include <ipxe/md5.h>
 
-struct md5_step {
-	u32 ( * f ) ( u32 b, u32 c, u32 d );
-	u8 coefficient;
-	u8 constant;
-};
+/** MD5 auxiliary function for steps 0-15 */
+#define MD5_F1( b, c, d ) ( (d) ^ ( (b) & ( (c) ^ (d) ) ) )
 
-static u32 f1(u32 b, u32 c, u32 d)
-{
-	return ( d ^ ( b & ( c ^ d ) ) );
-}
+/** MD5 auxiliary function for steps 16-31 */
+#define MD5_F2( b, c, d ) ( (c) ^ ( (d) & ( (b) ^ (c) ) ) )
 
-static u32 f2(u32 b, u32 c, u32 d)
-{
-	return ( c ^ ( d & ( b ^ c ) ) );
-}
+/** MD5 auxiliary function for steps 32-47 */
+#define MD5_F3( b, c, d ) ( (b) ^ (c) ^ (d) )
 
-static u32 f3(u32 b, u32 c, u32 d)
-{
-	return ( b ^ c ^ d );
-}
+/** MD5 auxiliary function for steps 48-63 */
+#define MD5_F4( b, c, d ) ( (c) ^ ( (b) | ~(d) ) )
 
-static u32 f4(u32 b, u32 c, u32 d)
-{
-	return ( c ^ ( b | ~d ) );
-}
-
-static struct md5_step md5_steps[4] = {
-	{
-		.f = f1,
-		.coefficient = 1,
-		.constant = 0,
-	},
-	{
-		.f = f2,
-		.coefficient = 5,
-		.constant = 1,
-	},
-	{
-		.f = f3,
-		.coefficient = 3,
-		.constant = 5,
-	},
-	{
-		.f = f4,
-		.coefficient = 7,
-		.constant = 0,
-	}
-};
+/** Perform one MD5 step */
+#define MD5_STEP( f, a, b, c, d, in, k, s ) do {			\
+	(a) += ( f ( (b), (c), (d) ) + (in) + (k) );			\
+	(a) = ( rol32 ( (a), (s) ) + (b) );				\
+	} while ( 0 )
 
-static const u8 r[64] = {
-	7,12,17,22,7,12,17,22,7,12,17,22,7,12,17,22,
-	5,9,14,20,5,9,14,20,5,9,14,20,5,9,14,20,
-	4,11,16,23,4,11,16,23,4,11,16,23,4,11,16,23,
-	6,10,15,21,6,10,15,21,6,10,15,21,6,10,15,21
-};
+/**
+ * Perform four MD5 steps
+ *
+ * Each round uses a fixed sequence of four rotation amounts, so
+ * unrolling by four allows every rotation to use a constant shift.
+ */
+#define MD5_STEP4( f, i, g0, g1, g2, g3, s0, s1, s2, s3 ) do {	\
+	MD5_STEP ( f, a, b, c, d, in[g0], k[ (i) + 0 ], s0 );		\
+	MD5_STEP ( f, d, a, b, c, in[g1], k[ (i) + 1 ], s1 );		\
+	MD5_STEP ( f, c, d, a, b, in[g2], k[ (i) + 2 ], s2 );		\
+	MD5_STEP ( f, b, c, d, a, in[g3], k[ (i) + 3 ], s3 );		\
+	} while ( 0 )
 
 static const u32 k[64] = {
 	0xd76aa478UL, 0xe8c7b756UL, 0x242070dbUL, 0xc1bdceeeUL,
@@ -103,28 +80,40 @@ static const u32 k[64] = {
 	0xf7537e82UL, 0xbd3af235UL, 0x2ad7d2bbUL, 0xeb86d391UL,
 };
 
+/**
+ * Calculate MD5 digest of a single block
+ *
+ * @v hash		Digest state
+ * @v in		Data block, as host-endian words
+ */
 static void md5_transform(u32 *hash, const u32 *in)
 {
-	u32 a, b, c, d, f, g, temp;
-	int i;
-	struct md5_step *step;
+	u32 a, b, c, d;
+	unsigned int i;
 
 	a = hash[0];
 	b = hash[1];
 	c = hash[2];
 	d = hash[3];
 
-	for ( i = 0 ; i < 64 ; i++ ) {
-		step = &md5_steps[i >> 4];
-		f = step->f ( b, c, d );
-		g = ( ( i * step->coefficient + step->constant ) & 0xf );
-		temp = d;
-		d = c;
-		c = b;
-		a += ( f + k[i] + in[g] );
-		a = ( ( a << r[i] ) | ( a >> ( 32-r[i] ) ) );
-		b += a;
-		a = temp;
+	for ( i = 0 ; i < 16 ; i += 4 ) {
+		MD5_STEP4 ( MD5_F1, i, i, ( i + 1 ), ( i + 2 ), ( i + 3 ),
+			    7, 12, 17, 22 );
+	}
+	for ( ; i < 32 ; i += 4 ) {
+		MD5_STEP4 ( MD5_F2, i, ( ( 5 * i + 1 ) & 0xf ),
+			    ( ( 5 * i + 6 ) & 0xf ), ( ( 5 * i + 11 ) & 0xf ),
+			    ( ( 5 * i + 16 ) & 0xf ), 5, 9, 14, 20 );
+	}
+	for ( ; i < 48 ; i += 4 ) {
+		MD5_STEP4 ( MD5_F3, i, ( ( 3 * i + 5 ) & 0xf ),
+			    ( ( 3 * i + 8 ) & 0xf ), ( ( 3 * i + 11 ) & 0xf ),
+			    ( ( 3 * i + 14 ) & 0xf ), 4, 11, 16, 23 );
+	}
+	for ( ; i < 64 ; i += 4 ) {
+		MD5_STEP4 ( MD5_F4, i, ( ( 7 * i ) & 0xf ),
+			    ( ( 7 * i + 7 ) & 0xf ), ( ( 7 * i + 14 ) & 0xf ),
+			    ( ( 7 * i + 21 ) & 0xf ), 6, 10, 15, 21 );
 	}
 
 	hash[0] += a;
@@ -133,7 +122,6 @@ static void md5_transform(u32 *hash, const u32 *in)
 	hash[3] += d;
 }
 
-/* XXX: this stuff can be optimized */
 static inline void le32_to_cpu_array(u32 *buf, unsigned int words)
 {
 	while (words--) {
@@ -150,10 +138,30 @@ static inline void cpu_to_le32_array(u32 *buf, unsigned int words)
 	}
 }
 
-static inline void md5_transform_helper(struct md5_ctx *ctx)
+/**
+ * Calculate MD5 digest of complete blocks
+ *
+ * @v hash		Digest state
+ * @v data		Data
+ * @v count		Number of blocks
+ *
+ * On little-endian machines, aligned blocks are processed in place
+ * without any copying or byte swapping.
+ */
+static void md5_blocks(u32 *hash, const void *data, size_t count)
 {
-	le32_to_cpu_array(ctx->block, sizeof(ctx->block) / sizeof(u32));
-	md5_transform(ctx->hash, ctx->block);
+	u32 block[MD5_BLOCK_WORDS];
+
+	for ( ; count ; count--, data += sizeof ( block ) ) {
+		if ( ( __BYTE_ORDER == __LITTLE_ENDIAN ) &&
+		     ! ( ( ( intptr_t ) data ) & ( sizeof ( u32 ) - 1 ) ) ) {
+			md5_transform ( hash, data );
+		} else {
+			memcpy ( block, data, sizeof ( block ) );
+			le32_to_cpu_array ( block, MD5_BLOCK_WORDS );
+			md5_transform ( hash, block );
+		}
+	}
 }
 
 static void md5_init(void *context)
@@ -183,16 +191,14 @@ static void md5_update(void *context, const void *data, size_t len)
 	memcpy((char *)mctx->block + (sizeof(mctx->block) - avail),
 	       data, avail);
 
-	md5_transform_helper(mctx);
+	md5_blocks(mctx->hash, mctx->block, 1);
 	data += avail;
 	len -= avail;
 
-	while (len >= sizeof(mctx->block)) {
-		memcpy(mctx->block, data, sizeof(mctx->block));
-		md5_transform_helper(mctx);
-		data += sizeof(mctx->block);
-		len -= sizeof(mctx->block);
-	}
+	/* Process complete blocks directly from the caller's buffer */
+	md5_blocks(mctx->hash, data, (len / sizeof(mctx->block)));
+	data += (len & ~(sizeof(mctx->block) - 1));
+	len &= (sizeof(mctx->block) - 1);
 
 	memcpy(mctx->block, data, len);
 }
@@ -207,17 +213,15 @@ static void md5_final(void *context, void *out)
 	*p++ = 0x80;
 	if (padding < 0) {
 		memset(p, 0x00, padding + sizeof (u64));
-		md5_transform_helper(mctx);
+		md5_blocks(mctx->hash, mctx->block, 1);
 		p = (char *)mctx->block;
 		padding = 56;
 	}
 
 	memset(p, 0, padding);
-	mctx->block[14] = mctx->byte_count << 3;
-	mctx->block[15] = mctx->byte_count >> 29;
-	le32_to_cpu_array(mctx->block, (sizeof(mctx->block) -
-	                  sizeof(u64)) / sizeof(u32));
-	md5_transform(mctx->hash, mctx->block);
+	mctx->block[14] = cpu_to_le32(mctx->byte_count << 3);
+	mctx->block[15] = cpu_to_le32(mctx->byte_count >> 29);
+	md5_blocks(mctx->hash, mctx->block, 1);
 	cpu_to_le32_array(mctx->hash, sizeof(mctx->hash) / sizeof(u32));
 	memcpy(out, mctx->hash, sizeof(mctx->hash));
 	memset(mctx, 0, sizeof(*mctx));
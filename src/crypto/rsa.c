@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2012 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/crypto.h>
+#include <ipxe/bigint.h>
+#include <ipxe/x509.h>
+#include <ipxe/rsa.h>
+
+/** @file
+ *
+ * RSA public-key cryptography
+ *
+ * RSA operations are performed using fixed-width big integers, with
+ * the width set by the key's modulus.
+ */
+
+/** Maximum supported RSA modulus size, in elements */
+#define RSA_MAX_SIZE bigint_required_size ( RSA_MAX_LEN )
+
+/** Minimum length of PKCS #1 padding */
+#define RSA_MIN_PAD_LEN 11
+
+/** RSA working storage
+ *
+ * RSA operations are never reentered, so a single static workspace
+ * sized for the largest supported modulus avoids both heap
+ * allocation and large stack frames.
+ */
+static struct {
+	/** Modulus */
+	bigint_element_t modulus[RSA_MAX_SIZE];
+	/** Exponent */
+	bigint_element_t exponent[RSA_MAX_SIZE];
+	/** Input value */
+	bigint_element_t input[RSA_MAX_SIZE];
+	/** Output value */
+	bigint_element_t output[RSA_MAX_SIZE];
+	/** Temporary working space for modular exponentiation */
+	uint8_t tmp[ bigint_mod_exp_tmp_len_raw ( RSA_MAX_SIZE ) ];
+} rsa_work;
+
+/**
+ * Strip leading zero bytes from big-endian integer
+ *
+ * @v data		Integer data
+ * @v len		Length of integer data, to be updated
+ * @ret data		Stripped integer data
+ *
+ * ASN.1 integers carry a leading zero byte whenever the most
+ * significant bit would otherwise be set.
+ */
+static const uint8_t * rsa_strip ( const uint8_t *data, size_t *len ) {
+
+	while ( *len && ( *data == 0 ) ) {
+		data++;
+		(*len)--;
+	}
+	return data;
+}
+
+/**
+ * Get RSA modulus length
+ *
+ * @v key		RSA public key
+ * @ret len		Length of modulus, in bytes
+ */
+size_t rsa_modulus_len ( const struct x509_rsa_public_key *key ) {
+	size_t len = key->modulus_len;
+
+	rsa_strip ( key->modulus, &len );
+	return len;
+}
+
+/**
+ * Perform RSA public-key operation
+ *
+ * @v key		RSA public key
+ * @v in		Input value
+ * @v out		Output buffer (may be the same as the input value)
+ * @ret rc		Return status code
+ *
+ * The input value and output buffer are both rsa_modulus_len() bytes
+ * long.
+ */
+int rsa_public ( const struct x509_rsa_public_key *key,
+		 const void *in, void *out ) {
+	size_t modulus_len = key->modulus_len;
+	size_t exponent_len = key->exponent_len;
+	const uint8_t *modulus_data = rsa_strip ( key->modulus, &modulus_len );
+	const uint8_t *exponent_data = rsa_strip ( key->exponent,
+						   &exponent_len );
+	unsigned int size = bigint_required_size ( modulus_len );
+	unsigned int exponent_size = bigint_required_size ( exponent_len );
+
+	/* Check that key is usable */
+	if ( ( modulus_len > RSA_MAX_LEN ) ||
+	     ( exponent_len > RSA_MAX_LEN ) ) {
+		DBGC ( key, "RSA %p unsupported %zd-bit modulus or %zd-bit "
+		       "exponent\n", key, ( modulus_len * 8 ),
+		       ( exponent_len * 8 ) );
+		return -ENOTSUP;
+	}
+	if ( ( modulus_len == 0 ) ||
+	     ( ( modulus_data[ modulus_len - 1 ] & 1 ) == 0 ) ) {
+		DBGC ( key, "RSA %p invalid modulus\n", key );
+		return -EINVAL;
+	}
+	if ( exponent_size == 0 )
+		exponent_size = 1;
+
+	/* Perform operation */
+	{
+		bigint_t ( size ) *modulus = ( ( void * ) rsa_work.modulus );
+		bigint_t ( exponent_size ) *exponent =
+			( ( void * ) rsa_work.exponent );
+		bigint_t ( size ) *input = ( ( void * ) rsa_work.input );
+		bigint_t ( size ) *output = ( ( void * ) rsa_work.output );
+
+		bigint_init ( modulus, modulus_data, modulus_len );
+		bigint_init ( exponent, exponent_data, exponent_len );
+		bigint_init ( input, in, modulus_len );
+		if ( bigint_is_geq ( input, modulus ) ) {
+			DBGC ( key, "RSA %p input out of range\n", key );
+			return -ERANGE;
+		}
+		bigint_mod_exp ( input, modulus, exponent, output,
+				 rsa_work.tmp );
+		bigint_done ( output, out, modulus_len );
+	}
+
+	return 0;
+}
+
+/**
+ * Encrypt using RSA with PKCS #1 v1.5 padding
+ *
+ * @v key		RSA public key
+ * @v plaintext		Plaintext
+ * @v plaintext_len	Length of plaintext
+ * @v ciphertext	Ciphertext buffer
+ * @ret rc		Return status code
+ *
+ * The ciphertext buffer must be rsa_modulus_len() bytes long.
+ */
+int rsa_encrypt ( const struct x509_rsa_public_key *key,
+		  const void *plaintext, size_t plaintext_len,
+		  void *ciphertext ) {
+	size_t len = rsa_modulus_len ( key );
+	uint8_t *block = ciphertext;
+	uint8_t *padding = ( block + 2 );
+	size_t padding_len;
+	unsigned int i;
+
+	/* Check that plaintext fits */
+	if ( ( plaintext_len + RSA_MIN_PAD_LEN ) > len ) {
+		DBGC ( key, "RSA %p plaintext too long (%zd bytes, max %zd)\n",
+		       key, plaintext_len, ( len - RSA_MIN_PAD_LEN ) );
+		return -ERANGE;
+	}
+	padding_len = ( len - plaintext_len - 3 );
+
+	/* Construct encryption block, padded with non-zero random bytes */
+	block[0] = 0x00;
+	block[1] = 0x02;
+	for ( i = 0 ; i < padding_len ; i++ ) {
+		do {
+			get_random_bytes ( &padding[i], 1 );
+		} while ( padding[i] == 0 );
+	}
+	padding[padding_len] = 0x00;
+	memcpy ( ( padding + padding_len + 1 ), plaintext, plaintext_len );
+
+	/* Encrypt block in place */
+	return rsa_public ( key, block, block );
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2011 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+/** @file
+ *
+ * SHA-1 algorithm
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <byteswap.h>
+#include <ipxe/rotate.h>
+#include <ipxe/crypto.h>
+#include <ipxe/sha1.h>
+#include <bits/sha1.h>
+
+/** SHA-1 round constants */
+#define SHA1_K0 0x5a827999UL
+#define SHA1_K1 0x6ed9eba1UL
+#define SHA1_K2 0x8f1bbcdcUL
+#define SHA1_K3 0xca62c1d6UL
+
+/** SHA-1 round function for rounds 0-19 */
+#define SHA1_F0( b, c, d ) ( (d) ^ ( (b) & ( (c) ^ (d) ) ) )
+
+/** SHA-1 round function for rounds 20-39 and 60-79 */
+#define SHA1_F1( b, c, d ) ( (b) ^ (c) ^ (d) )
+
+/** SHA-1 round function for rounds 40-59 */
+#define SHA1_F2( b, c, d ) ( ( (b) & (c) ) | ( (d) & ( (b) | (c) ) ) )
+
+/**
+ * Perform one SHA-1 round
+ *
+ * The new value of "a" is accumulated into "e", and "b" is rotated in
+ * place, so that the next round takes its arguments in the order
+ * ( e, a, b, c, d ).
+ */
+#define SHA1_ROUND( f, k, a, b, c, d, e, w ) do {			\
+	(e) += ( rol32 ( (a), 5 ) + f ( (b), (c), (d) ) + (k) + (w) );	\
+	(b) = rol32 ( (b), 30 );					\
+	} while ( 0 )
+
+/** Perform five SHA-1 rounds, returning variables to their original order */
+#define SHA1_ROUND5( f, k, w ) do {					\
+	SHA1_ROUND ( f, k, a, b, c, d, e, (w)[0] );			\
+	SHA1_ROUND ( f, k, e, a, b, c, d, (w)[1] );			\
+	SHA1_ROUND ( f, k, d, e, a, b, c, (w)[2] );			\
+	SHA1_ROUND ( f, k, c, d, e, a, b, (w)[3] );			\
+	SHA1_ROUND ( f, k, b, c, d, e, a, (w)[4] );			\
+	} while ( 0 )
+
+/**
+ * Calculate SHA-1 digest of a single block
+ *
+ * @v hash		Digest state
+ * @v data		Data block (must be 32-bit aligned)
+ */
+static void sha1_transform ( uint32_t *hash, const uint32_t *data ) {
+	uint32_t w[80];
+	uint32_t a, b, c, d, e;
+	unsigned int i;
+
+	/* Expand message schedule */
+	for ( i = 0 ; i < 16 ; i++ )
+		w[i] = be32_to_cpu ( data[i] );
+	for ( ; i < 80 ; i++ )
+		w[i] = rol32 ( ( w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16] ), 1 );
+
+	/* Perform rounds */
+	a = hash[0];
+	b = hash[1];
+	c = hash[2];
+	d = hash[3];
+	e = hash[4];
+	for ( i = 0 ; i < 20 ; i += 5 )
+		SHA1_ROUND5 ( SHA1_F0, SHA1_K0, &w[i] );
+	for ( ; i < 40 ; i += 5 )
+		SHA1_ROUND5 ( SHA1_F1, SHA1_K1, &w[i] );
+	for ( ; i < 60 ; i += 5 )
+		SHA1_ROUND5 ( SHA1_F2, SHA1_K2, &w[i] );
+	for ( ; i < 80 ; i += 5 )
+		SHA1_ROUND5 ( SHA1_F1, SHA1_K3, &w[i] );
+	hash[0] += a;
+	hash[1] += b;
+	hash[2] += c;
+	hash[3] += d;
+	hash[4] += e;
+}
+
+/**
+ * Calculate SHA-1 digest of complete blocks
+ *
+ * @v hash		Digest state
+ * @v data		Data
+ * @v count		Number of blocks
+ */
+static void sha1_blocks ( uint32_t *hash, const void *data, size_t count ) {
+	uint32_t aligned[ SHA1_BLOCK_SIZE / sizeof ( uint32_t ) ];
+
+	/* Use architecture-specific implementation, if available */
+	if ( sha1_arch_blocks ( hash, data, count ) )
+		return;
+
+	/* Process blocks in place where possible */
+	for ( ; count ; count--, data += SHA1_BLOCK_SIZE ) {
+		if ( ( ( intptr_t ) data ) & ( sizeof ( uint32_t ) - 1 ) ) {
+			memcpy ( aligned, data, sizeof ( aligned ) );
+			sha1_transform ( hash, aligned );
+		} else {
+			sha1_transform ( hash, data );
+		}
+	}
+}
+
+/**
+ * Initialise SHA-1 digest
+ *
+ * @v ctx		SHA-1 context
+ */
+static void sha1_init ( void *ctx ) {
+	struct sha1_context *context = ctx;
+
+	context->hash[0] = 0x67452301UL;
+	context->hash[1] = 0xefcdab89UL;
+	context->hash[2] = 0x98badcfeUL;
+	context->hash[3] = 0x10325476UL;
+	context->hash[4] = 0xc3d2e1f0UL;
+	context->len = 0;
+}
+
+/**
+ * Update SHA-1 digest
+ *
+ * @v ctx		SHA-1 context
+ * @v data		Data
+ * @v len		Length of data
+ */
+static void sha1_update ( void *ctx, const void *data, size_t len ) {
+	struct sha1_context *context = ctx;
+	size_t offset = ( context->len % SHA1_BLOCK_SIZE );
+	size_t frag_len;
+
+	context->len += len;
+
+	/* Complete any partial block */
+	if ( offset ) {
+		frag_len = ( SHA1_BLOCK_SIZE - offset );
+		if ( frag_len > len )
+			frag_len = len;
+		memcpy ( ( context->block + offset ), data, frag_len );
+		data += frag_len;
+		len -= frag_len;
+		if ( ( offset + frag_len ) < SHA1_BLOCK_SIZE )
+			return;
+		sha1_blocks ( context->hash, context->block, 1 );
+	}
+
+	/* Process complete blocks directly from the caller's buffer */
+	sha1_blocks ( context->hash, data, ( len / SHA1_BLOCK_SIZE ) );
+	data += ( len & ~( SHA1_BLOCK_SIZE - 1 ) );
+	len %= SHA1_BLOCK_SIZE;
+
+	/* Save any remaining partial block */
+	memcpy ( context->block, data, len );
+}
+
+/**
+ * Finalise SHA-1 digest
+ *
+ * @v ctx		SHA-1 context
+ * @v out		Output buffer
+ */
+static void sha1_final ( void *ctx, void *out ) {
+	struct sha1_context *context = ctx;
+	size_t offset = ( context->len % SHA1_BLOCK_SIZE );
+	uint64_t len_bits = cpu_to_be64 ( context->len * 8 );
+	uint32_t *digest = out;
+	unsigned int i;
+
+	/* Append padding, processing an extra block if necessary */
+	context->block[offset++] = 0x80;
+	if ( offset > ( SHA1_BLOCK_SIZE - sizeof ( len_bits ) ) ) {
+		memset ( ( context->block + offset ), 0,
+			 ( SHA1_BLOCK_SIZE - offset ) );
+		sha1_blocks ( context->hash, context->block, 1 );
+		offset = 0;
+	}
+	memset ( ( context->block + offset ), 0,
+		 ( SHA1_BLOCK_SIZE - sizeof ( len_bits ) - offset ) );
+
+	/* Append length and process final block */
+	memcpy ( ( context->block + SHA1_BLOCK_SIZE - sizeof ( len_bits ) ),
+		 &len_bits, sizeof ( len_bits ) );
+	sha1_blocks ( context->hash, context->block, 1 );
+
+	/* Construct digest */
+	for ( i = 0 ; i < ( SHA1_DIGEST_SIZE / sizeof ( digest[0] ) ) ; i++ )
+		digest[i] = cpu_to_be32 ( context->hash[i] );
+	memset ( context, 0, sizeof ( *context ) );
+}
+
+/** SHA-1 algorithm */
+struct digest_algorithm sha1_algorithm = {
+	.name		= "sha1",
+	.ctxsize	= SHA1_CTX_SIZE,
+	.blocksize	= SHA1_BLOCK_SIZE,
+	.digestsize	= SHA1_DIGEST_SIZE,
+	.init		= sha1_init,
+	.update		= sha1_update,
+	.final		= sha1_final,
+};
@@ -43,10 +43,10 @@ void prf_sha1 ( const void *key, size_t key_len, const char *label,
 		const void *data, size_t data_len, void *prf, size_t prf_len )
 {
 	u32 blk;
-	u8 keym[key_len];	/* modifiable copy of key */
+	u8 key_ctx[2 * SHA1_CTX_SIZE]; /* precomputed HMAC key */
 	u8 in[strlen ( label ) + 1 + data_len + 1]; /* message to HMAC */
 	u8 *in_blknr;		/* pointer to last byte of in, block number */
-	u8 out[SHA1_SIZE];	/* HMAC-SHA1 result */
+	u8 out[SHA1_DIGEST_SIZE];	/* HMAC-SHA1 result */
 	u8 sha1_ctx[SHA1_CTX_SIZE]; /* SHA1 context */
 	const size_t label_len = strlen ( label );
 
@@ -54,7 +54,7 @@ void prf_sha1 ( const void *key, size_t key_len, const char *label,
 	   message text `label', followed by a NUL, followed by one
 	   byte indicating the block number (0 for first). */
 
-	memcpy ( keym, key, key_len );
+	hmac_key_init ( &sha1_algorithm, key_ctx, key, key_len );
 
 	memcpy ( in, label, strlen ( label ) + 1 );
 	memcpy ( in + label_len + 1, data, data_len );
@@ -63,41 +63,39 @@ void prf_sha1 ( const void *key, size_t key_len, const char *label,
 	for ( blk = 0 ;; blk++ ) {
 		*in_blknr = blk;
 
-		hmac_init ( &sha1_algorithm, sha1_ctx, keym, &key_len );
+		hmac_key_start ( &sha1_algorithm, key_ctx, sha1_ctx );
 		hmac_update ( &sha1_algorithm, sha1_ctx, in, sizeof ( in ) );
-		hmac_final ( &sha1_algorithm, sha1_ctx, keym, &key_len, out );
+		hmac_key_final ( &sha1_algorithm, key_ctx, sha1_ctx, out );
 
-		if ( prf_len <= SHA1_SIZE ) {
+		if ( prf_len <= SHA1_DIGEST_SIZE ) {
 			memcpy ( prf, out, prf_len );
 			break;
 		}
 
-		memcpy ( prf, out, SHA1_SIZE );
-		prf_len -= SHA1_SIZE;
-		prf += SHA1_SIZE;
+		memcpy ( prf, out, SHA1_DIGEST_SIZE );
+		prf_len -= SHA1_DIGEST_SIZE;
+		prf += SHA1_DIGEST_SIZE;
 	}
 }
 
 /**
  * PBKDF2 key derivation function inner block operation
  *
- * @v passphrase	Passphrase from which to derive key
- * @v pass_len		Length of passphrase
+ * @v key_ctx		Precomputed HMAC key context for the passphrase
  * @v salt		Salt to include in key
  * @v salt_len		Length of salt
  * @v iterations	Number of iterations of SHA1 to perform
  * @v blocknr		Index of this block, starting at 1
- * @ret block		SHA1_SIZE bytes of PBKDF2 data
+ * @ret block		SHA1_DIGEST_SIZE bytes of PBKDF2 data
  *
  * The operation of this function is described in RFC 2898.
  */
-static void pbkdf2_sha1_f ( const void *passphrase, size_t pass_len,
+static void pbkdf2_sha1_f ( const void *key_ctx,
 			    const void *salt, size_t salt_len,
 			    int iterations, u32 blocknr, u8 *block )
 {
-	u8 pass[pass_len];	/* modifiable passphrase */
 	u8 in[salt_len + 4];	/* input buffer to first round */
-	u8 last[SHA1_SIZE];	/* output of round N, input of N+1 */
+	u8 last[SHA1_DIGEST_SIZE];	/* output of round N, input of N+1 */
 	u8 sha1_ctx[SHA1_CTX_SIZE];
 	u8 *next_in = in;	/* changed to `last' after first round */
 	int next_size = sizeof ( in );
@@ -105,22 +103,21 @@ static void pbkdf2_sha1_f ( const void *passphrase, size_t pass_len,
 
 	blocknr = htonl ( blocknr );
 
-	memcpy ( pass, passphrase, pass_len );
 	memcpy ( in, salt, salt_len );
 	memcpy ( in + salt_len, &blocknr, 4 );
-	memset ( block, 0, SHA1_SIZE );
+	memset ( block, 0, SHA1_DIGEST_SIZE );
 
 	for ( i = 0; i < iterations; i++ ) {
-		hmac_init ( &sha1_algorithm, sha1_ctx, pass, &pass_len );
+		hmac_key_start ( &sha1_algorithm, key_ctx, sha1_ctx );
 		hmac_update ( &sha1_algorithm, sha1_ctx, next_in, next_size );
-		hmac_final ( &sha1_algorithm, sha1_ctx, pass, &pass_len, last );
+		hmac_key_final ( &sha1_algorithm, key_ctx, sha1_ctx, last );
 
-		for ( j = 0; j < SHA1_SIZE; j++ ) {
+		for ( j = 0; j < SHA1_DIGEST_SIZE; j++ ) {
 			block[j] ^= last[j];
 		}
 
 		next_in = last;
-		next_size = SHA1_SIZE;
+		next_size = SHA1_DIGEST_SIZE;
 	}
 }
 
@@ -146,20 +143,23 @@ void pbkdf2_sha1 ( const void *passphrase, size_t pass_len,
 		   const void *salt, size_t salt_len,
 		   int iterations, void *key, size_t key_len )
 {
-	u32 blocks = ( key_len + SHA1_SIZE - 1 ) / SHA1_SIZE;
+	u32 blocks = ( key_len + SHA1_DIGEST_SIZE - 1 ) / SHA1_DIGEST_SIZE;
 	u32 blk;
-	u8 buf[SHA1_SIZE];
+	u8 buf[SHA1_DIGEST_SIZE];
+	u8 key_ctx[2 * SHA1_CTX_SIZE]; /* precomputed HMAC key */
+
+	hmac_key_init ( &sha1_algorithm, key_ctx, passphrase, pass_len );
 
 	for ( blk = 1; blk <= blocks; blk++ ) {
-		pbkdf2_sha1_f ( passphrase, pass_len, salt, salt_len,
+		pbkdf2_sha1_f ( key_ctx, salt, salt_len,
 				iterations, blk, buf );
-		if ( key_len <= SHA1_SIZE ) {
+		if ( key_len <= SHA1_DIGEST_SIZE ) {
 			memcpy ( key, buf, key_len );
 			break;
 		}
 
-		memcpy ( key, buf, SHA1_SIZE );
-		key_len -= SHA1_SIZE;
-		key += SHA1_SIZE;
+		memcpy ( key, buf, SHA1_DIGEST_SIZE );
+		key_len -= SHA1_DIGEST_SIZE;
+		key += SHA1_DIGEST_SIZE;
 	}
 }
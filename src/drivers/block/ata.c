@@ -70,6 +70,33 @@ int ata_command ( struct interface *control, struct interface *data,
 	return tag;
 }
 
+/**
+ * Get maximum number of blocks per ATA command
+ *
+ * @v control		ATA control interface
+ * @ret max_count	Maximum number of blocks per command, or zero
+ *
+ * The underlying transport may impose a limit on the size of a single
+ * command that is not known until after the ATA device is opened.
+ */
+unsigned int ata_max_count ( struct interface *control ) {
+	struct interface *dest;
+	ata_max_count_TYPE ( void * ) *op =
+		intf_get_dest_op ( control, ata_max_count, &dest );
+	void *object = intf_object ( dest );
+	unsigned int max_count;
+
+	if ( op ) {
+		max_count = op ( object );
+	} else {
+		/* Default is to impose no additional limit */
+		max_count = 0;
+	}
+
+	intf_put ( dest );
+	return max_count;
+}
+
 /******************************************************************************
  *
  * ATA devices and commands
@@ -374,6 +401,7 @@ static void atacmd_identify_done ( struct ata_command *atacmd, int rc ) {
 	struct ata_identify_private *priv = atacmd_priv ( atacmd );
 	struct ata_identity *identity = &priv->identity;
 	struct block_device_capacity capacity;
+	unsigned int max_count;
 
 	/* Close if command failed */
 	if ( rc != 0 ) {
@@ -390,6 +418,9 @@ static void atacmd_identify_done ( struct ata_command *atacmd, int rc ) {
 	}
 	capacity.blksize = ATA_SECTOR_SIZE;
 	capacity.max_count = atadev->max_count;
+	max_count = ata_max_count ( &atadev->ata );
+	if ( max_count && ( max_count < capacity.max_count ) )
+		capacity.max_count = max_count;
 	DBGC ( atadev, "ATA %p is a %s\n", atadev, ata_model ( identity ) );
 	DBGC ( atadev, "ATA %p has %#llx blocks (%ld MB) and uses %s\n",
 	       atadev, capacity.blocks,
@@ -33,6 +33,7 @@ FILE_LICENCE ( GPL2_ONLY );
 #ifndef _E1000_H_
 #define _E1000_H_
 
+#include <config/general.h>
 #include "e1000_api.h"
 
 #define BAR_0		0
@@ -276,8 +277,15 @@ struct e1000_adapter {
 	/* upper limit parameter for tx desc size */
 	u32 tx_desc_pwr;
 
-#define NUM_TX_DESC	8
-#define NUM_RX_DESC	8
+/** Number of transmit descriptors */
+#define NUM_TX_DESC	E1000_NUM_TX_DESC
+/** Maximum number of receive descriptors */
+#define NUM_RX_DESC	E1000_NUM_RX_DESC
+/** Minimum number of receive descriptors
+ *
+ * The receive descriptor ring length must be a multiple of 128 bytes.
+ */
+#define MIN_RX_DESC	8
 
 	struct io_buffer *tx_iobuf[NUM_TX_DESC];
 	struct io_buffer *rx_iobuf[NUM_RX_DESC];
@@ -293,11 +301,31 @@ struct e1000_adapter {
 	uint32_t tx_fill_ctr;
 
 	uint32_t rx_curr;
+	/** Number of receive descriptors in use */
+	uint32_t num_rx_desc;
 
 	uint32_t ioaddr;
 	uint32_t irqno;
 };
 
+/* Ring sizes must be powers of two and at least MIN_RX_DESC, so that
+ * the rx_iobuf[] array covers any ring chosen at open time.
+ */
+#if ( ( NUM_TX_DESC < MIN_RX_DESC ) || ( NUM_TX_DESC & ( NUM_TX_DESC - 1 ) ) )
+#error "E1000_NUM_TX_DESC must be a power of two and at least 8"
+#endif
+#if ( ( NUM_RX_DESC < MIN_RX_DESC ) || ( NUM_RX_DESC & ( NUM_RX_DESC - 1 ) ) )
+#error "E1000_NUM_RX_DESC must be a power of two and at least 8"
+#endif
+
+/* Descriptor ring lengths must be multiples of 128 bytes */
+extern char e1000_tx_ring_len_check[ ( ( NUM_TX_DESC *
+					sizeof ( struct e1000_tx_desc ) )
+				      % 128 ) ? -1 : 1 ];
+extern char e1000_rx_ring_len_check[ ( ( MIN_RX_DESC *
+					sizeof ( struct e1000_rx_desc ) )
+				      % 128 ) ? -1 : 1 ];
+
 #define E1000_FLAG_HAS_SMBUS                (1 << 0)
 #define E1000_FLAG_HAS_INTR_MODERATION      (1 << 4)
 #define E1000_FLAG_BAD_TX_CARRIER_STATS_FD  (1 << 6)
@@ -47,6 +47,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <ipxe/ethernet.h>
 #include <ipxe/iobuf.h>
 #include <ipxe/netdevice.h>
+#include <config/general.h>
 
 /* Begin OS Dependencies */
 
@@ -169,8 +170,15 @@ struct e1000_adapter {
 	unsigned int flags;
 	unsigned int flags2;
 
-#define NUM_TX_DESC	8
-#define NUM_RX_DESC	8
+/** Number of transmit descriptors */
+#define NUM_TX_DESC	E1000_NUM_TX_DESC
+/** Maximum number of receive descriptors */
+#define NUM_RX_DESC	E1000_NUM_RX_DESC
+/** Minimum number of receive descriptors
+ *
+ * The receive descriptor ring length must be a multiple of 128 bytes.
+ */
+#define MIN_RX_DESC	8
 
 	struct io_buffer *tx_iobuf[NUM_TX_DESC];
 	struct io_buffer *rx_iobuf[NUM_RX_DESC];
@@ -186,6 +194,8 @@ struct e1000_adapter {
 	uint32_t tx_fill_ctr;
 
 	uint32_t rx_curr;
+	/** Number of receive descriptors in use */
+	uint32_t num_rx_desc;
 
 	uint32_t ioaddr;
 	uint32_t irqno;
@@ -195,6 +205,24 @@ struct e1000_adapter {
         uint32_t txd_cmd;
 };
 
+/* Ring sizes must be powers of two and at least MIN_RX_DESC, so that
+ * the rx_iobuf[] array covers any ring chosen at open time.
+ */
+#if ( ( NUM_TX_DESC < MIN_RX_DESC ) || ( NUM_TX_DESC & ( NUM_TX_DESC - 1 ) ) )
+#error "E1000_NUM_TX_DESC must be a power of two and at least 8"
+#endif
+#if ( ( NUM_RX_DESC < MIN_RX_DESC ) || ( NUM_RX_DESC & ( NUM_RX_DESC - 1 ) ) )
+#error "E1000_NUM_RX_DESC must be a power of two and at least 8"
+#endif
+
+/* Descriptor ring lengths must be multiples of 128 bytes */
+extern char e1000e_tx_ring_len_check[ ( ( NUM_TX_DESC *
+					sizeof ( struct e1000_tx_desc ) )
+				      % 128 ) ? -1 : 1 ];
+extern char e1000e_rx_ring_len_check[ ( ( MIN_RX_DESC *
+					sizeof ( struct e1000_rx_desc ) )
+				      % 128 ) ? -1 : 1 ];
+
 struct e1000_info {
 	enum e1000_mac_type	mac;
 	unsigned int		flags;
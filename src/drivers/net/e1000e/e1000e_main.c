@@ -34,6 +34,14 @@ FILE_LICENCE ( GPL2_OR_LATER );
 
 #include "e1000e.h"
 
+/* Disambiguate the various receive error causes */
+#define ENOBUFS_RX_OVERRUN __einfo_error ( EINFO_ENOBUFS_RX_OVERRUN )
+#define EINFO_ENOBUFS_RX_OVERRUN \
+	__einfo_uniqify ( EINFO_ENOBUFS, 0x01, "Receive overrun" )
+#define ENOBUFS_RX_MISSED __einfo_error ( EINFO_ENOBUFS_RX_MISSED )
+#define EINFO_ENOBUFS_RX_MISSED \
+	__einfo_uniqify ( EINFO_ENOBUFS, 0x02, "Missed packet" )
+
 static s32 e1000e_get_variants_82571(struct e1000_adapter *adapter)
 {
 	struct e1000_hw *hw = &adapter->hw;
@@ -685,6 +693,7 @@ static void e1000e_free_rx_resources ( struct e1000_adapter *adapter )
 static int e1000e_refill_rx_ring ( struct e1000_adapter *adapter )
 {
 	int i, rx_curr;
+	int rx_tail = -1;
 	int rc = 0;
 	struct e1000_rx_desc *rx_curr_desc;
 	struct e1000_hw *hw = &adapter->hw;
@@ -692,8 +701,8 @@ static int e1000e_refill_rx_ring ( struct e1000_adapter *adapter )
 
 	DBGP ("e1000_refill_rx_ring\n");
 
-	for ( i = 0; i < NUM_RX_DESC; i++ ) {
-		rx_curr = ( ( adapter->rx_curr + i ) % NUM_RX_DESC );
+	for ( i = 0; i < ( int ) adapter->num_rx_desc; i++ ) {
+		rx_curr = ( ( adapter->rx_curr + i ) % adapter->num_rx_desc );
 		rx_curr_desc = adapter->rx_base + rx_curr;
 
 		if ( rx_curr_desc->status & E1000_RXD_STAT_DD )
@@ -713,10 +722,18 @@ static int e1000e_refill_rx_ring ( struct e1000_adapter *adapter )
 			break;
 		} else {
 			rx_curr_desc->buffer_addr = virt_to_bus ( iob->data );
-
-			E1000_WRITE_REG ( hw, E1000_RDT(0), rx_curr );
+			rx_tail = rx_curr;
 		}
 	}
+
+	/* Hand all refilled descriptors to the NIC with a single
+	 * tail pointer update
+	 */
+	if ( rx_tail >= 0 ) {
+		wmb();
+		E1000_WRITE_REG ( hw, E1000_RDT(0), rx_tail );
+	}
+
 	return rc;
 }
 
@@ -745,6 +762,13 @@ static int e1000e_setup_rx_resources ( struct e1000_adapter *adapter )
 	}
 	memset ( adapter->rx_base, 0, adapter->rx_ring_size );
 
+	/* Limit receive ring to what the free heap can accommodate */
+	adapter->num_rx_desc =
+		netdev_rx_fill_count ( NUM_RX_DESC, MIN_RX_DESC,
+				       MAXIMUM_ETHERNET_VLAN_SIZE );
+	DBG ( "e1000e using %d of %d RX descriptors\n",
+	      adapter->num_rx_desc, NUM_RX_DESC );
+
 	for ( i = 0; i < NUM_RX_DESC; i++ ) {
 		/* let e1000_refill_rx_ring() io_buffer allocations */
 		adapter->rx_iobuf[i] = NULL;
@@ -784,10 +808,11 @@ static void e1000e_configure_rx ( struct e1000_adapter *adapter )
 
 	E1000_WRITE_REG ( hw, E1000_RDBAL(0), virt_to_bus ( adapter->rx_base ) );
 	E1000_WRITE_REG ( hw, E1000_RDBAH(0), 0 );
-	E1000_WRITE_REG ( hw, E1000_RDLEN(0), adapter->rx_ring_size );
+	E1000_WRITE_REG ( hw, E1000_RDLEN(0), ( adapter->num_rx_desc *
+						sizeof ( *adapter->rx_base ) ) );
 
 	E1000_WRITE_REG ( hw, E1000_RDH(0), 0 );
-	E1000_WRITE_REG ( hw, E1000_RDT(0), NUM_RX_DESC - 1 );
+	E1000_WRITE_REG ( hw, E1000_RDT(0), adapter->num_rx_desc - 1 );
 
 	/* Enable Receives */
 	rctl |=	 E1000_RCTL_EN | E1000_RCTL_BAM | E1000_RCTL_SZ_2048 |
@@ -856,7 +881,8 @@ static void e1000e_process_rx_packets ( struct net_device *netdev )
 
 		memset ( rx_curr_desc, 0, sizeof ( *rx_curr_desc ) );
 
-		adapter->rx_curr = ( adapter->rx_curr + 1 ) % NUM_RX_DESC;
+		adapter->rx_curr = ( ( adapter->rx_curr + 1 ) %
+				     adapter->num_rx_desc );
 	}
 }
 
@@ -971,6 +997,12 @@ static void e1000e_poll ( struct net_device *netdev )
 
 	e1000e_process_rx_packets ( netdev );
 
+	/* Record receive overruns and missed packets */
+	if ( icr & E1000_ICR_RXO )
+		netdev_rx_err ( netdev, NULL, -ENOBUFS_RX_OVERRUN );
+	netdev_rx_err_count ( netdev, -ENOBUFS_RX_MISSED,
+			      E1000_READ_REG ( hw, E1000_MPC ) );
+
 	e1000e_refill_rx_ring(adapter);
 }
 
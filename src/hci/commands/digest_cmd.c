@@ -28,6 +28,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <ipxe/crypto.h>
 #include <ipxe/md5.h>
 #include <ipxe/sha1.h>
+#include <ipxe/imgdigest.h>
 
 /** @file
  *
@@ -58,12 +59,7 @@ static int digest_exec ( int argc, char **argv,
 			 struct digest_algorithm *digest ) {
 	struct digest_options opts;
 	struct image *image;
-	uint8_t digest_ctx[digest->ctxsize];
 	uint8_t digest_out[digest->digestsize];
-	uint8_t buf[128];
-	size_t offset;
-	size_t len;
-	size_t frag_len;
 	int i;
 	unsigned j;
 	int rc;
@@ -77,21 +73,10 @@ static int digest_exec ( int argc, char **argv,
 		/* find image */
 		if ( ( rc = parse_image ( argv[i], &image ) ) != 0 )
 			continue;
-		offset = 0;
-		len = image->len;
-
-		/* calculate digest */
-		digest_init ( digest, digest_ctx );
-		while ( len ) {
-			frag_len = len;
-			if ( frag_len > sizeof ( buf ) )
-				frag_len = sizeof ( buf );
-			copy_from_user ( buf, image->data, offset, frag_len );
-			digest_update ( digest, digest_ctx, buf, frag_len );
-			len -= frag_len;
-			offset += frag_len;
-		}
-		digest_final ( digest, digest_ctx, digest_out );
+
+		/* get digest (usually calculated during download) */
+		if ( ( rc = image_digest ( image, digest, digest_out ) ) != 0 )
+			continue;
 
 		for ( j = 0 ; j < sizeof ( digest_out ) ; j++ )
 			printf ( "%02x", digest_out[j] );
@@ -39,18 +39,23 @@ FILE_LICENCE ( GPL2_OR_LATER );
 struct imgfetch_options {
 	/** Image name */
 	const char *name;
+	/** Expected image digest */
+	const char *digest;
 };
 
 /** "imgfetch" option list */
 static struct option_descriptor imgfetch_opts[] = {
 	OPTION_DESC ( "name", 'n', required_argument,
 		      struct imgfetch_options, name, parse_string ),
+	OPTION_DESC ( "digest", 'd', required_argument,
+		      struct imgfetch_options, digest, parse_string ),
 };
 
 /** "imgfetch" command descriptor */
 static struct command_descriptor imgfetch_cmd =
 	COMMAND_DESC ( struct imgfetch_options, imgfetch_opts, 1, MAX_ARGUMENTS,
-		       "[--name <name>] <uri> [<arguments>...]" );
+		       "[--name <name>] [--digest <hex>] <uri> "
+		       "[<arguments>...]" );
 
 /**
  * The "imgfetch" and friends command body
@@ -90,7 +95,7 @@ static int imgfetch_core_exec ( int argc, char **argv,
 
 	/* Fetch the image */
 	if ( ( rc = imgdownload_string ( uri_string, opts.name, cmdline,
-					 action ) ) != 0 ) {
+					 opts.digest, action ) ) != 0 ) {
 		printf ( "Could not %s %s: %s\n",
 			 action_name, uri_string, strerror ( rc ) );
 		goto err_imgdownload;
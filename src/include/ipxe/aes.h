@@ -1,21 +1,40 @@
 #ifndef _IPXE_AES_H
 #define _IPXE_AES_H
 
+/** @file
+ *
+ * AES algorithm
+ *
+ */
+
 FILE_LICENCE ( GPL2_OR_LATER );
 
+#include <stdint.h>
+
 struct cipher_algorithm;
 
 /** Basic AES blocksize */
 #define AES_BLOCKSIZE 16
 
-#include "crypto/axtls/crypto.h"
+/** Maximum number of AES rounds */
+#define AES_MAX_ROUNDS 14
+
+/** Number of 32-bit words in an AES key schedule */
+#define AES_SCHEDULE_WORDS ( ( AES_MAX_ROUNDS + 1 ) * \
+			     ( AES_BLOCKSIZE / sizeof ( uint32_t ) ) )
 
 /** AES context */
 struct aes_context {
-	/** AES context for AXTLS */
-	AES_CTX axtls_ctx;
-	/** Cipher is being used for decrypting */
-	int decrypting;
+	/** Encryption key schedule
+	 *
+	 * Round keys are held as little-endian columns, so that the
+	 * in-memory layout matches the byte order of the AES state.
+	 */
+	uint32_t encrypt[AES_SCHEDULE_WORDS];
+	/** Decryption key schedule (for the equivalent inverse cipher) */
+	uint32_t decrypt[AES_SCHEDULE_WORDS];
+	/** Number of rounds */
+	unsigned int rounds;
 };
 
 /** AES context size */
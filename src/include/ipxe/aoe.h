@@ -106,8 +106,13 @@ struct aoehdr {
 /** AoE tag magic marker */
 #define AOE_TAG_MAGIC 0x18ae0000
 
-/** Maximum number of sectors per packet */
-#define AOE_MAX_COUNT 2
+/** Maximum number of sectors per packet
+ *
+ * The ATA sector count register is eight bits wide.  The number of
+ * sectors actually used is further limited by the network device MTU
+ * and by the target's advertised sector count.
+ */
+#define AOE_MAX_COUNT 255
 
 /** AoE boot firmware table signature */
 #define ABFT_SIG ACPI_SIGNATURE ( 'a', 'B', 'F', 'T' )
@@ -0,0 +1,150 @@
+#ifndef _IPXE_BIGINT_H
+#define _IPXE_BIGINT_H
+
+/** @file
+ *
+ * Big integer support
+ *
+ * Big integers are fixed-width arrays of word-sized elements, stored
+ * least significant element first.  All operands of an operation
+ * share the same width, and no operation allocates memory: any
+ * scratch space is supplied by the caller.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stddef.h>
+#include <bits/bigint.h>
+
+/** Number of bits in a big integer element */
+#define BIGINT_ELEMENT_BITS ( 8 * sizeof ( bigint_element_t ) )
+
+/**
+ * Define a big-integer type
+ *
+ * @v size		Number of elements
+ * @ret bigint_t	Big integer type
+ */
+#define bigint_t( size )						\
+	struct {							\
+		bigint_element_t element[ (size) ];			\
+	}
+
+/**
+ * Determine number of elements required for a big-integer type
+ *
+ * @v len		Maximum length of big integer, in bytes
+ * @ret size		Number of elements
+ */
+#define bigint_required_size( len )					\
+	( ( (len) + sizeof ( bigint_element_t ) - 1 ) /			\
+	  sizeof ( bigint_element_t ) )
+
+/**
+ * Determine number of elements in big-integer type
+ *
+ * @v bigint		Big integer
+ * @ret size		Number of elements
+ */
+#define bigint_size( bigint )						\
+	( sizeof ( *(bigint) ) / sizeof ( (bigint)->element[0] ) )
+
+/**
+ * Initialise big integer
+ *
+ * @v value		Big integer to initialise
+ * @v data		Raw data (in big-endian order)
+ * @v len		Length of raw data
+ */
+#define bigint_init( value, data, len ) do {				\
+	unsigned int size = bigint_size ( value );			\
+	bigint_init_raw ( (value)->element, size, (data), (len) );	\
+	} while ( 0 )
+
+/**
+ * Finalise big integer
+ *
+ * @v value		Big integer to finalise
+ * @v out		Output buffer (in big-endian order)
+ * @v len		Length of output buffer
+ */
+#define bigint_done( value, out, len ) do {				\
+	unsigned int size = bigint_size ( value );			\
+	bigint_done_raw ( (value)->element, size, (out), (len) );	\
+	} while ( 0 )
+
+/**
+ * Compare big integers
+ *
+ * @v value		Big integer
+ * @v reference		Reference big integer
+ * @ret geq		Big integer is greater than or equal to the reference
+ */
+#define bigint_is_geq( value, reference ) ( {				\
+	unsigned int size = bigint_size ( value );			\
+	bigint_is_geq_raw ( (value)->element, (reference)->element,	\
+			    size ); } )
+
+/**
+ * Find highest bit set in big integer
+ *
+ * @v value		Big integer
+ * @ret max_bit		Highest bit set + 1 (or 0 if no bits set)
+ */
+#define bigint_max_set_bit( value ) ( {					\
+	unsigned int size = bigint_size ( value );			\
+	bigint_max_set_bit_raw ( (value)->element, size ); } )
+
+/**
+ * Calculate temporary working space required for modular exponentiation
+ *
+ * @v modulus		Big integer modulus
+ * @ret len		Length of temporary working space
+ */
+#define bigint_mod_exp_tmp_len( modulus )				\
+	bigint_mod_exp_tmp_len_raw ( bigint_size ( modulus ) )
+
+/**
+ * Calculate temporary working space required for modular exponentiation
+ *
+ * @v size		Number of elements in modulus
+ * @ret len		Length of temporary working space
+ */
+#define bigint_mod_exp_tmp_len_raw( size )				\
+	( ( 3 * (size) + 1 ) * sizeof ( bigint_element_t ) )
+
+/**
+ * Perform modular exponentiation of big integers
+ *
+ * @v base		Big integer base
+ * @v modulus		Big integer modulus
+ * @v exponent		Big integer exponent
+ * @v result		Big integer to hold result
+ * @v tmp		Temporary working space
+ */
+#define bigint_mod_exp( base, modulus, exponent, result, tmp ) do {	\
+	unsigned int size = bigint_size ( base );			\
+	unsigned int exponent_size = bigint_size ( exponent );		\
+	bigint_mod_exp_raw ( (base)->element, (modulus)->element,	\
+			     (exponent)->element, (result)->element,	\
+			     size, exponent_size, (tmp) );		\
+	} while ( 0 )
+
+extern void bigint_init_raw ( bigint_element_t *value0, unsigned int size,
+			      const void *data, size_t len );
+extern void bigint_done_raw ( const bigint_element_t *value0,
+			      unsigned int size, void *out, size_t len );
+extern int bigint_is_geq_raw ( const bigint_element_t *value0,
+			       const bigint_element_t *reference0,
+			       unsigned int size );
+extern unsigned int bigint_max_set_bit_raw ( const bigint_element_t *value0,
+					     unsigned int size );
+extern void bigint_mod_exp_raw ( const bigint_element_t *base0,
+				 const bigint_element_t *modulus0,
+				 const bigint_element_t *exponent0,
+				 bigint_element_t *result0,
+				 unsigned int size, unsigned int exponent_size,
+				 void *tmp );
+
+#endif /* _IPXE_BIGINT_H */
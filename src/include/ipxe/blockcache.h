@@ -0,0 +1,105 @@
+#ifndef _IPXE_BLOCKCACHE_H
+#define _IPXE_BLOCKCACHE_H
+
+/** @file
+ *
+ * Block device cache
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <ipxe/list.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/blockdev.h>
+
+/** A block cache line */
+struct block_cache_line {
+	/** List of lines, most recently used first */
+	struct list_head list;
+	/** Starting logical block address */
+	uint64_t lba;
+	/** Flags */
+	unsigned int flags;
+};
+
+/** Block cache line contains valid data */
+#define BLOCK_CACHE_LINE_VALID 0x0001
+
+/** Block cache statistics */
+struct block_cache_statistics {
+	/** Number of blocks read from the cache */
+	unsigned long hits;
+	/** Number of blocks read from the underlying device */
+	unsigned long misses;
+	/** Number of blocks read ahead of a sequential reader */
+	unsigned long readahead;
+	/** Number of blocks read directly into the caller's buffer */
+	unsigned long direct;
+	/** Number of blocks copied into or out of cache lines */
+	unsigned long copied;
+	/** Number of times the cache storage was discarded */
+	unsigned long discards;
+};
+
+/** A block cache */
+struct block_cache {
+	/** List of all block caches */
+	struct list_head list;
+	/**
+	 * Read blocks from underlying device
+	 *
+	 * @v cache		Block cache
+	 * @v lba		Starting logical block address
+	 * @v count		Number of logical blocks
+	 * @v buffer		Data buffer
+	 * @ret rc		Return status code
+	 */
+	int ( * read ) ( struct block_cache *cache, uint64_t lba,
+			 unsigned int count, userptr_t buffer );
+
+	/** Underlying device capacity */
+	struct block_device_capacity capacity;
+	/** Number of blocks per cache line */
+	unsigned int line_count;
+	/** Length of a cache line */
+	size_t line_len;
+	/** Number of cache lines */
+	unsigned int num_lines;
+	/** Number of cache lines usable as a fill buffer */
+	unsigned int fill_lines;
+
+	/** Cache lines (or NULL if storage is not allocated) */
+	struct block_cache_line *lines;
+	/** List of cache lines, most recently used first */
+	struct list_head lru;
+	/** Cache line data, followed by the fill buffer */
+	userptr_t data;
+	/** Cache is in use and must not be discarded */
+	int busy;
+
+	/** Block following the most recent read */
+	uint64_t next_lba;
+	/** Current read-ahead window, in cache lines */
+	unsigned int readahead;
+
+	/** Statistics */
+	struct block_cache_statistics stats;
+};
+
+extern void block_cache_init ( struct block_cache *cache,
+			       int ( * read ) ( struct block_cache *cache,
+						uint64_t lba,
+						unsigned int count,
+						userptr_t buffer ) );
+extern void block_cache_reset ( struct block_cache *cache,
+				struct block_device_capacity *capacity );
+extern void block_cache_invalidate ( struct block_cache *cache );
+extern void block_cache_fini ( struct block_cache *cache );
+extern int block_cache_read ( struct block_cache *cache, uint64_t lba,
+			      unsigned int count, userptr_t buffer );
+extern void block_cache_write ( struct block_cache *cache, uint64_t lba,
+				unsigned int count, userptr_t buffer );
+
+#endif /* _IPXE_BLOCKCACHE_H */
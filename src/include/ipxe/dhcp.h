@@ -306,6 +306,21 @@ struct dhcp_client_uuid {
  */
 #define DHCP_EB_SKIP_SAN_BOOT DHCP_ENCAP_OPT ( DHCP_EB_ENCAP, 0x09 )
 
+/** Network device receive batch size
+ *
+ * This is the maximum number of received packets that will be
+ * processed from each network device's receive queue on each poll of
+ * the network stack.
+ */
+#define DHCP_EB_RX_BATCH DHCP_ENCAP_OPT ( DHCP_EB_ENCAP, 0x0a )
+
+/** DNS cache maximum TTL
+ *
+ * This is the maximum time, in seconds, for which a DNS result will
+ * be cached.  A value of zero disables (and flushes) the DNS cache.
+ */
+#define DHCP_EB_DNS_CACHE_TTL DHCP_ENCAP_OPT ( DHCP_EB_ENCAP, 0x0b )
+
 /*
  * Tags in the range 0x10-0x7f are reserved for feature markers
  *
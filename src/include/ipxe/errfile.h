@@ -60,6 +60,8 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #define ERRFILE_null_sanboot	       ( ERRFILE_CORE | 0x00140000 )
 #define ERRFILE_edd		       ( ERRFILE_CORE | 0x00150000 )
 #define ERRFILE_parseopt	       ( ERRFILE_CORE | 0x00160000 )
+#define ERRFILE_imgdigest	       ( ERRFILE_CORE | 0x00170000 )
+#define ERRFILE_blockcache	       ( ERRFILE_CORE | 0x00180000 )
 
 #define ERRFILE_eisa		     ( ERRFILE_DRIVER | 0x00000000 )
 #define ERRFILE_isa		     ( ERRFILE_DRIVER | 0x00010000 )
@@ -195,6 +197,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #define ERRFILE_fcoe			( ERRFILE_NET | 0x002e0000 )
 #define ERRFILE_fcns			( ERRFILE_NET | 0x002f0000 )
 #define ERRFILE_vlan			( ERRFILE_NET | 0x00300000 )
+#define ERRFILE_neighbour		( ERRFILE_NET | 0x00310000 )
 
 #define ERRFILE_image		      ( ERRFILE_IMAGE | 0x00000000 )
 #define ERRFILE_elf		      ( ERRFILE_IMAGE | 0x00010000 )
@@ -211,7 +214,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #define ERRFILE_imgmgmt		      ( ERRFILE_OTHER | 0x00050000 )
 #define ERRFILE_pxe_tftp	      ( ERRFILE_OTHER | 0x00060000 )
 #define ERRFILE_pxe_udp		      ( ERRFILE_OTHER | 0x00070000 )
-#define ERRFILE_axtls_aes	      ( ERRFILE_OTHER | 0x00080000 )
+#define ERRFILE_aes		      ( ERRFILE_OTHER | 0x00080000 )
 #define ERRFILE_cipher		      ( ERRFILE_OTHER | 0x00090000 )
 #define ERRFILE_image_cmd	      ( ERRFILE_OTHER | 0x000a0000 )
 #define ERRFILE_uri_test	      ( ERRFILE_OTHER | 0x000b0000 )
@@ -239,6 +242,17 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #define ERRFILE_bofm		      ( ERRFILE_OTHER | 0x00210000 )
 #define ERRFILE_prompt		      ( ERRFILE_OTHER | 0x00220000 )
 #define ERRFILE_nvo_cmd		      ( ERRFILE_OTHER | 0x00230000 )
+#define ERRFILE_retry_test	      ( ERRFILE_OTHER | 0x00240000 )
+#define ERRFILE_tcpip_test	      ( ERRFILE_OTHER | 0x00250000 )
+#define ERRFILE_crc32_test	      ( ERRFILE_OTHER | 0x00260000 )
+#define ERRFILE_malloc_test	      ( ERRFILE_OTHER | 0x00270000 )
+#define ERRFILE_hmac_test	      ( ERRFILE_OTHER | 0x00280000 )
+#define ERRFILE_digest_test	      ( ERRFILE_OTHER | 0x00290000 )
+#define ERRFILE_aes_test	      ( ERRFILE_OTHER | 0x002a0000 )
+#define ERRFILE_bigint		      ( ERRFILE_OTHER | 0x002b0000 )
+#define ERRFILE_rsa		      ( ERRFILE_OTHER | 0x002c0000 )
+#define ERRFILE_bigint_test	      ( ERRFILE_OTHER | 0x002d0000 )
+#define ERRFILE_test		      ( ERRFILE_OTHER | 0x002e0000 )
 
 /** @} */
 
@@ -8,6 +8,7 @@
 
 FILE_LICENCE ( GPL2_OR_LATER );
 
+#include <string.h>
 #include <ipxe/crypto.h>
 
 /**
@@ -24,9 +25,36 @@ static inline void hmac_update ( struct digest_algorithm *digest,
 	digest_update ( digest, digest_ctx, data, len );
 }
 
+/**
+ * Get size of precomputed HMAC key context
+ *
+ * @v digest		Digest algorithm to use
+ * @ret len		Length of HMAC key context
+ */
+static inline size_t hmac_key_ctxsize ( struct digest_algorithm *digest ) {
+	return ( 2 * digest->ctxsize );
+}
+
+/**
+ * Initialise HMAC using precomputed key context
+ *
+ * @v digest		Digest algorithm to use
+ * @v key_ctx		HMAC key context
+ * @v digest_ctx	Digest context
+ */
+static inline void hmac_key_start ( struct digest_algorithm *digest,
+				    const void *key_ctx, void *digest_ctx ) {
+	memcpy ( digest_ctx, key_ctx, digest->ctxsize );
+}
+
 extern void hmac_init ( struct digest_algorithm *digest, void *digest_ctx,
 			void *key, size_t *key_len );
 extern void hmac_final ( struct digest_algorithm *digest, void *digest_ctx,
 			 void *key, size_t *key_len, void *hmac );
+extern void hmac_key_init ( struct digest_algorithm *digest, void *key_ctx,
+			    const void *key, size_t key_len );
+extern void hmac_key_final ( struct digest_algorithm *digest,
+			     const void *key_ctx, void *digest_ctx,
+			     void *hmac );
 
 #endif /* _IPXE_HMAC_H */
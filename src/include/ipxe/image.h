@@ -14,9 +14,12 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <ipxe/list.h>
 #include <ipxe/uaccess.h>
 #include <ipxe/refcnt.h>
+#include <ipxe/md5.h>
+#include <ipxe/sha1.h>
 
 struct uri;
 struct image_type;
+struct digest_algorithm;
 
 /** An executable image */
 struct image {
@@ -39,6 +42,12 @@ struct image {
 	userptr_t data;
 	/** Length of raw file image */
 	size_t len;
+	/** MD5 digest of raw file image, if IMAGE_MD5 is set */
+	uint8_t md5[MD5_DIGEST_SIZE];
+	/** SHA-1 digest of raw file image, if IMAGE_SHA1 is set */
+	uint8_t sha1[SHA1_DIGEST_SIZE];
+	/** Digest algorithm to calculate during download, or NULL */
+	struct digest_algorithm *digest;
 
 	/** Image type, if known */
 	struct image_type *type;
@@ -64,6 +73,12 @@ struct image {
 /** Image is selected for execution */
 #define IMAGE_SELECTED 0x0002
 
+/** Image MD5 digest is known */
+#define IMAGE_MD5 0x0004
+
+/** Image SHA-1 digest is known */
+#define IMAGE_SHA1 0x0008
+
 /** An executable image type */
 struct image_type {
 	/** Name of this image type */
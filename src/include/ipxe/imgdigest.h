@@ -0,0 +1,23 @@
+#ifndef _IPXE_IMGDIGEST_H
+#define _IPXE_IMGDIGEST_H
+
+/** @file
+ *
+ * Image digests
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+struct interface;
+struct image;
+struct digest_algorithm;
+
+extern int add_image_digest ( struct interface *xfer, struct image *image,
+			      struct interface **next );
+extern int image_digest ( struct image *image,
+			  struct digest_algorithm *digest, void *out );
+extern int image_expect_digest ( struct image *image, const char *expected );
+extern int image_verify_digest ( struct image *image, const char *expected );
+
+#endif /* _IPXE_IMGDIGEST_H */
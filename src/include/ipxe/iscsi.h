@@ -10,6 +10,7 @@
 FILE_LICENCE ( GPL2_OR_LATER );
 
 #include <stdint.h>
+#include <ipxe/list.h>
 #include <ipxe/socket.h>
 #include <ipxe/scsi.h>
 #include <ipxe/chap.h>
@@ -119,8 +120,10 @@ struct iscsi_bhs_common_response {
 	uint32_t statsn;
 	/** Expected command sequence number */
 	uint32_t expcmdsn;
+	/** Maximum command sequence number */
+	uint32_t maxcmdsn;
 	/** Fields specific to the PDU type */
-	uint8_t other_d[16];
+	uint8_t other_d[12];
 };
 
 /**
@@ -531,6 +534,60 @@ enum iscsi_rx_state {
 	ISCSI_RX_DATA_PADDING,
 };
 
+/** A sequence of iSCSI data-out PDUs */
+struct iscsi_sequence {
+	/** Target transfer tag */
+	uint32_t ttt;
+	/** Offset of sequence within data-out buffer */
+	uint32_t offset;
+	/** Length of sequence */
+	uint32_t len;
+	/** Length of sequence already sent */
+	uint32_t sent;
+	/** Next data sequence number */
+	uint32_t datasn;
+};
+
+/** An iSCSI task */
+struct iscsi_task {
+	/** Reference counter */
+	struct refcnt refcnt;
+	/** iSCSI session */
+	struct iscsi_session *iscsi;
+	/** List of outstanding tasks within session */
+	struct list_head list;
+	/** SCSI command interface */
+	struct interface data;
+
+	/** Initiator task tag */
+	uint32_t itt;
+	/** Command sequence number */
+	uint32_t cmdsn;
+	/** SCSI command */
+	struct scsi_cmd command;
+	/** Transmission flags
+	 *
+	 * This is the bitwise-OR of zero or more ISCSI_TASK_XXX
+	 * constants.
+	 */
+	unsigned int flags;
+	/** Length of immediate data sent with SCSI command */
+	size_t immediate_len;
+	/** Data-out sequence in progress */
+	struct iscsi_sequence seq;
+	/** Data-out sequence requested by a queued R2T */
+	struct iscsi_sequence r2t;
+};
+
+/** iSCSI task needs to send its SCSI command */
+#define ISCSI_TASK_TX_COMMAND 0x0001
+
+/** iSCSI task needs to send data-out PDUs */
+#define ISCSI_TASK_TX_DATA_OUT 0x0002
+
+/** iSCSI task has an R2T queued behind the current data-out sequence */
+#define ISCSI_TASK_R2T_QUEUED 0x0004
+
 /** An iSCSI session */
 struct iscsi_session {
 	/** Reference counter */
@@ -538,8 +595,6 @@ struct iscsi_session {
 
 	/** SCSI command-issuing interface */
 	struct interface control;
-	/** SCSI command interface */
-	struct interface data;
 	/** Transport-layer socket */
 	struct interface socket;
 
@@ -585,36 +640,27 @@ struct iscsi_session {
 	uint16_t isid_iana_qual;
 	/** Initiator task tag
 	 *
-	 * This is the tag of the current command.  It is incremented
-	 * whenever a new command is started.
+	 * This is the tag used for login requests.  SCSI commands
+	 * each have their own task tag.
 	 */
 	uint32_t itt;
-	/** Target transfer tag
-	 *
-	 * This is the tag attached to a sequence of data-out PDUs in
-	 * response to an R2T.
-	 */
-	uint32_t ttt;
-	/** Transfer offset
-	 *
-	 * This is the offset for an in-progress sequence of data-out
-	 * PDUs in response to an R2T.
-	 */
-	uint32_t transfer_offset;
-	/** Transfer length
-	 *
-	 * This is the length for an in-progress sequence of data-out
-	 * PDUs in response to an R2T.
-	 */
-	uint32_t transfer_len;
 	/** Command sequence number
 	 *
-	 * This is the sequence number of the current command, used to
-	 * fill out the CmdSN field in iSCSI request PDUs.  It is
-	 * updated with the value of the ExpCmdSN field whenever we
-	 * receive an iSCSI response PDU containing such a field.
+	 * This is the sequence number to be assigned to the next
+	 * command, used to fill out the CmdSN field in iSCSI request
+	 * PDUs.  During login, it is updated with the value of the
+	 * ExpCmdSN field whenever we receive an iSCSI response PDU
+	 * containing such a field; thereafter, it is incremented
+	 * whenever a new command is issued.
 	 */
 	uint32_t cmdsn;
+	/** Maximum command sequence number
+	 *
+	 * This is the most recent value of the MaxCmdSN field in an
+	 * iSCSI response PDU, and limits the number of commands that
+	 * may be issued.
+	 */
+	uint32_t maxcmdsn;
 	/** Status sequence number
 	 *
 	 * This is the most recent status sequence number present in
@@ -623,7 +669,29 @@ struct iscsi_session {
 	 * the ExpStatSN field with this value plus one.
 	 */
 	uint32_t statsn;
-	
+
+	/** Maximum data segment length that we will send or receive
+	 *
+	 * This is the MaxRecvDataSegmentLength that we declare to the
+	 * target, and also limits the size of the PDUs that we send.
+	 * It is calculated from the available memory whenever a new
+	 * connection is opened.
+	 */
+	size_t max_pdu_len;
+	/** Maximum data segment length that the target will receive
+	 *
+	 * This is the target's declared MaxRecvDataSegmentLength.
+	 */
+	size_t max_send_len;
+	/** Maximum length of unsolicited data (FirstBurstLength) */
+	size_t first_burst_len;
+	/** Negotiated parameters
+	 *
+	 * This is the bitwise-OR of zero or more ISCSI_PARAM_XXX
+	 * constants.
+	 */
+	unsigned int params;
+
 	/** Basic header segment for current TX PDU */
 	union iscsi_bhs tx_bhs;
 	/** State of the TX engine */
@@ -642,8 +710,12 @@ struct iscsi_session {
 	/** Buffer for received data (not always used) */
 	void *rx_buffer;
 
-	/** Current SCSI command, if any */
-	struct scsi_cmd *command;
+	/** Outstanding tasks */
+	struct list_head tasks;
+	/** Number of outstanding tasks */
+	unsigned int num_tasks;
+	/** Task to which the current TX PDU belongs, if any */
+	struct iscsi_task *tx_task;
 
 	/** Target socket address (for boot firmware table) */
 	struct sockaddr target_sockaddr;
@@ -651,6 +723,12 @@ struct iscsi_session {
 	struct scsi_lun lun;
 };
 
+/** Target requires an R2T before any data-out (InitialR2T=Yes) */
+#define ISCSI_PARAM_INITIAL_R2T 0x0001
+
+/** Target accepts immediate data (ImmediateData=Yes) */
+#define ISCSI_PARAM_IMMEDIATE_DATA 0x0002
+
 /** iSCSI session is currently in the security negotiation phase */
 #define ISCSI_STATUS_SECURITY_NEGOTIATION_PHASE		\
 	( ISCSI_LOGIN_CSG_SECURITY_NEGOTIATION |	\
@@ -0,0 +1,55 @@
+#ifndef _IPXE_NEIGHBOUR_H
+#define _IPXE_NEIGHBOUR_H
+
+/** @file
+ *
+ * Neighbour cache
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <ipxe/list.h>
+#include <ipxe/netdevice.h>
+
+/** A neighbour cache entry */
+struct neighbour {
+	/** Next entry in the same hash bucket */
+	struct neighbour *next;
+	/** List of entries, most recently used first */
+	struct list_head lru;
+	/** Network device, or NULL if entry is unused */
+	struct net_device *netdev;
+	/** Network-layer protocol */
+	struct net_protocol *net_protocol;
+	/** Network-layer destination address */
+	uint8_t net_dest[MAX_NET_ADDR_LEN];
+	/** Link-layer destination address */
+	uint8_t ll_dest[MAX_LL_ADDR_LEN];
+	/** Flags */
+	unsigned int flags;
+	/** Time at which entry was created or last confirmed */
+	unsigned long updated;
+	/** Time at which a solicitation was last requested */
+	unsigned long solicited;
+};
+
+/** Neighbour cache entry has a valid link-layer address */
+#define NEIGHBOUR_RESOLVED 0x0001
+
+extern struct neighbour * neighbour_find ( struct net_device *netdev,
+					   struct net_protocol *net_protocol,
+					   const void *net_dest );
+extern struct neighbour * neighbour_create ( struct net_device *netdev,
+					     struct net_protocol *net_protocol,
+					     const void *net_dest );
+extern void neighbour_update ( struct neighbour *neighbour,
+			       const void *ll_dest );
+extern int neighbour_lookup ( struct net_device *netdev,
+			      struct net_protocol *net_protocol,
+			      const void *net_dest, void *ll_dest,
+			      int *solicit );
+extern void neighbour_flush ( struct net_device *netdev );
+
+#endif /* _IPXE_NEIGHBOUR_H */
@@ -43,8 +43,11 @@ struct device;
  */
 #define MAX_LL_HEADER_LEN 36
 
-/** Maximum length of a network-layer address */
-#define MAX_NET_ADDR_LEN 4
+/** Maximum length of a network-layer address
+ *
+ * The longest currently-supported network-layer address is for IPv6.
+ */
+#define MAX_NET_ADDR_LEN 16
 
 /** Maximum length of a network-layer header
  *
@@ -262,6 +265,24 @@ struct net_device_stats {
 	unsigned int bad;
 	/** Error breakdowns */
 	struct net_device_error errors[NETDEV_MAX_UNIQUE_ERRORS];
+	/** Count of non-empty processing batches (RX only) */
+	unsigned int batches;
+	/** Size of largest processing batch (RX only) */
+	unsigned int max_batch;
+	/** Count of batches terminated by the batch size limit (RX only) */
+	unsigned int full_batches;
+};
+
+/** Network device neighbour cache statistics */
+struct net_device_neighbour_stats {
+	/** Count of lookups satisfied from the cache */
+	unsigned int hits;
+	/** Count of lookups requiring address resolution */
+	unsigned int misses;
+	/** Count of entries recycled to make room for new entries */
+	unsigned int evictions;
+	/** Count of entries discarded due to age */
+	unsigned int expiries;
 };
 
 /**
@@ -333,6 +354,8 @@ struct net_device {
 	struct net_device_stats tx_stats;
 	/** RX statistics */
 	struct net_device_stats rx_stats;
+	/** Neighbour cache statistics */
+	struct net_device_neighbour_stats neighbour_stats;
 
 	/** Configuration settings applicable to this device */
 	struct generic_settings settings;
@@ -592,6 +615,10 @@ extern void netdev_tx_complete_next_err ( struct net_device *netdev, int rc );
 extern void netdev_rx ( struct net_device *netdev, struct io_buffer *iobuf );
 extern void netdev_rx_err ( struct net_device *netdev,
 			    struct io_buffer *iobuf, int rc );
+extern void netdev_rx_err_count ( struct net_device *netdev, int rc,
+				  unsigned int count );
+extern unsigned int netdev_rx_fill_count ( unsigned int max,
+					   unsigned int align, size_t len );
 extern void netdev_poll ( struct net_device *netdev );
 extern struct io_buffer * netdev_rx_dequeue ( struct net_device *netdev );
 extern struct net_device * alloc_netdev ( size_t priv_size );
@@ -1,12 +1,30 @@
 #ifndef _IPXE_RSA_H
 #define _IPXE_RSA_H
 
+/** @file
+ *
+ * RSA public-key cryptography
+ *
+ */
+
 FILE_LICENCE ( GPL2_OR_LATER );
 
+#include <stdint.h>
+#include <stddef.h>
+
 struct pubkey_algorithm;
+struct x509_rsa_public_key;
+
+/** Maximum supported RSA modulus length, in bytes */
+#define RSA_MAX_LEN ( 4096 / 8 )
 
 extern struct pubkey_algorithm rsa_algorithm;
 
-#include "crypto/axtls/crypto.h"
+extern size_t rsa_modulus_len ( const struct x509_rsa_public_key *key );
+extern int rsa_public ( const struct x509_rsa_public_key *key,
+			const void *in, void *out );
+extern int rsa_encrypt ( const struct x509_rsa_public_key *key,
+			 const void *plaintext, size_t plaintext_len,
+			 void *ciphertext );
 
 #endif /* _IPXE_RSA_H */
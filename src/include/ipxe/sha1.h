@@ -1,14 +1,36 @@
 #ifndef _IPXE_SHA1_H
 #define _IPXE_SHA1_H
 
+/** @file
+ *
+ * SHA-1 algorithm
+ *
+ */
+
 FILE_LICENCE ( GPL2_OR_LATER );
 
-#include "crypto/axtls/crypto.h"
+#include <stdint.h>
 
 struct digest_algorithm;
 
-#define SHA1_CTX_SIZE sizeof ( SHA1_CTX )
-#define SHA1_DIGEST_SIZE SHA1_SIZE
+/** SHA-1 block size */
+#define SHA1_BLOCK_SIZE 64
+
+/** SHA-1 digest size */
+#define SHA1_DIGEST_SIZE 20
+
+/** A SHA-1 context */
+struct sha1_context {
+	/** Digest state */
+	uint32_t hash[ SHA1_DIGEST_SIZE / sizeof ( uint32_t ) ];
+	/** Total length of data processed */
+	uint64_t len;
+	/** Partial block */
+	uint8_t block[SHA1_BLOCK_SIZE];
+};
+
+/** SHA-1 context size */
+#define SHA1_CTX_SIZE sizeof ( struct sha1_context )
 
 extern struct digest_algorithm sha1_algorithm;
 
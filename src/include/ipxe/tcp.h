@@ -54,6 +54,73 @@ struct tcp_mss_option {
 /** Code for the TCP MSS option */
 #define TCP_OPTION_MSS 2
 
+/** TCP window scale option */
+struct tcp_window_scale_option {
+	uint8_t kind;
+	uint8_t length;
+	uint8_t scale;
+} __attribute__ (( packed ));
+
+/** Padded TCP window scale option (used for sending) */
+struct tcp_window_scale_padded_option {
+	uint8_t nop[1];
+	struct tcp_window_scale_option wsopt;
+} __attribute__ (( packed ));
+
+/** Code for the TCP window scale option */
+#define TCP_OPTION_WS 3
+
+/** TCP SACK-permitted option */
+struct tcp_sack_permitted_option {
+	uint8_t kind;
+	uint8_t length;
+} __attribute__ (( packed ));
+
+/** Padded TCP SACK-permitted option (used for sending) */
+struct tcp_sack_permitted_padded_option {
+	uint8_t nop[2];
+	struct tcp_sack_permitted_option spopt;
+} __attribute__ (( packed ));
+
+/** Code for the TCP SACK-permitted option */
+#define TCP_OPTION_SACK_PERMITTED 4
+
+/** TCP SACK block */
+struct tcp_sack_block {
+	/** Left edge of block */
+	uint32_t left;
+	/** Right edge of block */
+	uint32_t right;
+} __attribute__ (( packed ));
+
+/** TCP SACK option */
+struct tcp_sack_option {
+	uint8_t kind;
+	uint8_t length;
+	struct tcp_sack_block block[0];
+} __attribute__ (( packed ));
+
+/** Padded TCP SACK option (used for sending) */
+struct tcp_sack_padded_option {
+	uint8_t nop[2];
+	struct tcp_sack_option sackopt;
+} __attribute__ (( packed ));
+
+/** Code for the TCP SACK option */
+#define TCP_OPTION_SACK 5
+
+/** Maximum number of SACK blocks that we will send
+ *
+ * This is the maximum that can fit alongside the timestamp option.
+ */
+#define TCP_SACK_MAX 3
+
+/** Maximum TCP window scale
+ *
+ * RFC 1323 limits the window scale shift count to 14.
+ */
+#define TCP_MAX_WINDOW_SCALE 14
+
 /** TCP timestamp option */
 struct tcp_timestamp_option {
 	uint8_t kind;
@@ -75,6 +142,10 @@ struct tcp_timestamp_padded_option {
 struct tcp_options {
 	/** MSS option, if present */
 	const struct tcp_mss_option *mssopt;
+	/** Window scale option, if present */
+	const struct tcp_window_scale_option *wsopt;
+	/** SACK-permitted option, if present */
+	const struct tcp_sack_permitted_option *spopt;
 	/** Timestampe option, if present */
 	const struct tcp_timestamp_option *tsopt;
 };
@@ -254,6 +325,9 @@ struct tcp_options {
 /** Mask for TCP header length field */
 #define TCP_MASK_HLEN	0xf0
 
+/** Maximum length of TCP header (including options) */
+#define TCP_MAX_HEADER_LEN 60
+
 /** Smallest port number on which a TCP connection can listen */
 #define TCP_MIN_PORT 1
 
@@ -262,27 +336,40 @@ struct tcp_options {
  *
  * We estimate the TCP window size as the amount of free memory we
  * have.  This is not strictly accurate (since it ignores any space
- * already allocated as RX buffers), but it will do for now.
+ * already allocated as RX buffers), but it will do for now.  The
+ * window is further limited under memory pressure; see
+ * tcp_discard().
  *
- * Since we don't store out-of-order received packets, the
- * retransmission penalty is that the whole window contents must be
- * resent.  This suggests keeping the window size small, but bear in
- * mind that the maximum bandwidth on any link is limited to
+ * The window can therefore never exceed three quarters of the
+ * 128kB heap, i.e. 96kB.  Bear in mind that the maximum bandwidth on
+ * any link is limited to
  *
  *    max_bandwidth = ( tcp_window / round_trip_time )
  *
- * With a 48kB window, which probably accurately reflects our amount
- * of free memory, and a WAN RTT of say 200ms, this gives a maximum
- * bandwidth of 240kB/s.  This is sufficiently close to realistic that
- * we will need to be careful that our advertised window doesn't end
- * up limiting WAN download speeds.
+ * With a 96kB window and a WAN RTT of say 200ms, this gives a
+ * maximum bandwidth of 480kB/s.
+ *
+ * Windows larger than 64kB can be advertised only if the peer agrees
+ * to use window scaling (RFC 1323).
+ */
+#define TCP_MAX_WINDOW_SIZE	( 96 * 1024 )
+
+/**
+ * Minimum TCP window size limit under memory pressure
+ *
+ * The window limit imposed under memory pressure will never be
+ * reduced below this value.
+ */
+#define TCP_MIN_WINDOW_LIMIT	8192
+
+/**
+ * Advertised TCP window scale
  *
- * Finally, since the window goes into a 16-bit field and we cannot
- * actually use 65536, we use a window size of (65536-4) to ensure
- * that payloads remain dword-aligned.
+ * This must be large enough to allow TCP_MAX_WINDOW_SIZE to be
+ * represented within the 16-bit window field.  A shift of one allows
+ * windows of up to 128kB, in units of two bytes.
  */
-//#define TCP_MAX_WINDOW_SIZE	( 65536 - 4 )
-#define TCP_MAX_WINDOW_SIZE	8192
+#define TCP_RX_WINDOW_SCALE 1
 
 /**
  * Path MTU
@@ -121,6 +121,8 @@ extern int tcpip_tx ( struct io_buffer *iobuf, struct tcpip_protocol *tcpip,
 		      struct sockaddr_tcpip *st_dest,
 		      struct net_device *netdev,
 		      uint16_t *trans_csum );
+extern uint16_t generic_tcpip_continue_chksum ( uint16_t partial,
+						const void *data, size_t len );
 extern uint16_t tcpip_continue_chksum ( uint16_t partial,
 					const void *data, size_t len );
 extern uint16_t tcpip_chksum ( const void *data, size_t len );
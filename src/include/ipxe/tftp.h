@@ -10,10 +10,12 @@
 FILE_LICENCE ( GPL2_OR_LATER );
 
 #include <stdint.h>
+#include <ipxe/bitmap.h>
 
 #define TFTP_PORT	       69 /**< Default TFTP server port */
 #define	TFTP_DEFAULT_BLKSIZE  512 /**< Default TFTP data block size */
 #define	TFTP_MAX_BLKSIZE     1432
+#define TFTP_MAX_WINDOWSIZE     8 /**< Maximum TFTP window size */
 
 #define TFTP_RRQ		1 /**< Read request opcode */
 #define TFTP_WRQ		2 /**< Write request opcode */
@@ -80,6 +82,20 @@ union tftp_any {
 	struct tftp_oack	oack;
 };
 
+/** A TFTP sliding window (RFC 7440) */
+struct tftp_window {
+	/** Window size, i.e. number of blocks sent for each ACK */
+	unsigned int size;
+	/** Number of contiguous blocks acknowledged by the last ACK */
+	unsigned int acked;
+	/** Server has been asked to roll back to the first missing block */
+	int rollback;
+};
+
 extern void tftp_set_request_blksize ( unsigned int blksize );
+extern int tftp_block ( unsigned int gap, unsigned int blkno );
+extern int tftp_ack_required ( struct tftp_window *window,
+			       struct bitmap *bitmap, unsigned int block,
+			       int duplicate );
 
 #endif /* _IPXE_TFTP_H */
@@ -11,6 +11,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 
 #include <stdint.h>
 #include <ipxe/refcnt.h>
+#include <ipxe/list.h>
 #include <ipxe/interface.h>
 #include <ipxe/process.h>
 #include <ipxe/crypto.h>
@@ -74,6 +75,12 @@ struct tls_header {
 #define TLS_RSA_WITH_AES_128_CBC_SHA 0x002f
 #define TLS_RSA_WITH_AES_256_CBC_SHA 0x0035
 
+/** Maximum length of a TLS session ID */
+#define TLS_MAX_SESSION_ID_LEN 32
+
+/** Maximum number of cached TLS sessions */
+#define TLS_MAX_CACHED_SESSIONS 8
+
 /** TLS RX state machine state */
 enum tls_rx_state {
 	TLS_RX_HEADER = 0,
@@ -108,8 +115,8 @@ struct tls_cipherspec {
 	void *cipher_ctx;
 	/** Next bulk encryption cipher context (TX only) */
 	void *cipher_next_ctx;
-	/** MAC secret */
-	void *mac_secret;
+	/** Precomputed HMAC key context for MAC secret */
+	void *mac_ctx;
 };
 
 /** TLS pre-master secret */
@@ -128,11 +135,42 @@ struct tls_client_random {
 	uint8_t random[28];
 } __attribute__ (( packed ));
 
+/** A cached TLS session, available for resumption */
+struct tls_cached_session {
+	/** List of cached sessions */
+	struct list_head list;
+	/** Server name */
+	char *name;
+	/** Server port */
+	unsigned int port;
+	/** Session ID */
+	uint8_t session_id[TLS_MAX_SESSION_ID_LEN];
+	/** Length of session ID */
+	size_t session_id_len;
+	/** Cipher suite (in network byte order) */
+	uint16_t cipher_suite;
+	/** Master secret */
+	uint8_t master_secret[48];
+};
+
 /** A TLS session */
 struct tls_session {
 	/** Reference counter */
 	struct refcnt refcnt;
 
+	/** Server name */
+	char *name;
+	/** Server port */
+	unsigned int port;
+	/** Session ID */
+	uint8_t session_id[TLS_MAX_SESSION_ID_LEN];
+	/** Length of session ID */
+	size_t session_id_len;
+	/** Cipher suite (in network byte order) */
+	uint16_t cipher_suite;
+	/** Session is being resumed via an abbreviated handshake */
+	int resumed;
+
 	/** Plaintext stream */
 	struct interface plainstream;
 	/** Ciphertext stream */
@@ -181,7 +219,7 @@ struct tls_session {
 	void *rx_data;
 };
 
-extern int add_tls ( struct interface *xfer,
-		     struct interface **next );
+extern int add_tls ( struct interface *xfer, const char *name,
+		     unsigned int port, struct interface **next );
 
 #endif /* _IPXE_TLS_H */
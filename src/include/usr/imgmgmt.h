@@ -17,9 +17,10 @@ extern int register_and_select_image ( struct image *image );
 extern int register_and_boot_image ( struct image *image );
 extern int register_and_replace_image ( struct image *image );
 extern int imgdownload ( struct uri *uri, const char *name, const char *cmdline,
+			 const char *digest,
 			 int ( * action ) ( struct image *image ) );
 extern int imgdownload_string ( const char *uri_string, const char *name,
-				const char *cmdline,
+				const char *cmdline, const char *digest,
 				int ( * action ) ( struct image *image ) );
 extern void imgstat ( struct image *image );
 extern void imgfree ( struct image *image );
@@ -82,6 +82,13 @@ struct aoe_device {
 	/** Saved timeout value */
 	unsigned long timeout;
 
+	/** Maximum number of sectors per ATA command */
+	unsigned int max_count;
+	/** Target queue depth */
+	unsigned int bufcnt;
+	/** Number of ATA commands in progress */
+	unsigned int outstanding;
+
 	/** Configuration command interface */
 	struct interface config;
 	/** Device is configued */
@@ -141,6 +148,8 @@ struct aoe_command_type {
 			size_t len, const void *ll_source );
 };
 
+static struct aoe_command_type aoecmd_ata;
+
 /**
  * Get reference to AoE device
  *
@@ -223,6 +232,7 @@ static void aoecmd_free ( struct refcnt *refcnt ) {
  */
 static void aoecmd_close ( struct aoe_command *aoecmd, int rc ) {
 	struct aoe_device *aoedev = aoecmd->aoedev;
+	int window_changed = 0;
 
 	/* Stop timer */
 	stop_timer ( &aoecmd->timer );
@@ -234,11 +244,19 @@ static void aoecmd_close ( struct aoe_command *aoecmd, int rc ) {
 	if ( ! list_empty ( &aoecmd->list ) ) {
 		list_del ( &aoecmd->list );
 		INIT_LIST_HEAD ( &aoecmd->list );
+		if ( aoecmd->type == &aoecmd_ata ) {
+			aoedev->outstanding--;
+			window_changed = 1;
+		}
 		aoecmd_put ( aoecmd );
 	}
 
 	/* Shut down interfaces */
 	intf_shutdown ( &aoecmd->ata, rc );
+
+	/* Notify parent that a command slot has become free */
+	if ( window_changed )
+		xfer_window_changed ( &aoedev->ata );
 }
 
 /**
@@ -545,6 +563,16 @@ static int aoecmd_cfg_rsp ( struct aoe_command *aoecmd, const void *data,
 	       aoedev_name ( aoedev ), aoecmd->tag, ntohs ( aoecfg->bufcnt ),
 	       aoecfg->fwver, aoecfg->scnt );
 
+	/* Record target queue depth and maximum sector count */
+	aoedev->bufcnt = ntohs ( aoecfg->bufcnt );
+	if ( ! aoedev->bufcnt )
+		aoedev->bufcnt = 1;
+	if ( aoecfg->scnt && ( aoecfg->scnt < aoedev->max_count ) )
+		aoedev->max_count = aoecfg->scnt;
+	DBGC ( aoedev, "AoE %s using %d sectors per command, %d commands "
+	       "in flight\n", aoedev_name ( aoedev ), aoedev->max_count,
+	       aoedev->bufcnt );
+
 	/* Record target MAC address */
 	memcpy ( aoedev->target, ll_source, ll_protocol->ll_addr_len );
 	DBGC ( aoedev, "AoE %s has MAC address %s\n",
@@ -664,6 +692,7 @@ static int aoedev_ata_command ( struct aoe_device *aoedev,
 	if ( ! aoecmd )
 		return -ENOMEM;
 	memcpy ( &aoecmd->command, command, sizeof ( aoecmd->command ) );
+	aoedev->outstanding++;
 
 	/* Attempt to send command.  Allow failures to be handled by
 	 * the retry timer.
@@ -749,7 +778,22 @@ static void aoedev_close ( struct aoe_device *aoedev, int rc ) {
  * @ret len		Length of window
  */
 static size_t aoedev_window ( struct aoe_device *aoedev ) {
-	return ( aoedev->configured ? ~( ( size_t ) 0 ) : 0 );
+
+	/* Allow as many commands as the target can queue */
+	if ( ( ! aoedev->configured ) ||
+	     ( aoedev->outstanding >= aoedev->bufcnt ) )
+		return 0;
+	return ( aoedev->bufcnt - aoedev->outstanding );
+}
+
+/**
+ * Get maximum number of sectors per AoE ATA command
+ *
+ * @v aoedev		AoE device
+ * @ret max_count	Maximum number of sectors per command
+ */
+static unsigned int aoedev_max_count ( struct aoe_device *aoedev ) {
+	return aoedev->max_count;
 }
 
 /**
@@ -817,6 +861,7 @@ static int aoedev_describe ( struct aoe_device *aoedev,
 static struct interface_operation aoedev_ata_op[] = {
 	INTF_OP ( ata_command, struct aoe_device *, aoedev_ata_command ),
 	INTF_OP ( xfer_window, struct aoe_device *, aoedev_window ),
+	INTF_OP ( ata_max_count, struct aoe_device *, aoedev_max_count ),
 	INTF_OP ( intf_close, struct aoe_device *, aoedev_close ),
 	INTF_OP ( acpi_describe, struct aoe_device *, aoedev_describe ),
 	INTF_OP ( identify_device, struct aoe_device *,
@@ -847,7 +892,9 @@ static struct interface_descriptor aoedev_config_desc =
  */
 static int aoedev_open ( struct interface *parent, struct net_device *netdev,
 			 unsigned int major, unsigned int minor ) {
+	struct ll_protocol *ll_protocol = netdev->ll_protocol;
 	struct aoe_device *aoedev;
+	size_t max_len;
 	int rc;
 
 	/* Allocate and initialise structure */
@@ -865,6 +912,17 @@ static int aoedev_open ( struct interface *parent, struct net_device *netdev,
 	memcpy ( aoedev->target, netdev->ll_broadcast,
 		 netdev->ll_protocol->ll_addr_len );
 
+	/* Fit as many sectors into each packet as the MTU allows */
+	max_len = ( ll_protocol->ll_header_len + sizeof ( struct aoehdr ) +
+		    sizeof ( struct aoeata ) );
+	max_len = ( ( netdev->max_pkt_len > max_len ) ?
+		    ( netdev->max_pkt_len - max_len ) : 0 );
+	aoedev->max_count = ( max_len / ATA_SECTOR_SIZE );
+	if ( aoedev->max_count > AOE_MAX_COUNT )
+		aoedev->max_count = AOE_MAX_COUNT;
+	if ( ! aoedev->max_count )
+		aoedev->max_count = 1;
+
 	/* Initiate configuration */
 	if ( ( rc = aoedev_cfg_command ( aoedev, &aoedev->config ) ) < 0 ) {
 		DBGC ( aoedev, "AoE %s could not initiate configuration: %s\n",
@@ -874,7 +932,7 @@ static int aoedev_open ( struct interface *parent, struct net_device *netdev,
 
 	/* Attach ATA device to parent interface */
 	if ( ( rc = ata_open ( parent, &aoedev->ata, ATA_DEV_MASTER,
-			       AOE_MAX_COUNT ) ) != 0 ) {
+			       aoedev->max_count ) ) != 0 ) {
 		DBGC ( aoedev, "AoE %s could not create ATA device: %s\n",
 		       aoedev_name ( aoedev ), strerror ( rc ) );
 		goto err_ata_open;
@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2012 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <config/general.h>
+#include <ipxe/list.h>
+#include <ipxe/timer.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/neighbour.h>
+
+/** @file
+ *
+ * Neighbour cache
+ *
+ * The neighbour cache maps network-layer addresses to link-layer
+ * addresses, and is shared by all address resolution protocols (ARP
+ * and NDP).  It is a global cache covering all network devices.
+ * Entries are located via a hash of the network-layer address; when
+ * the cache is full, the least recently used entry is recycled.
+ *
+ * A resolved entry is usable until it expires.  Once an entry is old
+ * enough to need refreshing, lookups continue to succeed but also
+ * request that a fresh solicitation be transmitted, so that a busy
+ * entry can be reconfirmed without stalling traffic.
+ */
+
+/** Number of neighbour cache hash buckets */
+#define NEIGHBOUR_HASH_SIZE ( ( NEIGHBOUR_CACHE_SIZE + 1 ) / 2 )
+
+/** Age at which a resolved entry should be refreshed */
+#define NEIGHBOUR_REFRESH_AGE ( 60 * TICKS_PER_SEC )
+
+/** Age at which an entry expires */
+#define NEIGHBOUR_EXPIRY_AGE ( 90 * TICKS_PER_SEC )
+
+/** Minimum interval between solicitations for a single entry */
+#define NEIGHBOUR_SOLICIT_INTERVAL ( TICKS_PER_SEC / 4 )
+
+/** Neighbour cache entries */
+static struct neighbour neighbours[NEIGHBOUR_CACHE_SIZE];
+
+/** Number of neighbour cache entries ever brought into use */
+static unsigned int neighbour_count;
+
+/** Neighbour cache hash buckets */
+static struct neighbour *neighbour_buckets[NEIGHBOUR_HASH_SIZE];
+
+/** Neighbour cache entries in use, most recently used first */
+static LIST_HEAD ( neighbour_lru );
+
+/**
+ * Calculate neighbour cache hash bucket
+ *
+ * @v net_protocol	Network-layer protocol
+ * @v net_dest		Network-layer destination address
+ * @ret bucket		Hash bucket
+ */
+static struct neighbour **
+neighbour_bucket ( struct net_protocol *net_protocol, const void *net_dest ) {
+	const uint8_t *byte = net_dest;
+	unsigned int hash = 0;
+	unsigned int i;
+
+	for ( i = 0 ; i < net_protocol->net_addr_len ; i++ )
+		hash = ( ( hash * 31 ) + byte[i] );
+	return &neighbour_buckets[ hash % NEIGHBOUR_HASH_SIZE ];
+}
+
+/**
+ * Discard neighbour cache entry
+ *
+ * @v neighbour		Neighbour cache entry
+ */
+static void neighbour_discard ( struct neighbour *neighbour ) {
+	struct neighbour **prev;
+
+	/* Remove from hash bucket */
+	prev = neighbour_bucket ( neighbour->net_protocol,
+				  neighbour->net_dest );
+	while ( *prev != neighbour )
+		prev = &(*prev)->next;
+	*prev = neighbour->next;
+
+	/* Move to end of LRU list, for immediate reuse */
+	list_del ( &neighbour->lru );
+	list_add_tail ( &neighbour->lru, &neighbour_lru );
+
+	/* Drop network device reference */
+	netdev_put ( neighbour->netdev );
+	neighbour->netdev = NULL;
+}
+
+/**
+ * Find neighbour cache entry
+ *
+ * @v netdev		Network device, or NULL to match any device
+ * @v net_protocol	Network-layer protocol
+ * @v net_dest		Network-layer destination address
+ * @ret neighbour	Neighbour cache entry, or NULL if not found
+ *
+ * Any matching entry that has expired is discarded.  A matching
+ * entry that has not expired becomes the most recently used entry.
+ */
+struct neighbour * neighbour_find ( struct net_device *netdev,
+				    struct net_protocol *net_protocol,
+				    const void *net_dest ) {
+	struct neighbour *neighbour;
+
+	for ( neighbour = *neighbour_bucket ( net_protocol, net_dest ) ;
+	      neighbour ; neighbour = neighbour->next ) {
+
+		/* Skip non-matching entries */
+		if ( ( netdev && ( neighbour->netdev != netdev ) ) ||
+		     ( neighbour->net_protocol != net_protocol ) ||
+		     ( memcmp ( neighbour->net_dest, net_dest,
+				net_protocol->net_addr_len ) != 0 ) )
+			continue;
+
+		/* Discard entry if it has expired */
+		if ( ( currticks() - neighbour->updated ) >=
+		     NEIGHBOUR_EXPIRY_AGE ) {
+			DBGC ( neighbour->netdev, "NEIGHBOUR %s %s %s "
+			       "expired\n", neighbour->netdev->name,
+			       net_protocol->name,
+			       net_protocol->ntoa ( net_dest ) );
+			neighbour->netdev->neighbour_stats.expiries++;
+			neighbour_discard ( neighbour );
+			return NULL;
+		}
+
+		/* Mark as most recently used */
+		list_del ( &neighbour->lru );
+		list_add ( &neighbour->lru, &neighbour_lru );
+		return neighbour;
+	}
+
+	return NULL;
+}
+
+/**
+ * Create neighbour cache entry
+ *
+ * @v netdev		Network device
+ * @v net_protocol	Network-layer protocol
+ * @v net_dest		Network-layer destination address
+ * @ret neighbour	Neighbour cache entry
+ *
+ * The new entry is unresolved.  If the cache is full, the least
+ * recently used entry will be recycled.
+ */
+struct neighbour * neighbour_create ( struct net_device *netdev,
+				      struct net_protocol *net_protocol,
+				      const void *net_dest ) {
+	struct neighbour *neighbour;
+	struct neighbour **bucket;
+
+	/* Bring a new entry into use, or recycle the oldest entry */
+	if ( neighbour_count < NEIGHBOUR_CACHE_SIZE ) {
+		neighbour = &neighbours[neighbour_count++];
+		list_add ( &neighbour->lru, &neighbour_lru );
+	} else {
+		neighbour = list_entry ( neighbour_lru.prev, struct neighbour,
+					 lru );
+		if ( neighbour->netdev ) {
+			DBGC ( neighbour->netdev, "NEIGHBOUR %s %s %s "
+			       "evicted\n", neighbour->netdev->name,
+			       neighbour->net_protocol->name,
+			       neighbour->net_protocol->ntoa (
+				       neighbour->net_dest ) );
+			neighbour->netdev->neighbour_stats.evictions++;
+			neighbour_discard ( neighbour );
+		}
+		list_del ( &neighbour->lru );
+		list_add ( &neighbour->lru, &neighbour_lru );
+	}
+
+	/* Populate entry */
+	neighbour->netdev = netdev_get ( netdev );
+	neighbour->net_protocol = net_protocol;
+	memcpy ( neighbour->net_dest, net_dest, net_protocol->net_addr_len );
+	memset ( neighbour->ll_dest, 0, sizeof ( neighbour->ll_dest ) );
+	neighbour->flags = 0;
+	neighbour->updated = currticks();
+	neighbour->solicited = ( neighbour->updated -
+				 NEIGHBOUR_SOLICIT_INTERVAL );
+
+	/* Add to hash bucket */
+	bucket = neighbour_bucket ( net_protocol, net_dest );
+	neighbour->next = *bucket;
+	*bucket = neighbour;
+
+	return neighbour;
+}
+
+/**
+ * Update neighbour cache entry
+ *
+ * @v neighbour		Neighbour cache entry
+ * @v ll_dest		Link-layer destination address
+ *
+ * The entry is marked as resolved and its age is reset.
+ */
+void neighbour_update ( struct neighbour *neighbour, const void *ll_dest ) {
+	struct ll_protocol *ll_protocol = neighbour->netdev->ll_protocol;
+
+	memcpy ( neighbour->ll_dest, ll_dest, ll_protocol->ll_addr_len );
+	neighbour->flags |= NEIGHBOUR_RESOLVED;
+	neighbour->updated = currticks();
+}
+
+/**
+ * Check whether or not to transmit a solicitation
+ *
+ * @v neighbour		Neighbour cache entry
+ * @ret solicit		A solicitation should be transmitted
+ */
+static int neighbour_solicit ( struct neighbour *neighbour ) {
+	unsigned long now = currticks();
+
+	if ( ( now - neighbour->solicited ) < NEIGHBOUR_SOLICIT_INTERVAL )
+		return 0;
+	neighbour->solicited = now;
+	return 1;
+}
+
+/**
+ * Look up link-layer address in neighbour cache
+ *
+ * @v netdev		Network device
+ * @v net_protocol	Network-layer protocol
+ * @v net_dest		Network-layer destination address
+ * @v ll_dest		Link-layer destination address to fill in
+ * @ret solicit		A solicitation should be transmitted
+ * @ret rc		Return status code
+ *
+ * If the cache holds a resolved entry, the link-layer destination
+ * address will be filled in.  Otherwise, an unresolved entry will be
+ * created if necessary and -ENOENT will be returned.
+ *
+ * Solicitations are rate-limited, and are also requested for a
+ * resolved entry that is due to be refreshed.
+ */
+int neighbour_lookup ( struct net_device *netdev,
+		       struct net_protocol *net_protocol,
+		       const void *net_dest, void *ll_dest, int *solicit ) {
+	struct ll_protocol *ll_protocol = netdev->ll_protocol;
+	struct neighbour *neighbour;
+
+	/* Find or create entry */
+	neighbour = neighbour_find ( netdev, net_protocol, net_dest );
+	if ( ! neighbour )
+		neighbour = neighbour_create ( netdev, net_protocol, net_dest );
+
+	/* Fail if entry is not yet resolved */
+	if ( ! ( neighbour->flags & NEIGHBOUR_RESOLVED ) ) {
+		netdev->neighbour_stats.misses++;
+		*solicit = neighbour_solicit ( neighbour );
+		return -ENOENT;
+	}
+
+	/* Use cached address, refreshing the entry if it is old */
+	netdev->neighbour_stats.hits++;
+	memcpy ( ll_dest, neighbour->ll_dest, ll_protocol->ll_addr_len );
+	*solicit = ( ( ( currticks() - neighbour->updated ) >=
+		       NEIGHBOUR_REFRESH_AGE ) &&
+		     neighbour_solicit ( neighbour ) );
+	return 0;
+}
+
+/**
+ * Flush neighbour cache entries for a network device
+ *
+ * @v netdev		Network device
+ */
+void neighbour_flush ( struct net_device *netdev ) {
+	struct neighbour *neighbour;
+	unsigned int i;
+
+	for ( i = 0 ; i < neighbour_count ; i++ ) {
+		neighbour = &neighbours[i];
+		if ( neighbour->netdev == netdev )
+			neighbour_discard ( neighbour );
+	}
+}
+
+/**
+ * Probe device for neighbour cache
+ *
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ */
+static int neighbour_probe ( struct net_device *netdev __unused ) {
+	return 0;
+}
+
+/**
+ * Handle device or link state change for neighbour cache
+ *
+ * @v netdev		Network device
+ */
+static void neighbour_notify ( struct net_device *netdev ) {
+
+	/* Entries cannot be trusted across a device close */
+	if ( ! netdev_is_open ( netdev ) )
+		neighbour_flush ( netdev );
+}
+
+/**
+ * Remove device from neighbour cache
+ *
+ * @v netdev		Network device
+ */
+static void neighbour_remove ( struct net_device *netdev ) {
+	neighbour_flush ( netdev );
+}
+
+/** Neighbour cache driver */
+struct net_driver neighbour_driver __net_driver = {
+	.name = "Neighbour",
+	.probe = neighbour_probe,
+	.notify = neighbour_notify,
+	.remove = neighbour_remove,
+};
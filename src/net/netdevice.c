@@ -27,11 +27,14 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <config/general.h>
 #include <ipxe/if_ether.h>
 #include <ipxe/iobuf.h>
+#include <ipxe/malloc.h>
 #include <ipxe/tables.h>
 #include <ipxe/process.h>
 #include <ipxe/init.h>
 #include <ipxe/device.h>
 #include <ipxe/errortab.h>
+#include <ipxe/settings.h>
+#include <ipxe/dhcp.h>
 #include <ipxe/netdevice.h>
 
 /** @file
@@ -110,20 +113,22 @@ void netdev_link_down ( struct net_device *netdev ) {
  *
  * @v stats		Network device statistics
  * @v rc		Status code
+ * @v count		Number of completions
  */
-static void netdev_record_stat ( struct net_device_stats *stats, int rc ) {
+static void netdev_record_stat ( struct net_device_stats *stats, int rc,
+				 unsigned int count ) {
 	struct net_device_error *error;
 	struct net_device_error *least_common_error;
 	unsigned int i;
 
 	/* If this is not an error, just update the good counter */
 	if ( rc == 0 ) {
-		stats->good++;
+		stats->good += count;
 		return;
 	}
 
 	/* Update the bad counter */
-	stats->bad++;
+	stats->bad += count;
 
 	/* Locate the appropriate error record */
 	least_common_error = &stats->errors[0];
@@ -132,7 +137,7 @@ static void netdev_record_stat ( struct net_device_stats *stats, int rc ) {
 		error = &stats->errors[i];
 		/* Update matching record, if found */
 		if ( error->rc == rc ) {
-			error->count++;
+			error->count += count;
 			return;
 		}
 		if ( error->count < least_common_error->count )
@@ -141,7 +146,7 @@ static void netdev_record_stat ( struct net_device_stats *stats, int rc ) {
 
 	/* Overwrite the least common error record */
 	least_common_error->rc = rc;
-	least_common_error->count = 1;
+	least_common_error->count = count;
 }
 
 /**
@@ -200,7 +205,7 @@ void netdev_tx_complete_err ( struct net_device *netdev,
 			      struct io_buffer *iobuf, int rc ) {
 
 	/* Update statistics counter */
-	netdev_record_stat ( &netdev->tx_stats, rc );
+	netdev_record_stat ( &netdev->tx_stats, rc, 1 );
 	if ( rc == 0 ) {
 		DBGC ( netdev, "NETDEV %s transmission %p complete\n",
 		       netdev->name, iobuf );
@@ -273,7 +278,7 @@ void netdev_rx ( struct net_device *netdev, struct io_buffer *iobuf ) {
 	list_add_tail ( &iobuf->list, &netdev->rx_queue );
 
 	/* Update statistics counter */
-	netdev_record_stat ( &netdev->rx_stats, 0 );
+	netdev_record_stat ( &netdev->rx_stats, 0, 1 );
 }
 
 /**
@@ -298,7 +303,63 @@ void netdev_rx_err ( struct net_device *netdev,
 	free_iob ( iobuf );
 
 	/* Update statistics counter */
-	netdev_record_stat ( &netdev->rx_stats, rc );
+	netdev_record_stat ( &netdev->rx_stats, rc, 1 );
+}
+
+/**
+ * Record packets dropped by network device hardware
+ *
+ * @v netdev		Network device
+ * @v rc		Packet status code
+ * @v count		Number of dropped packets
+ *
+ * This records RX errors for packets that never reached the driver,
+ * such as those counted by a hardware missed packet counter.
+ */
+void netdev_rx_err_count ( struct net_device *netdev, int rc,
+			   unsigned int count ) {
+
+	/* Do nothing unless packets were dropped */
+	if ( ! count )
+		return;
+
+	DBGC ( netdev, "NETDEV %s dropped %d packets: %s\n",
+	       netdev->name, count, strerror ( rc ) );
+
+	/* Update statistics counter */
+	netdev_record_stat ( &netdev->rx_stats, rc, count );
+}
+
+/**
+ * Calculate number of receive buffers to allocate
+ *
+ * @v max		Maximum number of buffers
+ * @v align		Required multiple (a power of two)
+ * @v len		Length of each buffer, as passed to alloc_iob()
+ * @ret count		Number of buffers
+ *
+ * A receive ring holding full-sized buffers can easily consume most
+ * of the heap.  The number of buffers is therefore limited to those
+ * that fit within half of the free heap, rounded down to a multiple
+ * of @c align, and is never less than @c align.
+ */
+unsigned int netdev_rx_fill_count ( unsigned int max, unsigned int align,
+				    size_t len ) {
+	size_t count;
+
+	/* Each buffer also holds its descriptor, and is aligned to
+	 * IOB_ALIGN; a full-sized Ethernet buffer therefore occupies
+	 * 2kB of heap.
+	 */
+	len += sizeof ( struct io_buffer );
+	len = ( ( len + IOB_ALIGN - 1 ) & ~( IOB_ALIGN - 1 ) );
+	count = ( ( freemem / 2 ) / len );
+	if ( count > max )
+		count = max;
+	count &= ~( align - 1 );
+	if ( count < align )
+		count = align;
+	return count;
 }
 
 /**
@@ -674,6 +735,60 @@ int net_rx ( struct io_buffer *iobuf, struct net_device *netdev,
 	return -ENOTSUP;
 }
 
+/** Maximum number of received packets to process per device per poll */
+static unsigned int netdev_rx_batch = NETDEV_RX_BATCH;
+
+/**
+ * Process received packet
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ */
+static void netdev_rx_process ( struct net_device *netdev,
+				struct io_buffer *iobuf ) {
+	struct ll_protocol *ll_protocol = netdev->ll_protocol;
+	const void *ll_dest;
+	const void *ll_source;
+	uint16_t net_proto;
+	int rc;
+
+	DBGC ( netdev, "NETDEV %s processing %p (%p+%zx)\n",
+	       netdev->name, iobuf, iobuf->data, iob_len ( iobuf ) );
+
+	/* Remove link-layer header */
+	if ( ( rc = ll_protocol->pull ( netdev, iobuf, &ll_dest, &ll_source,
+					&net_proto ) ) != 0 ) {
+		free_iob ( iobuf );
+		return;
+	}
+
+	/* Hand packet to network layer */
+	if ( ( rc = net_rx ( iob_disown ( iobuf ), netdev, net_proto,
+			     ll_dest, ll_source ) ) != 0 ) {
+		/* Record error for diagnosis */
+		netdev_rx_err ( netdev, NULL, rc );
+	}
+}
+
+/**
+ * Record network device receive batch
+ *
+ * @v netdev		Network device
+ * @v count		Number of packets processed in this batch
+ */
+static void netdev_record_batch ( struct net_device *netdev,
+				  unsigned int count ) {
+	struct net_device_stats *stats = &netdev->rx_stats;
+
+	if ( ! count )
+		return;
+	stats->batches++;
+	if ( count > stats->max_batch )
+		stats->max_batch = count;
+	if ( count >= netdev_rx_batch )
+		stats->full_batches++;
+}
+
 /**
  * Poll the network stack
  *
@@ -683,11 +798,7 @@ int net_rx ( struct io_buffer *iobuf, struct net_device *netdev,
 void net_poll ( void ) {
 	struct net_device *netdev;
 	struct io_buffer *iobuf;
-	struct ll_protocol *ll_protocol;
-	const void *ll_dest;
-	const void *ll_source;
-	uint16_t net_proto;
-	int rc;
+	unsigned int count;
 
 	/* Poll and process each network device */
 	list_for_each_entry ( netdev, &net_devices, list ) {
@@ -695,44 +806,37 @@ void net_poll ( void ) {
 		/* Poll for new packets */
 		netdev_poll ( netdev );
 
-		/* Leave received packets on the queue if receive
-		 * queue processing is currently frozen.  This will
-		 * happen when the raw packets are to be manually
-		 * dequeued using netdev_rx_dequeue(), rather than
-		 * processed via the usual networking stack.
+		/* Process up to a fixed number of received packets
+		 * from each device.  Processing more than one packet
+		 * per poll avoids limiting throughput to one packet
+		 * per scheduler step, while the per-device limit
+		 * prevents a single busy device from starving the
+		 * others (and from starving its own NIC, since we
+		 * advertise a window that assumes that we can receive
+		 * packets from the NIC faster than they arrive).
 		 */
-		if ( netdev_rx_frozen ( netdev ) )
-			continue;
-
-		/* Process at most one received packet.  Give priority
-		 * to getting packets out of the NIC over processing
-		 * the received packets, because we advertise a window
-		 * that assumes that we can receive packets from the
-		 * NIC faster than they arrive.
-		 */
-		if ( ( iobuf = netdev_rx_dequeue ( netdev ) ) ) {
-
-			DBGC ( netdev, "NETDEV %s processing %p (%p+%zx)\n",
-			       netdev->name, iobuf, iobuf->data,
-			       iob_len ( iobuf ) );
-
-			/* Remove link-layer header */
-			ll_protocol = netdev->ll_protocol;
-			if ( ( rc = ll_protocol->pull ( netdev, iobuf,
-							&ll_dest, &ll_source,
-							&net_proto ) ) != 0 ) {
-				free_iob ( iobuf );
-				continue;
-			}
-
-			/* Hand packet to network layer */
-			if ( ( rc = net_rx ( iob_disown ( iobuf ), netdev,
-					     net_proto, ll_dest,
-					     ll_source ) ) != 0 ) {
-				/* Record error for diagnosis */
-				netdev_rx_err ( netdev, NULL, rc );
-			}
+		for ( count = 0 ; count < netdev_rx_batch ; count++ ) {
+
+			/* Leave received packets on the queue if
+			 * receive queue processing is currently
+			 * frozen.  This will happen when the raw
+			 * packets are to be manually dequeued using
+			 * netdev_rx_dequeue(), rather than processed
+			 * via the usual networking stack.  (Check on
+			 * each iteration, since processing a packet
+			 * may freeze the queue.)
+			 */
+			if ( netdev_rx_frozen ( netdev ) )
+				break;
+
+			/* Dequeue next packet, if any */
+			if ( ! ( iobuf = netdev_rx_dequeue ( netdev ) ) )
+				break;
+
+			/* Process packet */
+			netdev_rx_process ( netdev, iobuf );
 		}
+		netdev_record_batch ( netdev, count );
 	}
 }
 
@@ -750,3 +854,40 @@ struct process net_process __permanent_process = {
 	.list = LIST_HEAD_INIT ( net_process.list ),
 	.step = net_step,
 };
+
+/******************************************************************************
+ *
+ * Settings
+ *
+ ******************************************************************************
+ */
+
+/** Receive batch size setting */
+struct setting rx_batch_setting __setting ( SETTING_NETDEV_EXTRA ) = {
+	.name = "rx-batch",
+	.description = "Receive batch size",
+	.tag = DHCP_EB_RX_BATCH,
+	.type = &setting_type_uint16,
+};
+
+/**
+ * Apply network device settings
+ *
+ * @ret rc		Return status code
+ */
+static int apply_netdev_settings ( void ) {
+	unsigned long rx_batch;
+
+	/* Fetch receive batch size, falling back to the default */
+	rx_batch = fetch_uintz_setting ( NULL, &rx_batch_setting );
+	netdev_rx_batch = ( rx_batch ? rx_batch : NETDEV_RX_BATCH );
+	DBG ( "NETDEV processing up to %d packets per poll\n",
+	      netdev_rx_batch );
+
+	return 0;
+}
+
+/** Network device settings applicator */
+struct settings_applicator netdev_applicator __settings_applicator = {
+	.apply = apply_netdev_settings,
+};
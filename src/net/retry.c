@@ -35,7 +35,11 @@ FILE_LICENCE ( GPL2_OR_LATER );
  * This implementation of the timer is designed to satisfy RFC 2988
  * and therefore be usable as a TCP retransmission timer.
  *
- * 
+ * Running timers are held in a hashed timing wheel, indexed by
+ * expiry time.  Starting and stopping a timer are O(1) operations,
+ * and each step of the retry timer process needs to examine only the
+ * timers hashed to the slots corresponding to the ticks that have
+ * elapsed since the previous step.
  */
 
 /* The theoretical minimum that the algorithm in stop_timer() can
@@ -44,8 +48,35 @@ FILE_LICENCE ( GPL2_OR_LATER );
  */
 #define MIN_TIMEOUT 7
 
-/** List of running timers */
-static LIST_HEAD ( timers );
+/** Number of slots in the timing wheel
+ *
+ * Must be a power of two.
+ */
+#define RETRY_WHEEL_SIZE 128
+
+/** Timing wheel of running timers, indexed by expiry time */
+static struct list_head retry_wheel[RETRY_WHEEL_SIZE];
+
+/** Next tick to be processed by the retry timer process */
+static unsigned long retry_wheel_tick;
+
+/**
+ * Add running timer to timing wheel
+ *
+ * @v timer		Retry timer
+ */
+static void timer_enqueue ( struct retry_timer *timer ) {
+	unsigned long expiry = ( timer->start + timer->timeout );
+
+	/* Timers that have already expired must be placed into the
+	 * next slot to be processed, otherwise they would not be
+	 * seen until the wheel had completed a full revolution.
+	 */
+	if ( ( long ) ( expiry - retry_wheel_tick ) < 0 )
+		expiry = retry_wheel_tick;
+	list_add_tail ( &timer->list,
+			&retry_wheel[ expiry & ( RETRY_WHEEL_SIZE - 1 ) ] );
+}
 
 /**
  * Start timer
@@ -57,8 +88,9 @@ static LIST_HEAD ( timers );
  * be stopped and the timer's callback function will be called.
  */
 void start_timer ( struct retry_timer *timer ) {
-	if ( ! timer->running ) {
-		list_add ( &timer->list, &timers );
+	if ( timer->running ) {
+		list_del ( &timer->list );
+	} else {
 		ref_get ( timer->refcnt );
 	}
 	timer->start = currticks();
@@ -73,6 +105,7 @@ void start_timer ( struct retry_timer *timer ) {
 	/* Honor user-specified minimum timeout */
 	if ( timer->timeout < timer->min_timeout )
 		timer->timeout = timer->min_timeout;
+	timer_enqueue ( timer );
 
 	DBG2 ( "Timer %p started at time %ld (expires at %ld)\n",
 	       timer, timer->start, ( timer->start + timer->timeout ) );
@@ -86,7 +119,9 @@ void start_timer ( struct retry_timer *timer ) {
  */
 void start_timer_fixed ( struct retry_timer *timer, unsigned long timeout ) {
 	start_timer ( timer );
+	list_del ( &timer->list );
 	timer->timeout = timeout;
+	timer_enqueue ( timer );
 	DBG2 ( "Timer %p expiry time changed to %ld\n",
 	       timer, ( timer->start + timer->timeout ) );
 }
@@ -180,23 +215,61 @@ static void timer_expired ( struct retry_timer *timer ) {
  */
 static void retry_step ( struct process *process __unused ) {
 	struct retry_timer *timer;
+	struct retry_timer *tmp;
+	struct list_head *slot;
+	LIST_HEAD ( expired );
 	unsigned long now = currticks();
 	unsigned long used;
+	unsigned int slots;
 
-	/* Process at most one timer expiry.  We cannot process
-	 * multiple expiries in one pass, because one timer expiring
-	 * may end up triggering another timer's deletion from the
-	 * list.
+	/* Collect all expired timers from each slot corresponding to
+	 * a tick that has elapsed since the last step.  If more than
+	 * a full revolution has elapsed, every slot will be examined
+	 * exactly once.
 	 */
-	list_for_each_entry ( timer, &timers, list ) {
-		used = ( now - timer->start );
-		if ( used >= timer->timeout ) {
-			timer_expired ( timer );
-			break;
+	for ( slots = RETRY_WHEEL_SIZE ;
+	      slots && ( ( long ) ( now - retry_wheel_tick ) >= 0 ) ;
+	      slots--, retry_wheel_tick++ ) {
+		slot = &retry_wheel[ retry_wheel_tick &
+				     ( RETRY_WHEEL_SIZE - 1 ) ];
+		list_for_each_entry_safe ( timer, tmp, slot, list ) {
+			used = ( now - timer->start );
+			if ( used >= timer->timeout ) {
+				list_del ( &timer->list );
+				list_add_tail ( &timer->list, &expired );
+			}
 		}
 	}
+	if ( ! slots )
+		retry_wheel_tick = ( now + 1 );
+
+	/* Process all expired timers.  One timer expiring may end up
+	 * stopping or restarting another expired timer, which will
+	 * remove it from the list of expired timers, so we must
+	 * always restart from the head of the list.
+	 */
+	while ( ( timer = list_first_entry ( &expired, struct retry_timer,
+					     list ) ) ) {
+		timer_expired ( timer );
+	}
+}
+
+/**
+ * Initialise retry timers
+ *
+ */
+static void retry_init ( void ) {
+	unsigned int i;
+
+	for ( i = 0 ; i < RETRY_WHEEL_SIZE ; i++ )
+		INIT_LIST_HEAD ( &retry_wheel[i] );
 }
 
+/** Retry timer initialisation function */
+struct init_fn retry_init_fn __init_fn ( INIT_EARLY ) = {
+	.initialise = retry_init,
+};
+
 /** Retry timer process */
 struct process retry_process __permanent_process = {
 	.list = LIST_HEAD_INIT ( retry_process.list ),
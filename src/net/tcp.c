@@ -64,6 +64,11 @@ struct tcp_connection {
 	 * Equivalent to SND.WND in RFC 793 terminology
 	 */
 	uint32_t snd_win;
+	/** Send window scale
+	 *
+	 * Equivalent to Snd.Wind.Scale in RFC 1323 terminology
+	 */
+	uint8_t snd_win_scale;
 	/** Current acknowledgement number
 	 *
 	 * Equivalent to RCV.NXT in RFC 793 terminology.
@@ -74,11 +79,21 @@ struct tcp_connection {
 	 * Equivalent to RCV.WND in RFC 793 terminology.
 	 */
 	uint32_t rcv_win;
+	/** Receive window scale
+	 *
+	 * Equivalent to Rcv.Wind.Scale in RFC 1323 terminology
+	 */
+	uint8_t rcv_win_scale;
 	/** Most recent received timestamp
 	 *
 	 * Equivalent to TS.Recent in RFC 1323 terminology.
 	 */
 	uint32_t ts_recent;
+	/** Start of most recently received out-of-order data
+	 *
+	 * Used to select the first SACK block, as per RFC 2018.
+	 */
+	uint32_t sack_seq;
 
 	/** Transmit queue */
 	struct list_head tx_queue;
@@ -98,6 +113,8 @@ enum tcp_flags {
 	TCP_TS_ENABLED = 0x0002,
 	/** TCP acknowledgement is pending */
 	TCP_ACK_PENDING = 0x0004,
+	/** TCP selective acknowledgement is enabled */
+	TCP_SACK_ENABLED = 0x0008,
 };
 
 /** TCP internal header
@@ -128,6 +145,14 @@ struct tcp_rx_queued_header {
  */
 static LIST_HEAD ( tcp_conns );
 
+/**
+ * Receive window limit
+ *
+ * This is reduced whenever memory runs short, and is gradually
+ * allowed to grow back towards TCP_MAX_WINDOW_SIZE.
+ */
+static uint32_t tcp_rcv_win_limit = TCP_MAX_WINDOW_SIZE;
+
 /* Forward declarations */
 static struct interface_descriptor tcp_xfer_desc;
 static void tcp_expired ( struct retry_timer *timer, int over );
@@ -427,11 +452,90 @@ static size_t tcp_process_tx_queue ( struct tcp_connection *tcp, size_t max_len,
 	return len;
 }
 
+/**
+ * Add SACK block
+ *
+ * @v tcp		TCP connection
+ * @v blocks		SACK block list (in host-endian order)
+ * @v count		Number of SACK blocks in list
+ * @v block		SACK block to add
+ * @ret count		Number of SACK blocks in list
+ *
+ * The first entry in the SACK block list is reserved for the block
+ * containing the most recently received out-of-order data.
+ */
+static unsigned int tcp_sack_add ( struct tcp_connection *tcp,
+				   struct tcp_sack_block *blocks,
+				   unsigned int count,
+				   struct tcp_sack_block *block ) {
+
+	if ( tcp_in_window ( tcp->sack_seq, block->left,
+			     ( block->right - block->left ) ) ) {
+		memcpy ( &blocks[0], block, sizeof ( blocks[0] ) );
+	} else if ( count < TCP_SACK_MAX ) {
+		memcpy ( &blocks[count++], block, sizeof ( blocks[0] ) );
+	}
+	return count;
+}
+
+/**
+ * Construct SACK blocks
+ *
+ * @v tcp		TCP connection
+ * @v blocks		SACK block list to fill in (in host-endian order)
+ * @ret count		Number of SACK blocks
+ *
+ * Constructs up to TCP_SACK_MAX SACK blocks describing the contents
+ * of the receive queue, with the block containing the most recently
+ * received out-of-order data reported first.
+ */
+static unsigned int tcp_sack ( struct tcp_connection *tcp,
+			       struct tcp_sack_block *blocks ) {
+	struct tcp_rx_queued_header *tcpqhdr;
+	struct io_buffer *iobuf;
+	struct tcp_sack_block block;
+	unsigned int count = 1;
+	uint32_t seq;
+	uint32_t end;
+
+	/* Coalesce contiguous packets in the (sorted) receive queue */
+	memset ( blocks, 0, sizeof ( blocks[0] ) );
+	memset ( &block, 0, sizeof ( block ) );
+	list_for_each_entry ( iobuf, &tcp->rx_queue, list ) {
+		tcpqhdr = iobuf->data;
+		seq = tcpqhdr->seq;
+		end = ( seq + iob_len ( iobuf ) - sizeof ( *tcpqhdr ) +
+			( ( tcpqhdr->flags & TCP_FIN ) ? 1 : 0 ) );
+		if ( ( block.left != block.right ) &&
+		     ( tcp_cmp ( seq, block.right ) <= 0 ) ) {
+			if ( tcp_cmp ( end, block.right ) > 0 )
+				block.right = end;
+			continue;
+		}
+		if ( block.left != block.right )
+			count = tcp_sack_add ( tcp, blocks, count, &block );
+		block.left = seq;
+		block.right = end;
+	}
+	if ( block.left != block.right )
+		count = tcp_sack_add ( tcp, blocks, count, &block );
+
+	/* Remove reserved first entry if not used */
+	if ( blocks[0].left == blocks[0].right ) {
+		count--;
+		memmove ( &blocks[0], &blocks[1],
+			  ( count * sizeof ( blocks[0] ) ) );
+	}
+
+	return count;
+}
+
 /**
  * Transmit any outstanding data
  *
  * @v tcp		TCP connection
- * 
+ * @ret rc		Return status code
+ *
  * Transmits any outstanding data on the connection.
  *
  * Note that even if an error is returned, the retransmission timer
@@ -442,13 +546,20 @@ static int tcp_xmit ( struct tcp_connection *tcp ) {
 	struct io_buffer *iobuf;
 	struct tcp_header *tcphdr;
 	struct tcp_mss_option *mssopt;
+	struct tcp_window_scale_padded_option *wsopt;
+	struct tcp_sack_permitted_padded_option *spopt;
 	struct tcp_timestamp_padded_option *tsopt;
+	struct tcp_sack_padded_option *sackopt;
+	struct tcp_sack_block blocks[TCP_SACK_MAX];
 	void *payload;
 	unsigned int flags;
+	unsigned int sack_count = 0;
+	unsigned int i;
 	size_t len = 0;
 	uint32_t seq_len;
 	uint32_t app_win;
 	uint32_t max_rcv_win;
+	uint16_t win;
 	int rc;
 
 	/* If retransmission timer is already running, do nothing */
@@ -484,22 +595,31 @@ static int tcp_xmit ( struct tcp_connection *tcp ) {
 		start_timer ( &tcp->timer );
 
 	/* Allocate I/O buffer */
-	iobuf = alloc_iob ( len + MAX_LL_NET_HEADER_LEN );
+	iobuf = alloc_iob ( len + TCP_MAX_HEADER_LEN + MAX_LL_NET_HEADER_LEN );
 	if ( ! iobuf ) {
 		DBGC ( tcp, "TCP %p could not allocate iobuf for %08x..%08x "
 		       "%08x\n", tcp, tcp->snd_seq, ( tcp->snd_seq + seq_len ),
 		       tcp->rcv_ack );
 		return -ENOMEM;
 	}
-	iob_reserve ( iobuf, MAX_LL_NET_HEADER_LEN );
+	iob_reserve ( iobuf, ( TCP_MAX_HEADER_LEN + MAX_LL_NET_HEADER_LEN ) );
 
 	/* Fill data payload from transmit queue */
 	tcp_process_tx_queue ( tcp, len, iobuf, 0 );
 
+	/* Allow the receive window limit to recover from any
+	 * previous memory pressure
+	 */
+	tcp_rcv_win_limit += TCP_MSS;
+	if ( tcp_rcv_win_limit > TCP_MAX_WINDOW_SIZE )
+		tcp_rcv_win_limit = TCP_MAX_WINDOW_SIZE;
+
 	/* Expand receive window if possible */
 	max_rcv_win = ( ( freemem * 3 ) / 4 );
-	if ( max_rcv_win > TCP_MAX_WINDOW_SIZE )
-		max_rcv_win = TCP_MAX_WINDOW_SIZE;
+	if ( max_rcv_win > tcp_rcv_win_limit )
+		max_rcv_win = tcp_rcv_win_limit;
+	if ( max_rcv_win > ( 0xffffUL << tcp->rcv_win_scale ) )
+		max_rcv_win = ( 0xffffUL << tcp->rcv_win_scale );
 	app_win = xfer_window ( &tcp->xfer );
 	if ( max_rcv_win > app_win )
 		max_rcv_win = app_win;
@@ -507,6 +627,15 @@ static int tcp_xmit ( struct tcp_connection *tcp ) {
 	if ( tcp->rcv_win < max_rcv_win )
 		tcp->rcv_win = max_rcv_win;
 
+	/* Calculate advertised window.  (The window field within a
+	 * SYN is never scaled.)
+	 */
+	if ( flags & TCP_SYN ) {
+		win = ( ( tcp->rcv_win > 0xffff ) ? 0xffff : tcp->rcv_win );
+	} else {
+		win = ( tcp->rcv_win >> tcp->rcv_win_scale );
+	}
+
 	/* Fill up the TCP header */
 	payload = iobuf->data;
 	if ( flags & TCP_SYN ) {
@@ -514,6 +643,38 @@ static int tcp_xmit ( struct tcp_connection *tcp ) {
 		mssopt->kind = TCP_OPTION_MSS;
 		mssopt->length = sizeof ( *mssopt );
 		mssopt->mss = htons ( TCP_MSS );
+		wsopt = iob_push ( iobuf, sizeof ( *wsopt ) );
+		wsopt->nop[0] = TCP_OPTION_NOP;
+		wsopt->wsopt.kind = TCP_OPTION_WS;
+		wsopt->wsopt.length = sizeof ( wsopt->wsopt );
+		wsopt->wsopt.scale = TCP_RX_WINDOW_SCALE;
+		/* Permit SACK so that the peer can learn about our
+		 * out-of-order receive queue; see tcp_sack().
+		 */
+		spopt = iob_push ( iobuf, sizeof ( *spopt ) );
+		memset ( spopt->nop, TCP_OPTION_NOP, sizeof ( spopt->nop ) );
+		spopt->spopt.kind = TCP_OPTION_SACK_PERMITTED;
+		spopt->spopt.length = sizeof ( spopt->spopt );
+	} else if ( ( tcp->flags & TCP_SACK_ENABLED ) &&
+		    ! list_empty ( &tcp->rx_queue ) ) {
+		sack_count = tcp_sack ( tcp, blocks );
+	}
+	if ( sack_count ) {
+		sackopt = iob_push ( iobuf, ( sizeof ( *sackopt ) +
+					      ( sack_count *
+						sizeof ( blocks[0] ) ) ) );
+		memset ( sackopt->nop, TCP_OPTION_NOP,
+			 sizeof ( sackopt->nop ) );
+		sackopt->sackopt.kind = TCP_OPTION_SACK;
+		sackopt->sackopt.length = ( sizeof ( sackopt->sackopt ) +
+					    ( sack_count *
+					      sizeof ( blocks[0] ) ) );
+		for ( i = 0 ; i < sack_count ; i++ ) {
+			sackopt->sackopt.block[i].left =
+				htonl ( blocks[i].left );
+			sackopt->sackopt.block[i].right =
+				htonl ( blocks[i].right );
+		}
 	}
 	if ( ( flags & TCP_SYN ) || ( tcp->flags & TCP_TS_ENABLED ) ) {
 		tsopt = iob_push ( iobuf, sizeof ( *tsopt ) );
@@ -533,7 +694,7 @@ static int tcp_xmit ( struct tcp_connection *tcp ) {
 	tcphdr->ack = htonl ( tcp->rcv_ack );
 	tcphdr->hlen = ( ( payload - iobuf->data ) << 2 );
 	tcphdr->flags = flags;
-	tcphdr->win = htons ( tcp->rcv_win );
+	tcphdr->win = htons ( win );
 	tcphdr->csum = tcpip_chksum ( iobuf->data, iob_len ( iobuf ) );
 
 	/* Dump header */
@@ -646,7 +807,7 @@ static int tcp_xmit_reset ( struct tcp_connection *tcp,
 	tcphdr->ack = in_tcphdr->seq;
 	tcphdr->hlen = ( ( sizeof ( *tcphdr ) / 4 ) << 4 );
 	tcphdr->flags = ( TCP_RST | TCP_ACK );
-	tcphdr->win = htons ( TCP_MAX_WINDOW_SIZE );
+	tcphdr->win = htons ( 0 );
 	tcphdr->csum = tcpip_chksum ( iobuf->data, iob_len ( iobuf ) );
 
 	/* Dump header */
@@ -721,6 +882,20 @@ static void tcp_rx_opts ( struct tcp_connection *tcp, const void *data,
 		case TCP_OPTION_MSS:
 			options->mssopt = data;
 			break;
+		case TCP_OPTION_WS:
+			options->wsopt = data;
+			break;
+		case TCP_OPTION_SACK_PERMITTED:
+			options->spopt = data;
+			break;
+		case TCP_OPTION_SACK:
+			/* We never have more than one segment in
+			 * flight, so there is never any sent data
+			 * beyond the cumulative ACK for a SACK block
+			 * to describe.  RFC 2018 allows the data
+			 * sender to ignore SACK information.
+			 */
+			break;
 		case TCP_OPTION_TS:
 			options->tsopt = data;
 			break;
@@ -765,6 +940,18 @@ static int tcp_rx_syn ( struct tcp_connection *tcp, uint32_t seq,
 		tcp->rcv_ack = seq;
 		if ( options->tsopt )
 			tcp->flags |= TCP_TS_ENABLED;
+		if ( options->wsopt ) {
+			tcp->snd_win_scale = options->wsopt->scale;
+			if ( tcp->snd_win_scale > TCP_MAX_WINDOW_SCALE )
+				tcp->snd_win_scale = TCP_MAX_WINDOW_SCALE;
+			tcp->rcv_win_scale = TCP_RX_WINDOW_SCALE;
+			DBGC ( tcp, "TCP %p using window scale %d (TX) %d (RX)\n",
+			       tcp, tcp->snd_win_scale, tcp->rcv_win_scale );
+		}
+		if ( options->spopt ) {
+			tcp->flags |= TCP_SACK_ENABLED;
+			DBGC ( tcp, "TCP %p using SACK\n", tcp );
+		}
 	}
 
 	/* Ignore duplicate SYN */
@@ -984,6 +1171,10 @@ static void tcp_rx_enqueue ( struct tcp_connection *tcp, uint32_t seq,
 		return;
 	}
 
+	/* Record start of most recently received out-of-order data */
+	if ( seq != tcp->rcv_ack )
+		tcp->sack_seq = seq;
+
 	/* Add internal header */
 	tcpqhdr = iob_push ( iobuf, sizeof ( *tcpqhdr ) );
 	tcpqhdr->seq = seq;
@@ -1126,6 +1317,12 @@ static int tcp_rx ( struct io_buffer *iobuf,
 		goto discard;
 	}
 
+	/* Scale window.  (The window field within a SYN is never
+	 * scaled.)
+	 */
+	if ( ! ( flags & TCP_SYN ) )
+		win <<= tcp->snd_win_scale;
+
 	/* Handle ACK, if present */
 	if ( flags & TCP_ACK ) {
 		if ( ( rc = tcp_rx_ack ( tcp, ack, win ) ) != 0 ) {
@@ -1203,6 +1400,13 @@ static unsigned int tcp_discard ( void ) {
 	struct io_buffer *iobuf;
 	unsigned int discarded = 0;
 
+	/* Limit the receive window to reduce the amount of data that
+	 * could arrive out of order and need to be queued.
+	 */
+	tcp_rcv_win_limit /= 2;
+	if ( tcp_rcv_win_limit < TCP_MIN_WINDOW_LIMIT )
+		tcp_rcv_win_limit = TCP_MIN_WINDOW_LIMIT;
+
 	/* Try to drop one queued RX packet from each connection */
 	list_for_each_entry ( tcp, &tcp_conns, list ) {
 		list_for_each_entry_reverse ( iobuf, &tcp->rx_queue, list ) {
@@ -33,6 +33,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <byteswap.h>
 #include <errno.h>
 #include <assert.h>
+#include <ipxe/list.h>
 #include <ipxe/uri.h>
 #include <ipxe/refcnt.h>
 #include <ipxe/iobuf.h>
@@ -44,16 +45,105 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <ipxe/linebuf.h>
 #include <ipxe/features.h>
 #include <ipxe/base64.h>
+#include <ipxe/retry.h>
+#include <ipxe/timer.h>
+#include <ipxe/init.h>
 #include <ipxe/http.h>
+#include <config/general.h>
 
 FEATURE ( FEATURE_PROTOCOL, "HTTP", DHCP_EB_FEATURE_HTTP, 1 );
 
+/** Time for which an idle connection is kept open for reuse */
+#define HTTP_IDLE_TIMEOUT ( 30 * TICKS_PER_SEC )
+
+/** Maximum response body length that will be drained from an
+ * abandoned request in order to keep the connection open for reuse
+ */
+#define HTTP_MAX_DRAIN 65536
+
+/** Minimum length of a segment in a segmented download */
+#define HTTP_SEGMENT_MIN_LEN ( 1024 * 1024 )
+
 /** HTTP receive state */
 enum http_rx_state {
 	HTTP_RX_RESPONSE = 0,
 	HTTP_RX_HEADER,
+	HTTP_RX_CHUNK_LEN,
+	HTTP_RX_TRAILER,
 	HTTP_RX_DATA,
-	HTTP_RX_DEAD,
+	HTTP_RX_DONE,
+};
+
+/** HTTP request flags */
+enum http_request_flags {
+	/** Request has been transmitted */
+	HTTP_TX_DONE = 0x0001,
+	/** Part of the response has been received */
+	HTTP_RX_STARTED = 0x0002,
+	/** Response has a Content-Length */
+	HTTP_CONTENT_LENGTH = 0x0004,
+	/** Response uses chunked transfer encoding */
+	HTTP_CHUNKED = 0x0008,
+	/** Data transfer interface has been closed */
+	HTTP_CLOSED = 0x0010,
+	/** Request has been reissued on a new connection */
+	HTTP_REISSUED = 0x0020,
+	/** Server accepts byte range requests */
+	HTTP_ACCEPT_RANGES = 0x0040,
+	/** Response has been received in full */
+	HTTP_RX_COMPLETE = 0x0080,
+	/** Download has been split into segments */
+	HTTP_SEGMENTED = 0x0100,
+	/** Segment is awaiting dispatch after a failed attempt */
+	HTTP_DEFERRED = 0x0200,
+	/** Segment is a retry of a failed attempt */
+	HTTP_RETRIED = 0x0400,
+};
+
+/** HTTP connection flags */
+enum http_connection_flags {
+	/** Connection may not be used for further requests */
+	HTTP_CONN_NO_REUSE = 0x0001,
+	/** Connection has been closed */
+	HTTP_CONN_CLOSED = 0x0002,
+};
+
+/**
+ * An HTTP connection
+ *
+ * A connection may carry several requests in sequence.  Requests
+ * are queued on the connection in the order in which they are
+ * transmitted; the response at the head of the receive stream always
+ * belongs to the first request in the queue.
+ */
+struct http_connection {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** List of open connections */
+	struct list_head list;
+	/** Transport layer interface */
+	struct interface socket;
+
+	/** Server host name */
+	char *host;
+	/** Server port */
+	unsigned int port;
+	/** Filter applied to socket, or NULL */
+	int ( * filter ) ( struct interface *xfer, const char *name,
+			   unsigned int port, struct interface **next );
+
+	/** Queued requests */
+	struct list_head requests;
+	/** TX process */
+	struct process process;
+	/** Idle timer */
+	struct retry_timer timer;
+	/** Line buffer for received header lines */
+	struct line_buffer linebuf;
+	/** Flags */
+	unsigned int flags;
+	/** Number of responses received */
+	unsigned int responses;
 };
 
 /**
@@ -68,11 +158,18 @@ struct http_request {
 
 	/** URI being fetched */
 	struct uri *uri;
-	/** Transport layer interface */
-	struct interface socket;
-
-	/** TX process */
-	struct process process;
+	/** Server port */
+	unsigned int port;
+	/** Filter to apply to socket, or NULL */
+	int ( * filter ) ( struct interface *xfer, const char *name,
+			   unsigned int port, struct interface **next );
+
+	/** Connection carrying this request, if any */
+	struct http_connection *conn;
+	/** List of requests queued on connection */
+	struct list_head list;
+	/** Flags */
+	unsigned int flags;
 
 	/** HTTP response code */
 	unsigned int response;
@@ -80,12 +177,45 @@ struct http_request {
 	size_t content_length;
 	/** Received length */
 	size_t rx_len;
+	/** Remaining length of body or current chunk */
+	size_t remaining;
 	/** RX state */
 	enum http_rx_state rx_state;
-	/** Line buffer for received header lines */
-	struct line_buffer linebuf;
+
+	/** Start of requested byte range */
+	size_t range_start;
+	/** Length of requested byte range, or zero for whole file */
+	size_t range_len;
+	/** Parent request, if this request fetches a segment */
+	struct http_request *parent;
+	/** List of segments (of a parent request) */
+	struct list_head segments;
+	/** List of segments of parent request (of a segment) */
+	struct list_head segment;
 };
 
+/** List of open HTTP connections */
+static LIST_HEAD ( http_connections );
+
+static int http_request_dispatch ( struct http_request *http );
+static void http_xfer_close ( struct http_request *http, int rc );
+static void http_segment ( struct http_request *http );
+static int http_segment_retry ( struct http_request *segment );
+static void http_segment_step ( struct http_request *http );
+
+/**
+ * Free HTTP connection
+ *
+ * @v refcnt		Reference counter
+ */
+static void http_conn_free ( struct refcnt *refcnt ) {
+	struct http_connection *conn =
+		container_of ( refcnt, struct http_connection, refcnt );
+
+	empty_line_buffer ( &conn->linebuf );
+	free ( conn );
+}
+
 /**
  * Free HTTP request
  *
@@ -96,37 +226,238 @@ static void http_free ( struct refcnt *refcnt ) {
 		container_of ( refcnt, struct http_request, refcnt );
 
 	uri_put ( http->uri );
-	empty_line_buffer ( &http->linebuf );
 	free ( http );
 };
 
 /**
- * Mark HTTP request as complete
+ * Remove HTTP request from its connection
+ *
+ * @v http		HTTP request
+ *
+ * The connection's reference to the request is dropped; the caller
+ * must hold its own reference if it wishes to continue using the
+ * request.  If this leaves the connection with no queued requests,
+ * the idle timer is started.
+ */
+static void http_detach ( struct http_request *http ) {
+	struct http_connection *conn = http->conn;
+
+	if ( ! conn )
+		return;
+	list_del ( &http->list );
+	http->conn = NULL;
+	if ( list_empty ( &conn->requests ) &&
+	     ! ( conn->flags & HTTP_CONN_CLOSED ) )
+		start_timer_fixed ( &conn->timer, HTTP_IDLE_TIMEOUT );
+	ref_put ( &conn->refcnt );
+	ref_put ( &http->refcnt );
+}
+
+/**
+ * Close HTTP request
  *
  * @v http		HTTP request
  * @v rc		Return status code
+ *
+ * If the request has already been transmitted, it remains queued on
+ * the connection so that the response can be drained.
+ *
+ * A failed segment is retried once (see http_segment_retry()) before
+ * its failure is reported to the parent request.
  */
-static void http_done ( struct http_request *http, int rc ) {
+static void http_close ( struct http_request *http, int rc ) {
+	struct http_request *parent = http->parent;
+	struct http_request *segment;
+
+	/* Do nothing if already closed */
+	if ( http->flags & HTTP_CLOSED )
+		return;
 
-	/* Prevent further processing of any current packet */
-	http->rx_state = HTTP_RX_DEAD;
+	/* Close data transfer interface */
+	http->flags |= HTTP_CLOSED;
+	intf_shutdown ( &http->xfer, rc );
+
+	/* Abandon any outstanding segments */
+	while ( ! list_empty ( &http->segments ) ) {
+		segment = list_first_entry ( &http->segments,
+					     struct http_request, segment );
+		ref_get ( &segment->refcnt );
+		http_xfer_close ( segment, ( rc ? rc : -ECANCELED ) );
+		ref_put ( &segment->refcnt );
+	}
+
+	/* Report completion of segment to parent request, unless the
+	 * segment can be retried.  The parent completes successfully
+	 * once its own response and all of its segments are complete.
+	 */
+	if ( parent ) {
+		if ( rc != 0 )
+			rc = http_segment_retry ( http );
+		list_del ( &http->segment );
+		http->parent = NULL;
+		if ( rc != 0 ) {
+			http_close ( parent, rc );
+		} else {
+			http_segment_step ( parent );
+		}
+		ref_put ( &parent->refcnt );
+	}
 
-	/* If we had a Content-Length, and the received content length
-	 * isn't correct, flag an error
+	/* Remove request from connection if not yet transmitted.
+	 * Otherwise, the request no longer counts towards the
+	 * pipeline depth, and a waiting request may now be sent.
 	 */
-	if ( http->content_length &&
-	     ( http->content_length != http->rx_len ) ) {
-		DBGC ( http, "HTTP %p incorrect length %zd, should be %zd\n",
-		       http, http->rx_len, http->content_length );
-		rc = -EIO;
+	if ( ! ( http->flags & HTTP_TX_DONE ) ) {
+		http_detach ( http );
+	} else if ( http->conn ) {
+		process_add ( &http->conn->process );
 	}
 
-	/* Remove process */
-	process_del ( &http->process );
+	/* Drop parent's list's reference, if applicable */
+	if ( parent )
+		ref_put ( &http->refcnt );
+}
 
-	/* Close all data transfer interfaces */
-	intf_shutdown ( &http->socket, rc );
-	intf_shutdown ( &http->xfer, rc );
+/**
+ * Close HTTP connection
+ *
+ * @v conn		HTTP connection
+ * @v rc		Return status code
+ *
+ * Any requests that have been transmitted on a previously working
+ * connection but have not yet seen any part of their response (as
+ * happens when the server closes an idle connection at the same time
+ * as we reuse it) are reissued on a new connection.
+ */
+static void http_conn_close ( struct http_connection *conn, int rc ) {
+	struct http_request *http;
+	int reissue_rc;
+
+	/* Do nothing if already closed */
+	if ( conn->flags & HTTP_CONN_CLOSED )
+		return;
+	conn->flags |= HTTP_CONN_CLOSED;
+	DBGC ( conn, "HTTP connection %p closed after %d responses: %s\n",
+	       conn, conn->responses, strerror ( rc ) );
+
+	/* Remove from list of open connections, retaining the list's
+	 * reference until we have finished.
+	 */
+	list_del ( &conn->list );
+
+	/* Stop process and timer, and close socket */
+	process_del ( &conn->process );
+	stop_timer ( &conn->timer );
+	intf_shutdown ( &conn->socket, rc );
+	empty_line_buffer ( &conn->linebuf );
+
+	/* Complete, reissue or fail any outstanding requests */
+	while ( ! list_empty ( &conn->requests ) ) {
+		http = list_first_entry ( &conn->requests,
+					  struct http_request, list );
+		ref_get ( &http->refcnt );
+		http_detach ( http );
+		if ( http->flags & HTTP_CLOSED ) {
+			/* Abandoned request; nothing to do */
+		} else if ( ( http->rx_state == HTTP_RX_DATA ) &&
+			    ! ( http->flags & ( HTTP_CONTENT_LENGTH |
+						HTTP_CHUNKED ) ) ) {
+			/* Response delimited by connection close */
+			http_close ( http, 0 );
+		} else if ( ( ! ( http->flags & HTTP_TX_DONE ) ) ||
+			    ( ( ! ( http->flags & HTTP_RX_STARTED ) ) &&
+			      conn->responses &&
+			      ( ! ( http->flags & HTTP_REISSUED ) ) ) ) {
+			/* Request never reached a working server */
+			if ( http->flags & HTTP_TX_DONE )
+				http->flags |= HTTP_REISSUED;
+			DBGC ( http, "HTTP %p reissuing request\n", http );
+			reissue_rc = http_request_dispatch ( http );
+			if ( reissue_rc != 0 )
+				http_close ( http, reissue_rc );
+		} else {
+			/* Response incomplete */
+			http_close ( http, ( rc ? rc : -ECONNRESET ) );
+		}
+		ref_put ( &http->refcnt );
+	}
+
+	/* Drop list's reference */
+	ref_put ( &conn->refcnt );
+}
+
+/**
+ * Handle HTTP connection idle timer expiry
+ *
+ * @v timer		Idle timer
+ * @v fail		Failure indicator
+ */
+static void http_conn_expired ( struct retry_timer *timer, int fail __unused ) {
+	struct http_connection *conn =
+		container_of ( timer, struct http_connection, timer );
+
+	http_conn_close ( conn, 0 );
+}
+
+/**
+ * Check whether or not an abandoned response may be drained
+ *
+ * @v http		HTTP request
+ * @ret rc		Return status code
+ *
+ * A response whose request has been closed (e.g. after a redirection
+ * or an error status) must still be received in full before the
+ * connection can carry another response.  This is done only if the
+ * remaining body is known to be small; otherwise an error is returned
+ * and the caller should close the connection.
+ */
+static int http_check_drain ( struct http_request *http ) {
+
+	if ( ! ( http->flags & HTTP_CLOSED ) )
+		return 0;
+	if ( http->rx_state != HTTP_RX_DATA )
+		return 0;
+	if ( ( http->flags & HTTP_CONTENT_LENGTH ) &&
+	     ( ! ( http->flags & HTTP_CHUNKED ) ) &&
+	     ( http->remaining <= HTTP_MAX_DRAIN ) )
+		return 0;
+
+	DBGC ( http, "HTTP %p abandoning response body\n", http );
+	return -ECANCELED;
+}
+
+/**
+ * Handle completion of HTTP response
+ *
+ * @v conn		HTTP connection
+ * @v http		HTTP request
+ */
+static void http_rx_done ( struct http_connection *conn,
+			   struct http_request *http ) {
+
+	DBGC ( http, "HTTP %p response complete (%zd bytes)\n",
+	       http, http->rx_len );
+	conn->responses++;
+	empty_line_buffer ( &conn->linebuf );
+
+	/* Remove request from connection, and close it unless still
+	 * waiting for segments to complete.
+	 */
+	http->flags |= HTTP_RX_COMPLETE;
+	ref_get ( &http->refcnt );
+	http_detach ( http );
+	http_segment_step ( http );
+	ref_put ( &http->refcnt );
+
+	/* Close connection if it cannot be reused; otherwise send
+	 * any waiting requests.  (If no requests are waiting, the
+	 * idle timer has already been started.)
+	 */
+	if ( conn->flags & HTTP_CONN_NO_REUSE ) {
+		http_conn_close ( conn, 0 );
+	} else if ( ! list_empty ( &conn->requests ) ) {
+		process_add ( &conn->process );
+	}
 }
 
 /**
@@ -138,6 +469,7 @@ static void http_done ( struct http_request *http, int rc ) {
 static int http_response_to_rc ( unsigned int response ) {
 	switch ( response ) {
 	case 200:
+	case 206:
 	case 301:
 	case 302:
 		return 0;
@@ -169,16 +501,32 @@ static int http_rx_response ( struct http_request *http, char *response ) {
 	if ( strncmp ( response, "HTTP/", 5 ) != 0 )
 		return -EIO;
 
-	/* Locate and check response code */
+	/* HTTP/1.0 servers do not support persistent connections */
+	if ( strncmp ( response, "HTTP/1.0", 8 ) == 0 )
+		http->conn->flags |= HTTP_CONN_NO_REUSE;
+
+	/* Locate response code */
 	spc = strchr ( response, ' ' );
 	if ( ! spc )
 		return -EIO;
 	http->response = strtoul ( spc, NULL, 10 );
-	if ( ( rc = http_response_to_rc ( http->response ) ) != 0 )
-		return rc;
 
 	/* Move to received headers */
 	http->rx_state = HTTP_RX_HEADER;
+
+	/* Check response code.  The response body must still be
+	 * received in order to keep the connection usable, so close
+	 * only the request rather than returning an error.
+	 */
+	if ( ( http->response / 100 ) == 1 )
+		return 0;
+	if ( ( rc = http_response_to_rc ( http->response ) ) != 0 ) {
+		http_close ( http, rc );
+	} else if ( http->range_len && ( http->response != 206 ) ) {
+		DBGC ( http, "HTTP %p range request refused\n", http );
+		http_close ( http, -EIO );
+	}
+
 	return 0;
 }
 
@@ -192,13 +540,17 @@ static int http_rx_response ( struct http_request *http, char *response ) {
 static int http_rx_location ( struct http_request *http, const char *value ) {
 	int rc;
 
+	/* Ignore if request has already been closed, or is a segment */
+	if ( ( http->flags & HTTP_CLOSED ) || http->parent )
+		return 0;
+
 	/* Redirect to new location */
 	DBGC ( http, "HTTP %p redirecting to %s\n", http, value );
 	if ( ( rc = xfer_redirect ( &http->xfer, LOCATION_URI_STRING,
 				    value ) ) != 0 ) {
 		DBGC ( http, "HTTP %p could not redirect: %s\n",
 		       http, strerror ( rc ) );
-		return rc;
+		http_close ( http, rc );
 	}
 
 	return 0;
@@ -221,6 +573,18 @@ static int http_rx_content_length ( struct http_request *http,
 		       http, value );
 		return -EIO;
 	}
+	http->flags |= HTTP_CONTENT_LENGTH;
+
+	/* Check length of segment */
+	if ( http->range_len ) {
+		if ( http->content_length != http->range_len ) {
+			DBGC ( http, "HTTP %p incorrect segment length %zd, "
+			       "should be %zd\n", http, http->content_length,
+			       http->range_len );
+			return -EIO;
+		}
+		return 0;
+	}
 
 	/* Use seek() to notify recipient of filesize */
 	xfer_seek ( &http->xfer, http->content_length );
@@ -229,6 +593,58 @@ static int http_rx_content_length ( struct http_request *http,
 	return 0;
 }
 
+/**
+ * Handle HTTP Accept-Ranges header
+ *
+ * @v http		HTTP request
+ * @v value		HTTP header value
+ * @ret rc		Return status code
+ */
+static int http_rx_accept_ranges ( struct http_request *http,
+				   const char *value ) {
+
+	if ( strcasecmp ( value, "bytes" ) == 0 )
+		http->flags |= HTTP_ACCEPT_RANGES;
+
+	return 0;
+}
+
+/**
+ * Handle HTTP Transfer-Encoding header
+ *
+ * @v http		HTTP request
+ * @v value		HTTP header value
+ * @ret rc		Return status code
+ */
+static int http_rx_transfer_encoding ( struct http_request *http,
+				       const char *value ) {
+
+	if ( strcasecmp ( value, "chunked" ) != 0 ) {
+		DBGC ( http, "HTTP %p unsupported Transfer-Encoding \"%s\"\n",
+		       http, value );
+		return -ENOTSUP;
+	}
+	http->flags |= HTTP_CHUNKED;
+
+	return 0;
+}
+
+/**
+ * Handle HTTP Connection header
+ *
+ * @v http		HTTP request
+ * @v value		HTTP header value
+ * @ret rc		Return status code
+ */
+static int http_rx_connection ( struct http_request *http,
+				const char *value ) {
+
+	if ( strcasecmp ( value, "close" ) == 0 )
+		http->conn->flags |= HTTP_CONN_NO_REUSE;
+
+	return 0;
+}
+
 /** An HTTP header handler */
 struct http_header_handler {
 	/** Name (e.g. "Content-Length") */
@@ -239,7 +655,7 @@ struct http_header_handler {
 	 * @v value	HTTP header value
 	 * @ret rc	Return status code
 	 *
-	 * If an error is returned, the download will be aborted.
+	 * If an error is returned, the connection will be closed.
 	 */
 	int ( * rx ) ( struct http_request *http, const char *value );
 };
@@ -254,6 +670,18 @@ static struct http_header_handler http_header_handlers[] = {
 		.header = "Content-Length",
 		.rx = http_rx_content_length,
 	},
+	{
+		.header = "Transfer-Encoding",
+		.rx = http_rx_transfer_encoding,
+	},
+	{
+		.header = "Connection",
+		.rx = http_rx_connection,
+	},
+	{
+		.header = "Accept-Ranges",
+		.rx = http_rx_accept_ranges,
+	},
 	{ NULL, NULL }
 };
 
@@ -273,9 +701,26 @@ static int http_rx_header ( struct http_request *http, char *header ) {
 	/* An empty header line marks the transition to the data phase */
 	if ( ! header[0] ) {
 		DBGC ( http, "HTTP %p start of data\n", http );
-		empty_line_buffer ( &http->linebuf );
-		http->rx_state = HTTP_RX_DATA;
-		return 0;
+		if ( ( http->response / 100 ) == 1 ) {
+			/* Informational response; await real response */
+			http->rx_state = HTTP_RX_RESPONSE;
+		} else if ( ( http->response == 204 ) ||
+			    ( http->response == 304 ) ) {
+			/* No response body */
+			http->rx_state = HTTP_RX_DONE;
+		} else if ( http->flags & HTTP_CHUNKED ) {
+			http->rx_state = HTTP_RX_CHUNK_LEN;
+		} else if ( http->flags & HTTP_CONTENT_LENGTH ) {
+			http->remaining = http->content_length;
+			http->rx_state = ( http->remaining ?
+					   HTTP_RX_DATA : HTTP_RX_DONE );
+		} else {
+			/* Response body is delimited by connection close */
+			http->conn->flags |= HTTP_CONN_NO_REUSE;
+			http->rx_state = HTTP_RX_DATA;
+		}
+		http_segment ( http );
+		return http_check_drain ( http );
 	}
 
 	DBGC ( http, "HTTP %p header \"%s\"\n", http, header );
@@ -300,6 +745,51 @@ static int http_rx_header ( struct http_request *http, char *header ) {
 	return 0;
 }
 
+/**
+ * Handle HTTP chunk length
+ *
+ * @v http		HTTP request
+ * @v length		Chunk length line
+ * @ret rc		Return status code
+ */
+static int http_rx_chunk_len ( struct http_request *http, char *length ) {
+	char *endp;
+
+	/* Skip the blank line which terminates each chunk's data */
+	if ( ! length[0] )
+		return 0;
+
+	/* Parse chunk length, ignoring any chunk extensions */
+	http->remaining = strtoul ( length, &endp, 16 );
+	if ( ( endp == length ) ||
+	     ( ( *endp != '\0' ) && ( *endp != ';' ) && ( *endp != ' ' ) ) ) {
+		DBGC ( http, "HTTP %p invalid chunk length \"%s\"\n",
+		       http, length );
+		return -EIO;
+	}
+
+	/* A zero-length chunk marks the start of the trailer */
+	http->rx_state = ( http->remaining ? HTTP_RX_DATA : HTTP_RX_TRAILER );
+
+	return http_check_drain ( http );
+}
+
+/**
+ * Handle HTTP trailer
+ *
+ * @v http		HTTP request
+ * @v trailer		HTTP trailer line
+ * @ret rc		Return status code
+ */
+static int http_rx_trailer ( struct http_request *http, char *trailer ) {
+
+	/* An empty line marks the end of the response */
+	if ( ! trailer[0] )
+		http->rx_state = HTTP_RX_DONE;
+
+	return 0;
+}
+
 /** An HTTP line-based data handler */
 struct http_line_handler {
 	/** Handle line
@@ -315,6 +805,8 @@ struct http_line_handler {
 static struct http_line_handler http_line_handlers[] = {
 	[HTTP_RX_RESPONSE]	= { .rx = http_rx_response },
 	[HTTP_RX_HEADER]	= { .rx = http_rx_header },
+	[HTTP_RX_CHUNK_LEN]	= { .rx = http_rx_chunk_len },
+	[HTTP_RX_TRAILER]	= { .rx = http_rx_trailer },
 };
 
 /**
@@ -326,57 +818,109 @@ static struct http_line_handler http_line_handlers[] = {
  */
 static int http_rx_data ( struct http_request *http,
 			  struct io_buffer *iobuf ) {
+	struct http_request *owner = ( http->parent ? http->parent : http );
+	struct xfer_metadata meta;
+	size_t len = iob_len ( iobuf );
 	int rc;
 
-	/* Update received length */
-	http->rx_len += iob_len ( iobuf );
+	/* Construct absolute position for segmented downloads */
+	memset ( &meta, 0, sizeof ( meta ) );
+	if ( owner->flags & HTTP_SEGMENTED ) {
+		meta.flags = XFER_FL_ABS_OFFSET;
+		meta.offset = ( http->range_start + http->rx_len );
+	}
 
-	/* Hand off data buffer */
-	if ( ( rc = xfer_deliver_iob ( &http->xfer, iobuf ) ) != 0 )
-		return rc;
+	/* Update received length */
+	http->rx_len += len;
+	if ( http->flags & ( HTTP_CONTENT_LENGTH | HTTP_CHUNKED ) )
+		http->remaining -= len;
+
+	/* Hand off data buffer, or discard if request is closed */
+	if ( http->flags & HTTP_CLOSED ) {
+		free_iob ( iobuf );
+	} else if ( ( rc = xfer_deliver ( &owner->xfer, iobuf,
+					  &meta ) ) != 0 ) {
+		http_close ( owner, rc );
+	}
 
-	/* If we have reached the content-length, stop now */
-	if ( http->content_length &&
-	     ( http->rx_len >= http->content_length ) ) {
-		http_done ( http, 0 );
+	/* Move to next chunk, or complete response, if applicable */
+	if ( ! http->remaining ) {
+		if ( http->flags & HTTP_CHUNKED ) {
+			http->rx_state = HTTP_RX_CHUNK_LEN;
+		} else if ( http->flags & HTTP_CONTENT_LENGTH ) {
+			http->rx_state = HTTP_RX_DONE;
+		}
 	}
 
-	return 0;
+	return http_check_drain ( http );
 }
 
 /**
  * Handle new data arriving via HTTP connection
  *
- * @v http		HTTP request
+ * @v conn		HTTP connection
  * @v iobuf		I/O buffer
  * @v meta		Data transfer metadata
  * @ret rc		Return status code
  */
-static int http_socket_deliver ( struct http_request *http,
+static int http_socket_deliver ( struct http_connection *conn,
 				 struct io_buffer *iobuf,
 				 struct xfer_metadata *meta __unused ) {
+	struct http_request *http;
 	struct http_line_handler *lh;
+	struct io_buffer *data;
 	char *line;
 	ssize_t len;
 	int rc = 0;
 
-	while ( iob_len ( iobuf ) ) {
-		switch ( http->rx_state ) {
-		case HTTP_RX_DEAD:
-			/* Do no further processing */
+	while ( iobuf && iob_len ( iobuf ) &&
+		! ( conn->flags & HTTP_CONN_CLOSED ) ) {
+
+		/* Identify request to which this response belongs */
+		if ( list_empty ( &conn->requests ) ) {
+			DBGC ( conn, "HTTP connection %p unexpected data\n",
+			       conn );
+			rc = -EPROTO;
 			goto done;
+		}
+		http = list_first_entry ( &conn->requests,
+					  struct http_request, list );
+		http->flags |= HTTP_RX_STARTED;
+
+		switch ( http->rx_state ) {
 		case HTTP_RX_DATA:
-			/* Once we're into the data phase, just fill
-			 * the data buffer
+			/* Pass through data up to the end of the
+			 * current body or chunk.  Avoid a copy unless
+			 * the I/O buffer also contains the start of
+			 * the next chunk or the next response.
 			 */
-			rc = http_rx_data ( http, iob_disown ( iobuf ) );
-			goto done;
+			len = iob_len ( iobuf );
+			if ( ( http->flags & ( HTTP_CONTENT_LENGTH |
+					       HTTP_CHUNKED ) ) &&
+			     ( ( size_t ) len > http->remaining ) ) {
+				len = http->remaining;
+				data = alloc_iob ( len );
+				if ( ! data ) {
+					rc = -ENOMEM;
+					goto done;
+				}
+				memcpy ( iob_put ( data, len ), iobuf->data,
+					 len );
+				iob_pull ( iobuf, len );
+			} else {
+				data = iob_disown ( iobuf );
+			}
+			if ( ( rc = http_rx_data ( http, data ) ) != 0 )
+				goto done;
+			break;
 		case HTTP_RX_RESPONSE:
 		case HTTP_RX_HEADER:
+		case HTTP_RX_CHUNK_LEN:
+		case HTTP_RX_TRAILER:
 			/* In the other phases, buffer and process a
 			 * line at a time
 			 */
-			len = line_buffer ( &http->linebuf, iobuf->data,
+			len = line_buffer ( &conn->linebuf, iobuf->data,
 					    iob_len ( iobuf ) );
 			if ( len < 0 ) {
 				rc = len;
@@ -385,7 +929,7 @@ static int http_socket_deliver ( struct http_request *http,
 				goto done;
 			}
 			iob_pull ( iobuf, len );
-			line = buffered_line ( &http->linebuf );
+			line = buffered_line ( &conn->linebuf );
 			if ( line ) {
 				lh = &http_line_handlers[http->rx_state];
 				if ( ( rc = lh->rx ( http, line ) ) != 0 )
@@ -396,23 +940,28 @@ static int http_socket_deliver ( struct http_request *http,
 			assert ( 0 );
 			break;
 		}
+
+		/* Complete response, if applicable */
+		if ( http->rx_state == HTTP_RX_DONE )
+			http_rx_done ( conn, http );
 	}
 
  done:
 	if ( rc )
-		http_done ( http, rc );
+		http_conn_close ( conn, rc );
 	free_iob ( iobuf );
 	return rc;
 }
 
 /**
- * HTTP process
+ * Transmit HTTP request
  *
- * @v process		Process
+ * @v conn		HTTP connection
+ * @v http		HTTP request
+ * @ret rc		Return status code
  */
-static void http_step ( struct process *process ) {
-	struct http_request *http =
-		container_of ( process, struct http_request, process );
+static int http_tx_request ( struct http_connection *conn,
+			     struct http_request *http ) {
 	const char *host = http->uri->host;
 	const char *user = http->uri->user;
 	const char *password =
@@ -422,69 +971,440 @@ static void http_step ( struct process *process ) {
 	size_t user_pw_base64_len = base64_encoded_len ( user_pw_len );
 	uint8_t user_pw[ user_pw_len + 1 /* NUL */ ];
 	char user_pw_base64[ user_pw_base64_len + 1 /* NUL */ ];
-	int rc;
 	int request_len = unparse_uri ( NULL, 0, http->uri,
 					URI_PATH_BIT | URI_QUERY_BIT );
+	char request[request_len + 1];
+	char range[48];
 
-	if ( xfer_window ( &http->socket ) ) {
-		char request[request_len + 1];
+	/* Construct path?query request */
+	unparse_uri ( request, sizeof ( request ), http->uri,
+		      URI_PATH_BIT | URI_QUERY_BIT );
 
-		/* Construct path?query request */
-		unparse_uri ( request, sizeof ( request ), http->uri,
-			      URI_PATH_BIT | URI_QUERY_BIT );
+	/* Construct authorisation, if applicable */
+	if ( user ) {
+		/* Make "user:password" string from decoded fields */
+		snprintf ( ( ( char * ) user_pw ), sizeof ( user_pw ),
+			   "%s:%s", user, password );
 
-		/* We want to execute only once */
-		process_del ( &http->process );
+		/* Base64-encode the "user:password" string */
+		base64_encode ( user_pw, user_pw_len, user_pw_base64 );
+	}
 
-		/* Construct authorisation, if applicable */
-		if ( user ) {
-			/* Make "user:password" string from decoded fields */
-			snprintf ( ( ( char * ) user_pw ), sizeof ( user_pw ),
-				   "%s:%s", user, password );
+	/* Construct byte range, if applicable */
+	range[0] = '\0';
+	if ( http->range_len ) {
+		snprintf ( range, sizeof ( range ), "Range: bytes=%zd-%zd\r\n",
+			   http->range_start,
+			   ( http->range_start + http->range_len - 1 ) );
+	}
 
-			/* Base64-encode the "user:password" string */
-			base64_encode ( user_pw, user_pw_len, user_pw_base64 );
-		}
+	/* Send GET request */
+	DBGC ( http, "HTTP %p sending request via connection %p\n",
+	       http, conn );
+	return xfer_printf ( &conn->socket,
+			     "GET %s%s HTTP/1.1\r\n"
+			     "User-Agent: iPXE/" VERSION "\r\n"
+			     "%s%s%s"
+			     "%s"
+			     "Host: %s\r\n"
+			     "\r\n",
+			     http->uri->path ? "" : "/",
+			     request,
+			     ( user ? "Authorization: Basic " : "" ),
+			     ( user ? user_pw_base64 : "" ),
+			     ( user ? "\r\n" : "" ),
+			     range, host );
+}
 
-		/* Send GET request */
-		if ( ( rc = xfer_printf ( &http->socket,
-					  "GET %s%s HTTP/1.0\r\n"
-					  "User-Agent: iPXE/" VERSION "\r\n"
-					  "%s%s%s"
-					  "Host: %s\r\n"
-					  "\r\n",
-					  http->uri->path ? "" : "/",
-					  request,
-					  ( user ?
-					    "Authorization: Basic " : "" ),
-					  ( user ? user_pw_base64 : "" ),
-					  ( user ? "\r\n" : "" ),
-					  host ) ) != 0 ) {
-			http_done ( http, rc );
+/**
+ * HTTP process
+ *
+ * @v process		Process
+ */
+static void http_step ( struct process *process ) {
+	struct http_connection *conn =
+		container_of ( process, struct http_connection, process );
+	struct http_request *http;
+	unsigned int depth = 0;
+	int rc;
+
+	/* Wait until socket is ready */
+	if ( ! xfer_window ( &conn->socket ) )
+		return;
+
+	/* We want to execute only until all eligible requests are sent */
+	process_del ( &conn->process );
+
+	/* Send requests, up to the permitted pipeline depth.
+	 * Requests that have already been closed are merely draining
+	 * their responses, and do not count towards the depth.
+	 */
+	list_for_each_entry ( http, &conn->requests, list ) {
+		if ( http->flags & HTTP_CLOSED )
+			continue;
+		if ( depth++ >= HTTP_PIPELINE )
+			break;
+		if ( http->flags & HTTP_TX_DONE )
+			continue;
+		if ( ( rc = http_tx_request ( conn, http ) ) != 0 ) {
+			http_conn_close ( conn, rc );
+			return;
 		}
+		http->flags |= HTTP_TX_DONE;
 	}
 }
 
 /** HTTP socket interface operations */
 static struct interface_operation http_socket_operations[] = {
-	INTF_OP ( xfer_deliver, struct http_request *, http_socket_deliver ),
-	INTF_OP ( intf_close, struct http_request *, http_done ),
+	INTF_OP ( xfer_deliver, struct http_connection *,
+		  http_socket_deliver ),
+	INTF_OP ( intf_close, struct http_connection *, http_conn_close ),
 };
 
 /** HTTP socket interface descriptor */
 static struct interface_descriptor http_socket_desc =
-	INTF_DESC_PASSTHRU ( struct http_request, socket,
-			     http_socket_operations, xfer );
+	INTF_DESC ( struct http_connection, socket, http_socket_operations );
+
+/**
+ * Close HTTP data transfer interface
+ *
+ * @v http		HTTP request
+ * @v rc		Reason for close
+ */
+static void http_xfer_close ( struct http_request *http, int rc ) {
+
+	DBGC ( http, "HTTP %p closed: %s\n", http, strerror ( rc ) );
+	http_close ( http, rc );
+
+	/* Abandon connection if response cannot be drained */
+	if ( http->conn && ( ( rc = http_check_drain ( http ) ) != 0 ) )
+		http_conn_close ( http->conn, rc );
+}
 
 /** HTTP data transfer interface operations */
 static struct interface_operation http_xfer_operations[] = {
-	INTF_OP ( intf_close, struct http_request *, http_done ),
+	INTF_OP ( intf_close, struct http_request *, http_xfer_close ),
 };
 
 /** HTTP data transfer interface descriptor */
 static struct interface_descriptor http_xfer_desc =
-	INTF_DESC_PASSTHRU ( struct http_request, xfer,
-			     http_xfer_operations, socket );
+	INTF_DESC ( struct http_request, xfer, http_xfer_operations );
+
+/**
+ * Open HTTP connection
+ *
+ * @v host		Server host name
+ * @v port		Server port
+ * @v filter		Filter to apply to socket, or NULL
+ * @ret conn		HTTP connection
+ * @ret rc		Return status code
+ *
+ * The new connection is owned by the list of open connections.
+ */
+static int http_conn_open ( const char *host, unsigned int port,
+			    int ( * filter ) ( struct interface *xfer,
+					       const char *name,
+					       unsigned int port,
+					       struct interface **next ),
+			    struct http_connection **conn ) {
+	struct http_connection *new;
+	struct sockaddr_tcpip server;
+	struct interface *socket;
+	int rc;
+
+	/* Allocate and populate connection */
+	new = zalloc ( sizeof ( *new ) + strlen ( host ) + 1 /* NUL */ );
+	if ( ! new )
+		return -ENOMEM;
+	ref_init ( &new->refcnt, http_conn_free );
+	intf_init ( &new->socket, &http_socket_desc, &new->refcnt );
+	new->host = ( ( ( void * ) new ) + sizeof ( *new ) );
+	strcpy ( new->host, host );
+	new->port = port;
+	new->filter = filter;
+	INIT_LIST_HEAD ( &new->requests );
+	process_init_stopped ( &new->process, http_step, &new->refcnt );
+	timer_init ( &new->timer, http_conn_expired, &new->refcnt );
+
+	/* Open socket */
+	memset ( &server, 0, sizeof ( server ) );
+	server.st_port = htons ( port );
+	socket = &new->socket;
+	if ( filter ) {
+		if ( ( rc = filter ( socket, host, port, &socket ) ) != 0 )
+			goto err;
+	}
+	if ( ( rc = xfer_open_named_socket ( socket, SOCK_STREAM,
+					     ( struct sockaddr * ) &server,
+					     host, NULL ) ) != 0 )
+		goto err;
+
+	/* Add to list of open connections */
+	DBGC ( new, "HTTP connection %p opened to %s:%d\n", new, host, port );
+	list_add ( &new->list, &http_connections );
+	*conn = new;
+	return 0;
+
+ err:
+	DBGC ( new, "HTTP connection %p could not open to %s:%d: %s\n",
+	       new, host, port, strerror ( rc ) );
+	intf_shutdown ( &new->socket, rc );
+	ref_put ( &new->refcnt );
+	return rc;
+}
+
+/**
+ * Queue HTTP request on a suitable connection
+ *
+ * @v http		HTTP request
+ * @ret rc		Return status code
+ *
+ * An idle connection to the same server will be reused if one
+ * exists; otherwise a new connection will be opened.
+ */
+static int http_request_dispatch ( struct http_request *http ) {
+	struct http_connection *conn;
+	struct http_request *queued;
+	unsigned int max_depth = ( http->parent ? 1 : HTTP_PIPELINE );
+	unsigned int depth;
+	int rc;
+
+	/* Look for a reusable connection with room in its pipeline.
+	 * Requests that have already been closed are merely draining
+	 * their responses, and do not count towards the depth.
+	 * Segments are never pipelined, since the point of segmenting
+	 * a download is to spread it across several connections.
+	 */
+	list_for_each_entry ( conn, &http_connections, list ) {
+		if ( ( conn->flags & HTTP_CONN_NO_REUSE ) ||
+		     ( conn->port != http->port ) ||
+		     ( conn->filter != http->filter ) ||
+		     ( strcasecmp ( conn->host, http->uri->host ) != 0 ) )
+			continue;
+		depth = 0;
+		list_for_each_entry ( queued, &conn->requests, list ) {
+			if ( ! ( queued->flags & HTTP_CLOSED ) )
+				depth++;
+		}
+		if ( depth < max_depth ) {
+			DBGC ( http, "HTTP %p reusing connection %p\n",
+			       http, conn );
+			goto found;
+		}
+	}
+
+	/* Open a new connection */
+	if ( ( rc = http_conn_open ( http->uri->host, http->port,
+				     http->filter, &conn ) ) != 0 )
+		return rc;
+	DBGC ( http, "HTTP %p using new connection %p\n", http, conn );
+
+ found:
+	/* Reset request state */
+	http->flags &= ( HTTP_REISSUED | HTTP_RETRIED );
+	http->response = 0;
+	http->content_length = 0;
+	http->rx_len = 0;
+	http->remaining = 0;
+	http->rx_state = HTTP_RX_RESPONSE;
+
+	/* Queue request on connection */
+	ref_get ( &conn->refcnt );
+	http->conn = conn;
+	ref_get ( &http->refcnt );
+	list_add_tail ( &http->list, &conn->requests );
+	stop_timer ( &conn->timer );
+	process_add ( &conn->process );
+
+	return 0;
+}
+
+/**
+ * Create HTTP segment
+ *
+ * @v http		HTTP request
+ * @v start		Start of byte range
+ * @v len		Length of byte range
+ * @ret segment		Segment, or NULL on allocation failure
+ *
+ * The segment is added to the parent request's list of segments,
+ * which holds the only reference to it.  The segment is not yet
+ * dispatched.
+ */
+static struct http_request * http_segment_alloc ( struct http_request *http,
+						  size_t start, size_t len ) {
+	struct http_request *segment;
+
+	segment = zalloc ( sizeof ( *segment ) );
+	if ( ! segment )
+		return NULL;
+	ref_init ( &segment->refcnt, http_free );
+	intf_init ( &segment->xfer, &http_xfer_desc, &segment->refcnt );
+	segment->uri = uri_get ( http->uri );
+	segment->port = http->port;
+	segment->filter = http->filter;
+	segment->range_start = start;
+	segment->range_len = len;
+	INIT_LIST_HEAD ( &segment->segments );
+	segment->parent = http;
+	ref_get ( &http->refcnt );
+	list_add_tail ( &segment->segment, &http->segments );
+	return segment;
+}
+
+/**
+ * Split HTTP download into segments
+ *
+ * @v http		HTTP request
+ *
+ * If the server supports byte range requests and the file is large
+ * enough, the remainder of the file is fetched in parallel by
+ * additional range requests over separate connections, with each
+ * segment delivered at its absolute offset.  The original request
+ * continues to receive only the first segment, and its connection is
+ * closed once that segment is complete.  If the segments cannot be
+ * created, the download simply continues over the original request.
+ */
+static void http_segment ( struct http_request *http ) {
+	struct http_request *segment;
+	size_t len = http->content_length;
+	size_t seg_len;
+	size_t start;
+	unsigned int count;
+	int rc;
+
+	/* Check that segmentation is possible and worthwhile */
+	if ( ( http->rx_state != HTTP_RX_DATA ) ||
+	     ( http->response != 200 ) || http->parent ||
+	     ( http->flags & ( HTTP_CLOSED | HTTP_CHUNKED ) ) ||
+	     ( ( http->flags & ( HTTP_CONTENT_LENGTH |
+				 HTTP_ACCEPT_RANGES ) ) !=
+	       ( HTTP_CONTENT_LENGTH | HTTP_ACCEPT_RANGES ) ) )
+		return;
+	count = ( len / HTTP_SEGMENT_MIN_LEN );
+	if ( count > HTTP_SEGMENTS )
+		count = HTTP_SEGMENTS;
+	if ( count < 2 )
+		return;
+	seg_len = ( ( len + count - 1 ) / count );
+
+	/* Create segments */
+	for ( start = seg_len ; start < len ; start += seg_len ) {
+		segment = http_segment_alloc ( http, start,
+					       ( ( ( len - start ) > seg_len ) ?
+						 seg_len : ( len - start ) ) );
+		if ( ! segment ) {
+			rc = -ENOMEM;
+			goto err;
+		}
+		if ( ( rc = http_request_dispatch ( segment ) ) != 0 )
+			goto err;
+		DBGC ( http, "HTTP %p segment %p fetching [%zx,%zx)\n",
+		       http, segment, segment->range_start,
+		       ( segment->range_start + segment->range_len ) );
+	}
+
+	/* Receive only the first segment via this request */
+	http->flags |= HTTP_SEGMENTED;
+	http->remaining = seg_len;
+	http->conn->flags |= HTTP_CONN_NO_REUSE;
+	return;
+
+ err:
+	DBGC ( http, "HTTP %p could not create segments: %s\n",
+	       http, strerror ( rc ) );
+	while ( ! list_empty ( &http->segments ) ) {
+		segment = list_first_entry ( &http->segments,
+					     struct http_request, segment );
+		list_del ( &segment->segment );
+		segment->parent = NULL;
+		ref_put ( &http->refcnt );
+		http_xfer_close ( segment, rc );
+		ref_put ( &segment->refcnt );
+	}
+}
+
+/**
+ * Retry failed HTTP segment
+ *
+ * @v segment		Failed segment
+ * @ret rc		Return status code
+ *
+ * A server may refuse a range request made over an additional
+ * connection (e.g. with "503 Service Unavailable" due to a limit on
+ * connections per client), or close such a connection early.  Rather
+ * than failing the whole download, the part of the segment not yet
+ * received is deferred until the parent request and all other
+ * segments have completed, and is then refetched over a single
+ * connection.  A segment is retried only once.
+ */
+static int http_segment_retry ( struct http_request *segment ) {
+	struct http_request *http = segment->parent;
+	struct http_request *retry;
+	size_t done = 0;
+
+	/* Do not retry if download is being abandoned, or if this
+	 * is already a retry.
+	 */
+	if ( ( http->flags & HTTP_CLOSED ) ||
+	     ( segment->flags & HTTP_RETRIED ) )
+		return -EIO;
+
+	/* Retain any data already received into place */
+	if ( segment->response == 206 )
+		done = segment->rx_len;
+	if ( done >= segment->range_len )
+		return 0;
+
+	/* Create deferred segment for the remainder */
+	retry = http_segment_alloc ( http, ( segment->range_start + done ),
+				     ( segment->range_len - done ) );
+	if ( ! retry )
+		return -ENOMEM;
+	retry->flags = ( HTTP_DEFERRED | HTTP_RETRIED );
+	DBGC ( http, "HTTP %p segment %p failed; deferring [%zx,%zx) to "
+	       "segment %p\n", http, segment, retry->range_start,
+	       ( retry->range_start + retry->range_len ), retry );
+
+	return 0;
+}
+
+/**
+ * Progress segmented HTTP download
+ *
+ * @v http		HTTP request
+ *
+ * Once the request's own response and all active segments have
+ * completed, the next deferred segment (if any) is dispatched;
+ * otherwise the request is closed successfully.
+ */
+static void http_segment_step ( struct http_request *http ) {
+	struct http_request *segment;
+	int rc;
+
+	/* Wait for own response and all active segments to complete */
+	if ( ! ( http->flags & HTTP_RX_COMPLETE ) )
+		return;
+	list_for_each_entry ( segment, &http->segments, segment ) {
+		if ( ! ( segment->flags & HTTP_DEFERRED ) )
+			return;
+	}
+
+	/* Close request if no deferred segments remain */
+	if ( list_empty ( &http->segments ) ) {
+		http_close ( http, 0 );
+		return;
+	}
+
+	/* Dispatch next deferred segment */
+	segment = list_first_entry ( &http->segments, struct http_request,
+				     segment );
+	DBGC ( http, "HTTP %p segment %p refetching [%zx,%zx)\n",
+	       http, segment, segment->range_start,
+	       ( segment->range_start + segment->range_len ) );
+	if ( ( rc = http_request_dispatch ( segment ) ) != 0 )
+		http_close ( http, rc );
+}
 
 /**
  * Initiate an HTTP connection, with optional filter
@@ -498,10 +1418,10 @@ static struct interface_descriptor http_xfer_desc =
 int http_open_filter ( struct interface *xfer, struct uri *uri,
 		       unsigned int default_port,
 		       int ( * filter ) ( struct interface *xfer,
+					  const char *name,
+					  unsigned int port,
 					  struct interface **next ) ) {
 	struct http_request *http;
-	struct sockaddr_tcpip server;
-	struct interface *socket;
 	int rc;
 
 	/* Sanity checks */
@@ -515,20 +1435,12 @@ int http_open_filter ( struct interface *xfer, struct uri *uri,
 	ref_init ( &http->refcnt, http_free );
 	intf_init ( &http->xfer, &http_xfer_desc, &http->refcnt );
        	http->uri = uri_get ( uri );
-	intf_init ( &http->socket, &http_socket_desc, &http->refcnt );
-	process_init ( &http->process, http_step, &http->refcnt );
+	http->port = uri_port ( http->uri, default_port );
+	http->filter = filter;
+	INIT_LIST_HEAD ( &http->segments );
 
-	/* Open socket */
-	memset ( &server, 0, sizeof ( server ) );
-	server.st_port = htons ( uri_port ( http->uri, default_port ) );
-	socket = &http->socket;
-	if ( filter ) {
-		if ( ( rc = filter ( socket, &socket ) ) != 0 )
-			goto err;
-	}
-	if ( ( rc = xfer_open_named_socket ( socket, SOCK_STREAM,
-					     ( struct sockaddr * ) &server,
-					     uri->host, NULL ) ) != 0 )
+	/* Queue request on a connection */
+	if ( ( rc = http_request_dispatch ( http ) ) != 0 )
 		goto err;
 
 	/* Attach to parent interface, mortalise self, and return */
@@ -539,11 +1451,30 @@ int http_open_filter ( struct interface *xfer, struct uri *uri,
  err:
 	DBGC ( http, "HTTP %p could not create request: %s\n", 
 	       http, strerror ( rc ) );
-	http_done ( http, rc );
 	ref_put ( &http->refcnt );
 	return rc;
 }
 
+/**
+ * Close idle HTTP connections
+ *
+ * @v booting		System is shutting down for OS boot
+ */
+static void http_shutdown ( int booting __unused ) {
+	struct http_connection *conn;
+	struct http_connection *tmp;
+
+	list_for_each_entry_safe ( conn, tmp, &http_connections, list ) {
+		if ( list_empty ( &conn->requests ) )
+			http_conn_close ( conn, 0 );
+	}
+}
+
+/** HTTP shutdown function */
+struct startup_fn http_startup_fn __startup_fn ( STARTUP_LATE ) = {
+	.shutdown = http_shutdown,
+};
+
 /**
  * Initiate an HTTP connection
  *
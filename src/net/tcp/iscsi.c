@@ -25,7 +25,9 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <errno.h>
 #include <assert.h>
 #include <byteswap.h>
+#include <config/general.h>
 #include <ipxe/vsprintf.h>
+#include <ipxe/malloc.h>
 #include <ipxe/socket.h>
 #include <ipxe/iobuf.h>
 #include <ipxe/uri.h>
@@ -131,11 +133,35 @@ FEATURE ( FEATURE_PROTOCOL, "iSCSI", DHCP_EB_FEATURE_ISCSI, 1 );
 	__einfo_error ( EINFO_EPROTO_INVALID_CHAP_RESPONSE )
 #define EINFO_EPROTO_INVALID_CHAP_RESPONSE \
 	__einfo_uniqify ( EINFO_EPROTO, 0x04, "Invalid CHAP response" )
-
-static void iscsi_start_tx ( struct iscsi_session *iscsi );
+#define EPROTO_UNKNOWN_TASK \
+	__einfo_error ( EINFO_EPROTO_UNKNOWN_TASK )
+#define EINFO_EPROTO_UNKNOWN_TASK \
+	__einfo_uniqify ( EINFO_EPROTO, 0x05, "Unknown initiator task tag" )
+#define EPROTO_INVALID_DATA_IN \
+	__einfo_error ( EINFO_EPROTO_INVALID_DATA_IN )
+#define EINFO_EPROTO_INVALID_DATA_IN \
+	__einfo_uniqify ( EINFO_EPROTO, 0x06, "Invalid data-in" )
+#define EPROTO_INVALID_R2T \
+	__einfo_error ( EINFO_EPROTO_INVALID_R2T )
+#define EINFO_EPROTO_INVALID_R2T \
+	__einfo_uniqify ( EINFO_EPROTO, 0x07, "Invalid R2T" )
+
+/** Default MaxRecvDataSegmentLength (as per RFC 3720) */
+#define ISCSI_DEFAULT_MAX_RECV_LEN 8192
+
+/** Default FirstBurstLength (as per RFC 3720) */
+#define ISCSI_DEFAULT_FIRST_BURST_LEN 65536
+
+/** MaxBurstLength and FirstBurstLength that we offer */
+#define ISCSI_MAX_BURST_LEN 262144
+
+/** Minimum PDU data segment length (as per RFC 3720) */
+#define ISCSI_MIN_PDU_LEN 512
+
+static void iscsi_start_tx ( struct iscsi_session *iscsi,
+			     struct iscsi_task *task );
+static void iscsi_tx_resume ( struct iscsi_session *iscsi );
 static void iscsi_start_login ( struct iscsi_session *iscsi );
-static void iscsi_start_data_out ( struct iscsi_session *iscsi,
-				   unsigned int datasn );
 
 /**
  * Finish receiving PDU data into buffer
@@ -195,10 +221,89 @@ static void iscsi_free ( struct refcnt *refcnt ) {
 	free ( iscsi->target_password );
 	chap_finish ( &iscsi->chap );
 	iscsi_rx_buffered_data_done ( iscsi );
-	free ( iscsi->command );
 	free ( iscsi );
 }
 
+/**
+ * Find iSCSI task
+ *
+ * @v iscsi		iSCSI session
+ * @v itt		Initiator task tag
+ * @ret task		iSCSI task, or NULL if not found
+ */
+static struct iscsi_task * iscsi_find_task ( struct iscsi_session *iscsi,
+					     uint32_t itt ) {
+	struct iscsi_task *task;
+
+	list_for_each_entry ( task, &iscsi->tasks, list ) {
+		if ( task->itt == itt )
+			return task;
+	}
+	return NULL;
+}
+
+/**
+ * Free iSCSI task
+ *
+ * @v refcnt		Reference counter
+ */
+static void iscsi_task_free ( struct refcnt *refcnt ) {
+	struct iscsi_task *task =
+		container_of ( refcnt, struct iscsi_task, refcnt );
+
+	ref_put ( &task->iscsi->refcnt );
+	free ( task );
+}
+
+/**
+ * Mark iSCSI task as complete
+ *
+ * @v task		iSCSI task
+ * @v rc		Return status code
+ * @v rsp		SCSI response, if any
+ *
+ * The task is removed from the session immediately.  Any PDU
+ * belonging to the task that is still being transmitted will be
+ * allowed to complete, since the TX engine holds its own reference
+ * to the task.
+ */
+static void iscsi_task_done ( struct iscsi_task *task, int rc,
+			      struct scsi_rsp *rsp ) {
+	struct iscsi_session *iscsi = task->iscsi;
+
+	/* Remove from list of outstanding tasks */
+	list_del ( &task->list );
+	INIT_LIST_HEAD ( &task->list );
+	task->flags = 0;
+	iscsi->num_tasks--;
+
+	/* Send SCSI response, if any */
+	if ( rsp )
+		scsi_response ( &task->data, rsp );
+
+	/* Close SCSI command */
+	intf_shutdown ( &task->data, rc );
+
+	/* Drop list's reference to task */
+	ref_put ( &task->refcnt );
+
+	/* Notify SCSI layer of window change */
+	xfer_window_changed ( &iscsi->control );
+}
+
+/**
+ * Release task to which the current TX PDU belongs
+ *
+ * @v iscsi		iSCSI session
+ */
+static void iscsi_tx_release ( struct iscsi_session *iscsi ) {
+
+	if ( iscsi->tx_task ) {
+		ref_put ( &iscsi->tx_task->refcnt );
+		iscsi->tx_task = NULL;
+	}
+}
+
 /**
  * Shut down iSCSI interface
  *
@@ -206,6 +311,8 @@ static void iscsi_free ( struct refcnt *refcnt ) {
  * @v rc		Reason for close
  */
 static void iscsi_close ( struct iscsi_session *iscsi, int rc ) {
+	struct iscsi_task *task;
+	struct iscsi_task *tmp;
 
 	/* A TCP graceful close is still an error from our point of view */
 	if ( rc == 0 )
@@ -215,22 +322,33 @@ static void iscsi_close ( struct iscsi_session *iscsi, int rc ) {
 
 	/* Stop transmission process */
 	process_del ( &iscsi->process );
+	iscsi_tx_release ( iscsi );
 
 	/* Shut down interfaces */
 	intf_shutdown ( &iscsi->socket, rc );
 	intf_shutdown ( &iscsi->control, rc );
-	intf_shutdown ( &iscsi->data, rc );
+
+	/* Fail any outstanding tasks */
+	list_for_each_entry_safe ( task, tmp, &iscsi->tasks, list )
+		iscsi_task_done ( task, rc, NULL );
 }
 
 /**
  * Assign new iSCSI initiator task tag
  *
  * @v iscsi		iSCSI session
+ * @ret itt		Initiator task tag
  */
-static void iscsi_new_itt ( struct iscsi_session *iscsi ) {
+static uint32_t iscsi_new_itt ( struct iscsi_session *iscsi ) {
 	static uint16_t itt_idx;
+	uint32_t itt;
+
+	/* Skip any tag still in use by a long-running task */
+	do {
+		itt = ( ISCSI_TAG_MAGIC | (++itt_idx) );
+	} while ( iscsi_find_task ( iscsi, itt ) );
 
-	iscsi->itt = ( ISCSI_TAG_MAGIC | (++itt_idx) );
+	return itt;
 }
 
 /**
@@ -268,8 +386,26 @@ static int iscsi_open_connection ( struct iscsi_session *iscsi ) {
 	/* Assign new ISID */
 	iscsi->isid_iana_qual = ( random() & 0xffff );
 
+	/* Size PDUs to fit within a quarter of the free heap, since
+	 * each PDU that we send is held in a single I/O buffer.
+	 */
+	iscsi->max_pdu_len = ( ( freemem / 4 ) & ~( ISCSI_MIN_PDU_LEN - 1 ) );
+	if ( iscsi->max_pdu_len > ISCSI_MAX_PDU_LEN )
+		iscsi->max_pdu_len = ISCSI_MAX_PDU_LEN;
+	if ( iscsi->max_pdu_len < ISCSI_MIN_PDU_LEN )
+		iscsi->max_pdu_len = ISCSI_MIN_PDU_LEN;
+
+	/* Assume the most conservative operational parameters until
+	 * the target tells us otherwise.
+	 */
+	iscsi->max_send_len = ISCSI_DEFAULT_MAX_RECV_LEN;
+	iscsi->first_burst_len = ISCSI_DEFAULT_FIRST_BURST_LEN;
+	iscsi->params = ISCSI_PARAM_INITIAL_R2T;
+	DBGC ( iscsi, "iSCSI %p using max PDU length %#zx\n",
+	       iscsi, iscsi->max_pdu_len );
+
 	/* Assign fresh initiator task tag */
-	iscsi_new_itt ( iscsi );
+	iscsi->itt = iscsi_new_itt ( iscsi );
 
 	/* Initiate login */
 	iscsi_start_login ( iscsi );
@@ -291,6 +427,10 @@ static void iscsi_close_connection ( struct iscsi_session *iscsi, int rc ) {
 	/* Close all data transfer interfaces */
 	intf_restart ( &iscsi->socket, rc );
 
+	/* Stop transmission process */
+	process_del ( &iscsi->process );
+	iscsi_tx_release ( iscsi );
+
 	/* Clear connection status */
 	iscsi->status = 0;
 
@@ -304,41 +444,6 @@ static void iscsi_close_connection ( struct iscsi_session *iscsi, int rc ) {
 	iscsi_rx_buffered_data_done ( iscsi );
 }
 
-/**
- * Mark iSCSI SCSI operation as complete
- *
- * @v iscsi		iSCSI session
- * @v rc		Return status code
- * @v rsp		SCSI response, if any
- *
- * Note that iscsi_scsi_done() will not close the connection, and must
- * therefore be called only when the internal state machines are in an
- * appropriate state, otherwise bad things may happen on the next call
- * to iscsi_scsi_command().  The general rule is to call
- * iscsi_scsi_done() only at the end of receiving a PDU; at this point
- * the TX and RX engines should both be idle.
- */
-static void iscsi_scsi_done ( struct iscsi_session *iscsi, int rc,
-			      struct scsi_rsp *rsp ) {
-	uint32_t itt = iscsi->itt;
-
-	assert ( iscsi->tx_state == ISCSI_TX_IDLE );
-
-	/* Clear command */
-	free ( iscsi->command );
-	iscsi->command = NULL;
-
-	/* Send SCSI response, if any */
-	scsi_response ( &iscsi->data, rsp );
-
-	/* Close SCSI command, if this is still the same command.  (It
-	 * is possible that the command interface has already been
-	 * closed as a result of the SCSI response we sent.)
-	 */
-	if ( iscsi->itt == itt )
-		intf_restart ( &iscsi->data, rc );
-}
-
 /****************************************************************************
  *
  * iSCSI SCSI command issuing
@@ -349,41 +454,131 @@ static void iscsi_scsi_done ( struct iscsi_session *iscsi, int rc,
  * Build iSCSI SCSI command BHS
  *
  * @v iscsi		iSCSI session
+ * @v task		iSCSI task
  *
  * We don't currently support bidirectional commands (i.e. with both
  * Data-In and Data-Out segments); these would require providing code
  * to generate an AHS, and there doesn't seem to be any need for it at
  * the moment.
+ *
+ * As much data-out as the target will accept without an R2T is sent
+ * immediately, as immediate data within the SCSI command PDU and/or
+ * as an unsolicited sequence of data-out PDUs following it.
  */
-static void iscsi_start_command ( struct iscsi_session *iscsi ) {
+static void iscsi_start_command ( struct iscsi_session *iscsi,
+				  struct iscsi_task *task ) {
 	struct iscsi_bhs_scsi_command *command = &iscsi->tx_bhs.scsi_command;
-
-	assert ( ! ( iscsi->command->data_in && iscsi->command->data_out ) );
+	struct scsi_cmd *cmd = &task->command;
+	size_t unsolicited_len;
+	size_t immediate_len;
+
+	assert ( ! ( cmd->data_in && cmd->data_out ) );
+
+	/* Calculate length of unsolicited and immediate data */
+	unsolicited_len = 0;
+	if ( ( iscsi->params & ISCSI_PARAM_IMMEDIATE_DATA ) ||
+	     ! ( iscsi->params & ISCSI_PARAM_INITIAL_R2T ) ) {
+		unsolicited_len = cmd->data_out_len;
+		if ( unsolicited_len > iscsi->first_burst_len )
+			unsolicited_len = iscsi->first_burst_len;
+	}
+	immediate_len = 0;
+	if ( iscsi->params & ISCSI_PARAM_IMMEDIATE_DATA ) {
+		immediate_len = unsolicited_len;
+		if ( immediate_len > iscsi->max_send_len )
+			immediate_len = iscsi->max_send_len;
+		if ( immediate_len > iscsi->max_pdu_len )
+			immediate_len = iscsi->max_pdu_len;
+	}
+	if ( iscsi->params & ISCSI_PARAM_INITIAL_R2T )
+		unsolicited_len = immediate_len;
+	task->immediate_len = immediate_len;
+
+	/* Schedule any unsolicited data-out sequence */
+	task->flags &= ~ISCSI_TASK_TX_COMMAND;
+	if ( unsolicited_len > immediate_len ) {
+		task->seq.ttt = ISCSI_TAG_RESERVED;
+		task->seq.offset = immediate_len;
+		task->seq.len = ( unsolicited_len - immediate_len );
+		task->seq.sent = 0;
+		task->seq.datasn = 0;
+		task->flags |= ISCSI_TASK_TX_DATA_OUT;
+	}
 
 	/* Construct BHS and initiate transmission */
-	iscsi_start_tx ( iscsi );
+	iscsi_start_tx ( iscsi, task );
 	command->opcode = ISCSI_OPCODE_SCSI_COMMAND;
-	command->flags = ( ISCSI_FLAG_FINAL |
-			   ISCSI_COMMAND_ATTR_SIMPLE );
-	if ( iscsi->command->data_in )
+	command->flags = ISCSI_COMMAND_ATTR_SIMPLE;
+	if ( ! ( task->flags & ISCSI_TASK_TX_DATA_OUT ) )
+		command->flags |= ISCSI_FLAG_FINAL;
+	if ( cmd->data_in )
 		command->flags |= ISCSI_COMMAND_FLAG_READ;
-	if ( iscsi->command->data_out )
+	if ( cmd->data_out )
 		command->flags |= ISCSI_COMMAND_FLAG_WRITE;
-	/* lengths left as zero */
-	memcpy ( &command->lun, &iscsi->command->lun,
-		 sizeof ( command->lun ) );
-	command->itt = htonl ( iscsi->itt );
-	command->exp_len = htonl ( iscsi->command->data_in_len |
-				   iscsi->command->data_out_len );
-	command->cmdsn = htonl ( iscsi->cmdsn );
+	ISCSI_SET_LENGTHS ( command->lengths, 0, immediate_len );
+	memcpy ( &command->lun, &cmd->lun, sizeof ( command->lun ) );
+	command->itt = htonl ( task->itt );
+	command->exp_len = htonl ( cmd->data_in_len | cmd->data_out_len );
+	command->cmdsn = htonl ( task->cmdsn );
 	command->expstatsn = htonl ( iscsi->statsn + 1 );
-	memcpy ( &command->cdb, &iscsi->command->cdb, sizeof ( command->cdb ));
-	DBGC2 ( iscsi, "iSCSI %p start " SCSI_CDB_FORMAT " %s %#zx\n",
-		iscsi, SCSI_CDB_DATA ( command->cdb ),
-		( iscsi->command->data_in ? "in" : "out" ),
-		( iscsi->command->data_in ?
-		  iscsi->command->data_in_len :
-		  iscsi->command->data_out_len ) );
+	memcpy ( &command->cdb, &cmd->cdb, sizeof ( command->cdb ) );
+	DBGC2 ( iscsi, "iSCSI %p ITT %08x start " SCSI_CDB_FORMAT " %s %#zx "
+		"(immediate %#zx, unsolicited %#zx)\n", iscsi, task->itt,
+		SCSI_CDB_DATA ( command->cdb ),
+		( cmd->data_in ? "in" : "out" ),
+		( cmd->data_in ? cmd->data_in_len : cmd->data_out_len ),
+		immediate_len, unsolicited_len );
+}
+
+/**
+ * Send iSCSI SCSI command immediate data segment
+ *
+ * @v iscsi		iSCSI session
+ * @ret rc		Return status code
+ */
+static int iscsi_tx_immediate_data ( struct iscsi_session *iscsi ) {
+	struct iscsi_bhs_scsi_command *command = &iscsi->tx_bhs.scsi_command;
+	struct iscsi_task *task = iscsi->tx_task;
+	struct io_buffer *iobuf;
+	size_t len;
+
+	len = ISCSI_DATA_LEN ( command->lengths );
+
+	assert ( task != NULL );
+	assert ( len == task->immediate_len );
+	assert ( len <= task->command.data_out_len );
+
+	/* Nothing to send if there is no immediate data */
+	if ( ! len )
+		return 0;
+
+	iobuf = xfer_alloc_iob ( &iscsi->socket, len );
+	if ( ! iobuf )
+		return -ENOMEM;
+
+	copy_from_user ( iob_put ( iobuf, len ),
+			 task->command.data_out, 0, len );
+
+	return xfer_deliver_iob ( &iscsi->socket, iobuf );
+}
+
+/**
+ * Find iSCSI task for received PDU
+ *
+ * @v iscsi		iSCSI session
+ * @ret task		iSCSI task, or NULL if not found
+ */
+static struct iscsi_task * iscsi_rx_task ( struct iscsi_session *iscsi ) {
+	struct iscsi_bhs_common_response *response
+		= &iscsi->rx_bhs.common_response;
+	struct iscsi_task *task;
+
+	task = iscsi_find_task ( iscsi, ntohl ( response->itt ) );
+	if ( ! task ) {
+		DBGC ( iscsi, "iSCSI %p opcode %02x for unknown ITT %08x\n",
+		       iscsi, response->opcode, ntohl ( response->itt ) );
+	}
+	return task;
 }
 
 /**
@@ -400,6 +595,7 @@ static int iscsi_rx_scsi_response ( struct iscsi_session *iscsi,
 				    size_t remaining ) {
 	struct iscsi_bhs_scsi_response *response
 		= &iscsi->rx_bhs.scsi_response;
+	struct iscsi_task *task;
 	struct scsi_rsp rsp;
 	uint32_t residual_count;
 	int rc;
@@ -431,8 +627,13 @@ static int iscsi_rx_scsi_response ( struct iscsi_session *iscsi,
 	if ( response->response != ISCSI_RESPONSE_COMMAND_COMPLETE )
 		return -EIO;
 
+	/* Identify task */
+	task = iscsi_rx_task ( iscsi );
+	if ( ! task )
+		return -EPROTO_UNKNOWN_TASK;
+
 	/* Mark as completed */
-	iscsi_scsi_done ( iscsi, 0, &rsp );
+	iscsi_task_done ( task, 0, &rsp );
 	return 0;
 }
 
@@ -449,14 +650,23 @@ static int iscsi_rx_data_in ( struct iscsi_session *iscsi,
 			      const void *data, size_t len,
 			      size_t remaining ) {
 	struct iscsi_bhs_data_in *data_in = &iscsi->rx_bhs.data_in;
+	struct iscsi_task *task;
 	unsigned long offset;
 
+	/* Identify task */
+	task = iscsi_rx_task ( iscsi );
+	if ( ! task )
+		return -EPROTO_UNKNOWN_TASK;
+
 	/* Copy data to data-in buffer */
 	offset = ntohl ( data_in->offset ) + iscsi->rx_offset;
-	assert ( iscsi->command != NULL );
-	assert ( iscsi->command->data_in );
-	assert ( ( offset + len ) <= iscsi->command->data_in_len );
-	copy_to_user ( iscsi->command->data_in, offset, data, len );
+	if ( ( ! task->command.data_in ) ||
+	     ( ( offset + len ) > task->command.data_in_len ) ) {
+		DBGC ( iscsi, "iSCSI %p ITT %08x data-in [%#lx,%#lx) out of "
+		       "range\n", iscsi, task->itt, offset, ( offset + len ) );
+		return -EPROTO_INVALID_DATA_IN;
+	}
+	copy_to_user ( task->command.data_in, offset, data, len );
 
 	/* Wait for whole SCSI response to arrive */
 	if ( remaining )
@@ -464,10 +674,10 @@ static int iscsi_rx_data_in ( struct iscsi_session *iscsi,
 
 	/* Mark as completed if status is present */
 	if ( data_in->flags & ISCSI_DATA_FLAG_STATUS ) {
-		assert ( ( offset + len ) == iscsi->command->data_in_len );
+		assert ( ( offset + len ) == task->command.data_in_len );
 		assert ( data_in->flags & ISCSI_FLAG_FINAL );
 		/* iSCSI cannot return an error status via a data-in */
-		iscsi_scsi_done ( iscsi, 0, NULL );
+		iscsi_task_done ( task, 0, NULL );
 	}
 
 	return 0;
@@ -481,17 +691,51 @@ static int iscsi_rx_data_in ( struct iscsi_session *iscsi,
  * @v len		Length of received data
  * @v remaining		Data remaining after this data
  * @ret rc		Return status code
+ *
+ * We negotiate MaxOutstandingR2T=1, so the target may send at most
+ * one R2T per task while we are still sending unsolicited data.
  */
 static int iscsi_rx_r2t ( struct iscsi_session *iscsi,
 			  const void *data __unused, size_t len __unused,
 			  size_t remaining __unused ) {
 	struct iscsi_bhs_r2t *r2t = &iscsi->rx_bhs.r2t;
+	struct iscsi_task *task;
+	struct iscsi_sequence *seq;
 
-	/* Record transfer parameters and trigger first data-out */
-	iscsi->ttt = ntohl ( r2t->ttt );
-	iscsi->transfer_offset = ntohl ( r2t->offset );
-	iscsi->transfer_len = ntohl ( r2t->len );
-	iscsi_start_data_out ( iscsi, 0 );
+	/* Identify task */
+	task = iscsi_rx_task ( iscsi );
+	if ( ! task )
+		return -EPROTO_UNKNOWN_TASK;
+
+	/* Record transfer parameters, queueing behind any sequence
+	 * already in progress.
+	 */
+	if ( ! ( task->flags & ISCSI_TASK_TX_DATA_OUT ) ) {
+		seq = &task->seq;
+		task->flags |= ISCSI_TASK_TX_DATA_OUT;
+	} else if ( ! ( task->flags & ISCSI_TASK_R2T_QUEUED ) ) {
+		seq = &task->r2t;
+		task->flags |= ISCSI_TASK_R2T_QUEUED;
+	} else {
+		DBGC ( iscsi, "iSCSI %p ITT %08x received too many R2Ts\n",
+		       iscsi, task->itt );
+		return -EPROTO_INVALID_R2T;
+	}
+	seq->ttt = ntohl ( r2t->ttt );
+	seq->offset = ntohl ( r2t->offset );
+	seq->len = ntohl ( r2t->len );
+	seq->sent = 0;
+	seq->datasn = 0;
+	if ( ( ! task->command.data_out ) ||
+	     ( ( seq->offset + seq->len ) > task->command.data_out_len ) ) {
+		DBGC ( iscsi, "iSCSI %p ITT %08x R2T [%#x,%#x) out of range\n",
+		       iscsi, task->itt, seq->offset,
+		       ( seq->offset + seq->len ) );
+		return -EPROTO_INVALID_R2T;
+	}
+
+	/* Trigger data-out, if idle */
+	iscsi_tx_resume ( iscsi );
 
 	return 0;
 }
@@ -500,55 +744,51 @@ static int iscsi_rx_r2t ( struct iscsi_session *iscsi,
  * Build iSCSI data-out BHS
  *
  * @v iscsi		iSCSI session
- * @v datasn		Data sequence number within the transfer
- *
+ * @v task		iSCSI task
  */
 static void iscsi_start_data_out ( struct iscsi_session *iscsi,
-				   unsigned int datasn ) {
+				   struct iscsi_task *task ) {
 	struct iscsi_bhs_data_out *data_out = &iscsi->tx_bhs.data_out;
-	unsigned long offset;
+	struct iscsi_sequence *seq = &task->seq;
 	unsigned long remaining;
 	unsigned long len;
 
-	/* We always send 512-byte Data-Out PDUs; this removes the
-	 * need to worry about the target's MaxRecvDataSegmentLength.
-	 */
-	offset = datasn * 512;
-	remaining = iscsi->transfer_len - offset;
+	/* Send as much as the target and our own buffers allow */
+	remaining = ( seq->len - seq->sent );
 	len = remaining;
-	if ( len > 512 )
-		len = 512;
+	if ( len > iscsi->max_send_len )
+		len = iscsi->max_send_len;
+	if ( len > iscsi->max_pdu_len )
+		len = iscsi->max_pdu_len;
 
 	/* Construct BHS and initiate transmission */
-	iscsi_start_tx ( iscsi );
+	iscsi_start_tx ( iscsi, task );
 	data_out->opcode = ISCSI_OPCODE_DATA_OUT;
 	if ( len == remaining )
 		data_out->flags = ( ISCSI_FLAG_FINAL );
 	ISCSI_SET_LENGTHS ( data_out->lengths, 0, len );
-	data_out->lun = iscsi->command->lun;
-	data_out->itt = htonl ( iscsi->itt );
-	data_out->ttt = htonl ( iscsi->ttt );
+	data_out->lun = task->command.lun;
+	data_out->itt = htonl ( task->itt );
+	data_out->ttt = htonl ( seq->ttt );
 	data_out->expstatsn = htonl ( iscsi->statsn + 1 );
-	data_out->datasn = htonl ( datasn );
-	data_out->offset = htonl ( iscsi->transfer_offset + offset );
-	DBGC ( iscsi, "iSCSI %p start data out DataSN %#x len %#lx\n",
-	       iscsi, datasn, len );
-}
-
-/**
- * Complete iSCSI data-out PDU transmission
- *
- * @v iscsi		iSCSI session
- *
- */
-static void iscsi_data_out_done ( struct iscsi_session *iscsi ) {
-	struct iscsi_bhs_data_out *data_out = &iscsi->tx_bhs.data_out;
+	data_out->datasn = htonl ( seq->datasn );
+	data_out->offset = htonl ( seq->offset + seq->sent );
+	DBGC2 ( iscsi, "iSCSI %p ITT %08x start data out DataSN %#x len "
+		"%#lx\n", iscsi, task->itt, seq->datasn, len );
 
-	/* If we haven't reached the end of the sequence, start
-	 * sending the next data-out PDU.
+	/* Advance sequence, moving on to any queued R2T once the
+	 * final PDU has been built.
 	 */
-	if ( ! ( data_out->flags & ISCSI_FLAG_FINAL ) )
-		iscsi_start_data_out ( iscsi, ntohl ( data_out->datasn ) + 1 );
+	seq->sent += len;
+	seq->datasn++;
+	if ( len == remaining ) {
+		task->flags &= ~ISCSI_TASK_TX_DATA_OUT;
+		if ( task->flags & ISCSI_TASK_R2T_QUEUED ) {
+			memcpy ( &task->seq, &task->r2t, sizeof ( task->seq ) );
+			task->flags &= ~ISCSI_TASK_R2T_QUEUED;
+			task->flags |= ISCSI_TASK_TX_DATA_OUT;
+		}
+	}
 }
 
 /**
@@ -559,6 +799,7 @@ static void iscsi_data_out_done ( struct iscsi_session *iscsi ) {
  */
 static int iscsi_tx_data_out ( struct iscsi_session *iscsi ) {
 	struct iscsi_bhs_data_out *data_out = &iscsi->tx_bhs.data_out;
+	struct iscsi_task *task = iscsi->tx_task;
 	struct io_buffer *iobuf;
 	unsigned long offset;
 	size_t len;
@@ -566,16 +807,16 @@ static int iscsi_tx_data_out ( struct iscsi_session *iscsi ) {
 	offset = ntohl ( data_out->offset );
 	len = ISCSI_DATA_LEN ( data_out->lengths );
 
-	assert ( iscsi->command != NULL );
-	assert ( iscsi->command->data_out );
-	assert ( ( offset + len ) <= iscsi->command->data_out_len );
+	assert ( task != NULL );
+	assert ( task->command.data_out );
+	assert ( ( offset + len ) <= task->command.data_out_len );
 
 	iobuf = xfer_alloc_iob ( &iscsi->socket, len );
 	if ( ! iobuf )
 		return -ENOMEM;
 	
 	copy_from_user ( iob_put ( iobuf, len ),
-			 iscsi->command->data_out, offset, len );
+			 task->command.data_out, offset, len );
 
 	return xfer_deliver_iob ( &iscsi->socket, iobuf );
 }
@@ -626,11 +867,11 @@ static int iscsi_rx_nop_in ( struct iscsi_session *iscsi,
  *     HeaderDigest=None
  *     DataDigest=None
  *     MaxConnections is irrelevant; we make only one connection anyway [4]
- *     InitialR2T=Yes [1]
- *     ImmediateData is irrelevant; we never send immediate data [4]
- *     MaxRecvDataSegmentLength=8192 (default; we don't care) [3]
+ *     InitialR2T=No [1]
+ *     ImmediateData=Yes [1]
+ *     MaxRecvDataSegmentLength sized from available memory [5]
  *     MaxBurstLength=262144 (default; we don't care) [3]
- *     FirstBurstLength=262144 (default; we don't care)
+ *     FirstBurstLength=262144 [1]
  *     DefaultTime2Wait=0 [2]
  *     DefaultTime2Retain=0 [2]
  *     MaxOutstandingR2T=1
@@ -638,9 +879,11 @@ static int iscsi_rx_nop_in ( struct iscsi_session *iscsi,
  *     DataSequenceInOrder=Yes
  *     ErrorRecoveryLevel=0
  *
- * [1] InitialR2T has an OR resolution function, so the target may
- * force us to use it.  We therefore simplify our logic by always
- * using it.
+ * [1] These allow us to send write data without waiting for an R2T.
+ * InitialR2T has an OR resolution function and ImmediateData and
+ * FirstBurstLength have AND and minimum resolution functions, so the
+ * target may force us back to waiting for R2Ts; we therefore act
+ * only upon the values in the target's response.
  *
  * [2] These ensure that we can safely start a new task once we have
  * reconnected after a failure, without having to manually tidy up
@@ -655,6 +898,11 @@ static int iscsi_rx_nop_in ( struct iscsi_session *iscsi,
  * these parameters, but some targets (notably a QNAP TS-639Pro) fail
  * unless they are supplied, so we explicitly specify the default
  * values.
+ *
+ * [5] Data-in PDUs are written directly to the data buffer, so a
+ * large value costs nothing when reading.  We use the same limit for
+ * the PDUs that we send, each of which is held in a single I/O
+ * buffer.
  */
 static int iscsi_build_login_request_strings ( struct iscsi_session *iscsi,
 					       void *data, size_t len ) {
@@ -709,17 +957,20 @@ static int iscsi_build_login_request_strings ( struct iscsi_session *iscsi,
 				    "HeaderDigest=None%c"
 				    "DataDigest=None%c"
 				    "MaxConnections=1%c"
-				    "InitialR2T=Yes%c"
-				    "ImmediateData=No%c"
-				    "MaxRecvDataSegmentLength=8192%c"
-				    "MaxBurstLength=262144%c"
+				    "InitialR2T=No%c"
+				    "ImmediateData=Yes%c"
+				    "MaxRecvDataSegmentLength=%zd%c"
+				    "MaxBurstLength=%d%c"
+				    "FirstBurstLength=%d%c"
 				    "DefaultTime2Wait=0%c"
 				    "DefaultTime2Retain=0%c"
 				    "MaxOutstandingR2T=1%c"
 				    "DataPDUInOrder=Yes%c"
 				    "DataSequenceInOrder=Yes%c"
 				    "ErrorRecoveryLevel=0%c",
-				    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 );
+				    0, 0, 0, 0, 0, iscsi->max_pdu_len, 0,
+				    ISCSI_MAX_BURST_LEN, 0,
+				    ISCSI_MAX_BURST_LEN, 0, 0, 0, 0, 0, 0, 0 );
 	}
 
 	return used;
@@ -748,7 +999,7 @@ static void iscsi_start_login ( struct iscsi_session *iscsi ) {
 	}
 
 	/* Construct BHS and initiate transmission */
-	iscsi_start_tx ( iscsi );
+	iscsi_start_tx ( iscsi, NULL );
 	request->opcode = ( ISCSI_OPCODE_LOGIN_REQUEST |
 			    ISCSI_FLAG_IMMEDIATE );
 	request->flags = ( ( iscsi->status & ISCSI_STATUS_PHASE_MASK ) |
@@ -1079,6 +1330,100 @@ static int iscsi_handle_chap_r_value ( struct iscsi_session *iscsi,
 	return 0;
 }
 
+/**
+ * Handle iSCSI InitialR2T text value
+ *
+ * @v iscsi		iSCSI session
+ * @v value		InitialR2T value
+ * @ret rc		Return status code
+ */
+static int iscsi_handle_initialr2t_value ( struct iscsi_session *iscsi,
+					   const char *value ) {
+
+	/* We offered "No"; anything else means we must wait for R2Ts */
+	if ( strcmp ( value, "No" ) == 0 ) {
+		iscsi->params &= ~ISCSI_PARAM_INITIAL_R2T;
+	} else {
+		iscsi->params |= ISCSI_PARAM_INITIAL_R2T;
+	}
+	return 0;
+}
+
+/**
+ * Handle iSCSI ImmediateData text value
+ *
+ * @v iscsi		iSCSI session
+ * @v value		ImmediateData value
+ * @ret rc		Return status code
+ */
+static int iscsi_handle_immediatedata_value ( struct iscsi_session *iscsi,
+					      const char *value ) {
+
+	/* We offered "Yes"; anything else disables immediate data */
+	if ( strcmp ( value, "Yes" ) == 0 ) {
+		iscsi->params |= ISCSI_PARAM_IMMEDIATE_DATA;
+	} else {
+		iscsi->params &= ~ISCSI_PARAM_IMMEDIATE_DATA;
+	}
+	return 0;
+}
+
+/**
+ * Parse iSCSI numerical text value
+ *
+ * @v iscsi		iSCSI session
+ * @v value		Text value
+ * @v len		Length to fill in
+ *
+ * Unparseable values are ignored, leaving the existing (default)
+ * length unaltered.
+ */
+static void iscsi_parse_length_value ( struct iscsi_session *iscsi,
+				       const char *value, size_t *len ) {
+	unsigned long num;
+	char *end;
+
+	num = strtoul ( value, &end, 0 );
+	if ( *end || ( num < ISCSI_MIN_PDU_LEN ) ) {
+		DBGC ( iscsi, "iSCSI %p ignoring invalid length \"%s\"\n",
+		       iscsi, value );
+		return;
+	}
+	*len = num;
+}
+
+/**
+ * Handle iSCSI MaxRecvDataSegmentLength text value
+ *
+ * @v iscsi		iSCSI session
+ * @v value		MaxRecvDataSegmentLength value
+ * @ret rc		Return status code
+ */
+static int iscsi_handle_maxrecvdsl_value ( struct iscsi_session *iscsi,
+					   const char *value ) {
+
+	/* This is a declaration of the target's own limit */
+	iscsi_parse_length_value ( iscsi, value, &iscsi->max_send_len );
+	return 0;
+}
+
+/**
+ * Handle iSCSI FirstBurstLength text value
+ *
+ * @v iscsi		iSCSI session
+ * @v value		FirstBurstLength value
+ * @ret rc		Return status code
+ */
+static int iscsi_handle_firstburstlength_value ( struct iscsi_session *iscsi,
+						 const char *value ) {
+
+	/* Result is the minimum of our value and the target's value */
+	iscsi_parse_length_value ( iscsi, value, &iscsi->first_burst_len );
+	if ( iscsi->first_burst_len > ISCSI_MAX_BURST_LEN )
+		iscsi->first_burst_len = ISCSI_MAX_BURST_LEN;
+	return 0;
+}
+
 /** An iSCSI text string that we want to handle */
 struct iscsi_string_type {
 	/** String key
@@ -1105,6 +1450,10 @@ static struct iscsi_string_type iscsi_string_types[] = {
 	{ "CHAP_C=", iscsi_handle_chap_c_value },
 	{ "CHAP_N=", iscsi_handle_chap_n_value },
 	{ "CHAP_R=", iscsi_handle_chap_r_value },
+	{ "InitialR2T=", iscsi_handle_initialr2t_value },
+	{ "ImmediateData=", iscsi_handle_immediatedata_value },
+	{ "MaxRecvDataSegmentLength=", iscsi_handle_maxrecvdsl_value },
+	{ "FirstBurstLength=", iscsi_handle_firstburstlength_value },
 	{ NULL, NULL }
 };
 
@@ -1293,6 +1642,13 @@ static int iscsi_rx_login_response ( struct iscsi_session *iscsi,
 
 	/* Notify SCSI layer of window change */
 	DBGC ( iscsi, "iSCSI %p entering full feature phase\n", iscsi );
+	DBGC ( iscsi, "iSCSI %p InitialR2T=%s ImmediateData=%s "
+	       "FirstBurstLength=%zd MaxRecvDataSegmentLength=%zd/%zd\n",
+	       iscsi,
+	       ( ( iscsi->params & ISCSI_PARAM_INITIAL_R2T ) ? "Yes" : "No" ),
+	       ( ( iscsi->params & ISCSI_PARAM_IMMEDIATE_DATA ) ?
+		 "Yes" : "No" ), iscsi->first_burst_len,
+	       iscsi->max_pdu_len, iscsi->max_send_len );
 	xfer_window_changed ( &iscsi->control );
 
 	return 0;
@@ -1308,18 +1664,27 @@ static int iscsi_rx_login_response ( struct iscsi_session *iscsi,
  * Start up a new TX PDU
  *
  * @v iscsi		iSCSI session
+ * @v task		iSCSI task to which the PDU belongs, or NULL
  *
  * This initiates the process of sending a new PDU.  Only one PDU may
  * be in transit at any one time.
  */
-static void iscsi_start_tx ( struct iscsi_session *iscsi ) {
+static void iscsi_start_tx ( struct iscsi_session *iscsi,
+			     struct iscsi_task *task ) {
 
 	assert ( iscsi->tx_state == ISCSI_TX_IDLE );
 	assert ( ! process_running ( &iscsi->process ) );
-	
+	assert ( iscsi->tx_task == NULL );
+
 	/* Initialise TX BHS */
 	memset ( &iscsi->tx_bhs, 0, sizeof ( iscsi->tx_bhs ) );
 
+	/* Hold a reference to the task until the PDU is sent */
+	if ( task ) {
+		ref_get ( &task->refcnt );
+		iscsi->tx_task = task;
+	}
+
 	/* Flag TX engine to start transmitting */
 	iscsi->tx_state = ISCSI_TX_BHS;
 
@@ -1361,6 +1726,8 @@ static int iscsi_tx_data ( struct iscsi_session *iscsi ) {
 	struct iscsi_bhs_common *common = &iscsi->tx_bhs.common;
 
 	switch ( common->opcode & ISCSI_OPCODE_MASK ) {
+	case ISCSI_OPCODE_SCSI_COMMAND:
+		return iscsi_tx_immediate_data ( iscsi );
 	case ISCSI_OPCODE_DATA_OUT:
 		return iscsi_tx_data_out ( iscsi );
 	case ISCSI_OPCODE_LOGIN_REQUEST:
@@ -1406,16 +1773,49 @@ static void iscsi_tx_done ( struct iscsi_session *iscsi ) {
 
 	/* Stop transmission process */
 	process_del ( &iscsi->process );
+	iscsi_tx_release ( iscsi );
 
 	switch ( common->opcode & ISCSI_OPCODE_MASK ) {
-	case ISCSI_OPCODE_DATA_OUT:
-		iscsi_data_out_done ( iscsi );
 	case ISCSI_OPCODE_LOGIN_REQUEST:
 		iscsi_login_request_done ( iscsi );
+		break;
 	default:
 		/* No action */
 		break;
 	}
+
+	/* Start transmitting the next PDU, if any */
+	iscsi_tx_resume ( iscsi );
+}
+
+/**
+ * Resume iSCSI PDU transmission
+ *
+ * @v iscsi		iSCSI session
+ *
+ * If the TX engine is idle, start transmitting the next PDU required
+ * by any outstanding task.  Tasks are serviced in the order in which
+ * they were issued, so that SCSI commands are always sent in CmdSN
+ * order.
+ */
+static void iscsi_tx_resume ( struct iscsi_session *iscsi ) {
+	struct iscsi_task *task;
+
+	/* Do nothing unless TX engine is idle */
+	if ( iscsi->tx_state != ISCSI_TX_IDLE )
+		return;
+
+	/* Find first task with a PDU to send */
+	list_for_each_entry ( task, &iscsi->tasks, list ) {
+		if ( task->flags & ISCSI_TASK_TX_COMMAND ) {
+			iscsi_start_command ( iscsi, task );
+			return;
+		}
+		if ( task->flags & ISCSI_TASK_TX_DATA_OUT ) {
+			iscsi_start_data_out ( iscsi, task );
+			return;
+		}
+	}
 }
 
 /**
@@ -1545,10 +1945,38 @@ static int iscsi_rx_data ( struct iscsi_session *iscsi, const void *data,
 			   size_t len, size_t remaining ) {
 	struct iscsi_bhs_common_response *response
 		= &iscsi->rx_bhs.common_response;
+	uint32_t maxcmdsn = ntohl ( response->maxcmdsn );
 
-	/* Update cmdsn and statsn */
-	iscsi->cmdsn = ntohl ( response->expcmdsn );
-	iscsi->statsn = ntohl ( response->statsn );
+	/* Update cmdsn and maxcmdsn.  During login, we simply adopt
+	 * the target's ExpCmdSN; thereafter, CmdSN advances as each
+	 * command is issued and MaxCmdSN limits the command window.
+	 */
+	if ( ( iscsi->status & ISCSI_STATUS_PHASE_MASK ) !=
+	     ISCSI_STATUS_FULL_FEATURE_PHASE ) {
+		iscsi->cmdsn = ntohl ( response->expcmdsn );
+		iscsi->maxcmdsn = maxcmdsn;
+	} else if ( ( ! remaining ) &&
+		    ( ( int32_t ) ( maxcmdsn - iscsi->maxcmdsn ) > 0 ) ) {
+		iscsi->maxcmdsn = maxcmdsn;
+		xfer_window_changed ( &iscsi->control );
+	}
+
+	/* Update statsn.  Other PDUs (such as R2Ts) may be
+	 * interleaved with responses to outstanding commands, and do
+	 * not advance StatSN.
+	 */
+	switch ( response->opcode & ISCSI_OPCODE_MASK ) {
+	case ISCSI_OPCODE_DATA_IN:
+		if ( ! ( response->flags & ISCSI_DATA_FLAG_STATUS ) )
+			break;
+		/* Fall through */
+	case ISCSI_OPCODE_LOGIN_RESPONSE:
+	case ISCSI_OPCODE_SCSI_RESPONSE:
+		iscsi->statsn = ntohl ( response->statsn );
+		break;
+	default:
+		break;
+	}
 
 	switch ( response->opcode & ISCSI_OPCODE_MASK ) {
 	case ISCSI_OPCODE_LOGIN_RESPONSE:
@@ -1708,22 +2136,63 @@ static struct interface_descriptor iscsi_socket_desc =
  *
  */
 
+/**
+ * Close iSCSI command
+ *
+ * @v task		iSCSI task
+ * @v rc		Reason for close
+ */
+static void iscsi_task_close ( struct iscsi_task *task, int rc ) {
+	struct iscsi_session *iscsi = task->iscsi;
+
+	/* Restart interface */
+	intf_restart ( &task->data, rc );
+
+	/* Treat unsolicited command closures mid-command as fatal,
+	 * because we have no code to abort an individual task.
+	 */
+	if ( ! list_empty ( &task->list ) )
+		iscsi_close ( iscsi, ( ( rc == 0 ) ? -ECANCELED : rc ) );
+}
+
+/** iSCSI SCSI command interface operations */
+static struct interface_operation iscsi_task_op[] = {
+	INTF_OP ( intf_close, struct iscsi_task *, iscsi_task_close ),
+};
+
+/** iSCSI SCSI command interface descriptor */
+static struct interface_descriptor iscsi_task_desc =
+	INTF_DESC ( struct iscsi_task, data, iscsi_task_op );
+
 /**
  * Check iSCSI flow-control window
  *
  * @v iscsi		iSCSI session
  * @ret len		Length of window
+ *
+ * The window is limited both by the number of tasks that we are
+ * prepared to track and by the target's command window.
  */
 static size_t iscsi_scsi_window ( struct iscsi_session *iscsi ) {
+	int32_t cmd_window;
+	size_t window;
 
-	if ( ( ( iscsi->status & ISCSI_STATUS_PHASE_MASK ) ==
-	       ISCSI_STATUS_FULL_FEATURE_PHASE ) &&
-	     ( iscsi->command == NULL ) ) {
-		/* We cannot handle concurrent commands */
-		return 1;
-	} else {
+	/* Cannot issue commands before login is complete */
+	if ( ( iscsi->status & ISCSI_STATUS_PHASE_MASK ) !=
+	     ISCSI_STATUS_FULL_FEATURE_PHASE )
 		return 0;
-	}
+
+	/* Limit to number of free task slots */
+	window = ( ISCSI_MAX_TASKS - iscsi->num_tasks );
+
+	/* Limit to target's command window.  A negative window can
+	 * arise only from an invalid MaxCmdSN, which we ignore.
+	 */
+	cmd_window = ( iscsi->maxcmdsn - iscsi->cmdsn + 1 );
+	if ( ( cmd_window >= 0 ) && ( window > ( ( size_t ) cmd_window ) ) )
+		window = cmd_window;
+
+	return window;
 }
 
 /**
@@ -1737,31 +2206,42 @@ static size_t iscsi_scsi_window ( struct iscsi_session *iscsi ) {
 static int iscsi_scsi_command ( struct iscsi_session *iscsi,
 				struct interface *parent,
 				struct scsi_cmd *command ) {
+	struct iscsi_task *task;
 
-	/* This iSCSI implementation cannot handle multiple concurrent
-	 * commands or commands arriving before login is complete.
+	/* Refuse commands arriving before login is complete or
+	 * beyond the command window.
 	 */
 	if ( iscsi_scsi_window ( iscsi ) == 0 ) {
-		DBGC ( iscsi, "iSCSI %p cannot handle concurrent commands\n",
+		DBGC ( iscsi, "iSCSI %p cannot accept further commands\n",
 		       iscsi );
 		return -EOPNOTSUPP;
 	}
 
-	/* Store command */
-	iscsi->command = malloc ( sizeof ( *command ) );
-	if ( ! iscsi->command )
+	/* Allocate and initialise task */
+	task = zalloc ( sizeof ( *task ) );
+	if ( ! task )
 		return -ENOMEM;
-	memcpy ( iscsi->command, command, sizeof ( *command ) );
-
-	/* Assign new ITT */
-	iscsi_new_itt ( iscsi );
-
-	/* Start sending command */
-	iscsi_start_command ( iscsi );
+	ref_init ( &task->refcnt, iscsi_task_free );
+	intf_init ( &task->data, &iscsi_task_desc, &task->refcnt );
+	task->iscsi = iscsi;
+	ref_get ( &iscsi->refcnt );
+	memcpy ( &task->command, command, sizeof ( task->command ) );
+
+	/* Assign new ITT and CmdSN */
+	task->itt = iscsi_new_itt ( iscsi );
+	task->cmdsn = iscsi->cmdsn++;
+
+	/* Add to list of outstanding tasks (which holds the
+	 * reference), and start sending command if idle.
+	 */
+	task->flags = ISCSI_TASK_TX_COMMAND;
+	list_add_tail ( &task->list, &iscsi->tasks );
+	iscsi->num_tasks++;
+	iscsi_tx_resume ( iscsi );
 
 	/* Attach to parent interface and return */
-	intf_plug_plug ( &iscsi->data, parent );
-	return iscsi->itt;
+	intf_plug_plug ( &task->data, parent );
+	return task->itt;
 }
 
 /** iSCSI SCSI command-issuing interface operations */
@@ -1776,33 +2256,6 @@ static struct interface_operation iscsi_control_op[] = {
 static struct interface_descriptor iscsi_control_desc =
 	INTF_DESC ( struct iscsi_session, control, iscsi_control_op );
 
-/**
- * Close iSCSI command
- *
- * @v iscsi		iSCSI session
- * @v rc		Reason for close
- */
-static void iscsi_command_close ( struct iscsi_session *iscsi, int rc ) {
-
-	/* Restart interface */
-	intf_restart ( &iscsi->data, rc );
-
-	/* Treat unsolicited command closures mid-command as fatal,
-	 * because we have no code to handle partially-completed PDUs.
-	 */
-	if ( iscsi->command != NULL )
-		iscsi_close ( iscsi, ( ( rc == 0 ) ? -ECANCELED : rc ) );
-}
-
-/** iSCSI SCSI command interface operations */
-static struct interface_operation iscsi_data_op[] = {
-	INTF_OP ( intf_close, struct iscsi_session *, iscsi_command_close ),
-};
-
-/** iSCSI SCSI command interface descriptor */
-static struct interface_descriptor iscsi_data_desc =
-	INTF_DESC ( struct iscsi_session, data, iscsi_data_op );
-
 /****************************************************************************
  *
  * Instantiator
@@ -2032,10 +2485,10 @@ static int iscsi_open ( struct interface *parent, struct uri *uri ) {
 	}
 	ref_init ( &iscsi->refcnt, iscsi_free );
 	intf_init ( &iscsi->control, &iscsi_control_desc, &iscsi->refcnt );
-	intf_init ( &iscsi->data, &iscsi_data_desc, &iscsi->refcnt );
 	intf_init ( &iscsi->socket, &iscsi_socket_desc, &iscsi->refcnt );
 	process_init_stopped ( &iscsi->process, iscsi_tx_step,
 			       &iscsi->refcnt );
+	INIT_LIST_HEAD ( &iscsi->tasks );
 
 	/* Parse root path */
 	if ( ( rc = iscsi_parse_root_path ( iscsi, uri->opaque ) ) != 0 )
@@ -28,6 +28,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
+#include <strings.h>
 #include <errno.h>
 #include <byteswap.h>
 #include <ipxe/hmac.h>
@@ -36,6 +37,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <ipxe/aes.h>
 #include <ipxe/rsa.h>
 #include <ipxe/iobuf.h>
+#include <ipxe/malloc.h>
 #include <ipxe/xfer.h>
 #include <ipxe/open.h>
 #include <ipxe/asn1.h>
@@ -67,6 +69,152 @@ static unsigned long tls_uint24 ( uint8_t field24[3] ) {
 	return ( ( field24[0] << 16 ) + ( field24[1] << 8 ) + field24[2] );
 }
 
+/******************************************************************************
+ *
+ * Session cache
+ *
+ ******************************************************************************
+ */
+
+/** List of cached TLS sessions, most recently used first */
+static LIST_HEAD ( tls_cached_sessions );
+
+/**
+ * Find cached TLS session
+ *
+ * @v name		Server name
+ * @v port		Server port
+ * @ret cached		Cached session, or NULL if not found
+ */
+static struct tls_cached_session * tls_find_cached ( const char *name,
+						     unsigned int port ) {
+	struct tls_cached_session *cached;
+
+	list_for_each_entry ( cached, &tls_cached_sessions, list ) {
+		if ( ( strcasecmp ( cached->name, name ) == 0 ) &&
+		     ( cached->port == port ) )
+			return cached;
+	}
+	return NULL;
+}
+
+/**
+ * Remove cached TLS session
+ *
+ * @v cached		Cached session
+ */
+static void tls_uncache ( struct tls_cached_session *cached ) {
+
+	list_del ( &cached->list );
+	memset ( cached->master_secret, 0, sizeof ( cached->master_secret ) );
+	free ( cached );
+}
+
+/**
+ * Add TLS session to session cache
+ *
+ * @v tls		TLS session
+ *
+ * Any existing cached session for the same server name and port is
+ * replaced.  If the cache is full, the least recently used session
+ * is discarded.  Failure to cache a session is not an error.
+ */
+static void tls_cache ( struct tls_session *tls ) {
+	struct tls_cached_session *cached;
+	unsigned int count = 0;
+
+	/* Reuse existing entry for this server, if any */
+	cached = tls_find_cached ( tls->name, tls->port );
+
+	/* Forget any stale entry if the server did not assign a
+	 * session ID.
+	 */
+	if ( ! tls->session_id_len ) {
+		if ( cached )
+			tls_uncache ( cached );
+		return;
+	}
+
+	if ( cached ) {
+		list_del ( &cached->list );
+	} else {
+		cached = zalloc ( sizeof ( *cached ) +
+				  strlen ( tls->name ) + 1 /* NUL */ );
+		if ( ! cached )
+			return;
+		cached->name = ( ( ( void * ) cached ) + sizeof ( *cached ) );
+		strcpy ( cached->name, tls->name );
+		cached->port = tls->port;
+	}
+
+	/* Record session parameters */
+	memcpy ( cached->session_id, tls->session_id, tls->session_id_len );
+	cached->session_id_len = tls->session_id_len;
+	cached->cipher_suite = tls->cipher_suite;
+	memcpy ( cached->master_secret, tls->master_secret,
+		 sizeof ( cached->master_secret ) );
+	list_add ( &cached->list, &tls_cached_sessions );
+	DBGC ( tls, "TLS %p cached session for %s:%d\n",
+	       tls, tls->name, tls->port );
+
+	/* Discard least recently used sessions beyond the cache size */
+	list_for_each_entry ( cached, &tls_cached_sessions, list )
+		count++;
+	while ( count-- > TLS_MAX_CACHED_SESSIONS ) {
+		cached = list_entry ( tls_cached_sessions.prev,
+				      struct tls_cached_session, list );
+		tls_uncache ( cached );
+	}
+}
+
+/**
+ * Prepare to resume cached TLS session
+ *
+ * @v tls		TLS session
+ *
+ * If a session for the same server name and port is cached, its
+ * session ID will be offered in the Client Hello.  The server may
+ * choose not to resume the session, in which case a full handshake
+ * takes place.
+ */
+static void tls_resume ( struct tls_session *tls ) {
+	struct tls_cached_session *cached;
+
+	cached = tls_find_cached ( tls->name, tls->port );
+	if ( ! cached )
+		return;
+
+	memcpy ( tls->session_id, cached->session_id,
+		 cached->session_id_len );
+	tls->session_id_len = cached->session_id_len;
+	tls->cipher_suite = cached->cipher_suite;
+	memcpy ( tls->master_secret, cached->master_secret,
+		 sizeof ( tls->master_secret ) );
+	DBGC ( tls, "TLS %p offering cached session for %s:%d\n",
+	       tls, tls->name, tls->port );
+}
+
+/**
+ * Discard a cached TLS session
+ *
+ * @ret discarded	Number of cached items discarded
+ */
+static unsigned int tls_discard ( void ) {
+	struct tls_cached_session *cached;
+
+	/* Discard least recently used session */
+	list_for_each_entry_reverse ( cached, &tls_cached_sessions, list ) {
+		tls_uncache ( cached );
+		return 1;
+	}
+	return 0;
+}
+
+/** TLS session cache discarder */
+struct cache_discarder tls_cache_discarder __cache_discarder = {
+	.discard = tls_discard,
+};
+
 /******************************************************************************
  *
  * Cleanup functions
@@ -102,6 +250,14 @@ static void free_tls ( struct refcnt *refcnt ) {
  * @v rc		Status code
  */
 static void tls_close ( struct tls_session *tls, int rc ) {
+	struct tls_cached_session *cached;
+
+	/* Never resume a session that failed during the handshake */
+	if ( rc && ( tls->tx_state != TLS_TX_DATA ) ) {
+		cached = tls_find_cached ( tls->name, tls->port );
+		if ( cached )
+			tls_uncache ( cached );
+	}
 
 	/* Remove process */
 	process_del ( &tls->process );
@@ -163,7 +319,7 @@ static void tls_p_hash_va ( struct tls_session *tls,
 			    void *secret, size_t secret_len,
 			    void *out, size_t out_len,
 			    va_list seeds ) {
-	uint8_t secret_copy[secret_len];
+	uint8_t key_ctx[ hmac_key_ctxsize ( digest ) ];
 	uint8_t digest_ctx[digest->ctxsize];
 	uint8_t digest_ctx_partial[digest->ctxsize];
 	uint8_t a[digest->digestsize];
@@ -171,32 +327,30 @@ static void tls_p_hash_va ( struct tls_session *tls,
 	size_t frag_len = digest->digestsize;
 	va_list tmp;
 
-	/* Copy the secret, in case HMAC modifies it */
-	memcpy ( secret_copy, secret, secret_len );
-	secret = secret_copy;
+	/* Precompute HMAC key, since it is used for every block */
 	DBGC2 ( tls, "TLS %p %s secret:\n", tls, digest->name );
 	DBGC2_HD ( tls, secret, secret_len );
+	hmac_key_init ( digest, key_ctx, secret, secret_len );
 
 	/* Calculate A(1) */
-	hmac_init ( digest, digest_ctx, secret, &secret_len );
+	hmac_key_start ( digest, key_ctx, digest_ctx );
 	va_copy ( tmp, seeds );
 	tls_hmac_update_va ( digest, digest_ctx, tmp );
 	va_end ( tmp );
-	hmac_final ( digest, digest_ctx, secret, &secret_len, a );
+	hmac_key_final ( digest, key_ctx, digest_ctx, a );
 	DBGC2 ( tls, "TLS %p %s A(1):\n", tls, digest->name );
 	DBGC2_HD ( tls, &a, sizeof ( a ) );
 
 	/* Generate as much data as required */
 	while ( out_len ) {
 		/* Calculate output portion */
-		hmac_init ( digest, digest_ctx, secret, &secret_len );
+		hmac_key_start ( digest, key_ctx, digest_ctx );
 		hmac_update ( digest, digest_ctx, a, sizeof ( a ) );
 		memcpy ( digest_ctx_partial, digest_ctx, digest->ctxsize );
 		va_copy ( tmp, seeds );
 		tls_hmac_update_va ( digest, digest_ctx, tmp );
 		va_end ( tmp );
-		hmac_final ( digest, digest_ctx,
-			     secret, &secret_len, out_tmp );
+		hmac_key_final ( digest, key_ctx, digest_ctx, out_tmp );
 
 		/* Copy output */
 		if ( frag_len > out_len )
@@ -206,8 +360,7 @@ static void tls_p_hash_va ( struct tls_session *tls,
 		DBGC2_HD ( tls, out, frag_len );
 
 		/* Calculate A(i) */
-		hmac_final ( digest, digest_ctx_partial,
-			     secret, &secret_len, a );
+		hmac_key_final ( digest, key_ctx, digest_ctx_partial, a );
 		DBGC2 ( tls, "TLS %p %s A(n):\n", tls, digest->name );
 		DBGC2_HD ( tls, &a, sizeof ( a ) );
 
@@ -341,13 +494,15 @@ static int tls_generate_keys ( struct tls_session *tls ) {
 	key = key_block;
 
 	/* TX MAC secret */
-	memcpy ( tx_cipherspec->mac_secret, key, hash_size );
+	hmac_key_init ( tx_cipherspec->digest, tx_cipherspec->mac_ctx,
+			key, hash_size );
 	DBGC ( tls, "TLS %p TX MAC secret:\n", tls );
 	DBGC_HD ( tls, key, hash_size );
 	key += hash_size;
 
 	/* RX MAC secret */
-	memcpy ( rx_cipherspec->mac_secret, key, hash_size );
+	hmac_key_init ( rx_cipherspec->digest, rx_cipherspec->mac_ctx,
+			key, hash_size );
 	DBGC ( tls, "TLS %p RX MAC secret:\n", tls );
 	DBGC_HD ( tls, key, hash_size );
 	key += hash_size;
@@ -438,7 +593,8 @@ static int tls_set_cipher ( struct tls_session *tls,
 	tls_clear_cipher ( tls, cipherspec );
 	
 	/* Allocate dynamic storage */
-	total = ( pubkey->ctxsize + 2 * cipher->ctxsize + digest->digestsize );
+	total = ( pubkey->ctxsize + 2 * cipher->ctxsize +
+		  hmac_key_ctxsize ( digest ) );
 	dynamic = malloc ( total );
 	if ( ! dynamic ) {
 		DBGC ( tls, "TLS %p could not allocate %zd bytes for crypto "
@@ -452,7 +608,8 @@ static int tls_set_cipher ( struct tls_session *tls,
 	cipherspec->pubkey_ctx = dynamic;	dynamic += pubkey->ctxsize;
 	cipherspec->cipher_ctx = dynamic;	dynamic += cipher->ctxsize;
 	cipherspec->cipher_next_ctx = dynamic;	dynamic += cipher->ctxsize;
-	cipherspec->mac_secret = dynamic;	dynamic += digest->digestsize;
+	cipherspec->mac_ctx = dynamic;
+	dynamic += hmac_key_ctxsize ( digest );
 	assert ( ( cipherspec->dynamic + total ) == dynamic );
 
 	/* Store parameters */
@@ -617,6 +774,7 @@ static int tls_send_client_hello ( struct tls_session *tls ) {
 		uint16_t version;
 		uint8_t random[32];
 		uint8_t session_id_len;
+		uint8_t session_id[tls->session_id_len];
 		uint16_t cipher_suite_len;
 		uint16_t cipher_suites[2];
 		uint8_t compression_methods_len;
@@ -629,6 +787,9 @@ static int tls_send_client_hello ( struct tls_session *tls ) {
 				      sizeof ( hello.type_length ) ) );
 	hello.version = htons ( TLS_VERSION_TLS_1_0 );
 	memcpy ( &hello.random, &tls->client_random, sizeof ( hello.random ) );
+	hello.session_id_len = sizeof ( hello.session_id );
+	memcpy ( hello.session_id, tls->session_id,
+		 sizeof ( hello.session_id ) );
 	hello.cipher_suite_len = htons ( sizeof ( hello.cipher_suites ) );
 	hello.cipher_suites[0] = htons ( TLS_RSA_WITH_AES_128_CBC_SHA );
 	hello.cipher_suites[1] = htons ( TLS_RSA_WITH_AES_256_CBC_SHA );
@@ -644,15 +805,13 @@ static int tls_send_client_hello ( struct tls_session *tls ) {
  * @ret rc		Return status code
  */
 static int tls_send_client_key_exchange ( struct tls_session *tls ) {
-	/* FIXME: Hack alert */
-	RSA_CTX *rsa_ctx;
-	RSA_pub_key_new ( &rsa_ctx, tls->rsa.modulus, tls->rsa.modulus_len,
-			  tls->rsa.exponent, tls->rsa.exponent_len );
+	size_t len = rsa_modulus_len ( &tls->rsa );
 	struct {
 		uint32_t type_length;
 		uint16_t encrypted_pre_master_secret_len;
-		uint8_t encrypted_pre_master_secret[rsa_ctx->num_octets];
+		uint8_t encrypted_pre_master_secret[len];
 	} __attribute__ (( packed )) key_xchg;
+	int rc;
 
 	memset ( &key_xchg, 0, sizeof ( key_xchg ) );
 	key_xchg.type_length = ( cpu_to_le32 ( TLS_CLIENT_KEY_EXCHANGE ) |
@@ -661,20 +820,19 @@ static int tls_send_client_key_exchange ( struct tls_session *tls ) {
 	key_xchg.encrypted_pre_master_secret_len
 		= htons ( sizeof ( key_xchg.encrypted_pre_master_secret ) );
 
-	/* FIXME: Hack alert */
-	DBGC ( tls, "RSA encrypting plaintext, modulus, exponent:\n" );
-	DBGC_HD ( tls, &tls->pre_master_secret,
-		  sizeof ( tls->pre_master_secret ) );
-	DBGC_HD ( tls, tls->rsa.modulus, tls->rsa.modulus_len );
-	DBGC_HD ( tls, tls->rsa.exponent, tls->rsa.exponent_len );
-	RSA_encrypt ( rsa_ctx, ( const uint8_t * ) &tls->pre_master_secret,
-		      sizeof ( tls->pre_master_secret ),
-		      key_xchg.encrypted_pre_master_secret, 0 );
-	DBGC ( tls, "RSA encrypt done.  Ciphertext:\n" );
+	/* Encrypt pre-master secret using server's public key */
+	DBGC ( tls, "TLS %p RSA encrypting pre-master secret\n", tls );
+	rc = rsa_encrypt ( &tls->rsa, &tls->pre_master_secret,
+			   sizeof ( tls->pre_master_secret ),
+			   key_xchg.encrypted_pre_master_secret );
+	if ( rc != 0 ) {
+		DBGC ( tls, "TLS %p could not encrypt pre-master secret: %s\n",
+		       tls, strerror ( rc ) );
+		return rc;
+	}
+	DBGC ( tls, "TLS %p RSA encrypt done.  Ciphertext:\n", tls );
 	DBGC_HD ( tls, &key_xchg.encrypted_pre_master_secret,
 		  sizeof ( key_xchg.encrypted_pre_master_secret ) );
-	RSA_free ( rsa_ctx );
-
 
 	return tls_send_handshake ( tls, &key_xchg, sizeof ( key_xchg ) );
 }
@@ -828,12 +986,42 @@ static int tls_new_server_hello ( struct tls_session *tls,
 	memcpy ( &tls->server_random, &hello_a->random,
 		 sizeof ( tls->server_random ) );
 
+	/* Check whether or not the server is resuming our cached session */
+	if ( tls->session_id_len &&
+	     ( hello_a->session_id_len == tls->session_id_len ) &&
+	     ( memcmp ( hello_b->session_id, tls->session_id,
+			tls->session_id_len ) == 0 ) ) {
+		if ( hello_b->cipher_suite != tls->cipher_suite ) {
+			DBGC ( tls, "TLS %p resumed session with cipher "
+			       "%04x (expected %04x)\n", tls,
+			       ntohs ( hello_b->cipher_suite ),
+			       ntohs ( tls->cipher_suite ) );
+			return -EINVAL;
+		}
+		DBGC ( tls, "TLS %p resuming cached session\n", tls );
+		tls->resumed = 1;
+	} else {
+		if ( hello_a->session_id_len > sizeof ( tls->session_id ) ) {
+			DBGC ( tls, "TLS %p received overlength session "
+			       "ID\n", tls );
+			DBGC_HD ( tls, data, len );
+			return -EINVAL;
+		}
+		memcpy ( tls->session_id, hello_b->session_id,
+			 hello_a->session_id_len );
+		tls->session_id_len = hello_a->session_id_len;
+		tls->cipher_suite = hello_b->cipher_suite;
+	}
+
 	/* Select cipher suite */
 	if ( ( rc = tls_select_cipher ( tls, hello_b->cipher_suite ) ) != 0 )
 		return rc;
 
-	/* Generate secrets */
-	tls_generate_master_secret ( tls );
+	/* Generate secrets.  A resumed session reuses the cached
+	 * master secret, and so requires no key exchange.
+	 */
+	if ( ! tls->resumed )
+		tls_generate_master_secret ( tls );
 	if ( ( rc = tls_generate_keys ( tls ) ) != 0 )
 		return rc;
 
@@ -872,6 +1060,13 @@ static int tls_new_certificate ( struct tls_session *tls,
 		return -EINVAL;
 	}
 
+	/* An abbreviated handshake does not include a certificate */
+	if ( tls->resumed ) {
+		DBGC ( tls, "TLS %p received Server Certificate for resumed "
+		       "session\n", tls );
+		return -EIO;
+	}
+
 	/* Traverse certificate chain */
 	do {
 		cursor.data = element->certificate;
@@ -922,7 +1117,7 @@ static int tls_new_server_hello_done ( struct tls_session *tls,
 	}
 
 	/* Check that we are ready to send the Client Key Exchange */
-	if ( tls->tx_state != TLS_TX_NONE ) {
+	if ( ( tls->tx_state != TLS_TX_NONE ) || tls->resumed ) {
 		DBGC ( tls, "TLS %p received Server Hello Done while in "
 		       "TX state %d\n", tls, tls->tx_state );
 		return -EIO;
@@ -944,11 +1139,49 @@ static int tls_new_server_hello_done ( struct tls_session *tls,
  */
 static int tls_new_finished ( struct tls_session *tls,
 			      void *data, size_t len ) {
+	struct {
+		uint8_t verify_data[12];
+		char next[0];
+	} __attribute__ (( packed )) *finished = data;
+	void *end = finished->next;
+	uint8_t digest[MD5_DIGEST_SIZE + SHA1_DIGEST_SIZE];
+	uint8_t verify_data[ sizeof ( finished->verify_data ) ];
+
+	/* Sanity check */
+	if ( end != ( data + len ) ) {
+		DBGC ( tls, "TLS %p received overlength Finished\n", tls );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL;
+	}
+
+	/* Verify data */
+	tls_verify_handshake ( tls, digest );
+	tls_prf_label ( tls, &tls->master_secret, sizeof ( tls->master_secret ),
+			verify_data, sizeof ( verify_data ), "server finished",
+			digest, sizeof ( digest ) );
+	if ( memcmp ( verify_data, finished->verify_data,
+		      sizeof ( verify_data ) ) != 0 ) {
+		DBGC ( tls, "TLS %p verification failed\n", tls );
+		return -EPERM;
+	}
+
+	/* An abbreviated handshake is completed by the client;
+	 * a full handshake is completed by the server.
+	 */
+	if ( tls->resumed ) {
+		if ( tls->tx_state != TLS_TX_NONE ) {
+			DBGC ( tls, "TLS %p received Finished while in TX "
+			       "state %d\n", tls, tls->tx_state );
+			return -EIO;
+		}
+		tls->tx_state = TLS_TX_CHANGE_CIPHER;
+	} else {
+		tls->tx_state = TLS_TX_DATA;
+	}
+
+	/* Make session available for resumption */
+	tls_cache ( tls );
 
-	/* FIXME: Handle this properly */
-	tls->tx_state = TLS_TX_DATA;
-	( void ) data;
-	( void ) len;
 	return 0;
 }
 
@@ -1078,14 +1311,12 @@ static void tls_hmac ( struct tls_session *tls __unused,
 	struct digest_algorithm *digest = cipherspec->digest;
 	uint8_t digest_ctx[digest->ctxsize];
 
-	hmac_init ( digest, digest_ctx, cipherspec->mac_secret,
-		    &digest->digestsize );
+	hmac_key_start ( digest, cipherspec->mac_ctx, digest_ctx );
 	seq = cpu_to_be64 ( seq );
 	hmac_update ( digest, digest_ctx, &seq, sizeof ( seq ) );
 	hmac_update ( digest, digest_ctx, tlshdr, sizeof ( *tlshdr ) );
 	hmac_update ( digest, digest_ctx, data, len );
-	hmac_final ( digest, digest_ctx, cipherspec->mac_secret,
-		     &digest->digestsize, hmac );
+	hmac_key_final ( digest, cipherspec->mac_ctx, digest_ctx, hmac );
 }
 
 /**
@@ -1698,7 +1929,7 @@ static void tls_step ( struct process *process ) {
 			       tls, strerror ( rc ) );
 			goto err;
 		}
-		tls->tx_state = TLS_TX_NONE;
+		tls->tx_state = ( tls->resumed ? TLS_TX_DATA : TLS_TX_NONE );
 		break;
 	case TLS_TX_DATA:
 		/* Nothing to do */
@@ -1720,15 +1951,31 @@ static void tls_step ( struct process *process ) {
  ******************************************************************************
  */
 
-int add_tls ( struct interface *xfer, struct interface **next ) {
+/**
+ * Add TLS filter
+ *
+ * @v xfer		Plaintext data transfer interface
+ * @v name		Server name
+ * @v port		Server port
+ * @v next		Ciphertext data transfer interface to fill in
+ * @ret rc		Return status code
+ *
+ * The server name and port are used as the key for session
+ * resumption.
+ */
+int add_tls ( struct interface *xfer, const char *name, unsigned int port,
+	      struct interface **next ) {
 	struct tls_session *tls;
 
 	/* Allocate and initialise TLS structure */
-	tls = malloc ( sizeof ( *tls ) );
+	tls = malloc ( sizeof ( *tls ) + strlen ( name ) + 1 /* NUL */ );
 	if ( ! tls )
 		return -ENOMEM;
 	memset ( tls, 0, sizeof ( *tls ) );
 	ref_init ( &tls->refcnt, free_tls );
+	tls->name = ( ( ( void * ) tls ) + sizeof ( *tls ) );
+	strcpy ( tls->name, name );
+	tls->port = port;
 	intf_init ( &tls->plainstream, &tls_plainstream_desc, &tls->refcnt );
 	intf_init ( &tls->cipherstream, &tls_cipherstream_desc, &tls->refcnt );
 	tls_clear_cipher ( tls, &tls->tx_cipherspec );
@@ -1743,6 +1990,7 @@ int add_tls ( struct interface *xfer, struct interface **next ) {
 			      ( sizeof ( tls->pre_master_secret.random ) ) );
 	digest_init ( &md5_algorithm, tls->handshake_md5_ctx );
 	digest_init ( &sha1_algorithm, tls->handshake_sha1_ctx );
+	tls_resume ( tls );
 	tls->tx_state = TLS_TX_CLIENT_HELLO;
 	process_init ( &tls->process, tls_step, &tls->refcnt );
 
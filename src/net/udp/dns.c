@@ -24,10 +24,16 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 #include <errno.h>
 #include <byteswap.h>
+#include <config/general.h>
 #include <ipxe/refcnt.h>
+#include <ipxe/list.h>
+#include <ipxe/malloc.h>
+#include <ipxe/timer.h>
+#include <ipxe/process.h>
 #include <ipxe/iobuf.h>
 #include <ipxe/xfer.h>
 #include <ipxe/open.h>
@@ -62,6 +68,166 @@ static struct sockaddr_tcpip nameserver = {
 /** The local domain */
 static char *localdomain;
 
+/** Maximum lifetime of cached DNS results, in seconds */
+static unsigned long dns_cache_ttl = DNS_CACHE_TTL;
+
+/******************************************************************************
+ *
+ * DNS cache
+ *
+ ******************************************************************************
+ */
+
+/** A DNS cache entry
+ *
+ * Each entry records the final outcome of resolving a fully-qualified
+ * name, after following any CNAME records.  A negative entry records
+ * that the name does not exist.
+ */
+struct dns_cache_entry {
+	/** List of DNS cache entries, most recently used first */
+	struct list_head list;
+	/** Time at which entry was created */
+	unsigned long created;
+	/** Lifetime of entry (in ticks) */
+	unsigned long lifetime;
+	/** Resolution status code (zero for a positive entry) */
+	int rc;
+	/** Resolved address (for a positive entry) */
+	struct in_addr in_addr;
+	/** Fully-qualified name
+	 *
+	 * Must be at end of structure
+	 */
+	char name[0];
+};
+
+/** DNS cache */
+static LIST_HEAD ( dns_cache );
+
+/** Number of entries in DNS cache */
+static unsigned int dns_cache_count;
+
+/**
+ * Remove DNS cache entry
+ *
+ * @v cache		DNS cache entry
+ */
+static void dns_cache_del ( struct dns_cache_entry *cache ) {
+
+	DBG ( "DNS cache removing \"%s\"\n", cache->name );
+	list_del ( &cache->list );
+	free ( cache );
+	dns_cache_count--;
+}
+
+/**
+ * Flush DNS cache
+ *
+ */
+static void dns_cache_flush ( void ) {
+	struct dns_cache_entry *cache;
+	struct dns_cache_entry *tmp;
+
+	list_for_each_entry_safe ( cache, tmp, &dns_cache, list )
+		dns_cache_del ( cache );
+}
+
+/**
+ * Find DNS cache entry
+ *
+ * @v name		Fully-qualified name
+ * @ret cache		DNS cache entry, or NULL if not found
+ *
+ * Any matching entry that has expired is removed.  A matching entry
+ * that has not expired becomes the most recently used entry.
+ */
+static struct dns_cache_entry * dns_cache_find ( const char *name ) {
+	struct dns_cache_entry *cache;
+
+	list_for_each_entry ( cache, &dns_cache, list ) {
+		if ( strcasecmp ( cache->name, name ) != 0 )
+			continue;
+		if ( ( currticks() - cache->created ) >= cache->lifetime ) {
+			dns_cache_del ( cache );
+			return NULL;
+		}
+		list_del ( &cache->list );
+		list_add ( &cache->list, &dns_cache );
+		return cache;
+	}
+	return NULL;
+}
+
+/**
+ * Add DNS cache entry
+ *
+ * @v name		Fully-qualified name
+ * @v rc		Resolution status code
+ * @v in_addr		Resolved address (if resolution succeeded)
+ * @v ttl		Time to live, in seconds
+ */
+static void dns_cache_add ( const char *name, int rc, struct in_addr in_addr,
+			    unsigned long ttl ) {
+	struct dns_cache_entry *cache;
+	unsigned long max_ttl = ( ~0UL / TICKS_PER_SEC );
+
+	/* Do nothing if result must not be cached */
+	if ( ( DNS_CACHE_SIZE == 0 ) || ( ttl == 0 ) )
+		return;
+	if ( ttl > max_ttl )
+		ttl = max_ttl;
+
+	/* Replace any existing entry, and make room for the new entry */
+	if ( ( cache = dns_cache_find ( name ) ) != NULL )
+		dns_cache_del ( cache );
+	if ( dns_cache_count >= DNS_CACHE_SIZE ) {
+		dns_cache_del ( list_entry ( dns_cache.prev,
+					     struct dns_cache_entry, list ) );
+	}
+
+	/* Allocate and populate entry */
+	cache = malloc ( sizeof ( *cache ) + strlen ( name ) + 1 /* NUL */ );
+	if ( ! cache )
+		return;
+	cache->created = currticks();
+	cache->lifetime = ( ttl * TICKS_PER_SEC );
+	cache->rc = rc;
+	cache->in_addr = in_addr;
+	strcpy ( cache->name, name );
+	list_add ( &cache->list, &dns_cache );
+	dns_cache_count++;
+	DBG ( "DNS cache adding \"%s\" => %s for %lds\n", name,
+	      ( rc ? strerror ( rc ) : inet_ntoa ( in_addr ) ), ttl );
+}
+
+/**
+ * Discard some cached DNS results
+ *
+ * @ret discarded	Number of cached items discarded
+ */
+static unsigned int dns_cache_discard ( void ) {
+
+	/* Discard the least recently used entry, if any */
+	if ( list_empty ( &dns_cache ) )
+		return 0;
+	dns_cache_del ( list_entry ( dns_cache.prev, struct dns_cache_entry,
+				     list ) );
+	return 1;
+}
+
+/** DNS cache discarder */
+struct cache_discarder dns_cache_discarder __cache_discarder = {
+	.discard = dns_cache_discard,
+};
+
+/******************************************************************************
+ *
+ * DNS requests
+ *
+ ******************************************************************************
+ */
+
 /** A DNS request */
 struct dns_request {
 	/** Reference counter */
@@ -72,6 +238,8 @@ struct dns_request {
 	struct interface socket;
 	/** Retry timer */
 	struct retry_timer timer;
+	/** Cached result delivery process */
+	struct process process;
 
 	/** Socket address to fill in with resolved address */
 	struct sockaddr sa;
@@ -85,6 +253,15 @@ struct dns_request {
 	struct dns_query_info *qinfo;
 	/** Recursion counter */
 	unsigned int recursion;
+	/** Minimum time to live of records used so far, in seconds */
+	unsigned long ttl;
+	/** Cached resolution status code */
+	int rc;
+	/** Fully-qualified name being resolved
+	 *
+	 * Must be at end of structure
+	 */
+	char name[0];
 };
 
 /**
@@ -95,8 +272,9 @@ struct dns_request {
  */
 static void dns_done ( struct dns_request *dns, int rc ) {
 
-	/* Stop the retry timer */
+	/* Stop the retry timer and cached result delivery process */
 	stop_timer ( &dns->timer );
+	process_del ( &dns->process );
 
 	/* Shut down interfaces */
 	intf_shutdown ( &dns->socket, rc );
@@ -191,6 +369,68 @@ static union dns_rr_info * dns_find_rr ( struct dns_request *dns,
 	return NULL;
 }
 
+/**
+ * Record time to live of an RR used in resolution
+ *
+ * @v dns		DNS request
+ * @v rr_info		DNS RR
+ *
+ * A result derived via a chain of CNAME records may be cached only
+ * for as long as the shortest-lived record in the chain.
+ */
+static void dns_use_ttl ( struct dns_request *dns,
+			  const union dns_rr_info *rr_info ) {
+	unsigned long ttl = ntohl ( rr_info->common.ttl );
+
+	if ( ttl < dns->ttl )
+		dns->ttl = ttl;
+}
+
+/**
+ * Determine time to live for a negative response
+ *
+ * @v reply		DNS reply
+ * @ret ttl		Time to live, in seconds (zero if not cacheable)
+ *
+ * As per RFC 2308, a negative response may be cached for the lesser
+ * of the TTL and the MINIMUM field of the SOA record in the authority
+ * section.  A negative response without an SOA record must not be
+ * cached.
+ */
+static unsigned long dns_negative_ttl ( const struct dns_header *reply ) {
+	const char *p = ( ( char * ) reply ) + sizeof ( struct dns_header );
+	const union dns_rr_info *rr_info;
+	const struct dns_soa_info *soa;
+	unsigned long ttl;
+	unsigned long minimum;
+	int i;
+
+	/* Skip over the questions and answers sections */
+	for ( i = ntohs ( reply->qdcount ) ; i > 0 ; i-- )
+		p = dns_skip_name ( p ) + sizeof ( struct dns_query_info );
+	for ( i = ntohs ( reply->ancount ) ; i > 0 ; i-- ) {
+		rr_info = ( ( union dns_rr_info * ) dns_skip_name ( p ) );
+		p = ( ( ( char * ) rr_info ) + sizeof ( rr_info->common ) +
+		      ntohs ( rr_info->common.rdlength ) );
+	}
+
+	/* Look for an SOA record in the authority section */
+	for ( i = ntohs ( reply->nscount ) ; i > 0 ; i-- ) {
+		rr_info = ( ( union dns_rr_info * ) dns_skip_name ( p ) );
+		p = ( ( ( char * ) rr_info ) + sizeof ( rr_info->common ) );
+		if ( rr_info->common.type == htons ( DNS_TYPE_SOA ) ) {
+			soa = ( ( struct dns_soa_info * )
+				dns_skip_name ( dns_skip_name ( p ) ) );
+			ttl = ntohl ( rr_info->common.ttl );
+			minimum = ntohl ( soa->minimum );
+			return ( ( minimum < ttl ) ? minimum : ttl );
+		}
+		p += ntohs ( rr_info->common.rdlength );
+	}
+
+	return 0;
+}
+
 /**
  * Append DHCP domain name if available and name is not fully qualified
  *
@@ -339,7 +579,9 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 	const struct dns_header *reply = iobuf->data;
 	union dns_rr_info *rr_info;
 	struct sockaddr_in *sin;
+	struct in_addr no_addr = { 0 };
 	unsigned int qtype = dns->qinfo->qtype;
+	unsigned long ttl;
 	int rc;
 
 	/* Sanity check */
@@ -385,6 +627,10 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 			sin->sin_family = AF_INET;
 			sin->sin_addr = rr_info->a.in_addr;
 
+			/* Cache resolved address */
+			dns_use_ttl ( dns, rr_info );
+			dns_cache_add ( dns->name, 0, sin->sin_addr, dns->ttl );
+
 			/* Return resolved address */
 			resolv_done ( &dns->resolv, &dns->sa );
 
@@ -397,6 +643,7 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 
 			/* Found a CNAME record; update query and recurse */
 			DBGC ( dns, "DNS %p found CNAME\n", dns );
+			dns_use_ttl ( dns, rr_info );
 			dns->qinfo = ( void * ) dns_decompress_name ( reply,
 							 rr_info->cname.cname,
 							 dns->query.payload );
@@ -446,6 +693,11 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 			goto done;
 		} else {
 			DBGC ( dns, "DNS %p found no CNAME record\n", dns );
+			ttl = dns_negative_ttl ( reply );
+			if ( ttl > dns->ttl )
+				ttl = dns->ttl;
+			dns_cache_add ( dns->name, -ENXIO_NO_RECORD,
+					no_addr, ttl );
 			dns_done ( dns, -ENXIO_NO_RECORD );
 			rc = 0;
 			goto done;
@@ -497,6 +749,20 @@ static struct interface_operation dns_resolv_op[] = {
 static struct interface_descriptor dns_resolv_desc =
 	INTF_DESC ( struct dns_request, resolv, dns_resolv_op );
 
+/**
+ * Deliver cached DNS result
+ *
+ * @v process		Process
+ */
+static void dns_cache_step ( struct process *process ) {
+	struct dns_request *dns =
+		container_of ( process, struct dns_request, process );
+
+	if ( dns->rc == 0 )
+		resolv_done ( &dns->resolv, &dns->sa );
+	dns_done ( dns, dns->rc );
+}
+
 /**
  * Resolve name using DNS
  *
@@ -508,6 +774,8 @@ static struct interface_descriptor dns_resolv_desc =
 static int dns_resolv ( struct interface *resolv,
 			const char *name, struct sockaddr *sa ) {
 	struct dns_request *dns;
+	struct dns_cache_entry *cache;
+	struct sockaddr_in *sin;
 	char *fqdn;
 	int rc;
 
@@ -527,7 +795,7 @@ static int dns_resolv ( struct interface *resolv,
 	}
 
 	/* Allocate DNS structure */
-	dns = zalloc ( sizeof ( *dns ) );
+	dns = zalloc ( sizeof ( *dns ) + strlen ( fqdn ) + 1 /* NUL */ );
 	if ( ! dns ) {
 		rc = -ENOMEM;
 		goto err_alloc_dns;
@@ -536,7 +804,10 @@ static int dns_resolv ( struct interface *resolv,
 	intf_init ( &dns->resolv, &dns_resolv_desc, &dns->refcnt );
 	intf_init ( &dns->socket, &dns_socket_desc, &dns->refcnt );
 	timer_init ( &dns->timer, dns_timer_expired, &dns->refcnt );
+	process_init_stopped ( &dns->process, dns_cache_step, &dns->refcnt );
 	memcpy ( &dns->sa, sa, sizeof ( dns->sa ) );
+	dns->ttl = dns_cache_ttl;
+	strcpy ( dns->name, fqdn );
 
 	/* Create query */
 	dns->query.dns.flags = htons ( DNS_FLAG_QUERY | DNS_FLAG_OPCODE_QUERY |
@@ -546,6 +817,18 @@ static int dns_resolv ( struct interface *resolv,
 	dns->qinfo->qtype = htons ( DNS_TYPE_A );
 	dns->qinfo->qclass = htons ( DNS_CLASS_IN );
 
+	/* Use cached result, if available */
+	if ( ( cache = dns_cache_find ( fqdn ) ) != NULL ) {
+		DBGC ( dns, "DNS %p using cached result for \"%s\"\n",
+		       dns, fqdn );
+		sin = ( struct sockaddr_in * ) &dns->sa;
+		sin->sin_family = AF_INET;
+		sin->sin_addr = cache->in_addr;
+		dns->rc = cache->rc;
+		process_add ( &dns->process );
+		goto done;
+	}
+
 	/* Open UDP connection */
 	if ( ( rc = xfer_open_socket ( &dns->socket, SOCK_DGRAM,
 				       ( struct sockaddr * ) &nameserver,
@@ -558,6 +841,8 @@ static int dns_resolv ( struct interface *resolv,
 	/* Send first DNS packet */
 	dns_send_packet ( dns );
 
+ done:
+
 	/* Attach parent interface, mortalise self, and return */
 	intf_plug_plug ( &dns->resolv, resolv );
 	ref_put ( &dns->refcnt );
@@ -602,16 +887,33 @@ struct setting domain_setting __setting ( SETTING_IPv4_EXTRA ) = {
 	.type = &setting_type_string,
 };
 
+/** DNS cache maximum TTL setting */
+struct setting dns_cache_ttl_setting __setting ( SETTING_IPv4_EXTRA ) = {
+	.name = "dns-cache-ttl",
+	.description = "DNS cache maximum TTL",
+	.tag = DHCP_EB_DNS_CACHE_TTL,
+	.type = &setting_type_uint16,
+};
+
 /**
  * Apply DNS settings
  *
  * @ret rc		Return status code
+ *
+ * Cached DNS results are flushed whenever the DNS server, the local
+ * domain or the DNS cache maximum TTL changes.
  */
 static int apply_dns_settings ( void ) {
 	struct sockaddr_in *sin_nameserver =
 		( struct sockaddr_in * ) &nameserver;
+	struct sockaddr_tcpip old_nameserver;
+	char *old_localdomain = localdomain;
+	unsigned long old_cache_ttl = dns_cache_ttl;
 	int len;
 
+	/* Record previous DNS server */
+	memcpy ( &old_nameserver, &nameserver, sizeof ( old_nameserver ) );
+
 	/* Fetch DNS server address */
 	nameserver.st_family = 0;
 	if ( ( len = fetch_ipv4_setting ( NULL, &dns_setting,
@@ -622,7 +924,6 @@ static int apply_dns_settings ( void ) {
 	}
 
 	/* Get local domain DHCP option */
-	free ( localdomain );
 	if ( ( len = fetch_string_setting_copy ( NULL, &domain_setting,
 						 &localdomain ) ) < 0 ) {
 		DBG ( "DNS could not fetch local domain: %s\n",
@@ -631,6 +932,22 @@ static int apply_dns_settings ( void ) {
 	if ( localdomain )
 		DBG ( "DNS local domain %s\n", localdomain );
 
+	/* Fetch DNS cache maximum TTL, falling back to the default */
+	if ( fetch_uint_setting ( NULL, &dns_cache_ttl_setting,
+				  &dns_cache_ttl ) < 0 )
+		dns_cache_ttl = DNS_CACHE_TTL;
+
+	/* Flush DNS cache if anything relevant has changed */
+	if ( ( memcmp ( &old_nameserver, &nameserver,
+			sizeof ( old_nameserver ) ) != 0 ) ||
+	     ( strcmp ( ( old_localdomain ? old_localdomain : "" ),
+			( localdomain ? localdomain : "" ) ) != 0 ) ||
+	     ( old_cache_ttl != dns_cache_ttl ) ) {
+		DBG ( "DNS flushing cache\n" );
+		dns_cache_flush();
+	}
+	free ( old_localdomain );
+
 	return 0;
 }
 
@@ -70,6 +70,9 @@ FEATURE ( FEATURE_PROTOCOL, "TFTP", DHCP_EB_FEATURE_TFTP, 1 );
 #define EINVAL_MC_INVALID_PORT __einfo_error ( EINFO_EINVAL_MC_INVALID_PORT )
 #define EINFO_EINVAL_MC_INVALID_PORT __einfo_uniqify \
 	( EINFO_EINVAL, 0x07, "Invalid multicast port" )
+#define EINVAL_WINDOWSIZE __einfo_error ( EINFO_EINVAL_WINDOWSIZE )
+#define EINFO_EINVAL_WINDOWSIZE __einfo_uniqify \
+	( EINFO_EINVAL, 0x08, "Invalid windowsize" )
 
 /**
  * A TFTP request
@@ -103,6 +106,13 @@ struct tftp_request {
 	 * "tsize" option, this value will be zero.
 	 */
 	unsigned long tsize;
+	/** Sliding window
+	 *
+	 * The window size is the "windowsize" option negotiated with
+	 * the TFTP server.  (If the TFTP server does not support the
+	 * windowsize option, this will default to 1).
+	 */
+	struct tftp_window window;
 	
 	/** Server port
 	 *
@@ -142,7 +152,7 @@ struct tftp_request {
 enum {
 	/** Send ACK packets */
 	TFTP_FL_SEND_ACK = 0x0001,
-	/** Request blksize and tsize options */
+	/** Request blksize, tsize and windowsize options */
 	TFTP_FL_RRQ_SIZES = 0x0002,
 	/** Request multicast option */
 	TFTP_FL_RRQ_MULTICAST = 0x0004,
@@ -205,6 +215,9 @@ static int tftp_reopen ( struct tftp_request *tftp ) {
 	/* Disable ACK sending. */
 	tftp->flags &= ~TFTP_FL_SEND_ACK;
 
+	/* Revert to lock-step transfer until options are negotiated */
+	tftp->window.size = 1;
+
 	/* Reset peer address */
 	memset ( &tftp->peer, 0, sizeof ( tftp->peer ) );
 
@@ -364,6 +377,7 @@ static int tftp_send_rrq ( struct tftp_request *tftp ) {
 		+ 5 + 1 /* "octet" + NUL */
 		+ 7 + 1 + 5 + 1 /* "blksize" + NUL + ddddd + NUL */
 		+ 5 + 1 + 1 + 1 /* "tsize" + NUL + "0" + NUL */ 
+		+ 10 + 1 + 5 + 1 /* "windowsize" + NUL + ddddd + NUL */
 		+ 9 + 1 + 1 /* "multicast" + NUL + NUL */ );
 	iobuf = xfer_alloc_iob ( &tftp->socket, len );
 	if ( ! iobuf )
@@ -379,6 +393,13 @@ static int tftp_send_rrq ( struct tftp_request *tftp ) {
 					    iob_tailroom ( iobuf ),
 					    "blksize%c%d%ctsize%c0", 0,
 					    tftp_request_blksize, 0, 0 ) + 1 );
+		/* Sliding windows are not meaningful for multicast */
+		if ( ! ( tftp->flags & TFTP_FL_RRQ_MULTICAST ) ) {
+			iob_put ( iobuf, snprintf ( iobuf->tail,
+						    iob_tailroom ( iobuf ),
+						    "windowsize%c%d", 0,
+						    TFTP_MAX_WINDOWSIZE ) + 1 );
+		}
 	}
 	if ( tftp->flags & TFTP_FL_RRQ_MULTICAST ) {
 		iob_put ( iobuf, snprintf ( iobuf->tail,
@@ -409,6 +430,7 @@ static int tftp_send_ack ( struct tftp_request *tftp ) {
 	/* Determine next required block number */
 	block = bitmap_first_gap ( &tftp->bitmap );
 	DBGC2 ( tftp, "TFTP %p sending ACK for block %d\n", tftp, block );
+	tftp->window.acked = block;
 
 	/* Allocate buffer */
 	iobuf = xfer_alloc_iob ( &tftp->socket, sizeof ( *ack ) );
@@ -579,6 +601,29 @@ static int tftp_process_blksize ( struct tftp_request *tftp,
 	return 0;
 }
 
+/**
+ * Process TFTP "windowsize" option
+ *
+ * @v tftp		TFTP connection
+ * @v value		Option value
+ * @ret rc		Return status code
+ */
+static int tftp_process_windowsize ( struct tftp_request *tftp,
+				     const char *value ) {
+	char *end;
+
+	tftp->window.size = strtoul ( value, &end, 10 );
+	if ( *end || ( tftp->window.size == 0 ) ||
+	     ( tftp->window.size > TFTP_MAX_WINDOWSIZE ) ) {
+		DBGC ( tftp, "TFTP %p got invalid windowsize \"%s\"\n",
+		       tftp, value );
+		return -EINVAL_WINDOWSIZE;
+	}
+	DBGC ( tftp, "TFTP %p windowsize=%d\n", tftp, tftp->window.size );
+
+	return 0;
+}
+
 /**
  * Process TFTP "tsize" option
  *
@@ -688,6 +733,7 @@ struct tftp_option {
 static struct tftp_option tftp_options[] = {
 	{ "blksize", tftp_process_blksize },
 	{ "tsize", tftp_process_tsize },
+	{ "windowsize", tftp_process_windowsize },
 	{ "multicast", tftp_process_multicast },
 	{ NULL, NULL }
 };
@@ -799,6 +845,75 @@ static int tftp_rx_oack ( struct tftp_request *tftp, void *buf, size_t len ) {
 	return rc;
 }
 
+/**
+ * Resolve TFTP DATA block number
+ *
+ * @v gap		Index of first missing block
+ * @v blkno		Block number from DATA packet
+ * @ret block		Block index, or negative if invalid
+ *
+ * Block numbers are 16 bits wide, and block N is carried in a packet
+ * with block number ( N + 1 ) modulo 65536.  With a window size
+ * greater than one, blocks may legitimately arrive from either side
+ * of a 16-bit wraparound, so the block number is resolved relative
+ * to the first missing block.
+ */
+int tftp_block ( unsigned int gap, unsigned int blkno ) {
+
+	return ( gap + ( int16_t ) ( blkno - ( gap + 1 ) ) );
+}
+
+/**
+ * Check whether or not a received DATA block should be acknowledged
+ *
+ * @v window		Sliding window
+ * @v bitmap		Block bitmap
+ * @v block		Block index
+ * @v duplicate		Block had already been received
+ * @ret ack		Block should be acknowledged
+ *
+ * The block must already have been marked as received in the block
+ * bitmap, and the caller must record the first missing block in
+ * @c window->acked whenever it sends an ACK.
+ *
+ * With the default window size of one, every block is acknowledged.
+ * With a larger window (RFC 7440), we acknowledge only once per
+ * window, on completion, and whenever the server needs to be rolled
+ * back to the first missing block: on the first out-of-order block
+ * since the last ACK, and on a repeat of the block immediately
+ * preceding the last ACK (which indicates that the ACK was lost).
+ */
+int tftp_ack_required ( struct tftp_window *window, struct bitmap *bitmap,
+			unsigned int block, int duplicate ) {
+	unsigned int gap = bitmap_first_gap ( bitmap );
+
+	/* Lock-step transfers acknowledge every block */
+	if ( window->size <= 1 )
+		return 1;
+
+	/* Always acknowledge completion */
+	if ( bitmap_full ( bitmap ) )
+		return 1;
+
+	/* Acknowledge a repeated end-of-window block */
+	if ( duplicate )
+		return ( ( block + 1 ) == window->acked );
+
+	/* Acknowledge the first out-of-order block since the last ACK */
+	if ( block > gap ) {
+		if ( window->rollback )
+			return 0;
+		DBGC ( window, "TFTP window %p missing block %d (got %d)\n",
+		       window, gap, block );
+		window->rollback = 1;
+		return 1;
+	}
+
+	/* Acknowledge each complete window */
+	window->rollback = 0;
+	return ( ( gap - window->acked ) >= window->size );
+}
+
 /**
  * Receive DATA
  *
@@ -812,7 +927,9 @@ static int tftp_rx_data ( struct tftp_request *tftp,
 			  struct io_buffer *iobuf ) {
 	struct tftp_data *data = iobuf->data;
 	struct xfer_metadata meta;
-	unsigned int block;
+	unsigned int gap;
+	int block;
+	int duplicate;
 	off_t offset;
 	size_t data_len;
 	int rc;
@@ -832,14 +949,15 @@ static int tftp_rx_data ( struct tftp_request *tftp,
 		goto done;
 	}
 
-	/* Calculate block number */
-	block = ( ( bitmap_first_gap ( &tftp->bitmap ) + 1 ) & ~0xffff );
-	if ( data->block == 0 && block == 0 ) {
-		DBGC ( tftp, "TFTP %p received data block 0\n", tftp );
+	/* Calculate block number relative to the first missing block */
+	gap = bitmap_first_gap ( &tftp->bitmap );
+	block = tftp_block ( gap, ntohs ( data->block ) );
+	if ( block < 0 ) {
+		DBGC ( tftp, "TFTP %p received data block %d\n",
+		       tftp, ntohs ( data->block ) );
 		rc = -EINVAL;
 		goto done;
 	}
-	block += ( ntohs ( data->block ) - 1 );
 
 	/* Extract data */
 	offset = ( block * tftp->blksize );
@@ -852,15 +970,18 @@ static int tftp_rx_data ( struct tftp_request *tftp,
 		goto done;
 	}
 
-	/* Deliver data */
-	memset ( &meta, 0, sizeof ( meta ) );
-	meta.flags = XFER_FL_ABS_OFFSET;
-	meta.offset = offset;
-	if ( ( rc = xfer_deliver ( &tftp->xfer, iob_disown ( iobuf ),
-				   &meta ) ) != 0 ) {
-		DBGC ( tftp, "TFTP %p could not deliver data: %s\n",
-		       tftp, strerror ( rc ) );
-		goto done;
+	/* Deliver data, unless we already have this block */
+	duplicate = bitmap_test ( &tftp->bitmap, block );
+	if ( ! duplicate ) {
+		memset ( &meta, 0, sizeof ( meta ) );
+		meta.flags = XFER_FL_ABS_OFFSET;
+		meta.offset = offset;
+		if ( ( rc = xfer_deliver ( &tftp->xfer, iob_disown ( iobuf ),
+					   &meta ) ) != 0 ) {
+			DBGC ( tftp, "TFTP %p could not deliver data: %s\n",
+			       tftp, strerror ( rc ) );
+			goto done;
+		}
 	}
 
 	/* Ensure block bitmap is ready */
@@ -870,8 +991,10 @@ static int tftp_rx_data ( struct tftp_request *tftp,
 	/* Mark block as received */
 	bitmap_set ( &tftp->bitmap, block );
 
-	/* Acknowledge block */
-	tftp_send_packet ( tftp );
+	/* Acknowledge block, if required */
+	if ( tftp_ack_required ( &tftp->window, &tftp->bitmap, block,
+				 duplicate ) )
+		tftp_send_packet ( tftp );
 
 	/* If all blocks have been received, finish. */
 	if ( bitmap_full ( &tftp->bitmap ) )
@@ -1100,6 +1223,7 @@ static int tftp_core_open ( struct interface *xfer, struct uri *uri,
 	timer_init ( &tftp->timer, tftp_timer_expired, &tftp->refcnt );
 	tftp->uri = uri_get ( uri );
 	tftp->blksize = TFTP_DEFAULT_BLKSIZE;
+	tftp->window.size = 1;
 	tftp->flags = flags;
 
 	/* Open socket */
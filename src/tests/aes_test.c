@@ -0,0 +1,318 @@
+/*
+ * Copyright (C) 2011 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <ipxe/timer.h>
+#include <ipxe/profile.h>
+#include <ipxe/crypto.h>
+#include <ipxe/aes.h>
+#include <ipxe/test.h>
+
+/** @file
+ *
+ * AES self-tests
+ *
+ * Verifies AES and AES-CBC against published test vectors, checks
+ * that multi-block operations match block-at-a-time operations, and
+ * measures AES-CBC throughput.
+ */
+
+/** Length of data used for multi-block and throughput tests */
+#define AES_TEST_MULTI_LEN 4096
+
+/** Duration of each throughput measurement, in seconds */
+#define AES_TEST_BENCH_SECS 1
+
+/** Maximum length of test vector data */
+#define AES_TEST_MAX_LEN 64
+
+/** An AES test vector */
+struct aes_test {
+	/** Cipher algorithm */
+	struct cipher_algorithm *cipher;
+	/** Key */
+	uint8_t key[32];
+	/** Key length */
+	size_t key_len;
+	/** Initialisation vector */
+	uint8_t iv[AES_BLOCKSIZE];
+	/** Plaintext */
+	uint8_t plaintext[AES_TEST_MAX_LEN];
+	/** Ciphertext */
+	uint8_t ciphertext[AES_TEST_MAX_LEN];
+	/** Length of data */
+	size_t len;
+};
+
+/** NIST SP 800-38A example plaintext */
+#define AES_TEST_SP800_38A_PLAINTEXT					\
+	{ 0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,		\
+	  0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,		\
+	  0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,		\
+	  0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,		\
+	  0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,		\
+	  0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,		\
+	  0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17,		\
+	  0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10 }
+
+/** NIST SP 800-38A example initialisation vector */
+#define AES_TEST_SP800_38A_IV						\
+	{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,		\
+	  0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f }
+
+/** FIPS 197 example plaintext */
+#define AES_TEST_FIPS197_PLAINTEXT					\
+	{ 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,		\
+	  0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff }
+
+/** FIPS 197 example key */
+#define AES_TEST_FIPS197_KEY						\
+	{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,		\
+	  0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,		\
+	  0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,		\
+	  0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f }
+
+/** AES test vectors (from FIPS 197 and NIST SP 800-38A) */
+static struct aes_test aes_tests[] = {
+	{ &aes_algorithm, AES_TEST_FIPS197_KEY, 16, { 0 },
+	  AES_TEST_FIPS197_PLAINTEXT,
+	  { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+	    0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a }, 16 },
+	{ &aes_algorithm, AES_TEST_FIPS197_KEY, 24, { 0 },
+	  AES_TEST_FIPS197_PLAINTEXT,
+	  { 0xdd, 0xa9, 0x7c, 0xa4, 0x86, 0x4c, 0xdf, 0xe0,
+	    0x6e, 0xaf, 0x70, 0xa0, 0xec, 0x0d, 0x71, 0x91 }, 16 },
+	{ &aes_algorithm, AES_TEST_FIPS197_KEY, 32, { 0 },
+	  AES_TEST_FIPS197_PLAINTEXT,
+	  { 0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf,
+	    0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89 }, 16 },
+	{ &aes_cbc_algorithm,
+	  { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+	    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c }, 16,
+	  AES_TEST_SP800_38A_IV, AES_TEST_SP800_38A_PLAINTEXT,
+	  { 0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46,
+	    0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+	    0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee,
+	    0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+	    0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b,
+	    0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+	    0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09,
+	    0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7 }, 64 },
+	{ &aes_cbc_algorithm,
+	  { 0x8e, 0x73, 0xb0, 0xf7, 0xda, 0x0e, 0x64, 0x52,
+	    0xc8, 0x10, 0xf3, 0x2b, 0x80, 0x90, 0x79, 0xe5,
+	    0x62, 0xf8, 0xea, 0xd2, 0x52, 0x2c, 0x6b, 0x7b }, 24,
+	  AES_TEST_SP800_38A_IV, AES_TEST_SP800_38A_PLAINTEXT,
+	  { 0x4f, 0x02, 0x1d, 0xb2, 0x43, 0xbc, 0x63, 0x3d,
+	    0x71, 0x78, 0x18, 0x3a, 0x9f, 0xa0, 0x71, 0xe8,
+	    0xb4, 0xd9, 0xad, 0xa9, 0xad, 0x7d, 0xed, 0xf4,
+	    0xe5, 0xe7, 0x38, 0x76, 0x3f, 0x69, 0x14, 0x5a,
+	    0x57, 0x1b, 0x24, 0x20, 0x12, 0xfb, 0x7a, 0xe0,
+	    0x7f, 0xa9, 0xba, 0xac, 0x3d, 0xf1, 0x02, 0xe0,
+	    0x08, 0xb0, 0xe2, 0x79, 0x88, 0x59, 0x88, 0x81,
+	    0xd9, 0x20, 0xa9, 0xe6, 0x4f, 0x56, 0x15, 0xcd }, 64 },
+	{ &aes_cbc_algorithm,
+	  { 0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe,
+	    0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+	    0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7,
+	    0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4 }, 32,
+	  AES_TEST_SP800_38A_IV, AES_TEST_SP800_38A_PLAINTEXT,
+	  { 0xf5, 0x8c, 0x4c, 0x04, 0xd6, 0xe5, 0xf1, 0xba,
+	    0x77, 0x9e, 0xab, 0xfb, 0x5f, 0x7b, 0xfb, 0xd6,
+	    0x9c, 0xfc, 0x4e, 0x96, 0x7e, 0xdb, 0x80, 0x8d,
+	    0x67, 0x9f, 0x77, 0x7b, 0xc6, 0x70, 0x2c, 0x7d,
+	    0x39, 0xf2, 0x33, 0x69, 0xa9, 0xd9, 0xba, 0xcf,
+	    0xa5, 0x30, 0xe2, 0x63, 0x04, 0x23, 0x14, 0x61,
+	    0xb2, 0xeb, 0x05, 0xe2, 0xc3, 0x9b, 0xe9, 0xfc,
+	    0xda, 0x6c, 0x19, 0x07, 0x8c, 0x6a, 0x9d, 0x1b }, 64 },
+};
+
+/** Key lengths used for multi-block and throughput tests */
+static const size_t aes_test_key_lens[] = { 16, 24, 32 };
+
+/** Multi-block test data buffers */
+static uint8_t aes_test_data[3][AES_TEST_MULTI_LEN];
+
+/**
+ * Verify AES test vector
+ *
+ * @v test		AES test vector
+ */
+static void aes_test_verify ( struct aes_test *test ) {
+	struct cipher_algorithm *cipher = test->cipher;
+	uint8_t ctx[cipher->ctxsize];
+	uint8_t out[test->len];
+
+	/* Set key */
+	ok ( cipher_setkey ( cipher, ctx, test->key, test->key_len ) == 0 );
+
+	/* Encrypt */
+	cipher_setiv ( cipher, ctx, test->iv );
+	cipher_encrypt ( cipher, ctx, test->plaintext, out, sizeof ( out ) );
+	ok ( memcmp ( out, test->ciphertext, sizeof ( out ) ) == 0 );
+
+	/* Decrypt in place */
+	cipher_setiv ( cipher, ctx, test->iv );
+	cipher_decrypt ( cipher, ctx, out, out, sizeof ( out ) );
+	ok ( memcmp ( out, test->plaintext, sizeof ( out ) ) == 0 );
+}
+
+/**
+ * Verify that multi-block operations match single-block operations
+ *
+ * @v key_len		Key length
+ */
+static void aes_test_multi ( size_t key_len ) {
+	struct cipher_algorithm *cipher = &aes_cbc_algorithm;
+	uint8_t ctx[cipher->ctxsize];
+	uint8_t key[key_len];
+	uint8_t iv[AES_BLOCKSIZE];
+	uint8_t *plaintext = aes_test_data[0];
+	uint8_t *multi = aes_test_data[1];
+	uint8_t *single = aes_test_data[2];
+	size_t offset;
+	unsigned int i;
+
+	/* Construct arbitrary key, IV and plaintext */
+	for ( i = 0 ; i < key_len ; i++ )
+		key[i] = ( i * 7 );
+	for ( i = 0 ; i < sizeof ( iv ) ; i++ )
+		iv[i] = ( i * 13 );
+	for ( i = 0 ; i < AES_TEST_MULTI_LEN ; i++ )
+		plaintext[i] = ( i ^ ( i >> 8 ) );
+	ok ( cipher_setkey ( cipher, ctx, key, key_len ) == 0 );
+
+	/* Encrypt in a single call and one block at a time */
+	cipher_setiv ( cipher, ctx, iv );
+	cipher_encrypt ( cipher, ctx, plaintext, multi, AES_TEST_MULTI_LEN );
+	cipher_setiv ( cipher, ctx, iv );
+	for ( offset = 0 ; offset < AES_TEST_MULTI_LEN ;
+	      offset += AES_BLOCKSIZE ) {
+		cipher_encrypt ( cipher, ctx, ( plaintext + offset ),
+				 ( single + offset ), AES_BLOCKSIZE );
+	}
+	ok ( memcmp ( multi, single, AES_TEST_MULTI_LEN ) == 0 );
+
+	/* Decrypt in place in a single call and one block at a time */
+	cipher_setiv ( cipher, ctx, iv );
+	cipher_decrypt ( cipher, ctx, multi, multi, AES_TEST_MULTI_LEN );
+	cipher_setiv ( cipher, ctx, iv );
+	for ( offset = 0 ; offset < AES_TEST_MULTI_LEN ;
+	      offset += AES_BLOCKSIZE ) {
+		cipher_decrypt ( cipher, ctx, ( single + offset ),
+				 ( single + offset ), AES_BLOCKSIZE );
+	}
+	ok ( memcmp ( multi, plaintext, AES_TEST_MULTI_LEN ) == 0 );
+	ok ( memcmp ( single, plaintext, AES_TEST_MULTI_LEN ) == 0 );
+}
+
+/**
+ * Measure AES-CBC throughput
+ *
+ * @v key_len		Key length
+ * @v op		Encryption or decryption method
+ * @ret ticks_per_kb	Cost, in CPU ticks per kilobyte
+ * @ret kbps		Throughput, in kB/s
+ */
+static unsigned long aes_test_bench ( size_t key_len,
+				      void ( * op ) ( void *ctx,
+						      const void *src,
+						      void *dst,
+						      size_t len ),
+				      unsigned long *ticks_per_kb ) {
+	struct cipher_algorithm *cipher = &aes_cbc_algorithm;
+	union profiler profiler;
+	uint8_t ctx[cipher->ctxsize];
+	uint8_t key[key_len];
+	uint8_t iv[AES_BLOCKSIZE];
+	uint8_t *data = aes_test_data[0];
+	unsigned long started;
+	unsigned long elapsed;
+	unsigned long count = 0;
+	uint64_t ticks = 0;
+
+	/* Process as much data as possible within the measurement period */
+	memset ( key, 0x5a, sizeof ( key ) );
+	memset ( iv, 0xa5, sizeof ( iv ) );
+	cipher_setkey ( cipher, ctx, key, sizeof ( key ) );
+	cipher_setiv ( cipher, ctx, iv );
+	started = currticks();
+	do {
+		profile ( &profiler );
+		op ( ctx, data, data, AES_TEST_MULTI_LEN );
+		ticks += profile ( &profiler );
+		count++;
+		elapsed = ( currticks() - started );
+	} while ( elapsed < ( AES_TEST_BENCH_SECS * TICKS_PER_SEC ) );
+
+	*ticks_per_kb = ( ticks / ( count * ( AES_TEST_MULTI_LEN / 1024 ) ) );
+	return ( ( ( ( uint64_t ) count ) * ( AES_TEST_MULTI_LEN / 1024 ) *
+		   TICKS_PER_SEC ) / elapsed );
+}
+
+/**
+ * Perform AES self-tests
+ *
+ */
+static void aes_test_exec ( void ) {
+	struct cipher_algorithm *cipher = &aes_cbc_algorithm;
+	unsigned long encrypt;
+	unsigned long decrypt;
+	unsigned long encrypt_ticks;
+	unsigned long decrypt_ticks;
+	size_t key_len;
+	unsigned int i;
+
+	/* Verify test vectors */
+	for ( i = 0 ; i < ( sizeof ( aes_tests ) /
+			    sizeof ( aes_tests[0] ) ) ; i++ ) {
+		aes_test_verify ( &aes_tests[i] );
+	}
+
+	/* Verify multi-block operations */
+	for ( i = 0 ; i < ( sizeof ( aes_test_key_lens ) /
+			    sizeof ( aes_test_key_lens[0] ) ) ; i++ ) {
+		aes_test_multi ( aes_test_key_lens[i] );
+	}
+
+	/* Measure throughput */
+	for ( i = 0 ; i < ( sizeof ( aes_test_key_lens ) /
+			    sizeof ( aes_test_key_lens[0] ) ) ; i++ ) {
+		key_len = aes_test_key_lens[i];
+		encrypt = aes_test_bench ( key_len, cipher->encrypt,
+					   &encrypt_ticks );
+		decrypt = aes_test_bench ( key_len, cipher->decrypt,
+					   &decrypt_ticks );
+		printf ( "%s-%zd: encrypt %ld MB/s (%ld CPU ticks/kB), "
+			 "decrypt %ld MB/s (%ld CPU ticks/kB)\n",
+			 cipher->name, ( key_len * 8 ),
+			 ( encrypt / 1024 ), encrypt_ticks,
+			 ( decrypt / 1024 ), decrypt_ticks );
+	}
+}
+
+/** AES self-test */
+struct self_test aes_test __self_test = {
+	.name = "aes",
+	.exec = aes_test_exec,
+};
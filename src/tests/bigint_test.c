@@ -0,0 +1,955 @@
+/*
+ * Copyright (C) 2012 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/timer.h>
+#include <ipxe/profile.h>
+#include <ipxe/bigint.h>
+#include <ipxe/x509.h>
+#include <ipxe/rsa.h>
+#include <ipxe/test.h>
+
+/** @file
+ *
+ * Big integer and RSA self-tests
+ *
+ * Verifies modular exponentiation against precalculated results,
+ * checks RSA encryption by decrypting with the matching private key,
+ * and measures the time taken by each RSA operation.
+ */
+
+/** Duration of each timing measurement, in seconds */
+#define BIGINT_TEST_BENCH_SECS 1
+
+/** Maximum size of test big integers, in elements */
+#define BIGINT_TEST_MAX_SIZE bigint_required_size ( RSA_MAX_LEN )
+
+/** A modular exponentiation test */
+struct bigint_test {
+	/** Name */
+	const char *name;
+	/** Base */
+	const uint8_t *base;
+	/** Length of base */
+	size_t base_len;
+	/** Modulus */
+	const uint8_t *modulus;
+	/** Length of modulus */
+	size_t modulus_len;
+	/** Exponent */
+	const uint8_t *exponent;
+	/** Length of exponent */
+	size_t exponent_len;
+	/** Expected result */
+	const uint8_t *expected;
+	/** Length of expected result */
+	size_t expected_len;
+};
+
+/**
+ * Define a modular exponentiation test
+ *
+ * @v _name		Test name
+ * @v _prefix		Prefix of test data arrays
+ */
+#define BIGINT_TEST( _name, _prefix ) {					\
+	.name = _name,							\
+	.base = _prefix ## _base,					\
+	.base_len = sizeof ( _prefix ## _base ),			\
+	.modulus = _prefix ## _modulus,					\
+	.modulus_len = sizeof ( _prefix ## _modulus ),			\
+	.exponent = _prefix ## _exponent,				\
+	.exponent_len = sizeof ( _prefix ## _exponent ),		\
+	.expected = _prefix ## _expected,				\
+	.expected_len = sizeof ( _prefix ## _expected ),		\
+	}
+
+/** Single byte: base */
+static const uint8_t bigint_test_0_base[] = {
+	0x05
+};
+
+/** Single byte: modulus */
+static const uint8_t bigint_test_0_modulus[] = {
+	0x0b
+};
+
+/** Single byte: exponent */
+static const uint8_t bigint_test_0_exponent[] = {
+	0x03
+};
+
+/** Single byte: expected result */
+static const uint8_t bigint_test_0_expected[] = {
+	0x04
+};
+
+/** Zero exponent: base */
+static const uint8_t bigint_test_1_base[] = {
+	0x00, 0x12, 0x34
+};
+
+/** Zero exponent: modulus */
+static const uint8_t bigint_test_1_modulus[] = {
+	0x0f, 0xed, 0xcb
+};
+
+/** Zero exponent: exponent */
+static const uint8_t bigint_test_1_exponent[] = {
+	0x00
+};
+
+/** Zero exponent: expected result */
+static const uint8_t bigint_test_1_expected[] = {
+	0x00, 0x00, 0x01
+};
+
+/** Zero base: base */
+static const uint8_t bigint_test_2_base[] = {
+	0x00, 0x00, 0x00
+};
+
+/** Zero base: modulus */
+static const uint8_t bigint_test_2_modulus[] = {
+	0x0f, 0xed, 0xcb
+};
+
+/** Zero base: exponent */
+static const uint8_t bigint_test_2_exponent[] = {
+	0x01, 0x00, 0x01
+};
+
+/** Zero base: expected result */
+static const uint8_t bigint_test_2_expected[] = {
+	0x00, 0x00, 0x00
+};
+
+/** Leading zeros: base */
+static const uint8_t bigint_test_3_base[] = {
+	0x00, 0x00, 0x00, 0x77
+};
+
+/** Leading zeros: modulus */
+static const uint8_t bigint_test_3_modulus[] = {
+	0x00, 0x00, 0x00, 0xef
+};
+
+/** Leading zeros: exponent */
+static const uint8_t bigint_test_3_exponent[] = {
+	0x00, 0x00, 0xff
+};
+
+/** Leading zeros: expected result */
+static const uint8_t bigint_test_3_expected[] = {
+	0x00, 0x00, 0x00, 0x8d
+};
+
+/** Element boundary: base */
+static const uint8_t bigint_test_4_base[] = {
+	0x6a, 0x21, 0x27, 0x52, 0x76, 0xc6, 0xb7, 0xba
+};
+
+/** Element boundary: modulus */
+static const uint8_t bigint_test_4_modulus[] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc5
+};
+
+/** Element boundary: exponent */
+static const uint8_t bigint_test_4_exponent[] = {
+	0xe7, 0xf1, 0x69, 0xa0, 0xcc, 0x42, 0x60, 0xdc
+};
+
+/** Element boundary: expected result */
+static const uint8_t bigint_test_4_expected[] = {
+	0xf3, 0xbe, 0x12, 0x77, 0x1a, 0xc1, 0x9c, 0x37
+};
+
+/** Short modulus: base */
+static const uint8_t bigint_test_5_base[] = {
+	0x02, 0xfc, 0x5c, 0x47, 0x12, 0xb3, 0x33, 0xf8,
+	0xd2
+};
+
+/** Short modulus: modulus */
+static const uint8_t bigint_test_5_modulus[] = {
+	0x83, 0x1c, 0xd5, 0xf4, 0xd7, 0x90, 0x95, 0xda,
+	0x9f
+};
+
+/** Short modulus: exponent */
+static const uint8_t bigint_test_5_exponent[] = {
+	0x01, 0x00, 0x01
+};
+
+/** Short modulus: expected result */
+static const uint8_t bigint_test_5_expected[] = {
+	0x22, 0x65, 0x8e, 0xb8, 0x0e, 0xb1, 0xd7, 0xd4,
+	0x1f
+};
+
+/** 1024-bit public: base */
+static const uint8_t bigint_test_6_base[] = {
+	0x81, 0x7e, 0x9f, 0x4f, 0x82, 0x1f, 0xfb, 0xee,
+	0xbb, 0xb0, 0xdc, 0x2c, 0xfc, 0xd0, 0x53, 0x17,
+	0x63, 0xed, 0xca, 0xb6, 0x16, 0x22, 0x66, 0x85,
+	0x3f, 0x19, 0xd4, 0x4e, 0x8c, 0x4b, 0x9a, 0xc5,
+	0x23, 0x51, 0x54, 0x52, 0x55, 0x8a, 0xb6, 0xd6,
+	0x1a, 0x71, 0x6d, 0x20, 0x21, 0x81, 0x76, 0x56,
+	0x76, 0xc7, 0x5d, 0x96, 0x92, 0x66, 0xe1, 0x1a,
+	0x3d, 0xb9, 0x31, 0xf9, 0xd3, 0x98, 0x97, 0xb6,
+	0x03, 0xcc, 0x81, 0x19, 0x5e, 0xa5, 0x6c, 0x12,
+	0xe0, 0xc7, 0x9a, 0x65, 0xe1, 0x9d, 0x2f, 0x96,
+	0x66, 0x90, 0x45, 0x80, 0x13, 0x66, 0x13, 0x85,
+	0xd0, 0xa9, 0xcc, 0x77, 0x1c, 0x07, 0x90, 0x64,
+	0xdc, 0x25, 0x6c, 0xaf, 0xa3, 0x04, 0xcc, 0xe6,
+	0x3e, 0x87, 0x23, 0xe3, 0x64, 0xf1, 0xc6, 0x6a,
+	0xeb, 0x5d, 0x93, 0xdf, 0x97, 0xef, 0x4f, 0xa9,
+	0x5c, 0x7e, 0x35, 0x8a, 0x4d, 0xdb, 0x5e, 0x10
+};
+
+/** 1024-bit public: modulus */
+static const uint8_t bigint_test_6_modulus[] = {
+	0xb5, 0x68, 0xba, 0x2e, 0xda, 0xe3, 0x9d, 0xb4,
+	0x38, 0x00, 0x7c, 0x87, 0xc4, 0x87, 0xa8, 0x8d,
+	0xdc, 0x1f, 0x81, 0x6f, 0x41, 0xf1, 0x38, 0x12,
+	0x6a, 0xdb, 0x84, 0x92, 0xae, 0xb2, 0x46, 0x68,
+	0xea, 0x54, 0xa4, 0xe1, 0x20, 0x1b, 0x2f, 0xf9,
+	0xde, 0x7d, 0xc5, 0x81, 0x90, 0x7c, 0x47, 0x9b,
+	0xab, 0x1e, 0xd8, 0xc2, 0x81, 0x23, 0xbe, 0x76,
+	0xe7, 0x6b, 0x04, 0x2e, 0xed, 0x5b, 0xbb, 0xab,
+	0x8b, 0x63, 0x0c, 0x2b, 0x6f, 0xf3, 0x24, 0x56,
+	0x93, 0x3c, 0xd3, 0x3b, 0xd4, 0x93, 0xb8, 0xa2,
+	0x41, 0xc8, 0xb1, 0x75, 0xd1, 0x4c, 0x65, 0xce,
+	0xda, 0xd5, 0xb7, 0x1d, 0x29, 0xef, 0x00, 0xd9,
+	0x21, 0xc5, 0xcf, 0x63, 0xf7, 0x4e, 0x8e, 0x81,
+	0x42, 0xd6, 0xb3, 0x0d, 0xfc, 0x06, 0x33, 0x58,
+	0xf1, 0x2b, 0xee, 0x71, 0x86, 0x7e, 0x2f, 0xff,
+	0x79, 0x36, 0xc9, 0x9f, 0x82, 0xc9, 0x8d, 0xed
+};
+
+/** 1024-bit public: exponent */
+static const uint8_t bigint_test_6_exponent[] = {
+	0x01, 0x00, 0x01
+};
+
+/** 1024-bit public: expected result */
+static const uint8_t bigint_test_6_expected[] = {
+	0x59, 0x14, 0xe3, 0xe2, 0x46, 0x40, 0xb0, 0xa1,
+	0x59, 0xef, 0x24, 0x17, 0x49, 0x45, 0xf5, 0x09,
+	0x46, 0x49, 0xa2, 0x31, 0x5e, 0xb3, 0x7d, 0x6d,
+	0x29, 0x49, 0x03, 0x86, 0x72, 0x3f, 0x83, 0xd4,
+	0x1a, 0x42, 0xb1, 0xb3, 0x8b, 0x2a, 0x29, 0x69,
+	0x39, 0xfd, 0x07, 0x07, 0x81, 0xf9, 0x47, 0x6b,
+	0x72, 0xdd, 0xe8, 0x7a, 0xfb, 0xcf, 0x32, 0x86,
+	0x3d, 0xff, 0x07, 0x4b, 0x68, 0xcb, 0x0d, 0xc3,
+	0xd2, 0xd1, 0xb0, 0x27, 0x24, 0xc0, 0xbb, 0xf8,
+	0x8f, 0xb6, 0xc6, 0xdc, 0x64, 0xdf, 0x5e, 0x62,
+	0xd8, 0x55, 0x46, 0x2e, 0xb0, 0x11, 0xc6, 0xdf,
+	0x71, 0x09, 0xb1, 0x87, 0xf0, 0x7a, 0xd1, 0xa0,
+	0x20, 0x5a, 0x43, 0x4e, 0xa5, 0x17, 0xa1, 0x58,
+	0x4c, 0x7b, 0x58, 0x16, 0x96, 0xc2, 0x23, 0xa7,
+	0x3a, 0x82, 0x54, 0x26, 0xf5, 0x6c, 0x87, 0x40,
+	0x99, 0x36, 0xda, 0x6d, 0xaa, 0xdd, 0x67, 0x98
+};
+
+/** 2048-bit public: base */
+static const uint8_t bigint_test_7_base[] = {
+	0x22, 0xa3, 0xa8, 0xd4, 0x43, 0x83, 0x9c, 0xb7,
+	0x6b, 0x8d, 0x16, 0xb3, 0x35, 0xd0, 0xd5, 0xd9,
+	0x77, 0x38, 0x3f, 0xbf, 0x39, 0xa1, 0x08, 0xe6,
+	0x71, 0xfb, 0x99, 0x5b, 0x50, 0xc0, 0xa2, 0xbf,
+	0x82, 0xa9, 0xd7, 0x8e, 0xd1, 0x3c, 0xaa, 0xa9,
+	0xbb, 0x1c, 0x0b, 0x49, 0x43, 0xe7, 0x79, 0x96,
+	0x3e, 0x8c, 0x3b, 0x79, 0x4f, 0xdb, 0xcc, 0x45,
+	0xce, 0x3f, 0xef, 0x73, 0x1b, 0x90, 0x29, 0x8c,
+	0xec, 0x95, 0x01, 0x07, 0x57, 0x43, 0x58, 0xa0,
+	0x3e, 0x24, 0x8d, 0x85, 0x1b, 0xb1, 0xa0, 0x66,
+	0x7b, 0x83, 0x68, 0x24, 0xf7, 0xaa, 0x12, 0x37,
+	0xc5, 0x7a, 0x4a, 0x0d, 0x8c, 0xe0, 0x6a, 0x9d,
+	0x0d, 0x48, 0xd9, 0xd8, 0x95, 0x57, 0xf4, 0xa7,
+	0x3f, 0x50, 0xcd, 0xa0, 0xce, 0x8a, 0x10, 0x5a,
+	0xe0, 0xd1, 0x2f, 0x39, 0xc3, 0x7f, 0x62, 0x81,
+	0xcb, 0xa7, 0xf0, 0xb0, 0x76, 0x00, 0xe8, 0x0a,
+	0x18, 0xc3, 0xdb, 0xe9, 0xf8, 0x33, 0x11, 0xad,
+	0xf9, 0xf3, 0xcc, 0x1d, 0x0b, 0xdf, 0xd3, 0xcf,
+	0x11, 0x04, 0xd6, 0xa8, 0x8a, 0x90, 0xd3, 0xf4,
+	0x38, 0x16, 0x8e, 0x3f, 0xb4, 0xd7, 0x8f, 0x24,
+	0x2a, 0x8c, 0xd3, 0x33, 0x8d, 0x54, 0xd1, 0x8e,
+	0xfa, 0x86, 0x9c, 0x28, 0x5a, 0xef, 0x65, 0x83,
+	0xcb, 0x41, 0x7d, 0xb4, 0x95, 0x3a, 0xd8, 0x27,
+	0xcb, 0x5b, 0x2d, 0x44, 0x51, 0xd0, 0xe6, 0xc7,
+	0xfa, 0x11, 0xd0, 0x51, 0x5c, 0x63, 0x31, 0x8d,
+	0x94, 0xba, 0x90, 0x99, 0xca, 0xa2, 0x8b, 0xa2,
+	0x21, 0x28, 0xf9, 0x1e, 0xaf, 0xb8, 0xcd, 0x54,
+	0xba, 0x6c, 0xa2, 0x0d, 0xb2, 0xde, 0x1f, 0x30,
+	0xc4, 0x46, 0xa8, 0x42, 0x26, 0x1e, 0x49, 0xe2,
+	0xaa, 0xd2, 0x4a, 0x56, 0xf0, 0x1f, 0x4a, 0xb0,
+	0x6c, 0x97, 0x4a, 0x9b, 0x09, 0x6a, 0xc0, 0x8a,
+	0xff, 0xf4, 0x57, 0x40, 0x3a, 0x63, 0xf4, 0x26
+};
+
+/** 2048-bit public: modulus */
+static const uint8_t bigint_test_7_modulus[] = {
+	0xf6, 0x3b, 0x87, 0xd0, 0xa4, 0xe8, 0x84, 0x06,
+	0x49, 0x82, 0x22, 0xda, 0xc3, 0xb9, 0xb1, 0x8a,
+	0x24, 0xdf, 0xeb, 0x27, 0x78, 0xc8, 0x9d, 0x02,
+	0x30, 0xe7, 0xa1, 0x1f, 0x50, 0x4d, 0xe5, 0xc5,
+	0x7c, 0xb6, 0xad, 0x88, 0xce, 0xdf, 0x57, 0x46,
+	0x78, 0xc5, 0xad, 0x1f, 0xbb, 0x7a, 0xa1, 0xf7,
+	0xcd, 0x72, 0x9f, 0x8c, 0xcb, 0x49, 0xcd, 0xb3,
+	0xf0, 0x4c, 0xbf, 0x07, 0x16, 0x5c, 0x43, 0xd9,
+	0x2f, 0x59, 0x4c, 0x85, 0xee, 0xa4, 0xa2, 0x93,
+	0x29, 0x0e, 0x6e, 0x54, 0xde, 0x15, 0x25, 0xbd,
+	0x81, 0x71, 0x3d, 0x14, 0xb1, 0x37, 0xb0, 0xa4,
+	0xae, 0x74, 0x66, 0x56, 0xb6, 0x56, 0x71, 0xd9,
+	0x12, 0xa1, 0x61, 0xed, 0xe0, 0xe0, 0xf2, 0x75,
+	0x99, 0x4d, 0xc3, 0x00, 0x2a, 0x7e, 0x57, 0x76,
+	0x21, 0x6c, 0x1f, 0xa5, 0xab, 0xd9, 0x0a, 0xc9,
+	0xad, 0xd2, 0x50, 0xdf, 0x5b, 0x6d, 0x7e, 0xf2,
+	0xf8, 0x62, 0x3a, 0x35, 0x4d, 0x45, 0x37, 0x59,
+	0x77, 0xac, 0x45, 0x22, 0x09, 0x6d, 0xe7, 0xdf,
+	0x3c, 0x70, 0xa6, 0x51, 0x9f, 0x82, 0xfa, 0xc9,
+	0xc3, 0x99, 0x3b, 0x02, 0xac, 0x5f, 0x65, 0x21,
+	0xa4, 0xb1, 0xa6, 0x7b, 0x57, 0x2b, 0x9c, 0x84,
+	0x4f, 0x53, 0x25, 0xa7, 0x08, 0x17, 0x0e, 0xec,
+	0x4c, 0x4e, 0x30, 0x44, 0x83, 0x57, 0xf7, 0x3b,
+	0x3b, 0xc5, 0xa1, 0x50, 0xd9, 0xbf, 0xc9, 0xbf,
+	0x75, 0x5a, 0x0e, 0x07, 0x0d, 0x29, 0xca, 0x2f,
+	0x5c, 0x26, 0xb0, 0x32, 0xd2, 0x50, 0xad, 0xfb,
+	0x05, 0xc7, 0x70, 0x79, 0x54, 0x45, 0x92, 0x6a,
+	0x4a, 0x3e, 0x0f, 0xd5, 0x69, 0xf8, 0x0b, 0x83,
+	0x9d, 0x18, 0x29, 0x3c, 0x65, 0xf9, 0x45, 0x1a,
+	0xf3, 0x24, 0xcc, 0x74, 0x62, 0xa3, 0x0d, 0x59,
+	0x46, 0x1b, 0x81, 0x5d, 0xfe, 0x0b, 0x7d, 0xb7,
+	0x03, 0xa2, 0x02, 0x01, 0x1b, 0xa2, 0x5d, 0x81
+};
+
+/** 2048-bit public: exponent */
+static const uint8_t bigint_test_7_exponent[] = {
+	0x01, 0x00, 0x01
+};
+
+/** 2048-bit public: expected result */
+static const uint8_t bigint_test_7_expected[] = {
+	0x2a, 0xf6, 0xc4, 0x2d, 0x83, 0x77, 0xe9, 0x75,
+	0x52, 0x74, 0xea, 0x17, 0x93, 0x52, 0xc8, 0x20,
+	0xcb, 0x70, 0x5e, 0x1e, 0xe5, 0x2d, 0xa8, 0x9d,
+	0x96, 0x82, 0x79, 0xe8, 0x17, 0xfd, 0xaa, 0x48,
+	0x67, 0xf9, 0xce, 0x34, 0xc6, 0x8e, 0xca, 0xf0,
+	0xb0, 0xc3, 0xde, 0x7e, 0xa7, 0xfc, 0xe2, 0xaf,
+	0xb9, 0x53, 0xdf, 0x77, 0x69, 0xd2, 0x65, 0x21,
+	0x70, 0x8e, 0xd9, 0xd6, 0x43, 0xbe, 0xa2, 0xeb,
+	0xbe, 0x03, 0x11, 0x96, 0x4a, 0x4e, 0x23, 0xcb,
+	0xb3, 0x30, 0xc7, 0xfa, 0x83, 0xe9, 0x5c, 0x5d,
+	0xbb, 0xfc, 0x1f, 0xbd, 0x8d, 0x82, 0xc1, 0x5c,
+	0xb9, 0x15, 0xbe, 0xbb, 0xf1, 0xcb, 0x2c, 0x40,
+	0xcb, 0xe9, 0x71, 0x01, 0x1f, 0x00, 0x27, 0x7b,
+	0x6a, 0x15, 0xde, 0x2d, 0x0f, 0xff, 0xf0, 0x16,
+	0xc2, 0x4e, 0x5e, 0x64, 0x61, 0xd6, 0x1f, 0x71,
+	0x9a, 0x9a, 0x5f, 0x6e, 0x40, 0x13, 0x2e, 0x89,
+	0x31, 0xb4, 0xf9, 0xa0, 0x41, 0x63, 0x35, 0xca,
+	0xe0, 0xa2, 0x20, 0xe9, 0x3d, 0x62, 0x55, 0xcc,
+	0x34, 0x0f, 0x9e, 0x11, 0x6e, 0xeb, 0xa3, 0xbf,
+	0xce, 0x73, 0x9b, 0xeb, 0xc0, 0x25, 0xf5, 0x3e,
+	0x30, 0xf2, 0xbf, 0xfb, 0x92, 0xac, 0x80, 0xbf,
+	0x35, 0x4f, 0x3a, 0xd3, 0x09, 0x5b, 0xf6, 0xa0,
+	0xa6, 0xba, 0x2d, 0xcb, 0xae, 0x41, 0xbc, 0x32,
+	0x27, 0xc7, 0xe7, 0xa3, 0x9a, 0x56, 0xed, 0x68,
+	0x40, 0xed, 0x70, 0x8a, 0xba, 0x5d, 0xa4, 0x31,
+	0xd4, 0x87, 0xc9, 0x48, 0xd7, 0xcd, 0xe4, 0x2a,
+	0xa8, 0xba, 0x05, 0xf6, 0x83, 0x12, 0x5c, 0xd6,
+	0x9c, 0xc5, 0x81, 0x84, 0xed, 0x8b, 0x86, 0x2b,
+	0x52, 0x38, 0x14, 0x5f, 0x9c, 0x99, 0x32, 0xa7,
+	0xa0, 0xe5, 0x92, 0x56, 0x0b, 0x52, 0x01, 0x90,
+	0x09, 0x5a, 0x01, 0x71, 0x6a, 0xfe, 0xaf, 0xa5,
+	0x07, 0x63, 0x2a, 0xb4, 0x80, 0x41, 0xa1, 0x6c
+};
+
+/** 4096-bit public: base */
+static const uint8_t bigint_test_8_base[] = {
+	0x94, 0x7f, 0x37, 0xda, 0xbc, 0xa1, 0x03, 0x71,
+	0x28, 0x30, 0x09, 0xb1, 0x34, 0xa9, 0xed, 0xec,
+	0x12, 0xd1, 0x8c, 0x4e, 0xbc, 0x98, 0xd8, 0x95,
+	0xe8, 0x43, 0x66, 0x90, 0x1c, 0xc3, 0x69, 0xc1,
+	0xf4, 0x53, 0xca, 0x72, 0x05, 0x7a, 0x5b, 0x13,
+	0xa4, 0xef, 0x45, 0x8a, 0x93, 0x06, 0xbf, 0xb4,
+	0x6d, 0xe1, 0xbe, 0x34, 0x69, 0xbb, 0x67, 0xe7,
+	0x58, 0x97, 0xcc, 0x3c, 0x75, 0x83, 0x01, 0x18,
+	0x41, 0x68, 0x7d, 0xb3, 0xb5, 0x3d, 0xc8, 0x05,
+	0x06, 0xfc, 0x91, 0xd8, 0x98, 0x84, 0x9d, 0xd0,
+	0x5f, 0xc1, 0x85, 0xa9, 0x69, 0xcc, 0x87, 0x95,
+	0xe9, 0xdb, 0x7e, 0x4f, 0x04, 0x42, 0x21, 0xf8,
+	0x11, 0xa8, 0x13, 0x34, 0xf1, 0x33, 0x2f, 0xe2,
+	0x12, 0xc0, 0x99, 0x0b, 0x2c, 0x3e, 0x1f, 0x51,
+	0xac, 0x9a, 0x79, 0x08, 0xaa, 0x51, 0x99, 0x65,
+	0x70, 0xf9, 0x71, 0x7e, 0x62, 0x70, 0x26, 0x15,
+	0x38, 0xbe, 0x7a, 0x83, 0x85, 0x64, 0xf7, 0x5a,
+	0xaa, 0x8c, 0x56, 0xde, 0xac, 0xd6, 0x90, 0x8b,
+	0xb8, 0x42, 0x97, 0x00, 0x40, 0x5e, 0xee, 0x84,
+	0x11, 0x69, 0xc6, 0xbc, 0x17, 0xab, 0xa0, 0x6c,
+	0xa7, 0x89, 0x77, 0x6f, 0x2e, 0xfa, 0x40, 0x8f,
+	0xb8, 0x8a, 0xdd, 0x8c, 0xeb, 0xf9, 0x30, 0x2b,
+	0x45, 0xa9, 0x9f, 0x57, 0x71, 0x22, 0xa2, 0x0a,
+	0x96, 0x2f, 0xb0, 0x67, 0x92, 0x74, 0xfc, 0x01,
+	0x93, 0x3c, 0x8a, 0xc8, 0xaf, 0x1e, 0x5f, 0xf6,
+	0xbb, 0x14, 0x0b, 0xd2, 0x8e, 0x66, 0x80, 0x90,
+	0xef, 0xa4, 0xfc, 0x7d, 0xf7, 0x92, 0xe5, 0x1a,
+	0x87, 0x2e, 0xd6, 0x6e, 0xac, 0xa1, 0xbc, 0x35,
+	0x1b, 0x88, 0x76, 0x25, 0x46, 0x5b, 0xf3, 0x7a,
+	0xc1, 0xdb, 0x59, 0x3c, 0xbf, 0x04, 0x16, 0xfc,
+	0x3c, 0x43, 0x19, 0xf8, 0xca, 0xf5, 0xe8, 0xcb,
+	0xe2, 0xec, 0x9f, 0x56, 0xcc, 0xdf, 0x4c, 0xf1,
+	0x2a, 0x35, 0x2c, 0x59, 0xdc, 0xbe, 0xc5, 0x70,
+	0x64, 0x2e, 0x19, 0xce, 0x12, 0x6d, 0x3d, 0x3d,
+	0x57, 0x52, 0x24, 0x43, 0xc5, 0x3b, 0x54, 0xe2,
+	0x4d, 0x62, 0xc4, 0xcf, 0x0f, 0x1d, 0x0b, 0xa0,
+	0x30, 0x35, 0xe5, 0xa1, 0x22, 0x86, 0xa0, 0xda,
+	0x84, 0xa5, 0x1e, 0x1b, 0xe9, 0x3b, 0x25, 0xa7,
+	0x03, 0x71, 0x6d, 0xf2, 0x14, 0x5b, 0xc6, 0x7a,
+	0x2e, 0x26, 0x7f, 0xdf, 0x59, 0x24, 0x89, 0x38,
+	0xe5, 0x73, 0x23, 0xd8, 0xc5, 0x12, 0x75, 0x53,
+	0x78, 0xf9, 0x6c, 0x6f, 0xb2, 0xf9, 0x5d, 0x44,
+	0x06, 0x23, 0xa8, 0x99, 0x95, 0x83, 0xcb, 0xfb,
+	0x94, 0x38, 0x5f, 0x53, 0xad, 0x0f, 0x2d, 0x7f,
+	0x6d, 0x08, 0xfc, 0x4f, 0xfc, 0x5d, 0x13, 0xd8,
+	0x5b, 0xe1, 0x75, 0x40, 0xae, 0x03, 0x34, 0x45,
+	0x0c, 0xbb, 0x99, 0x82, 0x4c, 0x05, 0x93, 0xfc,
+	0xc7, 0xe6, 0x5f, 0xb3, 0x59, 0x44, 0x71, 0x9f,
+	0xc3, 0x9c, 0x87, 0xcb, 0x04, 0xee, 0x4f, 0x5a,
+	0x6f, 0x2f, 0x22, 0x8d, 0x03, 0x57, 0x3f, 0xdc,
+	0xaf, 0x5e, 0x4e, 0xea, 0x4f, 0x9c, 0x1b, 0xeb,
+	0xfb, 0xaf, 0xcd, 0x8a, 0xe9, 0xdb, 0x0f, 0x92,
+	0x8c, 0x2a, 0xe1, 0xd8, 0x1d, 0x57, 0xe1, 0x47,
+	0xab, 0x37, 0x42, 0xe9, 0x5a, 0xe2, 0x16, 0x65,
+	0xac, 0x12, 0xdc, 0xbd, 0x17, 0xaa, 0xfd, 0x6a,
+	0x57, 0xea, 0x63, 0xab, 0x80, 0x83, 0x3d, 0x20,
+	0xd9, 0x0f, 0xf4, 0x8a, 0x6d, 0x30, 0x41, 0x3c,
+	0xbb, 0x6a, 0x44, 0x9f, 0x35, 0x4d, 0x6d, 0x13,
+	0xf0, 0x8c, 0x89, 0x07, 0xe2, 0x51, 0x13, 0x20,
+	0x14, 0x69, 0x28, 0x64, 0xde, 0x85, 0x68, 0xd0,
+	0x35, 0x1b, 0x8f, 0xbf, 0x6f, 0xac, 0x60, 0xb0,
+	0xd1, 0x9d, 0xdc, 0xab, 0x8b, 0x4d, 0x09, 0xa2,
+	0xdf, 0x8f, 0xcf, 0x3a, 0x99, 0x7c, 0x8f, 0xd9,
+	0x10, 0xd6, 0xc9, 0xd1, 0x5b, 0xb2, 0x71, 0x7e
+};
+
+/** 4096-bit public: modulus */
+static const uint8_t bigint_test_8_modulus[] = {
+	0xc3, 0x59, 0xdb, 0x67, 0xda, 0x84, 0x5f, 0x9c,
+	0x90, 0x1d, 0x47, 0xfc, 0x35, 0xa1, 0x63, 0x14,
+	0x94, 0x9f, 0xf6, 0x75, 0xe1, 0xdf, 0x6f, 0x0b,
+	0xc0, 0x6d, 0x47, 0xa7, 0x3b, 0x9f, 0x9d, 0xf2,
+	0xb9, 0x23, 0xef, 0xc9, 0xd9, 0xbc, 0x31, 0x87,
+	0x22, 0x0f, 0x3c, 0x69, 0xeb, 0x3b, 0xe2, 0x9c,
+	0x83, 0xbc, 0xab, 0xaa, 0xe1, 0xf7, 0x8a, 0x66,
+	0x41, 0x5c, 0x43, 0x28, 0xd8, 0xd3, 0x66, 0x87,
+	0xe2, 0x42, 0x94, 0x2e, 0x39, 0x69, 0x61, 0xa4,
+	0x6f, 0x66, 0xc3, 0xa2, 0x96, 0xe1, 0xb7, 0x45,
+	0x09, 0x98, 0x78, 0xf8, 0xbc, 0x21, 0x70, 0xb1,
+	0xcb, 0x65, 0x78, 0x45, 0xab, 0x20, 0x43, 0xae,
+	0x47, 0xdc, 0x1a, 0xb6, 0x20, 0x11, 0x6f, 0x95,
+	0x3f, 0x23, 0xb1, 0xb4, 0x3c, 0x6c, 0x61, 0x78,
+	0x66, 0x7d, 0x6d, 0xce, 0xb8, 0x25, 0xd4, 0xeb,
+	0x41, 0x61, 0x73, 0xb6, 0xe8, 0x24, 0x01, 0x68,
+	0xb3, 0x14, 0xc8, 0x5d, 0x27, 0xc2, 0xf7, 0xbd,
+	0x84, 0xa0, 0xec, 0xe6, 0xac, 0x49, 0x66, 0x3c,
+	0x36, 0x28, 0x57, 0x99, 0x83, 0x99, 0x73, 0x17,
+	0x2f, 0xa7, 0xc4, 0x09, 0x89, 0x61, 0x72, 0xc1,
+	0x62, 0x01, 0x70, 0x70, 0x02, 0x94, 0xad, 0x3c,
+	0xe7, 0x74, 0xf9, 0xce, 0x92, 0xed, 0x0c, 0xa6,
+	0xf1, 0x1d, 0xc8, 0x6b, 0x3e, 0xe3, 0x38, 0xb6,
+	0x87, 0x88, 0x27, 0x9b, 0x18, 0xd7, 0xd5, 0x3a,
+	0x39, 0x95, 0xcc, 0x30, 0xd1, 0x19, 0x29, 0x60,
+	0x02, 0x39, 0x6e, 0x04, 0xc2, 0x48, 0x6f, 0xfe,
+	0x46, 0x39, 0x5c, 0xa0, 0x0c, 0xe9, 0x31, 0xb7,
+	0xe9, 0x08, 0x12, 0x0f, 0x67, 0x1d, 0x2a, 0xc0,
+	0xd5, 0x3c, 0x21, 0xf6, 0xcb, 0xb0, 0x12, 0xe1,
+	0x30, 0xa6, 0xd3, 0x19, 0x2b, 0x5a, 0x5f, 0xcc,
+	0x91, 0xb6, 0xd4, 0xc6, 0x4b, 0x9e, 0x11, 0x16,
+	0xf7, 0xf8, 0x4b, 0x1d, 0xff, 0xb5, 0x9f, 0xa4,
+	0x87, 0xbd, 0x01, 0x4e, 0x3c, 0x56, 0x33, 0x81,
+	0x66, 0x91, 0x60, 0x0a, 0x9b, 0x45, 0x58, 0x32,
+	0x70, 0x18, 0xa1, 0x23, 0x02, 0x63, 0x42, 0x16,
+	0xe8, 0x23, 0x17, 0x61, 0x76, 0x63, 0x71, 0xfb,
+	0x27, 0xe5, 0x5f, 0x2b, 0x08, 0xb1, 0xa9, 0x92,
+	0xef, 0xca, 0x8e, 0x22, 0x5c, 0xcd, 0x6c, 0x6a,
+	0xa4, 0xe0, 0x23, 0xf4, 0xee, 0xc3, 0xfb, 0xb6,
+	0xa2, 0x6b, 0x03, 0x09, 0xe2, 0xaf, 0x79, 0x9f,
+	0x46, 0xe3, 0x54, 0xe7, 0x9f, 0x15, 0x36, 0xa2,
+	0x53, 0x2f, 0x05, 0x0d, 0x45, 0xcf, 0xfa, 0x1b,
+	0x4d, 0xe8, 0xc5, 0xe6, 0x0a, 0x61, 0x44, 0xa7,
+	0xf3, 0x82, 0xe7, 0x2b, 0x94, 0xdf, 0x6f, 0xff,
+	0x6f, 0x9c, 0x4b, 0xb3, 0xe4, 0xca, 0x15, 0x7c,
+	0x56, 0x41, 0x01, 0x41, 0x58, 0xa4, 0xcf, 0x8c,
+	0x6c, 0xd1, 0xdf, 0x87, 0x01, 0xca, 0xeb, 0x8c,
+	0xaf, 0x83, 0xca, 0xd1, 0x61, 0x75, 0x72, 0x31,
+	0x01, 0xbb, 0x45, 0x24, 0xd3, 0x1d, 0x97, 0xb6,
+	0x9c, 0x83, 0x14, 0xa2, 0xe7, 0x76, 0x2f, 0x59,
+	0xa1, 0xc3, 0x04, 0xf9, 0x2b, 0xf4, 0x65, 0x42,
+	0x1d, 0x0e, 0xea, 0x5f, 0x5d, 0x5c, 0x84, 0xf6,
+	0x43, 0xa8, 0x10, 0xd4, 0x4e, 0x37, 0xa6, 0xfc,
+	0x06, 0x55, 0xf8, 0xaf, 0x98, 0x8d, 0xdb, 0x28,
+	0xf3, 0x1d, 0xba, 0x99, 0xf6, 0x35, 0xed, 0x8a,
+	0xfa, 0xc4, 0xd3, 0x53, 0xf5, 0x73, 0x82, 0xe1,
+	0x75, 0xf3, 0x72, 0xf7, 0xe4, 0x46, 0x96, 0xef,
+	0x6a, 0xfe, 0x10, 0x55, 0x55, 0x7d, 0x69, 0x46,
+	0x56, 0x06, 0xb0, 0x78, 0x11, 0xc1, 0xb5, 0xb3,
+	0xbd, 0xf6, 0xc5, 0x62, 0xbb, 0x51, 0x2e, 0xd9,
+	0x8b, 0xdb, 0x71, 0x89, 0x9b, 0x14, 0x7d, 0x8d,
+	0xd5, 0x60, 0x26, 0xbf, 0xae, 0xd1, 0x35, 0x09,
+	0x89, 0xc8, 0x42, 0xc5, 0x36, 0x92, 0xf4, 0xaa,
+	0xed, 0x48, 0x65, 0x58, 0x9c, 0xf2, 0x5f, 0x97
+};
+
+/** 4096-bit public: exponent */
+static const uint8_t bigint_test_8_exponent[] = {
+	0x01, 0x00, 0x01
+};
+
+/** 4096-bit public: expected result */
+static const uint8_t bigint_test_8_expected[] = {
+	0x9f, 0x66, 0x8f, 0x08, 0xa7, 0x43, 0xaa, 0x94,
+	0xc7, 0x9f, 0x52, 0xa3, 0x64, 0x71, 0x1b, 0xf7,
+	0x65, 0x10, 0x66, 0x7b, 0x2e, 0xa3, 0x79, 0xaf,
+	0x03, 0xf3, 0x56, 0xa6, 0x46, 0x23, 0x80, 0x74,
+	0x87, 0x4e, 0x0c, 0x80, 0x37, 0x1f, 0xee, 0x97,
+	0xf7, 0x3f, 0x4b, 0x84, 0xc4, 0x9f, 0x7d, 0x11,
+	0xb2, 0xaa, 0x9a, 0xc2, 0x84, 0xe4, 0x05, 0x7b,
+	0xc8, 0x5e, 0xd4, 0xc8, 0xb4, 0xf0, 0x3d, 0xa8,
+	0x0d, 0x0a, 0xb6, 0x27, 0x7c, 0x9c, 0xff, 0xdf,
+	0x0e, 0xbb, 0xd3, 0x78, 0xc6, 0x76, 0xa6, 0x28,
+	0x2e, 0x85, 0xbf, 0x70, 0xca, 0xed, 0x5e, 0x44,
+	0xb3, 0x62, 0xc1, 0x51, 0x89, 0x72, 0xea, 0xc6,
+	0x28, 0x0f, 0x2e, 0xb8, 0x92, 0x47, 0x04, 0x26,
+	0x20, 0xbd, 0x29, 0xcd, 0x24, 0xc6, 0xbd, 0xc5,
+	0xbb, 0x97, 0x24, 0xf0, 0xb5, 0xbd, 0xd9, 0xa4,
+	0xb2, 0x7c, 0xa0, 0x6e, 0x96, 0x9c, 0xd7, 0x71,
+	0x21, 0x4b, 0xd7, 0x95, 0x2a, 0xd0, 0x15, 0xd2,
+	0xcd, 0x8f, 0x5c, 0x92, 0xb1, 0x9d, 0xec, 0x79,
+	0x7a, 0x51, 0x77, 0x14, 0xbd, 0x9a, 0xc1, 0xf0,
+	0x24, 0x65, 0xe2, 0x0b, 0x4b, 0x2d, 0x21, 0x44,
+	0x22, 0xb6, 0x8c, 0x83, 0x98, 0x98, 0xc7, 0x63,
+	0x1e, 0xac, 0x0a, 0x7a, 0xc9, 0xcd, 0x81, 0x43,
+	0x83, 0xbe, 0xdc, 0xe4, 0xcc, 0xde, 0x1b, 0x74,
+	0xc1, 0x98, 0xdd, 0xfe, 0x1b, 0xab, 0x59, 0x35,
+	0x2a, 0x19, 0xe2, 0xe3, 0x98, 0x5b, 0x92, 0xdc,
+	0x79, 0xde, 0x62, 0xd8, 0x97, 0xec, 0xa9, 0x4d,
+	0x87, 0x3b, 0xa2, 0x9a, 0xf1, 0xcd, 0x29, 0x03,
+	0x65, 0x50, 0x2d, 0xe0, 0xe3, 0x82, 0x6e, 0x52,
+	0xba, 0x42, 0x91, 0xa7, 0x95, 0x35, 0x56, 0xde,
+	0x17, 0x36, 0xbb, 0xca, 0xc6, 0xe6, 0x19, 0x92,
+	0x77, 0xff, 0x2d, 0x74, 0x4b, 0x1e, 0x69, 0xdd,
+	0xa4, 0x4a, 0x6c, 0x40, 0xf8, 0x51, 0x57, 0xd1,
+	0x98, 0x95, 0xa5, 0x1a, 0xcb, 0x9b, 0xdd, 0x39,
+	0x42, 0x57, 0x49, 0xe6, 0x18, 0x6b, 0x12, 0x27,
+	0x14, 0x1a, 0xd8, 0x9c, 0x11, 0x78, 0x67, 0x65,
+	0xdb, 0x57, 0x96, 0x2e, 0xe2, 0xd5, 0x34, 0xe8,
+	0x09, 0x11, 0x07, 0xde, 0x8d, 0x6d, 0x10, 0xd9,
+	0x04, 0x6d, 0xe6, 0xab, 0x4a, 0x1e, 0x03, 0x8c,
+	0x8a, 0x7a, 0x18, 0xd0, 0x13, 0x57, 0x95, 0x47,
+	0x6e, 0xd4, 0xa7, 0xb9, 0x2f, 0x4f, 0xd0, 0x0b,
+	0x97, 0xb7, 0xc1, 0xc7, 0x9e, 0xa0, 0x15, 0x78,
+	0x18, 0x46, 0xf2, 0x9f, 0x56, 0xe2, 0x5c, 0xa9,
+	0x7a, 0xe9, 0xfa, 0xa9, 0xb6, 0xba, 0x6f, 0xe9,
+	0x3a, 0x27, 0x58, 0x9c, 0x05, 0x7d, 0xee, 0x0c,
+	0x85, 0x0e, 0x89, 0x22, 0xbb, 0x7a, 0xc9, 0x45,
+	0x6f, 0x64, 0x72, 0xac, 0xf7, 0x31, 0x45, 0xb0,
+	0xc1, 0x7a, 0x69, 0x4c, 0x5d, 0x7a, 0xe1, 0x09,
+	0xad, 0xcb, 0xb4, 0x6f, 0xb6, 0xa4, 0xcd, 0xd9,
+	0xc5, 0x34, 0xc9, 0x52, 0x1d, 0x84, 0xc3, 0x6f,
+	0x9d, 0xe2, 0xd6, 0x74, 0x8c, 0xb5, 0xcd, 0x68,
+	0x30, 0x47, 0x11, 0x56, 0xc3, 0x6b, 0xbb, 0x53,
+	0x62, 0xe6, 0x40, 0x13, 0xe1, 0x83, 0xcc, 0xf6,
+	0xdc, 0x41, 0xb5, 0xb7, 0xcb, 0xa1, 0x46, 0x65,
+	0x96, 0x68, 0xf6, 0x9b, 0x27, 0x53, 0x72, 0x19,
+	0xf5, 0xe0, 0x47, 0xc3, 0xfe, 0x30, 0xd3, 0xa1,
+	0xf2, 0xce, 0x78, 0xc4, 0x00, 0xa4, 0x66, 0xfe,
+	0x70, 0x5b, 0xb3, 0xd3, 0x72, 0x51, 0x21, 0xce,
+	0x4c, 0x3c, 0x6f, 0xea, 0x90, 0xc4, 0xa2, 0x16,
+	0x6f, 0xf0, 0xd3, 0x03, 0x67, 0x9f, 0x9c, 0x92,
+	0x5c, 0x6f, 0xd5, 0x59, 0xfd, 0x70, 0x5c, 0xec,
+	0x20, 0xa2, 0x72, 0x5a, 0x2d, 0xe8, 0x88, 0xb1,
+	0x34, 0x11, 0x6a, 0x50, 0xed, 0xb1, 0xe9, 0xff,
+	0x17, 0x04, 0x3e, 0x22, 0xc4, 0xe2, 0xc2, 0x90,
+	0x37, 0x1e, 0xa8, 0xa5, 0x5a, 0x41, 0xe0, 0xdc
+};
+
+/** 1024-bit full exponent: base */
+static const uint8_t bigint_test_9_base[] = {
+	0xd4, 0x44, 0x68, 0xbd, 0x01, 0x00, 0x30, 0x05,
+	0xa9, 0xc5, 0x9b, 0xb8, 0x6a, 0x49, 0xcb, 0xc6,
+	0x55, 0x31, 0x0c, 0x51, 0xce, 0xee, 0xac, 0x95,
+	0x6f, 0x71, 0x9c, 0x00, 0x25, 0xdb, 0x59, 0x13,
+	0x06, 0xa0, 0x7e, 0x96, 0xb6, 0x3c, 0x4a, 0x8d,
+	0x24, 0xfa, 0x39, 0xa1, 0x4b, 0x6c, 0xcc, 0x69,
+	0x11, 0x16, 0x9c, 0xdf, 0x61, 0x61, 0x45, 0xe5,
+	0x3f, 0x9b, 0x00, 0x1e, 0x4c, 0xdf, 0xe1, 0x8a,
+	0xcd, 0x71, 0x92, 0x1c, 0xd0, 0xcd, 0xb8, 0xab,
+	0x0f, 0x83, 0xac, 0x95, 0x3d, 0x52, 0x52, 0xd4,
+	0x69, 0x3d, 0xc5, 0xbb, 0xf6, 0x30, 0x00, 0xb1,
+	0xe0, 0x70, 0x92, 0x16, 0x53, 0xd1, 0x17, 0xd2,
+	0x45, 0x0b, 0xb2, 0xea, 0xcf, 0x04, 0x9f, 0xa7,
+	0x23, 0xec, 0x49, 0xd9, 0x63, 0xf7, 0xe8, 0x5d,
+	0x6c, 0x02, 0x9c, 0xc3, 0x42, 0x5e, 0xeb, 0x5b,
+	0x3f, 0x58, 0xfd, 0x4b, 0xdf, 0x73, 0x2b, 0x97
+};
+
+/** 1024-bit full exponent: modulus */
+static const uint8_t bigint_test_9_modulus[] = {
+	0xfb, 0xd3, 0x67, 0xbb, 0x51, 0x6d, 0xde, 0xc7,
+	0xef, 0x4b, 0x8c, 0xa5, 0x8d, 0xc5, 0x15, 0xa4,
+	0x34, 0x13, 0xff, 0x08, 0xfc, 0x67, 0x8e, 0x52,
+	0x02, 0xe2, 0x3b, 0x68, 0x65, 0xe2, 0x9a, 0x3c,
+	0x3e, 0xff, 0x70, 0xc7, 0xa0, 0xac, 0x9d, 0xb5,
+	0x27, 0xa8, 0xa7, 0x99, 0xec, 0x70, 0x9f, 0x80,
+	0xb0, 0x85, 0x41, 0xac, 0xc3, 0xf9, 0xff, 0x73,
+	0xfe, 0x5d, 0xd9, 0x15, 0xc0, 0xf7, 0x34, 0x19,
+	0x29, 0xd5, 0xff, 0xad, 0xf5, 0x80, 0x12, 0x63,
+	0xf4, 0x40, 0x97, 0x46, 0x39, 0xfa, 0xbb, 0xf8,
+	0x66, 0x39, 0xa8, 0x22, 0xca, 0x5e, 0x85, 0x35,
+	0xf8, 0x56, 0x32, 0x7e, 0x0b, 0x2a, 0xee, 0xb4,
+	0x41, 0x8a, 0xe2, 0x1f, 0x7a, 0x14, 0x7a, 0x95,
+	0x74, 0x0a, 0x1f, 0xed, 0xe9, 0x45, 0x8c, 0x86,
+	0x6a, 0x4c, 0xe2, 0x81, 0xee, 0x64, 0xd6, 0x55,
+	0x8c, 0xaf, 0x3a, 0xe0, 0x2e, 0x8a, 0x8a, 0x21
+};
+
+/** 1024-bit full exponent: exponent */
+static const uint8_t bigint_test_9_exponent[] = {
+	0xbf, 0xa4, 0xff, 0xef, 0x47, 0xd3, 0x96, 0x9f,
+	0x2d, 0x3f, 0xe0, 0xaf, 0x81, 0xa5, 0xd2, 0x9a,
+	0x62, 0x27, 0xf6, 0x59, 0x22, 0x81, 0xe0, 0x95,
+	0xf7, 0x59, 0xf6, 0x8a, 0x04, 0x07, 0x34, 0xb5,
+	0xe5, 0x11, 0x4d, 0xa1, 0xac, 0xb3, 0xa3, 0x88,
+	0xa1, 0x14, 0xff, 0x7c, 0x3d, 0xc0, 0xd6, 0x66,
+	0xd6, 0xe9, 0xee, 0x97, 0xd5, 0x0d, 0x70, 0x1d,
+	0x0f, 0xea, 0xbc, 0x95, 0xfa, 0xe9, 0xaa, 0x4f,
+	0x0a, 0xb2, 0x0d, 0xea, 0x6c, 0x4a, 0x7d, 0xa2,
+	0x50, 0x72, 0x46, 0xa2, 0xd5, 0x8d, 0x95, 0x38,
+	0xf5, 0xe2, 0x11, 0x99, 0xe4, 0x15, 0xde, 0xc9,
+	0x64, 0x6d, 0xfa, 0x4f, 0x1b, 0x9a, 0x86, 0xed,
+	0x3f, 0x41, 0x6b, 0x1b, 0xaf, 0x12, 0x01, 0xc2,
+	0x30, 0x27, 0x03, 0x9b, 0x5a, 0x24, 0x2a, 0xfa,
+	0x80, 0xf2, 0x05, 0x9e, 0xb2, 0xc2, 0xd8, 0xb8,
+	0xa6, 0x8a, 0x3b, 0xab, 0x83, 0x63, 0xe2, 0x88
+};
+
+/** 1024-bit full exponent: expected result */
+static const uint8_t bigint_test_9_expected[] = {
+	0xa8, 0xd1, 0xe9, 0x4b, 0x35, 0xf7, 0x00, 0x69,
+	0xab, 0xa0, 0x72, 0xf7, 0x59, 0x35, 0x61, 0x4a,
+	0x08, 0x99, 0xc3, 0x5a, 0xd6, 0xe3, 0x0b, 0xbb,
+	0x8c, 0x3b, 0x4f, 0x58, 0xdf, 0x90, 0xcc, 0x05,
+	0xb5, 0x1a, 0x76, 0x8b, 0x03, 0xcd, 0x61, 0xf7,
+	0xd6, 0x02, 0x4b, 0xa0, 0xf0, 0x0c, 0x61, 0x82,
+	0xef, 0x28, 0xbd, 0x8a, 0x77, 0xb8, 0x85, 0x70,
+	0xeb, 0xf9, 0x7f, 0xb0, 0x1d, 0xa5, 0x9e, 0x3b,
+	0x1e, 0x8c, 0x88, 0xd4, 0x3c, 0xe1, 0x04, 0xe0,
+	0xce, 0x55, 0xeb, 0x7e, 0x96, 0x32, 0xb2, 0x9e,
+	0x42, 0x94, 0x4d, 0x4e, 0x17, 0x5a, 0x50, 0x0e,
+	0xee, 0xde, 0x3f, 0x6c, 0x98, 0x0e, 0x23, 0xdc,
+	0x08, 0x62, 0x0c, 0xa2, 0x7a, 0xa8, 0xbd, 0xcb,
+	0xdb, 0xfa, 0x52, 0x38, 0x00, 0x07, 0x48, 0xfb,
+	0xef, 0x67, 0x4d, 0x99, 0xc7, 0x0c, 0x13, 0x08,
+	0x6e, 0xac, 0x23, 0xdb, 0x48, 0xff, 0x40, 0x5b
+};
+
+/** Modular exponentiation tests */
+static struct bigint_test bigint_tests[] = {
+	BIGINT_TEST ( "Single byte", bigint_test_0 ),
+	BIGINT_TEST ( "Zero exponent", bigint_test_1 ),
+	BIGINT_TEST ( "Zero base", bigint_test_2 ),
+	BIGINT_TEST ( "Leading zeros", bigint_test_3 ),
+	BIGINT_TEST ( "Element boundary", bigint_test_4 ),
+	BIGINT_TEST ( "Short modulus", bigint_test_5 ),
+	BIGINT_TEST ( "1024-bit public", bigint_test_6 ),
+	BIGINT_TEST ( "2048-bit public", bigint_test_7 ),
+	BIGINT_TEST ( "4096-bit public", bigint_test_8 ),
+	BIGINT_TEST ( "1024-bit full exponent", bigint_test_9 ),
+};
+
+/** RSA test key: modulus */
+static const uint8_t rsa_test_modulus[] = {
+	0x00, 0xd0, 0x3c, 0xf1, 0x20, 0xb0, 0x99, 0x7f,
+	0xae, 0x0e, 0x21, 0x4c, 0x19, 0x2a, 0x95, 0x8b,
+	0x49, 0x66, 0xcb, 0x4a, 0x72, 0x24, 0xd0, 0x12,
+	0x9a, 0x62, 0xb4, 0x5e, 0x8a, 0x60, 0x54, 0x7a,
+	0x06, 0x84, 0xaf, 0x5b, 0xae, 0xac, 0xe9, 0xe9,
+	0x25, 0x4e, 0x48, 0x15, 0xdf, 0x16, 0x8d, 0x9c,
+	0x41, 0x4c, 0xed, 0x12, 0x06, 0xa9, 0x59, 0xed,
+	0x1d, 0x0d, 0x59, 0x05, 0x99, 0x8f, 0x43, 0xa6,
+	0x49, 0xd5, 0x37, 0x10, 0x72, 0x73, 0x5e, 0x3a,
+	0x5c, 0x2d, 0x9e, 0xbb, 0x47, 0xbe, 0x15, 0x9a,
+	0x84, 0x63, 0x8b, 0x6f, 0xf0, 0xac, 0x08, 0xec,
+	0x99, 0xf4, 0xa2, 0x6a, 0xea, 0x88, 0x51, 0x51,
+	0xd3, 0xef, 0x7c, 0x7f, 0x4d, 0xf2, 0x3d, 0x59,
+	0xbd, 0x72, 0xab, 0x16, 0x36, 0x70, 0xe7, 0xf4,
+	0x42, 0xd8, 0x10, 0x4d, 0x19, 0x4f, 0xf4, 0x59,
+	0x1f, 0x9e, 0x53, 0x9d, 0xcb, 0x0e, 0x7f, 0x58,
+	0xa5
+};
+
+/** RSA test key: public exponent */
+static const uint8_t rsa_test_exponent[] = {
+	0x01, 0x00, 0x01
+};
+
+/** RSA test key: private exponent */
+static const uint8_t rsa_test_private_exponent[] = {
+	0xb5, 0x90, 0x4d, 0x56, 0x09, 0x64, 0xed, 0x34,
+	0x9f, 0xd1, 0x5c, 0x7e, 0x9c, 0xe8, 0xa2, 0xf7,
+	0xaf, 0x0f, 0x15, 0xac, 0x0c, 0x78, 0xf7, 0x9f,
+	0x70, 0xec, 0x7f, 0x79, 0xfb, 0x9f, 0xec, 0x7d,
+	0x7e, 0x77, 0x3f, 0x63, 0x40, 0x14, 0xfb, 0x59,
+	0xb1, 0xb5, 0x9c, 0x8c, 0x55, 0x27, 0xc7, 0xd4,
+	0x0f, 0xf4, 0xac, 0xc0, 0xee, 0x2c, 0x20, 0x58,
+	0x32, 0x69, 0x2a, 0x3e, 0xc7, 0xf1, 0x5e, 0x2c,
+	0x73, 0x6d, 0xa9, 0x0a, 0x30, 0xc4, 0xaf, 0x86,
+	0xbc, 0x72, 0xa9, 0xc1, 0xd1, 0x29, 0x3e, 0xc7,
+	0x0f, 0xb9, 0x9b, 0x30, 0xe7, 0xdf, 0x20, 0x91,
+	0x36, 0x3c, 0x8a, 0xb1, 0x1d, 0x9d, 0xb0, 0x7b,
+	0xf8, 0x35, 0x0c, 0x5c, 0xe9, 0xa2, 0x35, 0xf1,
+	0x71, 0x2d, 0x1d, 0x62, 0xff, 0x17, 0x6b, 0xf4,
+	0x72, 0xab, 0x73, 0x6f, 0xb8, 0x7d, 0x62, 0x92,
+	0x82, 0x07, 0x36, 0x8e, 0x3a, 0x33, 0x5b, 0x09
+};
+
+/** RSA test plaintext (a TLS pre-master secret) */
+static const uint8_t rsa_test_plaintext[48] = {
+	0x03, 0x01, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a,
+	0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a,
+	0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a,
+	0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a,
+	0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a,
+	0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a, 0x5a,
+};
+
+/** Big integer test working storage */
+static struct {
+	/** Base */
+	bigint_element_t base[BIGINT_TEST_MAX_SIZE];
+	/** Modulus */
+	bigint_element_t modulus[BIGINT_TEST_MAX_SIZE];
+	/** Exponent */
+	bigint_element_t exponent[BIGINT_TEST_MAX_SIZE];
+	/** Result */
+	bigint_element_t result[BIGINT_TEST_MAX_SIZE];
+	/** Temporary working space */
+	uint8_t tmp[ bigint_mod_exp_tmp_len_raw ( BIGINT_TEST_MAX_SIZE ) ];
+	/** Raw output buffer */
+	uint8_t out[RSA_MAX_LEN];
+} bigint_test_work;
+
+/**
+ * Perform modular exponentiation on raw data
+ *
+ * @v base		Base
+ * @v base_len		Length of base
+ * @v modulus		Modulus
+ * @v modulus_len	Length of modulus
+ * @v exponent		Exponent
+ * @v exponent_len	Length of exponent
+ * @v out		Output buffer
+ * @v out_len		Length of output buffer
+ */
+static void bigint_test_mod_exp ( const void *base, size_t base_len,
+				  const void *modulus, size_t modulus_len,
+				  const void *exponent, size_t exponent_len,
+				  void *out, size_t out_len ) {
+	unsigned int size = bigint_required_size ( modulus_len );
+	unsigned int exponent_size = bigint_required_size ( exponent_len );
+	bigint_t ( size ) *base_bi = ( ( void * ) bigint_test_work.base );
+	bigint_t ( size ) *modulus_bi =
+		( ( void * ) bigint_test_work.modulus );
+	bigint_t ( exponent_size ) *exponent_bi =
+		( ( void * ) bigint_test_work.exponent );
+	bigint_t ( size ) *result_bi = ( ( void * ) bigint_test_work.result );
+
+	bigint_init ( base_bi, base, base_len );
+	bigint_init ( modulus_bi, modulus, modulus_len );
+	bigint_init ( exponent_bi, exponent, exponent_len );
+	bigint_mod_exp ( base_bi, modulus_bi, exponent_bi, result_bi,
+			 bigint_test_work.tmp );
+	bigint_done ( result_bi, out, out_len );
+}
+
+/**
+ * Verify modular exponentiation test
+ *
+ * @v test		Modular exponentiation test
+ */
+static void bigint_test_verify ( struct bigint_test *test ) {
+	uint8_t *out = bigint_test_work.out;
+	struct x509_rsa_public_key key;
+
+	/* Verify using big integer operations */
+	bigint_test_mod_exp ( test->base, test->base_len, test->modulus,
+			      test->modulus_len, test->exponent,
+			      test->exponent_len, out, test->expected_len );
+	ok ( memcmp ( out, test->expected, test->expected_len ) == 0 );
+
+	/* Verify using RSA public-key operation, where applicable */
+	if ( ( test->base_len != test->modulus_len ) ||
+	     ( test->modulus[0] == 0 ) )
+		return;
+	key.modulus = ( ( void * ) test->modulus );
+	key.modulus_len = test->modulus_len;
+	key.exponent = ( ( void * ) test->exponent );
+	key.exponent_len = test->exponent_len;
+	memset ( out, 0, test->expected_len );
+	ok ( rsa_public ( &key, test->base, out ) == 0 );
+	ok ( memcmp ( out, test->expected, test->expected_len ) == 0 );
+}
+
+/**
+ * Check for a range error
+ *
+ * @v rc		Return status code
+ * @ret is_erange	Return status code is a range error
+ *
+ * Only the POSIX error number is compared, since the remainder of the
+ * error code identifies the file in which the error was raised.
+ */
+static int rsa_test_is_erange ( int rc ) {
+	return ( ( ( -rc ) >> 24 ) == ( ERANGE >> 24 ) );
+}
+
+/**
+ * Verify RSA encryption
+ *
+ */
+static void rsa_test_verify ( void ) {
+	struct x509_rsa_public_key key = {
+		.modulus = ( ( void * ) rsa_test_modulus ),
+		.modulus_len = sizeof ( rsa_test_modulus ),
+		.exponent = ( ( void * ) rsa_test_exponent ),
+		.exponent_len = sizeof ( rsa_test_exponent ),
+	};
+	size_t len = rsa_modulus_len ( &key );
+	uint8_t ciphertext[len];
+	uint8_t *block = bigint_test_work.out;
+	size_t padding_len = ( len - sizeof ( rsa_test_plaintext ) - 3 );
+	unsigned int zeros = 0;
+	unsigned int i;
+
+	/* Check that leading zero is ignored */
+	ok ( len == sizeof ( rsa_test_private_exponent ) );
+	if ( len != sizeof ( rsa_test_private_exponent ) )
+		return;
+
+	/* Encrypt, then decrypt using private exponent */
+	ok ( rsa_encrypt ( &key, rsa_test_plaintext,
+			   sizeof ( rsa_test_plaintext ), ciphertext ) == 0 );
+	bigint_test_mod_exp ( ciphertext, len, ( rsa_test_modulus + 1 ), len,
+			      rsa_test_private_exponent,
+			      sizeof ( rsa_test_private_exponent ),
+			      block, len );
+
+	/* Check PKCS #1 padding and recovered plaintext */
+	ok ( block[0] == 0x00 );
+	ok ( block[1] == 0x02 );
+	ok ( block[ 2 + padding_len ] == 0x00 );
+	ok ( memcmp ( &block[ 3 + padding_len ], rsa_test_plaintext,
+		      sizeof ( rsa_test_plaintext ) ) == 0 );
+	for ( i = 0 ; i < padding_len ; i++ ) {
+		if ( block[ 2 + i ] == 0x00 )
+			zeros++;
+	}
+	ok ( zeros == 0 );
+
+	/* Check that out-of-range input is rejected */
+	memset ( block, 0xff, len );
+	ok ( rsa_test_is_erange ( rsa_public ( &key, block, block ) ) );
+
+	/* Check that overlength plaintext is rejected */
+	ok ( rsa_test_is_erange ( rsa_encrypt ( &key, block, ( len - 10 ),
+						block ) ) );
+}
+
+/**
+ * Measure time taken by modular exponentiation
+ *
+ * @v test		Modular exponentiation test
+ * @ret ticks		Cost per operation, in CPU ticks
+ * @ret usecs		Time per operation, in microseconds
+ */
+static unsigned long bigint_test_bench ( struct bigint_test *test,
+					 unsigned long *ticks ) {
+	union profiler profiler;
+	unsigned long started;
+	unsigned long elapsed;
+	unsigned long count = 0;
+	uint64_t total = 0;
+
+	started = currticks();
+	do {
+		profile ( &profiler );
+		bigint_test_mod_exp ( test->base, test->base_len,
+				      test->modulus, test->modulus_len,
+				      test->exponent, test->exponent_len,
+				      bigint_test_work.out,
+				      test->expected_len );
+		total += profile ( &profiler );
+		count++;
+		elapsed = ( currticks() - started );
+	} while ( elapsed < ( BIGINT_TEST_BENCH_SECS * TICKS_PER_SEC ) );
+
+	*ticks = ( total / count );
+	return ( ( ( ( uint64_t ) elapsed ) * 1000000 ) /
+		 ( ( ( uint64_t ) count ) * TICKS_PER_SEC ) );
+}
+
+/**
+ * Perform big integer self-tests
+ *
+ */
+static void bigint_test_exec ( void ) {
+	struct bigint_test *test;
+	unsigned long usecs;
+	unsigned long ticks;
+	unsigned int i;
+
+	/* Verify test vectors */
+	for ( i = 0 ; i < ( sizeof ( bigint_tests ) /
+			    sizeof ( bigint_tests[0] ) ) ; i++ ) {
+		bigint_test_verify ( &bigint_tests[i] );
+	}
+	rsa_test_verify();
+
+	/* Measure time per operation for full-size keys */
+	for ( i = 0 ; i < ( sizeof ( bigint_tests ) /
+			    sizeof ( bigint_tests[0] ) ) ; i++ ) {
+		test = &bigint_tests[i];
+		if ( test->modulus_len < ( 1024 / 8 ) )
+			continue;
+		usecs = bigint_test_bench ( test, &ticks );
+		printf ( "%s: %ld us (%ld CPU ticks)\n", test->name,
+			 usecs, ticks );
+	}
+}
+
+/** Big integer self-test */
+struct self_test bigint_test __self_test = {
+	.name = "bigint",
+	.exec = bigint_test_exec,
+};
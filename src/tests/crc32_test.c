@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2011 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ipxe/profile.h>
+#include <ipxe/crc32.h>
+#include <ipxe/test.h>
+
+/** @file
+ *
+ * CRC32 self-tests
+ *
+ * Checks crc32_le() against known answers and against a bit-by-bit
+ * reference implementation for all alignments, and measures its
+ * throughput.
+ */
+
+/** Maximum buffer alignment offset to test */
+#define CRC32_TEST_MAX_OFFSET 16
+
+/** Maximum buffer length to test */
+#define CRC32_TEST_MAX_LEN 2112
+
+/** Buffer length used for benchmarking (a maximum-size FCoE frame) */
+#define CRC32_TEST_BENCH_LEN 2112
+
+/** Number of iterations used for benchmarking */
+#define CRC32_TEST_BENCH_COUNT 256
+
+/** A CRC32 known-answer test */
+struct crc32_test {
+	/** Data */
+	const char *data;
+	/** Expected CRC32 (as used by Ethernet, i.e. inverted) */
+	uint32_t crc;
+};
+
+/** CRC32 known-answer tests */
+static struct crc32_test crc32_tests[] = {
+	{ "", 0x00000000 },
+	{ "a", 0xe8b7be43 },
+	{ "abc", 0x352441c2 },
+	{ "123456789", 0xcbf43926 },
+	{ "The quick brown fox jumps over the lazy dog", 0x414fa339 },
+};
+
+/** Test data buffer */
+static uint8_t crc32_test_data[ CRC32_TEST_MAX_OFFSET + CRC32_TEST_MAX_LEN ];
+
+/**
+ * Calculate CRC32 a bit at a time
+ *
+ * @v seed		Initial value
+ * @v data		Data to checksum
+ * @v len		Length of data
+ * @ret crc		CRC32
+ */
+static uint32_t crc32_test_reference ( uint32_t seed, const void *data,
+				       size_t len ) {
+	const uint8_t *src = data;
+	uint32_t crc = seed;
+	unsigned int i;
+
+	while ( len-- ) {
+		crc ^= *(src++);
+		for ( i = 0 ; i < 8 ; i++ ) {
+			crc = ( ( crc >> 1 ) ^
+				( ( crc & 1 ) ? 0xedb88320 : 0 ) );
+		}
+	}
+	return crc;
+}
+
+/**
+ * Verify CRC32 over all alignments and lengths
+ *
+ * @ret matches		All CRCs match reference implementation
+ */
+static int crc32_test_verify_all ( void ) {
+	unsigned int offset;
+	uint32_t seed;
+	uint32_t expected;
+	uint32_t actual;
+	size_t len;
+
+	for ( offset = 0 ; offset < CRC32_TEST_MAX_OFFSET ; offset++ ) {
+		for ( len = 0 ; len <= CRC32_TEST_MAX_LEN ; len++ ) {
+			seed = random();
+			expected = crc32_test_reference ( seed,
+						&crc32_test_data[offset], len );
+			actual = crc32_le ( seed, &crc32_test_data[offset],
+					    len );
+			if ( actual != expected ) {
+				printf ( "CRC32 %08x+%p+%zx incorrect: got "
+					 "%08x, expected %08x\n", seed,
+					 &crc32_test_data[offset], len,
+					 actual, expected );
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+/**
+ * Perform CRC32 self-tests
+ *
+ */
+static void crc32_test_exec ( void ) {
+	union profiler profiler;
+	struct crc32_test *test;
+	unsigned long ticks;
+	unsigned int i;
+
+	/* Known-answer tests */
+	for ( i = 0 ; i < ( sizeof ( crc32_tests ) /
+			    sizeof ( crc32_tests[0] ) ) ; i++ ) {
+		test = &crc32_tests[i];
+		ok ( ~crc32_le ( ~0, test->data, strlen ( test->data ) )
+		     == test->crc );
+	}
+
+	/* Compare against reference implementation */
+	for ( i = 0 ; i < sizeof ( crc32_test_data ) ; i++ )
+		crc32_test_data[i] = random();
+	ok ( crc32_test_verify_all() );
+
+	/* Measure throughput */
+	profile ( &profiler );
+	for ( i = 0 ; i < CRC32_TEST_BENCH_COUNT ; i++ )
+		crc32_le ( ~0, crc32_test_data, CRC32_TEST_BENCH_LEN );
+	ticks = profile ( &profiler );
+	printf ( "CRC32 %d bytes: %ld CPU ticks/kB\n", CRC32_TEST_BENCH_LEN,
+		 ( ( ticks * 1024 ) /
+		   ( CRC32_TEST_BENCH_COUNT * CRC32_TEST_BENCH_LEN ) ) );
+}
+
+/** CRC32 self-test */
+struct self_test crc32_test __self_test = {
+	.name = "crc32",
+	.exec = crc32_test_exec,
+};
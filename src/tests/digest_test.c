@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2011 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <ipxe/timer.h>
+#include <ipxe/profile.h>
+#include <ipxe/crypto.h>
+#include <ipxe/md5.h>
+#include <ipxe/sha1.h>
+#include <ipxe/test.h>
+
+/** @file
+ *
+ * Digest algorithm self-tests
+ *
+ * Verifies each digest algorithm against published test vectors,
+ * using a variety of buffer alignments and fragment lengths, and
+ * measures the throughput of each algorithm.  All operations go
+ * through the generic digest algorithm interface.
+ */
+
+/** Length of scratch data buffer */
+#define DIGEST_TEST_BUF_LEN 4096
+
+/** Duration of each throughput measurement, in seconds */
+#define DIGEST_TEST_BENCH_SECS 1
+
+/** A digest test vector */
+struct digest_test {
+	/** Digest algorithm */
+	struct digest_algorithm *digest;
+	/** Data */
+	const char *data;
+	/** Number of times data is repeated */
+	unsigned int repeat;
+	/** Expected digest */
+	uint8_t expected[SHA1_DIGEST_SIZE];
+};
+
+/** Digest test vectors (from RFC 1321 and FIPS 180-2) */
+static struct digest_test digest_tests[] = {
+	{ &md5_algorithm, "", 1,
+	  { 0xd4, 0x1d, 0x8c, 0xd9, 0x8f, 0x00, 0xb2, 0x04,
+	    0xe9, 0x80, 0x09, 0x98, 0xec, 0xf8, 0x42, 0x7e } },
+	{ &md5_algorithm, "abc", 1,
+	  { 0x90, 0x01, 0x50, 0x98, 0x3c, 0xd2, 0x4f, 0xb0,
+	    0xd6, 0x96, 0x3f, 0x7d, 0x28, 0xe1, 0x7f, 0x72 } },
+	{ &md5_algorithm, "message digest", 1,
+	  { 0xf9, 0x6b, 0x69, 0x7d, 0x7c, 0xb7, 0x93, 0x8d,
+	    0x52, 0x5a, 0x2f, 0x31, 0xaa, 0xf1, 0x61, 0xd0 } },
+	{ &md5_algorithm, "1234567890", 8,
+	  { 0x57, 0xed, 0xf4, 0xa2, 0x2b, 0xe3, 0xc9, 0x55,
+	    0xac, 0x49, 0xda, 0x2e, 0x21, 0x07, 0xb6, 0x7a } },
+	{ &md5_algorithm, "a", 1000000,
+	  { 0x77, 0x07, 0xd6, 0xae, 0x4e, 0x02, 0x7c, 0x70,
+	    0xee, 0xa2, 0xa9, 0x35, 0xc2, 0x29, 0x6f, 0x21 } },
+	{ &sha1_algorithm, "", 1,
+	  { 0xda, 0x39, 0xa3, 0xee, 0x5e, 0x6b, 0x4b, 0x0d, 0x32, 0x55,
+	    0xbf, 0xef, 0x95, 0x60, 0x18, 0x90, 0xaf, 0xd8, 0x07, 0x09 } },
+	{ &sha1_algorithm, "abc", 1,
+	  { 0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e,
+	    0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d } },
+	{ &sha1_algorithm,
+	  "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+	  { 0x84, 0x98, 0x3e, 0x44, 0x1c, 0x3b, 0xd2, 0x6e, 0xba, 0xae,
+	    0x4a, 0xa1, 0xf9, 0x51, 0x29, 0xe5, 0xe5, 0x46, 0x70, 0xf1 } },
+	{ &sha1_algorithm, "1234567890", 8,
+	  { 0x50, 0xab, 0xf5, 0x70, 0x6a, 0x15, 0x09, 0x90, 0xa0, 0x8b,
+	    0x2c, 0x5e, 0xa4, 0x0f, 0xa0, 0xe5, 0x85, 0x55, 0x47, 0x32 } },
+	{ &sha1_algorithm, "a", 1000000,
+	  { 0x34, 0xaa, 0x97, 0x3c, 0xd4, 0xc4, 0xda, 0xa4, 0xf6, 0x1e,
+	    0xeb, 0x2b, 0xdb, 0xad, 0x27, 0x31, 0x65, 0x34, 0x01, 0x6f } },
+};
+
+/** Digest algorithms for throughput measurement */
+static struct digest_algorithm *digest_test_algorithms[] = {
+	&md5_algorithm,
+	&sha1_algorithm,
+};
+
+/** Fragment lengths used to exercise partial block handling */
+static const size_t digest_test_frag_lens[] = { 1, 3, 17, 64, 65, 200 };
+
+/** Scratch data buffer (with room for misalignment) */
+static uint8_t digest_test_buf[ DIGEST_TEST_BUF_LEN + sizeof ( uint32_t ) ];
+
+/**
+ * Calculate digest of test vector
+ *
+ * @v test		Digest test vector
+ * @v offset		Alignment offset within scratch buffer
+ * @v max_frag_len	Maximum length of each digest update
+ * @v out		Digest output buffer
+ *
+ * The data is copied (repeatedly, if necessary) into the scratch
+ * buffer at the specified alignment offset, and passed to the digest
+ * algorithm in fragments of at most @c max_frag_len bytes.
+ */
+static void digest_test_calculate ( struct digest_test *test, size_t offset,
+				    size_t max_frag_len, void *out ) {
+	struct digest_algorithm *digest = test->digest;
+	uint8_t ctx[digest->ctxsize];
+	uint8_t *data = ( digest_test_buf + offset );
+	size_t data_len = strlen ( test->data );
+	size_t len = ( data_len * test->repeat );
+	size_t buf_len = ( sizeof ( digest_test_buf ) - offset );
+	size_t chunk_len;
+	size_t frag_len;
+	size_t i;
+
+	/* Fill buffer with as many whole copies of the data as fit */
+	chunk_len = 0;
+	for ( i = 0 ; ( i < test->repeat ) &&
+		      ( ( chunk_len + data_len ) <= buf_len ) ; i++ ) {
+		memcpy ( ( data + chunk_len ), test->data, data_len );
+		chunk_len += data_len;
+	}
+
+	/* Digest data */
+	digest_init ( digest, ctx );
+	while ( len ) {
+		for ( i = 0 ; ( len && ( i < chunk_len ) ) ; i += frag_len ) {
+			frag_len = ( chunk_len - i );
+			if ( frag_len > max_frag_len )
+				frag_len = max_frag_len;
+			if ( frag_len > len )
+				frag_len = len;
+			digest_update ( digest, ctx, ( data + i ), frag_len );
+			len -= frag_len;
+		}
+	}
+	digest_final ( digest, ctx, out );
+}
+
+/**
+ * Verify digest test vector
+ *
+ * @v test		Digest test vector
+ */
+static void digest_test_verify ( struct digest_test *test ) {
+	struct digest_algorithm *digest = test->digest;
+	uint8_t out[digest->digestsize];
+	size_t offset;
+	unsigned int i;
+
+	/* Verify at each alignment offset */
+	for ( offset = 0 ; offset < sizeof ( uint32_t ) ; offset++ ) {
+		digest_test_calculate ( test, offset,
+					sizeof ( digest_test_buf ), out );
+		ok ( memcmp ( out, test->expected, sizeof ( out ) ) == 0 );
+	}
+
+	/* Verify with each fragment length */
+	for ( i = 0 ; i < ( sizeof ( digest_test_frag_lens ) /
+			    sizeof ( digest_test_frag_lens[0] ) ) ; i++ ) {
+		digest_test_calculate ( test, ( i % sizeof ( uint32_t ) ),
+					digest_test_frag_lens[i], out );
+		ok ( memcmp ( out, test->expected, sizeof ( out ) ) == 0 );
+	}
+}
+
+/**
+ * Measure digest throughput
+ *
+ * @v digest		Digest algorithm
+ * @v offset		Alignment offset within scratch buffer
+ * @ret ticks_per_kb	Cost, in CPU ticks per kilobyte
+ * @ret kbps		Throughput, in kB/s
+ */
+static unsigned long digest_test_bench ( struct digest_algorithm *digest,
+					 size_t offset,
+					 unsigned long *ticks_per_kb ) {
+	union profiler profiler;
+	uint8_t ctx[digest->ctxsize];
+	uint8_t out[digest->digestsize];
+	unsigned long started;
+	unsigned long elapsed;
+	unsigned long count = 0;
+	uint64_t ticks = 0;
+
+	/* Digest as much data as possible within the measurement period */
+	memset ( digest_test_buf, 0x5a, sizeof ( digest_test_buf ) );
+	digest_init ( digest, ctx );
+	started = currticks();
+	do {
+		profile ( &profiler );
+		digest_update ( digest, ctx, ( digest_test_buf + offset ),
+				DIGEST_TEST_BUF_LEN );
+		ticks += profile ( &profiler );
+		count++;
+		elapsed = ( currticks() - started );
+	} while ( elapsed < ( DIGEST_TEST_BENCH_SECS * TICKS_PER_SEC ) );
+	digest_final ( digest, ctx, out );
+
+	*ticks_per_kb = ( ticks / ( count * ( DIGEST_TEST_BUF_LEN / 1024 ) ) );
+	return ( ( ( ( uint64_t ) count ) * ( DIGEST_TEST_BUF_LEN / 1024 ) *
+		   TICKS_PER_SEC ) / elapsed );
+}
+
+/**
+ * Perform digest self-tests
+ *
+ */
+static void digest_test_exec ( void ) {
+	struct digest_algorithm *digest;
+	unsigned long aligned;
+	unsigned long unaligned;
+	unsigned long aligned_ticks;
+	unsigned long unaligned_ticks;
+	unsigned int i;
+
+	/* Verify test vectors */
+	for ( i = 0 ; i < ( sizeof ( digest_tests ) /
+			    sizeof ( digest_tests[0] ) ) ; i++ ) {
+		digest_test_verify ( &digest_tests[i] );
+	}
+
+	/* Measure throughput */
+	for ( i = 0 ; i < ( sizeof ( digest_test_algorithms ) /
+			    sizeof ( digest_test_algorithms[0] ) ) ; i++ ) {
+		digest = digest_test_algorithms[i];
+		aligned = digest_test_bench ( digest, 0, &aligned_ticks );
+		unaligned = digest_test_bench ( digest, 1, &unaligned_ticks );
+		printf ( "%s: %ld MB/s, %ld CPU ticks/kB (unaligned %ld MB/s, "
+			 "%ld CPU ticks/kB)\n", digest->name,
+			 ( aligned / 1024 ), aligned_ticks,
+			 ( unaligned / 1024 ), unaligned_ticks );
+	}
+}
+
+/** Digest algorithm self-test */
+struct self_test digest_test __self_test = {
+	.name = "digest",
+	.exec = digest_test_exec,
+};
@@ -0,0 +1,320 @@
+/*
+ * Copyright (C) 2011 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <byteswap.h>
+#include <ipxe/profile.h>
+#include <ipxe/crypto.h>
+#include <ipxe/md5.h>
+#include <ipxe/sha1.h>
+#include <ipxe/hmac.h>
+#include <ipxe/test.h>
+
+/** @file
+ *
+ * HMAC self-tests
+ *
+ * Verifies HMAC and PBKDF2 against published test vectors, checks
+ * that precomputed HMAC key contexts give the same results as
+ * hmac_init() and hmac_final(), and measures the cost of a WPA-PSK
+ * key derivation and of a TLS record MAC with each API.
+ */
+
+/** Length of data used for record MAC benchmarking */
+#define HMAC_TEST_RECORD_LEN 1024
+
+/** Number of records used for record MAC benchmarking */
+#define HMAC_TEST_RECORD_COUNT 256
+
+/** Data used for record MAC benchmarking */
+static uint8_t hmac_test_record[HMAC_TEST_RECORD_LEN];
+
+/** An HMAC test vector */
+struct hmac_test {
+	/** Digest algorithm */
+	struct digest_algorithm *digest;
+	/** Key byte (repeated) */
+	uint8_t key;
+	/** Key length */
+	size_t key_len;
+	/** Data */
+	const char *data;
+	/** Expected HMAC */
+	uint8_t expected[SHA1_DIGEST_SIZE];
+};
+
+/** HMAC test vectors (from RFC 2202) */
+static struct hmac_test hmac_tests[] = {
+	{ &md5_algorithm, 0x0b, 16, "Hi There",
+	  { 0x92, 0x94, 0x72, 0x7a, 0x36, 0x38, 0xbb, 0x1c,
+	    0x13, 0xf4, 0x8e, 0xf8, 0x15, 0x8b, 0xfc, 0x9d } },
+	{ &md5_algorithm, 0xaa, 80,
+	  "Test Using Larger Than Block-Size Key - Hash Key First",
+	  { 0x6b, 0x1a, 0xb7, 0xfe, 0x4b, 0xd7, 0xbf, 0x8f,
+	    0x0b, 0x62, 0xe6, 0xce, 0x61, 0xb9, 0xd0, 0xcd } },
+	{ &sha1_algorithm, 0x0b, 20, "Hi There",
+	  { 0xb6, 0x17, 0x31, 0x86, 0x55, 0x05, 0x72, 0x64, 0xe2, 0x8b,
+	    0xc0, 0xb6, 0xfb, 0x37, 0x8c, 0x8e, 0xf1, 0x46, 0xbe, 0x00 } },
+	{ &sha1_algorithm, 0xaa, 80,
+	  "Test Using Larger Than Block-Size Key - Hash Key First",
+	  { 0xaa, 0x4a, 0xe5, 0xe1, 0x52, 0x72, 0xd0, 0x0e, 0x95, 0x70,
+	    0x56, 0x37, 0xce, 0x8a, 0x3b, 0x55, 0xed, 0x40, 0x21, 0x12 } },
+};
+
+/** A PBKDF2 test vector */
+struct pbkdf2_test {
+	/** Passphrase */
+	const char *passphrase;
+	/** Salt */
+	const char *salt;
+	/** Number of iterations */
+	int iterations;
+	/** Length of derived key */
+	size_t key_len;
+	/** Expected derived key */
+	uint8_t expected[32];
+};
+
+/** PBKDF2 test vectors (from RFC 6070 and IEEE 802.11i) */
+static struct pbkdf2_test pbkdf2_tests[] = {
+	{ "password", "salt", 1, 20,
+	  { 0x0c, 0x60, 0xc8, 0x0f, 0x96, 0x1f, 0x0e, 0x71, 0xf3, 0xa9,
+	    0xb5, 0x24, 0xaf, 0x60, 0x12, 0x06, 0x2f, 0xe0, 0x37, 0xa6 } },
+	{ "password", "salt", 4096, 20,
+	  { 0x4b, 0x00, 0x79, 0x01, 0xb7, 0x65, 0x48, 0x9a, 0xbe, 0xad,
+	    0x49, 0xd9, 0x26, 0xf7, 0x21, 0xd0, 0x65, 0xa4, 0x29, 0xc1 } },
+	{ "password", "IEEE", 4096, 32,
+	  { 0xf4, 0x2c, 0x6f, 0xc5, 0x2d, 0xf0, 0xeb, 0xef,
+	    0x9e, 0xbb, 0x4b, 0x90, 0xb3, 0x8a, 0x5f, 0x90,
+	    0x2e, 0x83, 0xfe, 0x1b, 0x13, 0x5a, 0x70, 0xe2,
+	    0x3a, 0xed, 0x76, 0x2e, 0x97, 0x10, 0xa1, 0x2e } },
+};
+
+/**
+ * Calculate PBKDF2 using hmac_init() and hmac_final()
+ *
+ * @v passphrase	Passphrase
+ * @v pass_len		Length of passphrase
+ * @v salt		Salt
+ * @v salt_len		Length of salt
+ * @v iterations	Number of iterations
+ * @v key		Derived key to fill in
+ * @v key_len		Length of derived key
+ *
+ * This is the per-iteration key setup used by pbkdf2_sha1() prior to
+ * the introduction of precomputed HMAC key contexts, retained here
+ * for comparison.
+ */
+static void pbkdf2_sha1_reference ( const void *passphrase, size_t pass_len,
+				    const void *salt, size_t salt_len,
+				    int iterations, void *key,
+				    size_t key_len ) {
+	uint8_t pass[pass_len];
+	uint8_t in[ salt_len + 4 ];
+	uint8_t last[SHA1_DIGEST_SIZE];
+	uint8_t block[SHA1_DIGEST_SIZE];
+	uint8_t sha1_ctx[SHA1_CTX_SIZE];
+	uint32_t blocknr;
+	uint32_t blocknr_be;
+	size_t frag_len;
+	size_t in_len;
+	int i;
+	unsigned int j;
+
+	for ( blocknr = 1 ; key_len ; blocknr++ ) {
+		memcpy ( pass, passphrase, pass_len );
+		memcpy ( in, salt, salt_len );
+		blocknr_be = htonl ( blocknr );
+		memcpy ( ( in + salt_len ), &blocknr_be,
+			 sizeof ( blocknr_be ) );
+		memset ( block, 0, sizeof ( block ) );
+		in_len = sizeof ( in );
+		for ( i = 0 ; i < iterations ; i++ ) {
+			hmac_init ( &sha1_algorithm, sha1_ctx, pass,
+				    &pass_len );
+			hmac_update ( &sha1_algorithm, sha1_ctx,
+				      ( i ? last : in ), in_len );
+			hmac_final ( &sha1_algorithm, sha1_ctx, pass,
+				     &pass_len, last );
+			for ( j = 0 ; j < sizeof ( block ) ; j++ )
+				block[j] ^= last[j];
+			in_len = sizeof ( last );
+		}
+		frag_len = key_len;
+		if ( frag_len > sizeof ( block ) )
+			frag_len = sizeof ( block );
+		memcpy ( key, block, frag_len );
+		key += frag_len;
+		key_len -= frag_len;
+	}
+}
+
+/**
+ * Verify HMAC test vector
+ *
+ * @v test		HMAC test vector
+ */
+static void hmac_test_verify ( struct hmac_test *test ) {
+	struct digest_algorithm *digest = test->digest;
+	uint8_t key[test->key_len];
+	size_t key_len = sizeof ( key );
+	uint8_t key_ctx[ hmac_key_ctxsize ( digest ) ];
+	uint8_t ctx[digest->ctxsize];
+	uint8_t out[digest->digestsize];
+	uint8_t out_key[digest->digestsize];
+
+	/* Calculate using hmac_init() and hmac_final() */
+	memset ( key, test->key, sizeof ( key ) );
+	hmac_init ( digest, ctx, key, &key_len );
+	hmac_update ( digest, ctx, test->data, strlen ( test->data ) );
+	hmac_final ( digest, ctx, key, &key_len, out );
+	ok ( memcmp ( out, test->expected, sizeof ( out ) ) == 0 );
+
+	/* Calculate using precomputed key context */
+	memset ( key, test->key, sizeof ( key ) );
+	hmac_key_init ( digest, key_ctx, key, sizeof ( key ) );
+	hmac_key_start ( digest, key_ctx, ctx );
+	hmac_update ( digest, ctx, test->data, strlen ( test->data ) );
+	hmac_key_final ( digest, key_ctx, ctx, out_key );
+	ok ( memcmp ( out_key, test->expected, sizeof ( out_key ) ) == 0 );
+}
+
+/**
+ * Verify PBKDF2 test vector
+ *
+ * @v test		PBKDF2 test vector
+ */
+static void hmac_test_pbkdf2 ( struct pbkdf2_test *test ) {
+	uint8_t key[32];
+	uint8_t key_ref[32];
+
+	pbkdf2_sha1 ( test->passphrase, strlen ( test->passphrase ),
+		      test->salt, strlen ( test->salt ),
+		      test->iterations, key, test->key_len );
+	ok ( memcmp ( key, test->expected, test->key_len ) == 0 );
+
+	pbkdf2_sha1_reference ( test->passphrase, strlen ( test->passphrase ),
+				test->salt, strlen ( test->salt ),
+				test->iterations, key_ref, test->key_len );
+	ok ( memcmp ( key_ref, test->expected, test->key_len ) == 0 );
+}
+
+/**
+ * Measure cost of WPA-PSK key derivation
+ *
+ * @v pbkdf2		PBKDF2 implementation
+ * @ret ticks		Cost, in CPU ticks
+ */
+static unsigned long
+hmac_test_bench_psk ( void ( * pbkdf2 ) ( const void *passphrase,
+					  size_t pass_len, const void *salt,
+					  size_t salt_len, int iterations,
+					  void *key, size_t key_len ) ) {
+	union profiler profiler;
+	uint8_t pmk[32];
+
+	profile ( &profiler );
+	pbkdf2 ( "password", 8, "IEEE", 4, 4096, pmk, sizeof ( pmk ) );
+	return profile ( &profiler );
+}
+
+/**
+ * Measure cost of record MAC using hmac_init() and hmac_final()
+ *
+ * @ret ticks		Cost per record, in CPU ticks
+ */
+static unsigned long hmac_test_bench_record_reference ( void ) {
+	union profiler profiler;
+	uint8_t secret[SHA1_DIGEST_SIZE];
+	size_t secret_len = sizeof ( secret );
+	uint8_t ctx[SHA1_CTX_SIZE];
+	uint8_t mac[SHA1_DIGEST_SIZE];
+	unsigned int i;
+
+	memset ( secret, 0x5a, sizeof ( secret ) );
+	profile ( &profiler );
+	for ( i = 0 ; i < HMAC_TEST_RECORD_COUNT ; i++ ) {
+		hmac_init ( &sha1_algorithm, ctx, secret, &secret_len );
+		hmac_update ( &sha1_algorithm, ctx, hmac_test_record,
+			      sizeof ( hmac_test_record ) );
+		hmac_final ( &sha1_algorithm, ctx, secret, &secret_len, mac );
+	}
+	return ( profile ( &profiler ) / HMAC_TEST_RECORD_COUNT );
+}
+
+/**
+ * Measure cost of record MAC using a precomputed key context
+ *
+ * @ret ticks		Cost per record, in CPU ticks
+ */
+static unsigned long hmac_test_bench_record ( void ) {
+	union profiler profiler;
+	uint8_t secret[SHA1_DIGEST_SIZE];
+	uint8_t key_ctx[ hmac_key_ctxsize ( &sha1_algorithm ) ];
+	uint8_t ctx[SHA1_CTX_SIZE];
+	uint8_t mac[SHA1_DIGEST_SIZE];
+	unsigned int i;
+
+	memset ( secret, 0x5a, sizeof ( secret ) );
+	hmac_key_init ( &sha1_algorithm, key_ctx, secret, sizeof ( secret ) );
+	profile ( &profiler );
+	for ( i = 0 ; i < HMAC_TEST_RECORD_COUNT ; i++ ) {
+		hmac_key_start ( &sha1_algorithm, key_ctx, ctx );
+		hmac_update ( &sha1_algorithm, ctx, hmac_test_record,
+			      sizeof ( hmac_test_record ) );
+		hmac_key_final ( &sha1_algorithm, key_ctx, ctx, mac );
+	}
+	return ( profile ( &profiler ) / HMAC_TEST_RECORD_COUNT );
+}
+
+/**
+ * Perform HMAC self-tests
+ *
+ */
+static void hmac_test_exec ( void ) {
+	unsigned int i;
+
+	for ( i = 0 ; i < ( sizeof ( hmac_tests ) /
+			    sizeof ( hmac_tests[0] ) ) ; i++ ) {
+		hmac_test_verify ( &hmac_tests[i] );
+	}
+	for ( i = 0 ; i < ( sizeof ( pbkdf2_tests ) /
+			    sizeof ( pbkdf2_tests[0] ) ) ; i++ ) {
+		hmac_test_pbkdf2 ( &pbkdf2_tests[i] );
+	}
+
+	/* Measure cost of WPA-PSK key derivation */
+	printf ( "HMAC WPA-PSK derivation: %ld (reference %ld) CPU ticks\n",
+		 hmac_test_bench_psk ( pbkdf2_sha1 ),
+		 hmac_test_bench_psk ( pbkdf2_sha1_reference ) );
+
+	/* Measure cost of TLS record MAC */
+	printf ( "HMAC-SHA1 %d-byte record: %ld (reference %ld) CPU ticks\n",
+		 HMAC_TEST_RECORD_LEN, hmac_test_bench_record(),
+		 hmac_test_bench_record_reference() );
+}
+
+/** HMAC self-test */
+struct self_test hmac_test __self_test = {
+	.name = "hmac",
+	.exec = hmac_test_exec,
+};
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2011 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ipxe/io.h>
+#include <ipxe/malloc.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/test.h>
+
+/** @file
+ *
+ * Memory allocator self-tests
+ *
+ * Performs a long sequence of randomly-sized allocations and frees
+ * (including physically aligned allocations of the kind used for I/O
+ * buffers), checking that no allocation is corrupted by any other
+ * and that all memory is returned to the heap.
+ */
+
+/** Number of simultaneously live allocations */
+#define MALLOC_TEST_SLOTS 16
+
+/** Number of allocation or free operations to perform */
+#define MALLOC_TEST_ITERATIONS 16384
+
+/** Maximum size of a random allocation */
+#define MALLOC_TEST_MAX_LEN 4200
+
+/** Allocation sizes at and around the size class boundaries */
+static const size_t malloc_test_lens[] = {
+	1, 16, 17, 32, 33, 48, 49, 64, 65, 3072, 3073, 4095, 4096, 4097,
+	6144, 8192,
+};
+
+/** A live test allocation */
+struct malloc_test_slot {
+	/** Allocated memory, or NULL */
+	uint8_t *data;
+	/** Length of allocation */
+	size_t len;
+	/** Physical alignment, or zero for malloc() */
+	size_t align;
+	/** Fill byte */
+	uint8_t fill;
+};
+
+/** Live test allocations */
+static struct malloc_test_slot malloc_test_slots[MALLOC_TEST_SLOTS];
+
+/**
+ * Allocate memory for a test slot
+ *
+ * @v slot		Test slot
+ * @ret success		Allocation succeeded
+ */
+static int malloc_test_alloc ( struct malloc_test_slot *slot ) {
+
+	/* Choose size and alignment */
+	slot->len = ( ( random() % MALLOC_TEST_MAX_LEN ) + 1 );
+	slot->align = 0;
+	if ( ( random() % 4 ) == 0 ) {
+		slot->len = ( 1536 + sizeof ( struct io_buffer ) );
+		slot->align = IOB_ALIGN;
+	}
+	slot->fill = random();
+
+	/* Allocate and fill memory */
+	if ( slot->align ) {
+		slot->data = malloc_dma ( slot->len, slot->align );
+	} else {
+		slot->data = malloc ( slot->len );
+	}
+	if ( ! slot->data ) {
+		printf ( "MALLOC could not allocate %#zx bytes\n", slot->len );
+		return 0;
+	}
+	if ( slot->align && ( virt_to_phys ( slot->data ) &
+			      ( slot->align - 1 ) ) ) {
+		printf ( "MALLOC %p is not aligned to %#zx\n",
+			 slot->data, slot->align );
+		return 0;
+	}
+	memset ( slot->data, slot->fill, slot->len );
+	return 1;
+}
+
+/**
+ * Free memory for a test slot
+ *
+ * @v slot		Test slot
+ * @ret success		Contents were intact
+ */
+static int malloc_test_free ( struct malloc_test_slot *slot ) {
+	int success = 1;
+	size_t i;
+
+	/* Check that contents have not been corrupted */
+	for ( i = 0 ; i < slot->len ; i++ ) {
+		if ( slot->data[i] != slot->fill ) {
+			printf ( "MALLOC %p+%#zx corrupted at offset %#zx\n",
+				 slot->data, slot->len, i );
+			success = 0;
+			break;
+		}
+	}
+
+	/* Free memory */
+	if ( slot->align ) {
+		free_dma ( slot->data, slot->len );
+	} else {
+		free ( slot->data );
+	}
+	slot->data = NULL;
+	return success;
+}
+
+/**
+ * Perform memory allocator self-tests
+ *
+ */
+static void malloc_test_exec ( void ) {
+	struct malloc_test_slot *slot;
+	size_t initial_freemem = freemem;
+	unsigned int i;
+	int success = 1;
+	void *data;
+
+	/* Allocate and free each size class boundary */
+	for ( i = 0 ; i < ( sizeof ( malloc_test_lens ) /
+			    sizeof ( malloc_test_lens[0] ) ) ; i++ ) {
+		data = malloc ( malloc_test_lens[i] );
+		ok ( data != NULL );
+		if ( data ) {
+			memset ( data, 0xaa, malloc_test_lens[i] );
+			free ( data );
+		}
+		ok ( freemem == initial_freemem );
+	}
+
+	/* Perform random allocations and frees */
+	for ( i = 0 ; success && ( i < MALLOC_TEST_ITERATIONS ) ; i++ ) {
+		slot = &malloc_test_slots[ random() % MALLOC_TEST_SLOTS ];
+		if ( slot->data ) {
+			success = malloc_test_free ( slot );
+		} else {
+			success = malloc_test_alloc ( slot );
+		}
+	}
+	ok ( success );
+
+	/* Free all remaining allocations */
+	success = 1;
+	for ( i = 0 ; i < MALLOC_TEST_SLOTS ; i++ ) {
+		slot = &malloc_test_slots[i];
+		if ( slot->data && ( ! malloc_test_free ( slot ) ) )
+			success = 0;
+	}
+	ok ( success );
+
+	/* Check that all memory has been returned */
+	ok ( freemem == initial_freemem );
+}
+
+/** Memory allocator self-test */
+struct self_test malloc_test __self_test = {
+	.name = "malloc",
+	.exec = malloc_test_exec,
+};
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2011 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ipxe/timer.h>
+#include <ipxe/process.h>
+#include <ipxe/profile.h>
+#include <ipxe/retry.h>
+#include <ipxe/test.h>
+
+/** @file
+ *
+ * Retry timer self-tests
+ *
+ * Creates over a thousand concurrently running timers, stops half
+ * of them, and checks that exactly the remaining half expire.  The
+ * cost of starting, stopping and expiring the timers is reported.
+ */
+
+/** Number of timers to create */
+#define RETRY_TEST_COUNT 1024
+
+/** Spread of timeout values, in ticks */
+#define RETRY_TEST_SPREAD 64
+
+/** Number of timers that have expired */
+static unsigned int retry_test_expired;
+
+/**
+ * Handle test timer expiry
+ *
+ * @v timer		Retry timer
+ * @v fail		Failure indicator
+ */
+static void retry_test_timer_expired ( struct retry_timer *timer __unused,
+				       int fail __unused ) {
+	retry_test_expired++;
+}
+
+/**
+ * Perform retry timer self-tests
+ *
+ */
+static void retry_test_exec ( void ) {
+	union profiler profiler;
+	struct retry_timer *timers;
+	unsigned long start_ticks;
+	unsigned long stop_ticks;
+	unsigned long expire_ticks;
+	unsigned long started;
+	unsigned int running;
+	unsigned int i;
+
+	/* Allocate timers */
+	timers = zalloc ( RETRY_TEST_COUNT * sizeof ( timers[0] ) );
+	ok ( timers != NULL );
+	if ( ! timers )
+		return;
+	for ( i = 0 ; i < RETRY_TEST_COUNT ; i++ )
+		timer_init ( &timers[i], retry_test_timer_expired, NULL );
+	retry_test_expired = 0;
+
+	/* Start all timers */
+	profile ( &profiler );
+	for ( i = 0 ; i < RETRY_TEST_COUNT ; i++ )
+		start_timer_fixed ( &timers[i], ( i % RETRY_TEST_SPREAD ) );
+	start_ticks = profile ( &profiler );
+
+	/* Stop every other timer */
+	profile ( &profiler );
+	for ( i = 0 ; i < RETRY_TEST_COUNT ; i += 2 )
+		stop_timer ( &timers[i] );
+	stop_ticks = profile ( &profiler );
+
+	/* Wait for all remaining timers to expire */
+	started = currticks();
+	profile ( &profiler );
+	while ( ( retry_test_expired < ( RETRY_TEST_COUNT / 2 ) ) &&
+		( ( currticks() - started ) <= ( 4 * RETRY_TEST_SPREAD ) ) ) {
+		step();
+	}
+	expire_ticks = profile ( &profiler );
+	ok ( retry_test_expired == ( RETRY_TEST_COUNT / 2 ) );
+
+	/* Check that no timer remains running */
+	running = 0;
+	for ( i = 0 ; i < RETRY_TEST_COUNT ; i++ ) {
+		if ( timer_running ( &timers[i] ) ) {
+			stop_timer ( &timers[i] );
+			running++;
+		}
+	}
+	ok ( running == 0 );
+
+	printf ( "RETRY %d timers: start %ld, stop %ld, expire %ld CPU "
+		 "ticks per timer\n", RETRY_TEST_COUNT,
+		 ( start_ticks / RETRY_TEST_COUNT ),
+		 ( stop_ticks / ( RETRY_TEST_COUNT / 2 ) ),
+		 ( expire_ticks / ( RETRY_TEST_COUNT / 2 ) ) );
+
+	free ( timers );
+}
+
+/** Retry timer self-test */
+struct self_test retry_test __self_test = {
+	.name = "retry",
+	.exec = retry_test_exec,
+};
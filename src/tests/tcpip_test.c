@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2011 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <byteswap.h>
+#include <ipxe/profile.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/test.h>
+
+/** @file
+ *
+ * TCP/IP checksum self-tests
+ *
+ * Verifies tcpip_continue_chksum() against a known answer and
+ * against the reference implementation for all alignments and a
+ * range of lengths, and measures the cost per byte of each
+ * implementation.
+ */
+
+/** Maximum buffer alignment offset to test */
+#define TCPIP_TEST_MAX_OFFSET 16
+
+/** Maximum buffer length to test */
+#define TCPIP_TEST_MAX_LEN 1600
+
+/** Buffer length used for benchmarking */
+#define TCPIP_TEST_BENCH_LEN 1460
+
+/** Number of iterations used for benchmarking */
+#define TCPIP_TEST_BENCH_COUNT 1024
+
+/** Partial checksums to test */
+static const uint16_t tcpip_test_partials[] = {
+	0x0000, 0xffff, 0x0001, 0xfffe, 0x1234,
+};
+
+/** Known-answer data (from RFC 1071 section 3) */
+static const uint8_t tcpip_test_rfc1071[] = {
+	0x00, 0x01, 0xf2, 0x03, 0xf4, 0xf5, 0xf6, 0xf7,
+};
+
+/** Test data buffer */
+static uint8_t tcpip_test_data[ TCPIP_TEST_MAX_OFFSET + TCPIP_TEST_MAX_LEN ];
+
+/**
+ * Verify checksum over a specified data block
+ *
+ * @v data		Data buffer
+ * @v len		Length of data buffer
+ * @ret matches		Checksum matches reference implementation
+ */
+static int tcpip_test_verify ( const void *data, size_t len ) {
+	uint16_t partial;
+	uint16_t expected;
+	uint16_t actual;
+	unsigned int i;
+
+	for ( i = 0 ; i < ( sizeof ( tcpip_test_partials ) /
+			    sizeof ( tcpip_test_partials[0] ) ) ; i++ ) {
+		partial = tcpip_test_partials[i];
+		expected = generic_tcpip_continue_chksum ( partial, data, len );
+		actual = tcpip_continue_chksum ( partial, data, len );
+		if ( actual != expected ) {
+			printf ( "TCPIP checksum %04x+%p+%zx incorrect: got "
+				 "%04x, expected %04x\n", partial, data, len,
+				 actual, expected );
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * Verify checksums over all alignments and lengths
+ *
+ * @ret matches		All checksums match reference implementation
+ */
+static int tcpip_test_verify_all ( void ) {
+	unsigned int offset;
+	size_t len;
+
+	for ( offset = 0 ; offset < TCPIP_TEST_MAX_OFFSET ; offset++ ) {
+		for ( len = 0 ; len <= TCPIP_TEST_MAX_LEN ; len++ ) {
+			if ( ! tcpip_test_verify ( &tcpip_test_data[offset],
+						   len ) )
+				return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * Measure cost of checksum calculation
+ *
+ * @v chksum		Checksum function
+ * @v offset		Buffer alignment offset
+ * @ret cost		Cost, in CPU ticks per kilobyte
+ */
+static unsigned long
+tcpip_test_bench ( uint16_t ( * chksum ) ( uint16_t partial, const void *data,
+					   size_t len ),
+		   unsigned int offset ) {
+	union profiler profiler;
+	unsigned long ticks;
+	unsigned int i;
+
+	profile ( &profiler );
+	for ( i = 0 ; i < TCPIP_TEST_BENCH_COUNT ; i++ ) {
+		chksum ( TCPIP_EMPTY_CSUM, &tcpip_test_data[offset],
+			 TCPIP_TEST_BENCH_LEN );
+	}
+	ticks = profile ( &profiler );
+	return ( ( ticks * 1024 ) /
+		 ( TCPIP_TEST_BENCH_COUNT * TCPIP_TEST_BENCH_LEN ) );
+}
+
+/**
+ * Perform TCP/IP checksum self-tests
+ *
+ */
+static void tcpip_test_exec ( void ) {
+	unsigned int offset;
+	unsigned int i;
+
+	/* Check known answer */
+	ok ( tcpip_chksum ( tcpip_test_rfc1071, sizeof ( tcpip_test_rfc1071 ) )
+	     == htons ( 0x220d ) );
+
+	/* Verify against reference implementation using random data,
+	 * all-ones data (which exercises the end-around carry) and
+	 * all-zeroes data.
+	 */
+	for ( i = 0 ; i < sizeof ( tcpip_test_data ) ; i++ )
+		tcpip_test_data[i] = random();
+	ok ( tcpip_test_verify_all() );
+	memset ( tcpip_test_data, 0xff, sizeof ( tcpip_test_data ) );
+	ok ( tcpip_test_verify_all() );
+	memset ( tcpip_test_data, 0x00, sizeof ( tcpip_test_data ) );
+	ok ( tcpip_test_verify_all() );
+
+	/* Measure cost per kilobyte at each alignment */
+	for ( offset = 0 ; offset < sizeof ( unsigned long ) ; offset++ ) {
+		printf ( "TCPIP checksum offset %d: %ld (reference %ld) CPU "
+			 "ticks/kB\n", offset,
+			 tcpip_test_bench ( tcpip_continue_chksum, offset ),
+			 tcpip_test_bench ( generic_tcpip_continue_chksum,
+					    offset ) );
+	}
+}
+
+/** TCP/IP checksum self-test */
+struct self_test tcpip_test __self_test = {
+	.name = "tcpip",
+	.exec = tcpip_test_exec,
+};
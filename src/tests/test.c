@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2012 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+/** @file
+ *
+ * Self-test infrastructure
+ *
+ * The self-tests are run as an embedded image, so that a build
+ * containing them (e.g. "make bin/tests.lkrn") will run all tests
+ * immediately after initialisation.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <errno.h>
+#include <assert.h>
+#include <string.h>
+#include <ipxe/image.h>
+#include <ipxe/init.h>
+#include <ipxe/test.h>
+
+/** Current self-test set */
+static struct self_test *current_tests;
+
+/**
+ * Report test result
+ *
+ * @v success		Test succeeded
+ * @v file		Test code file
+ * @v line		Test code line
+ * @v test		Test code
+ */
+void test_ok ( int success, const char *file, unsigned int line,
+	       const char *test ) {
+
+	/* Sanity check */
+	assert ( current_tests != NULL );
+
+	/* Increment test counter */
+	current_tests->total++;
+
+	/* Report failure if applicable */
+	if ( ! success ) {
+		current_tests->failures++;
+		printf ( "FAILURE: \"%s\" test failed at %s line %d:\n( %s )\n",
+			 current_tests->name, file, line, test );
+	}
+}
+
+/**
+ * Run self-test set
+ *
+ * @v tests		Self-test set
+ */
+static void run_tests ( struct self_test *tests ) {
+
+	/* Run tests */
+	current_tests = tests;
+	tests->total = 0;
+	tests->failures = 0;
+	tests->exec();
+	current_tests = NULL;
+
+	/* Report results */
+	if ( tests->failures ) {
+		printf ( "FAILURE: \"%s\" %d of %d tests failed\n",
+			 tests->name, tests->failures, tests->total );
+	} else {
+		printf ( "OK: \"%s\" %d tests passed\n",
+			 tests->name, tests->total );
+	}
+}
+
+/**
+ * Run all self-tests
+ *
+ * @ret rc		Return status code
+ */
+static int run_all_tests ( void ) {
+	struct self_test *tests;
+	unsigned int failures = 0;
+	unsigned int total = 0;
+
+	/* Run all compiled-in self-tests */
+	printf ( "Starting self-tests\n" );
+	for_each_table_entry ( tests, SELF_TESTS ) {
+		run_tests ( tests );
+		total += tests->total;
+		failures += tests->failures;
+	}
+
+	/* Report results */
+	if ( failures ) {
+		printf ( "FAILURE: %d of %d tests failed\n",
+			 failures, total );
+		return -EINPROGRESS;
+	} else {
+		printf ( "OK: all %d tests passed\n", total );
+		return 0;
+	}
+}
+
+/**
+ * Execute self-test image
+ *
+ * @v image		Self-test image
+ * @ret rc		Return status code
+ */
+static int test_image_exec ( struct image *image __unused ) {
+	return run_all_tests();
+}
+
+/** Self-test image type */
+static struct image_type test_image_type = {
+	.name = "self-tests",
+	.exec = test_image_exec,
+};
+
+/** Self-test image */
+static struct image test_image = {
+	.refcnt = REF_INIT ( ref_no_free ),
+	.name = "<TESTS>",
+	.type = &test_image_type,
+};
+
+/**
+ * Register self-test image
+ *
+ */
+static void test_init ( void ) {
+	int rc;
+
+	if ( ( rc = register_image ( &test_image ) ) != 0 ) {
+		printf ( "Could not register self-test image: %s\n",
+			 strerror ( rc ) );
+	}
+}
+
+/** Self-test initialisation function */
+struct init_fn test_init_fn __init_fn ( INIT_NORMAL ) = {
+	.initialise = test_init,
+};
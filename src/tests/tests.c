@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2012 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+/** @file
+ *
+ * Self-test collection
+ *
+ * Build e.g. "bin/tests.lkrn" to obtain an image that runs all of
+ * these self-tests at startup.
+ */
+
+/* Drag in all applicable self-tests */
+REQUIRE_OBJECT ( test );
+REQUIRE_OBJECT ( retry_test );
+REQUIRE_OBJECT ( tcpip_test );
+REQUIRE_OBJECT ( crc32_test );
+REQUIRE_OBJECT ( malloc_test );
+REQUIRE_OBJECT ( hmac_test );
+REQUIRE_OBJECT ( digest_test );
+REQUIRE_OBJECT ( aes_test );
+REQUIRE_OBJECT ( bigint_test );
+REQUIRE_OBJECT ( tftp_test );
@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2011 Michael Brown <mbrown@fensystems.co.uk>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER );
+
+#include <stdint.h>
+#include <string.h>
+#include <ipxe/bitmap.h>
+#include <ipxe/tftp.h>
+#include <ipxe/test.h>
+
+/** @file
+ *
+ * TFTP sliding window self-tests
+ *
+ * Checks the resolution of 16-bit DATA block numbers across a
+ * wraparound, and the ACK cadence for lock-step and windowed
+ * transfers, including lost ACKs and out-of-order blocks.
+ */
+
+/** Index of the first block after the 16-bit block number wraparound */
+#define TFTP_TEST_WRAP 65535
+
+/**
+ * Receive a DATA block
+ *
+ * @v window		Sliding window
+ * @v bitmap		Block bitmap
+ * @v block		Block index
+ * @ret ack		Block was acknowledged
+ *
+ * Mirrors the handling of a received block in tftp_rx_data().
+ */
+static int tftp_test_rx ( struct tftp_window *window, struct bitmap *bitmap,
+			  unsigned int block ) {
+	int duplicate;
+	int ack;
+
+	duplicate = bitmap_test ( bitmap, block );
+	bitmap_set ( bitmap, block );
+	ack = tftp_ack_required ( window, bitmap, block, duplicate );
+	if ( ack )
+		window->acked = bitmap_first_gap ( bitmap );
+	return ack;
+}
+
+/**
+ * Initialise sliding window and block bitmap
+ *
+ * @v window		Sliding window
+ * @v bitmap		Block bitmap
+ * @v size		Window size
+ * @v blocks		Number of blocks
+ * @ret rc		Return status code
+ */
+static int tftp_test_init ( struct tftp_window *window,
+			    struct bitmap *bitmap, unsigned int size,
+			    unsigned int blocks ) {
+
+	memset ( window, 0, sizeof ( *window ) );
+	window->size = size;
+	memset ( bitmap, 0, sizeof ( *bitmap ) );
+	return bitmap_resize ( bitmap, blocks );
+}
+
+/**
+ * Perform TFTP sliding window self-tests
+ *
+ */
+static void tftp_test_exec ( void ) {
+	struct tftp_window window;
+	struct bitmap bitmap;
+	unsigned int i;
+
+	/* Block number resolution */
+	ok ( tftp_block ( 0, 1 ) == 0 );
+	ok ( tftp_block ( 0, 8 ) == 7 );
+	ok ( tftp_block ( 0, 0 ) < 0 );
+	ok ( tftp_block ( 4, 2 ) == 1 );
+	ok ( tftp_block ( 65534, 65535 ) == 65534 );
+	ok ( tftp_block ( 65535, 0 ) == 65535 );
+	ok ( tftp_block ( 65535, 3 ) == 65538 );
+	ok ( tftp_block ( 65537, 65535 ) == 65534 );
+	ok ( tftp_block ( 65537, 2 ) == 65537 );
+	ok ( tftp_block ( 131071, 0 ) == 131071 );
+
+	/* Lock-step transfer acknowledges every block */
+	ok ( tftp_test_init ( &window, &bitmap, 1, 4 ) == 0 );
+	ok ( tftp_test_rx ( &window, &bitmap, 0 ) );
+	ok ( tftp_test_rx ( &window, &bitmap, 1 ) );
+	ok ( tftp_test_rx ( &window, &bitmap, 1 ) );
+	ok ( tftp_test_rx ( &window, &bitmap, 2 ) );
+	ok ( tftp_test_rx ( &window, &bitmap, 3 ) );
+	bitmap_free ( &bitmap );
+
+	/* Windowed transfer acknowledges each window and completion */
+	ok ( tftp_test_init ( &window, &bitmap, 4, 10 ) == 0 );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 0 ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 1 ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 2 ) );
+	ok ( tftp_test_rx ( &window, &bitmap, 3 ) );
+	ok ( window.acked == 4 );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 4 ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 5 ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 6 ) );
+	ok ( tftp_test_rx ( &window, &bitmap, 7 ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 8 ) );
+	ok ( tftp_test_rx ( &window, &bitmap, 9 ) );
+	ok ( bitmap_full ( &bitmap ) );
+	bitmap_free ( &bitmap );
+
+	/* Lost ACK: only the repeated end-of-window block is
+	 * acknowledged, and other duplicates are ignored.
+	 */
+	ok ( tftp_test_init ( &window, &bitmap, 4, 12 ) == 0 );
+	for ( i = 0 ; i < 3 ; i++ )
+		ok ( ! tftp_test_rx ( &window, &bitmap, i ) );
+	ok ( tftp_test_rx ( &window, &bitmap, 3 ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 0 ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 1 ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 2 ) );
+	ok ( tftp_test_rx ( &window, &bitmap, 3 ) );
+	ok ( window.acked == 4 );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 4 ) );
+	bitmap_free ( &bitmap );
+
+	/* Out-of-order block: the first gap since the last ACK rolls
+	 * the server back, and the window restarts from the ACK.
+	 */
+	ok ( tftp_test_init ( &window, &bitmap, 4, 12 ) == 0 );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 0 ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 1 ) );
+	ok ( tftp_test_rx ( &window, &bitmap, 3 ) );
+	ok ( window.acked == 2 );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 4 ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 2 ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 3 ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap, 4 ) );
+	ok ( tftp_test_rx ( &window, &bitmap, 5 ) );
+	ok ( window.acked == 6 );
+	bitmap_free ( &bitmap );
+
+	/* Window straddling the 16-bit block number wraparound */
+	ok ( tftp_test_init ( &window, &bitmap, 4,
+			      ( TFTP_TEST_WRAP + 5 ) ) == 0 );
+	for ( i = 0 ; i < ( TFTP_TEST_WRAP - 3 ) ; i++ )
+		bitmap_set ( &bitmap, i );
+	window.acked = bitmap_first_gap ( &bitmap );
+	ok ( ! tftp_test_rx ( &window, &bitmap,
+			      tftp_block ( bitmap_first_gap ( &bitmap ),
+					   65533 ) ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap,
+			      tftp_block ( bitmap_first_gap ( &bitmap ),
+					   65534 ) ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap,
+			      tftp_block ( bitmap_first_gap ( &bitmap ),
+					   65535 ) ) );
+	ok ( tftp_test_rx ( &window, &bitmap,
+			    tftp_block ( bitmap_first_gap ( &bitmap ), 0 ) ) );
+	ok ( window.acked == ( TFTP_TEST_WRAP + 1 ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap,
+			      tftp_block ( bitmap_first_gap ( &bitmap ),
+					   65535 ) ) );
+	ok ( tftp_test_rx ( &window, &bitmap,
+			    tftp_block ( bitmap_first_gap ( &bitmap ), 0 ) ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap,
+			      tftp_block ( bitmap_first_gap ( &bitmap ),
+					   1 ) ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap,
+			      tftp_block ( bitmap_first_gap ( &bitmap ),
+					   2 ) ) );
+	ok ( ! tftp_test_rx ( &window, &bitmap,
+			      tftp_block ( bitmap_first_gap ( &bitmap ),
+					   3 ) ) );
+	ok ( tftp_test_rx ( &window, &bitmap,
+			    tftp_block ( bitmap_first_gap ( &bitmap ), 4 ) ) );
+	ok ( bitmap_full ( &bitmap ) );
+	bitmap_free ( &bitmap );
+}
+
+/** TFTP sliding window self-test */
+struct self_test tftp_test __self_test = {
+	.name = "tftp",
+	.exec = tftp_test_exec,
+};
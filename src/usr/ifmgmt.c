@@ -98,6 +98,18 @@ void ifstat ( struct net_device *netdev ) {
 		printf ( "  [Link status: %s]\n",
 			 strerror ( netdev->link_rc ) );
 	}
+	if ( netdev->rx_stats.batches ) {
+		printf ( "  [RX batches:%d max:%d full:%d]\n",
+			 netdev->rx_stats.batches, netdev->rx_stats.max_batch,
+			 netdev->rx_stats.full_batches );
+	}
+	if ( netdev->neighbour_stats.hits || netdev->neighbour_stats.misses ) {
+		printf ( "  [Neighbours hit:%d miss:%d evict:%d expire:%d]\n",
+			 netdev->neighbour_stats.hits,
+			 netdev->neighbour_stats.misses,
+			 netdev->neighbour_stats.evictions,
+			 netdev->neighbour_stats.expiries );
+	}
 	ifstat_errors ( &netdev->tx_stats, "TXE" );
 	ifstat_errors ( &netdev->rx_stats, "RXE" );
 }
@@ -21,8 +21,10 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 #include <ipxe/image.h>
+#include <ipxe/imgdigest.h>
 #include <ipxe/downloader.h>
 #include <ipxe/monojob.h>
 #include <ipxe/open.h>
@@ -131,16 +133,48 @@ int register_and_replace_image ( struct image *image ) {
 	return 0;
 }
 
+/**
+ * Request image digest calculation during download
+ *
+ * @v image		Image
+ * @v expected		Expected digest, as a hex string
+ * @ret rc		Return status code
+ *
+ * This is a stub that is overridden when image digest support is
+ * present.
+ */
+__weak int image_expect_digest ( struct image *image __unused,
+				 const char *expected __unused ) {
+	return -ENOTSUP;
+}
+
+/**
+ * Verify image digest
+ *
+ * @v image		Image
+ * @v expected		Expected digest, as a hex string
+ * @ret rc		Return status code
+ *
+ * This is a stub that is overridden when image digest support is
+ * present.
+ */
+__weak int image_verify_digest ( struct image *image __unused,
+				 const char *expected __unused ) {
+	return -ENOTSUP;
+}
+
 /**
  * Download an image
  *
  * @v uri		URI
  * @v name		Image name, or NULL to use default
  * @v cmdline		Command line, or NULL for no command line
+ * @v digest		Expected digest (as a hex string), or NULL
  * @v action		Action to take upon a successful download
  * @ret rc		Return status code
  */
 int imgdownload ( struct uri *uri, const char *name, const char *cmdline,
+		  const char *digest,
 		  int ( * action ) ( struct image *image ) ) {
 	struct image *image;
 	size_t len = ( unparse_uri ( NULL, 0, uri, URI_ALL ) + 1 );
@@ -171,6 +205,13 @@ int imgdownload ( struct uri *uri, const char *name, const char *cmdline,
 		      uri, URI_ALL );
 	uri->password = password;
 
+	/* Calculate digest during download, if applicable */
+	if ( digest &&
+	     ( ( rc = image_expect_digest ( image, digest ) ) != 0 ) ) {
+		image_put ( image );
+		return rc;
+	}
+
 	/* Create downloader */
 	if ( ( rc = create_downloader ( &monojob, image, LOCATION_URI,
 					uri ) ) != 0 ) {
@@ -184,6 +225,13 @@ int imgdownload ( struct uri *uri, const char *name, const char *cmdline,
 		return rc;
 	}
 
+	/* Verify digest, if applicable */
+	if ( digest &&
+	     ( ( rc = image_verify_digest ( image, digest ) ) != 0 ) ) {
+		image_put ( image );
+		return rc;
+	}
+
 	/* Act upon downloaded image.  This action assumes our
 	 * ownership of the image.
 	 */
@@ -199,11 +247,12 @@ int imgdownload ( struct uri *uri, const char *name, const char *cmdline,
  * @v uri_string	URI as a string (e.g. "http://www.nowhere.com/vmlinuz")
  * @v name		Image name, or NULL to use default
  * @v cmdline		Command line, or NULL for no command line
+ * @v digest		Expected digest (as a hex string), or NULL
  * @v action		Action to take upon a successful download
  * @ret rc		Return status code
  */
 int imgdownload_string ( const char *uri_string, const char *name,
-			 const char *cmdline,
+			 const char *cmdline, const char *digest,
 			 int ( * action ) ( struct image *image ) ) {
 	struct uri *uri;
 	int rc;
@@ -211,7 +260,7 @@ int imgdownload_string ( const char *uri_string, const char *name,
 	if ( ! ( uri = parse_uri ( uri_string ) ) )
 		return -ENOMEM;
 
-	rc = imgdownload ( uri, name, cmdline, action );
+	rc = imgdownload ( uri, name, cmdline, digest, action );
 
 	uri_put ( uri );
 	return rc;